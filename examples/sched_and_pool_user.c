@@ -316,6 +316,9 @@ static int example_pool_get_def(ABT_pool_access access, ABT_pool_def *p_def)
     p_def->p_init               = pool_init;
     p_def->p_free               = pool_free;
     p_def->p_get_size           = pool_get_size;
+    p_def->p_pop_steal          = NULL;
+    p_def->p_push_many          = NULL;
+    p_def->p_pop_many           = NULL;
     p_def->u_get_type           = unit_get_type;
     p_def->u_get_thread         = unit_get_thread;
     p_def->u_get_task           = unit_get_task;
@@ -5,6 +5,7 @@
 
 #include "abti.h"
 #include <unistd.h>
+#include <dirent.h>
 
 #ifdef HAVE_PTHREAD_SETAFFINITY_NP
 #if defined(__FreeBSD__)
@@ -235,3 +236,213 @@ int ABTD_affinity_get_cpuset(ABTD_xstream_context ctx, int cpuset_size,
 #endif
 }
 
+
+/* Return the CPU on which the calling ES runs, or -1 if it is unknown.  If
+ * the ES is bound to a single CPU, that CPU is returned. */
+int ABTD_affinity_get_self_cpu(void)
+{
+    int cpu = -1;
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+    int i;
+    cpu_set_t cpuset;
+
+    if (!pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset) &&
+        ABTD_CPU_COUNT(&cpuset) == 1) {
+        for (i = 0; i < CPU_SETSIZE; i++) {
+            if (CPU_ISSET(i, &cpuset)) return i;
+        }
+    }
+#endif
+#ifdef HAVE_SCHED_GETCPU
+    cpu = sched_getcpu();
+#endif
+    return cpu;
+}
+
+
+/* CPU topology read from /sys/devices/system/cpu.  For each CPU, the smallest
+ * IDs of the CPUs that share its core and its last-level cache, and its NUMA
+ * node ID, are kept (-1 if unknown).  The topology is read when it is first
+ * needed. */
+static ABTI_spinlock g_topo_lock = ABTI_SPINLOCK_STATIC_INITIALIZER();
+static uint32_t g_topo_initialized = 0;
+static int g_topo_num_cpus = 0;
+static int *g_topo_core = NULL;
+static int *g_topo_llc = NULL;
+static int *g_topo_node = NULL;
+
+/* Read the first integer in the file.  For a CPU list such as "0-3,8-11",
+ * this is the smallest CPU ID. */
+static int ABTD_topo_read_int(const char *path)
+{
+    int val = -1;
+    FILE *fp = fopen(path, "r");
+    if (fp) {
+        if (fscanf(fp, "%d", &val) != 1) val = -1;
+        fclose(fp);
+    }
+    return val;
+}
+
+static void ABTD_topo_read_cpu(int cpu)
+{
+    char path[256];
+    int idx, level, max_level = -1;
+    DIR *p_dir;
+    struct dirent *p_ent;
+
+    sprintf(path, "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list",
+            cpu);
+    g_topo_core[cpu] = ABTD_topo_read_int(path);
+
+    /* The cache with the highest level is the last-level cache. */
+    g_topo_llc[cpu] = -1;
+    for (idx = 0; ; idx++) {
+        sprintf(path, "/sys/devices/system/cpu/cpu%d/cache/index%d/level",
+                cpu, idx);
+        level = ABTD_topo_read_int(path);
+        if (level < 0) break;
+        if (level > max_level) {
+            sprintf(path, "/sys/devices/system/cpu/cpu%d/cache/index%d/"
+                    "shared_cpu_list", cpu, idx);
+            g_topo_llc[cpu] = ABTD_topo_read_int(path);
+            max_level = level;
+        }
+    }
+
+    /* The CPU directory has a link named "node<N>" to its NUMA node. */
+    g_topo_node[cpu] = -1;
+    sprintf(path, "/sys/devices/system/cpu/cpu%d", cpu);
+    p_dir = opendir(path);
+    if (p_dir) {
+        while ((p_ent = readdir(p_dir)) != NULL) {
+            if (strncmp(p_ent->d_name, "node", 4) == 0 &&
+                p_ent->d_name[4] >= '0' && p_ent->d_name[4] <= '9') {
+                g_topo_node[cpu] = atoi(p_ent->d_name + 4);
+                break;
+            }
+        }
+        closedir(p_dir);
+    }
+}
+
+static void ABTD_topo_init(void)
+{
+    int cpu;
+
+    ABTI_spinlock_acquire(&g_topo_lock);
+    if (g_topo_initialized == 0) {
+        long num_cpus = sysconf(_SC_NPROCESSORS_CONF);
+        g_topo_num_cpus = (num_cpus > 0) ? (int)num_cpus : 0;
+        g_topo_core = (int *)ABTU_malloc(sizeof(int) * (g_topo_num_cpus + 1));
+        g_topo_llc  = (int *)ABTU_malloc(sizeof(int) * (g_topo_num_cpus + 1));
+        g_topo_node = (int *)ABTU_malloc(sizeof(int) * (g_topo_num_cpus + 1));
+        for (cpu = 0; cpu < g_topo_num_cpus; cpu++) {
+            ABTD_topo_read_cpu(cpu);
+        }
+        ABTD_atomic_store_uint32(&g_topo_initialized, 1);
+    }
+    ABTI_spinlock_release(&g_topo_lock);
+}
+
+void ABTD_affinity_topology_finalize(void)
+{
+    if (g_topo_initialized == 0) return;
+
+    ABTU_free(g_topo_core);
+    ABTU_free(g_topo_llc);
+    ABTU_free(g_topo_node);
+    g_topo_core = NULL;
+    g_topo_llc  = NULL;
+    g_topo_node = NULL;
+    g_topo_num_cpus = 0;
+    g_topo_initialized = 0;
+}
+
+/* Return the number of NUMA nodes, i.e., the largest node ID plus one, or 0
+ * if it is unknown.  Only the node directory is read, so the CPU topology is
+ * not initialized. */
+int ABTD_affinity_get_num_nodes(void)
+{
+    int num_nodes = 0;
+    DIR *p_dir;
+    struct dirent *p_ent;
+
+    p_dir = opendir("/sys/devices/system/node");
+    if (p_dir) {
+        while ((p_ent = readdir(p_dir)) != NULL) {
+            if (strncmp(p_ent->d_name, "node", 4) == 0 &&
+                p_ent->d_name[4] >= '0' && p_ent->d_name[4] <= '9') {
+                int node = atoi(p_ent->d_name + 4);
+                if (node + 1 > num_nodes) num_nodes = node + 1;
+            }
+        }
+        closedir(p_dir);
+    }
+    return num_nodes;
+}
+
+/* Return the NUMA node of cpu, or -1 if it is unknown. */
+int ABTD_affinity_get_node(int cpu)
+{
+    if (ABTD_atomic_load_uint32(&g_topo_initialized) == 0) {
+        ABTD_topo_init();
+    }
+
+    if (cpu < 0 || cpu >= g_topo_num_cpus) return -1;
+    return g_topo_node[cpu];
+}
+
+/* Return the NUMA node that contains all the CPUs the calling ES may run on,
+ * or -1 if they span several nodes or the node is unknown.  An unbound ES can
+ * be moved across nodes by the OS, so it has no node. */
+int ABTD_affinity_get_self_node(void)
+{
+    int node = -1;
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+    int cpu;
+    cpu_set_t cpuset;
+
+    if (ABTD_atomic_load_uint32(&g_topo_initialized) == 0) {
+        ABTD_topo_init();
+    }
+    if (pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset)) {
+        return -1;
+    }
+    for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &cpuset)) continue;
+        if (cpu >= g_topo_num_cpus || g_topo_node[cpu] == -1) return -1;
+        if (node == -1) {
+            node = g_topo_node[cpu];
+        } else if (node != g_topo_node[cpu]) {
+            return -1;
+        }
+    }
+#endif
+    return node;
+}
+
+/* Return how far cpu2 is from cpu1 (ABTD_AFFINITY_DIST_XXX). */
+int ABTD_affinity_get_distance(int cpu1, int cpu2)
+{
+    if (ABTD_atomic_load_uint32(&g_topo_initialized) == 0) {
+        ABTD_topo_init();
+    }
+
+    if (cpu1 < 0 || cpu2 < 0 ||
+        cpu1 >= g_topo_num_cpus || cpu2 >= g_topo_num_cpus) {
+        return ABTD_AFFINITY_DIST_REMOTE;
+    }
+    if (cpu1 == cpu2 ||
+        (g_topo_core[cpu1] != -1 && g_topo_core[cpu1] == g_topo_core[cpu2])) {
+        return ABTD_AFFINITY_DIST_SMT;
+    }
+    if (g_topo_llc[cpu1] != -1 && g_topo_llc[cpu1] == g_topo_llc[cpu2]) {
+        return ABTD_AFFINITY_DIST_LLC;
+    }
+    /* Without NUMA information, all CPUs are on the same node. */
+    if (g_topo_node[cpu1] == g_topo_node[cpu2]) {
+        return ABTD_AFFINITY_DIST_NODE;
+    }
+    return ABTD_AFFINITY_DIST_REMOTE;
+}
@@ -10,15 +10,26 @@
 #define ABTD_KEY_TABLE_DEFAULT_SIZE     4
 #define ABTD_THREAD_DEFAULT_STACKSIZE   16384
 #define ABTD_SCHED_DEFAULT_STACKSIZE    (4*1024*1024)
+#define ABTD_COPY_DEFAULT_STACKSIZE     (1024*1024)
 #define ABTD_SCHED_EVENT_FREQ           50
 #define ABTD_SCHED_SLEEP_NSEC           100
+#define ABTD_SCHED_PARK_SPIN_USEC       50
+#define ABTD_SCHED_PARK_TIMEOUT_USEC    1000
+#define ABTD_TRACE_BUFFER_SIZE          65536
+#define ABTD_STACK_ADAPTIVE_PERCENTILE  100
+#define ABTD_STACK_ADAPTIVE_SAMPLES     16
 
 #define ABTD_OS_PAGE_SIZE               (4*1024)
 #define ABTD_HUGE_PAGE_SIZE             (2*1024*1024)
 #define ABTD_MEM_PAGE_SIZE              (2*1024*1024)
 #define ABTD_MEM_STACK_PAGE_SIZE        (8*1024*1024)
 #define ABTD_MEM_MAX_NUM_STACKS         65536
+#define ABTD_MEM_STACK_SIZES            "65536,262144,1048576"
+#define ABTD_MEM_TRIM_INTERVAL_MSEC     10000
 
+#ifdef ABT_CONFIG_USE_MEM_POOL
+static void ABTD_env_add_stack_class(ABTI_global *p_global, size_t stacksize);
+#endif
 
 void ABTD_env_init(ABTI_global *p_global)
 {
@@ -130,6 +141,50 @@ void ABTD_env_init(ABTI_global *p_global)
         p_global->sched_sleep_nsec = ABTD_SCHED_SLEEP_NSEC;
     }
 
+#ifdef ABT_CONFIG_USE_SCHED_PARK
+    /* Idle microseconds before the scheduler parks */
+    env = getenv("ABT_SCHED_PARK_SPIN_USEC");
+    if (env == NULL) env = getenv("ABT_ENV_SCHED_PARK_SPIN_USEC");
+    if (env != NULL) {
+        p_global->sched_park_spin_usec = (uint32_t)atol(env);
+    } else {
+        p_global->sched_park_spin_usec = ABTD_SCHED_PARK_SPIN_USEC;
+    }
+
+    /* Maximum microseconds of each parking */
+    env = getenv("ABT_SCHED_PARK_TIMEOUT_USEC");
+    if (env == NULL) env = getenv("ABT_ENV_SCHED_PARK_TIMEOUT_USEC");
+    if (env != NULL) {
+        p_global->sched_park_timeout_usec = (uint32_t)atol(env);
+        ABTI_ASSERT(p_global->sched_park_timeout_usec >= 1);
+    } else {
+        p_global->sched_park_timeout_usec = ABTD_SCHED_PARK_TIMEOUT_USEC;
+    }
+#endif
+
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
+    /* Whether tasklets run on lent stacks so that they can suspend */
+    p_global->task_blockable = ABT_FALSE;
+    env = getenv("ABT_TASK_BLOCKABLE");
+    if (env == NULL) env = getenv("ABT_ENV_TASK_BLOCKABLE");
+    if (env != NULL) {
+        if (strcmp(env, "1") == 0 || strcasecmp(env, "yes") == 0 ||
+            strcasecmp(env, "y") == 0) {
+            p_global->task_blockable = ABT_TRUE;
+        }
+    }
+
+    /* Stack size shared by stack-copying ULTs */
+    env = getenv("ABT_COPY_STACKSIZE");
+    if (env == NULL) env = getenv("ABT_ENV_COPY_STACKSIZE");
+    if (env != NULL) {
+        p_global->copy_stacksize = (size_t)atol(env);
+        ABTI_ASSERT(p_global->copy_stacksize >= 512);
+    } else {
+        p_global->copy_stacksize = ABTD_COPY_DEFAULT_STACKSIZE;
+    }
+#endif
+
     /* Mutex attributes */
     env = getenv("ABT_MUTEX_MAX_HANDOVERS");
     if (env == NULL) env = getenv("ABT_ENV_MUTEX_MAX_HANDOVERS");
@@ -195,6 +250,70 @@ void ABTD_env_init(ABTI_global *p_global)
         p_global->mem_max_stacks = ABTD_MEM_MAX_NUM_STACKS;
     }
 
+    /* Stack sizes pooled by the stack pool.  The default ULT stack size is
+     * always pooled.  Stacks that are not of these sizes are rounded up to the
+     * closest one, and stacks larger than all of them are allocated by
+     * malloc(). */
+    env = getenv("ABT_MEM_STACK_SIZES");
+    if (env == NULL) env = getenv("ABT_ENV_MEM_STACK_SIZES");
+    if (env == NULL) env = ABTD_MEM_STACK_SIZES;
+    p_global->mem_num_stack_classes = 0;
+    ABTD_env_add_stack_class(p_global, p_global->thread_stacksize);
+    while (*env != '\0') {
+        char *p_end;
+        size_t stacksize = (size_t)strtoul(env, &p_end, 0);
+        if (p_end == env) break;
+        ABTD_env_add_stack_class(p_global, stacksize);
+        env = (*p_end == ',') ? p_end + 1 : p_end;
+    }
+
+    /* Milliseconds that free stacks stay unused before their memory is
+     * released.  0 disables the periodic trimming. */
+    env = getenv("ABT_MEM_TRIM_INTERVAL_MSEC");
+    if (env == NULL) env = getenv("ABT_ENV_MEM_TRIM_INTERVAL_MSEC");
+    if (env != NULL) {
+        p_global->mem_trim_nsec = (uint64_t)atol(env) * 1000000;
+    } else {
+        p_global->mem_trim_nsec = (uint64_t)ABTD_MEM_TRIM_INTERVAL_MSEC
+                                * 1000000;
+    }
+
+    /* Whether to put a guard page at the bottom of each pooled stack */
+    p_global->mem_stack_guard = ABT_FALSE;
+    env = getenv("ABT_MEM_STACK_GUARD");
+    if (env == NULL) env = getenv("ABT_ENV_MEM_STACK_GUARD");
+    if (env != NULL) {
+        if (strcmp(env, "1") == 0 || strcasecmp(env, "yes") == 0 ||
+            strcasecmp(env, "y") == 0) {
+            p_global->mem_stack_guard = ABT_TRUE;
+        }
+    }
+
+    /* Whether to place stacks and pages on the NUMA node of the ES that
+     * allocates them and to keep a global free list per node.  Only ESs whose
+     * affinity lies within one node use it.  It is useless on a single-node
+     * machine. */
+    p_global->mem_numa = ABT_TRUE;
+    env = getenv("ABT_MEM_NUMA");
+    if (env == NULL) env = getenv("ABT_ENV_MEM_NUMA");
+    if (env != NULL) {
+        if (strcmp(env, "0") == 0 || strcasecmp(env, "n") == 0 ||
+            strcasecmp(env, "no") == 0) {
+            p_global->mem_numa = ABT_FALSE;
+        }
+    }
+    p_global->mem_num_nodes = 1;
+    if (p_global->mem_numa == ABT_TRUE) {
+        int num_nodes = ABTD_affinity_get_num_nodes();
+        if (num_nodes > 1) {
+            /* One more list is shared by ESs that have no node. */
+            p_global->mem_num_nodes = (num_nodes < ABTI_MEM_MAX_NODES - 1)
+                                    ? num_nodes + 1 : ABTI_MEM_MAX_NODES;
+        } else {
+            p_global->mem_numa = ABT_FALSE;
+        }
+    }
+
     /* How to allocate large pages.  The default is to use mmap() for huge
      * pages and then to fall back to allocate regular pages using mmap() when
      * huge pages are run out of. */
@@ -236,6 +355,16 @@ void ABTD_env_init(ABTI_global *p_global)
         }
     }
 
+    /* Guard pages cannot be set up in hugetlb pages, so stack guards fall back
+     * to regular pages or THP. */
+    if (p_global->mem_stack_guard == ABT_TRUE) {
+        if (lp_alloc == ABTI_MEM_LP_MMAP_HP_RP) {
+            lp_alloc = ABTI_MEM_LP_MMAP_RP;
+        } else if (lp_alloc == ABTI_MEM_LP_MMAP_HP_THP) {
+            lp_alloc = ABTI_MEM_LP_THP;
+        }
+    }
+
     /* Check if the requested allocation method is really possible. */
     if (lp_alloc != ABTI_MEM_LP_MALLOC) {
         p_global->mem_lp_alloc = ABTI_mem_check_lp_alloc(lp_alloc);
@@ -258,7 +387,121 @@ void ABTD_env_init(ABTI_global *p_global)
         p_global->print_config = ABT_FALSE;
     }
 
+    /* Whether to measure the stack usage of ULTs for each function */
+    p_global->stack_watermark = ABT_FALSE;
+    env = getenv("ABT_STACK_WATERMARK");
+    if (env == NULL) env = getenv("ABT_ENV_STACK_WATERMARK");
+    if (env != NULL) {
+        if (strcmp(env, "1") == 0 || strcasecmp(env, "yes") == 0 ||
+            strcasecmp(env, "y") == 0) {
+            p_global->stack_watermark = ABT_TRUE;
+        }
+    }
+
+    /* Whether to choose the stack sizes of ULTs from the measured usage of
+     * their functions.  It needs the stack size classes of the memory pool
+     * and enables the measurement. */
+    p_global->stack_adaptive = ABT_FALSE;
+#ifdef ABT_CONFIG_USE_MEM_POOL
+    env = getenv("ABT_STACK_ADAPTIVE");
+    if (env == NULL) env = getenv("ABT_ENV_STACK_ADAPTIVE");
+    if (env != NULL) {
+        if (strcmp(env, "1") == 0 || strcasecmp(env, "yes") == 0 ||
+            strcasecmp(env, "y") == 0) {
+            p_global->stack_adaptive = ABT_TRUE;
+            p_global->stack_watermark = ABT_TRUE;
+        }
+    }
+#endif
+
+    /* Percentile of the measured usage that the chosen stack size covers */
+    env = getenv("ABT_STACK_ADAPTIVE_PERCENTILE");
+    if (env == NULL) env = getenv("ABT_ENV_STACK_ADAPTIVE_PERCENTILE");
+    if (env != NULL) {
+        p_global->stack_adaptive_pct = (uint32_t)atol(env);
+        ABTI_ASSERT(p_global->stack_adaptive_pct >= 1 &&
+                    p_global->stack_adaptive_pct <= 100);
+    } else {
+        p_global->stack_adaptive_pct = ABTD_STACK_ADAPTIVE_PERCENTILE;
+    }
+
+    /* Number of samples needed before a stack size is chosen */
+    env = getenv("ABT_STACK_ADAPTIVE_SAMPLES");
+    if (env == NULL) env = getenv("ABT_ENV_STACK_ADAPTIVE_SAMPLES");
+    if (env != NULL) {
+        p_global->stack_adaptive_samples = (uint32_t)atol(env);
+    } else {
+        p_global->stack_adaptive_samples = ABTD_STACK_ADAPTIVE_SAMPLES;
+    }
+    if (p_global->stack_adaptive_samples == 0) {
+        p_global->stack_adaptive_samples = 1;
+    }
+
+#ifdef ABT_CONFIG_USE_TRACE
+    /* Number of trace events kept per ES (rounded up to a power of two) */
+    env = getenv("ABT_TRACE_BUFFER_SIZE");
+    if (env == NULL) env = getenv("ABT_ENV_TRACE_BUFFER_SIZE");
+    uint64_t trace_buffer_size = ABTD_TRACE_BUFFER_SIZE;
+    if (env != NULL) trace_buffer_size = (uint64_t)atoll(env);
+    p_global->trace_buffer_size = 0;
+    if (trace_buffer_size > 0) {
+        p_global->trace_buffer_size = 1;
+        while (p_global->trace_buffer_size < trace_buffer_size) {
+            p_global->trace_buffer_size <<= 1;
+        }
+    }
+
+    /* File to which the trace is written on ABT_finalize() */
+    env = getenv("ABT_TRACE_FILE");
+    if (env == NULL) env = getenv("ABT_ENV_TRACE_FILE");
+    if (env != NULL && env[0] != '\0') {
+        p_global->trace_file = (char *)ABTU_malloc(strlen(env) + 1);
+        ABTU_strcpy(p_global->trace_file, env);
+    } else {
+        p_global->trace_file = NULL;
+    }
+#endif
+
+    /* Whether to use the invariant TSC for timing */
+    ABT_bool use_tsc = ABT_TRUE;
+    env = getenv("ABT_USE_TSC");
+    if (env == NULL) env = getenv("ABT_ENV_USE_TSC");
+    if (env != NULL) {
+        if (strcmp(env, "0") == 0 || strcasecmp(env, "n") == 0 ||
+            strcasecmp(env, "no") == 0) {
+            use_tsc = ABT_FALSE;
+        }
+    }
+
     /* Init timer */
-    ABTD_time_init();
+    ABTD_time_init(use_tsc);
 }
 
+
+/*****************************************************************************/
+/* Internal static functions                                                 */
+/*****************************************************************************/
+
+#ifdef ABT_CONFIG_USE_MEM_POOL
+/* Insert stacksize into the sorted stack size classes.  It is rounded up to
+ * the cache line size so that the stacks carved out of a stack page are
+ * aligned.  Sizes that do not fit in a stack page are ignored. */
+static void ABTD_env_add_stack_class(ABTI_global *p_global, size_t stacksize)
+{
+    size_t *classes = p_global->mem_stack_classes;
+    uint32_t num = p_global->mem_num_stack_classes;
+    uint32_t i;
+
+    stacksize = (stacksize + ABT_CONFIG_STATIC_CACHELINE_SIZE - 1)
+              / ABT_CONFIG_STATIC_CACHELINE_SIZE
+              * ABT_CONFIG_STATIC_CACHELINE_SIZE;
+    if (stacksize == 0 || stacksize > p_global->mem_sp_size) return;
+    if (num == ABTI_MEM_MAX_STACK_CLASSES) return;
+
+    for (i = 0; i < num && classes[i] < stacksize; i++);
+    if (i < num && classes[i] == stacksize) return;
+    memmove(&classes[i + 1], &classes[i], sizeof(size_t) * (num - i));
+    classes[i] = stacksize;
+    p_global->mem_num_stack_classes = num + 1;
+}
+#endif
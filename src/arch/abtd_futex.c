@@ -0,0 +1,110 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+#if defined(HAVE_LINUX_FUTEX_H) && defined(HAVE_SYS_SYSCALL_H)
+#define ABTD_USE_FUTEX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#define ABTD_FUTEX_POLL_NSEC    50000
+#endif
+
+/* How many times a signal word is polled before the native thread blocks */
+#define ABTD_FUTEX_SIGNAL_SPIN  1024
+
+/* Values of a signal word */
+#define ABTD_FUTEX_SIGNAL_UNSET     0
+#define ABTD_FUTEX_SIGNAL_SET       1
+#define ABTD_FUTEX_SIGNAL_BLOCKED   2
+
+/* Block the calling native thread while *p_addr is equal to val, for at most
+ * timeout_nsec nanoseconds (UINT64_MAX means no timeout).  The caller must
+ * check the condition again after return because this function may return
+ * spuriously. */
+void ABTD_futex_wait(uint32_t *p_addr, uint32_t val, uint64_t timeout_nsec)
+{
+#ifdef ABTD_USE_FUTEX
+    struct timespec ts, *p_ts = NULL;
+    if (timeout_nsec != UINT64_MAX) {
+        ts.tv_sec  = (time_t)(timeout_nsec / 1000000000);
+        ts.tv_nsec = (long)(timeout_nsec % 1000000000);
+        p_ts = &ts;
+    }
+    syscall(SYS_futex, p_addr, FUTEX_WAIT_PRIVATE, val, p_ts, NULL, 0);
+#else
+    /* Poll the value with short sleeps. */
+    struct timespec ts = { 0, ABTD_FUTEX_POLL_NSEC };
+    uint64_t slept = 0;
+    while (ABTD_atomic_load_uint32(p_addr) == val && slept < timeout_nsec) {
+        nanosleep(&ts, NULL);
+        slept += ABTD_FUTEX_POLL_NSEC;
+    }
+#endif
+}
+
+/* Wake up at most num_waiters native threads blocked on p_addr. */
+void ABTD_futex_wake(uint32_t *p_addr, int num_waiters)
+{
+#ifdef ABTD_USE_FUTEX
+    syscall(SYS_futex, p_addr, FUTEX_WAKE_PRIVATE, num_waiters, NULL, NULL, 0);
+#else
+    ABTI_UNUSED(p_addr);
+    ABTI_UNUSED(num_waiters);
+#endif
+}
+
+/* Wait until the signal word *p_signal, which is initially 0, is set by
+ * ABTD_futex_signal_set() or the time of ABTD_time_get() reaches
+ * deadline_nsec (UINT64_MAX means no timeout).  The word is polled for a
+ * while, and then the native thread is blocked.  Returns ABT_TRUE if it has
+ * been set. */
+ABT_bool ABTD_futex_signal_wait_until(uint32_t *p_signal,
+                                      uint64_t deadline_nsec)
+{
+    ABTD_time now;
+    uint32_t val;
+    int i;
+
+    for (i = 0; i < ABTD_FUTEX_SIGNAL_SPIN; i++) {
+        if (ABTD_atomic_load_uint32(p_signal) == ABTD_FUTEX_SIGNAL_SET) {
+            return ABT_TRUE;
+        }
+        ABTD_atomic_pause();
+    }
+
+    /* Tell the setter that it needs to wake this thread up. */
+    val = ABTD_atomic_val_cas_strong_uint32(p_signal, ABTD_FUTEX_SIGNAL_UNSET,
+                                            ABTD_FUTEX_SIGNAL_BLOCKED);
+    while (val != ABTD_FUTEX_SIGNAL_SET) {
+        uint64_t timeout_nsec = UINT64_MAX;
+        if (deadline_nsec != UINT64_MAX) {
+            ABTD_time_get(&now);
+            if (ABTD_time_read_nsec(&now) >= deadline_nsec) return ABT_FALSE;
+            timeout_nsec = deadline_nsec - ABTD_time_read_nsec(&now);
+        }
+        ABTD_futex_wait(p_signal, ABTD_FUTEX_SIGNAL_BLOCKED, timeout_nsec);
+        val = ABTD_atomic_load_uint32(p_signal);
+    }
+    return ABT_TRUE;
+}
+
+/* Wait until the signal word *p_signal is set, without a timeout. */
+void ABTD_futex_signal_wait(uint32_t *p_signal)
+{
+    ABTD_futex_signal_wait_until(p_signal, UINT64_MAX);
+}
+
+/* Set the signal word *p_signal and wake up its waiter if it is blocked.  The
+ * waiter may return and release the word before the wakeup, which only causes
+ * a spurious wakeup of a later user of the same address. */
+void ABTD_futex_signal_set(uint32_t *p_signal)
+{
+    uint32_t val = ABTD_atomic_exchange_uint32(p_signal,
+                                               ABTD_FUTEX_SIGNAL_SET);
+    if (val == ABTD_FUTEX_SIGNAL_BLOCKED) ABTD_futex_wake(p_signal, 1);
+}
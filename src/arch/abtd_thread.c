@@ -61,15 +61,27 @@ static inline void ABTDI_thread_terminate(ABTI_local *p_local,
                                           ABTI_thread *p_thread,
                                           ABT_bool is_sched)
 {
+    /* A ULT that has lent its stack to tasklets is not measured. */
+    if (gp_ABTI_global->stack_watermark == ABT_TRUE && is_sched == ABT_FALSE &&
+        p_thread->type == ABTI_THREAD_TYPE_USER) {
+        ABTI_stack_usage_record(p_thread);
+    }
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
+    if (ABTI_thread_is_stack_copy(p_thread)) {
+        ABTI_thread_release_copy_stack(p_local, p_thread);
+    }
+#endif
     ABTD_thread_context *p_ctx = &p_thread->ctx;
     ABTD_thread_context *p_link = (ABTD_thread_context *)
         ABTD_atomic_load_ptr((void **)&p_ctx->p_link);
     if (p_link) {
         /* If p_link is set, it means that other ULT has called the join. */
         ABTI_thread *p_joiner = (ABTI_thread *)p_link;
-        if (p_thread->p_last_xstream == p_joiner->p_last_xstream) {
+        if (p_thread->p_last_xstream == p_joiner->p_last_xstream &&
+            !ABTI_thread_is_stack_copy(p_joiner)) {
             /* Only when the current ULT is on the same ES as p_joiner's,
-             * we can jump to the joiner ULT. */
+             * we can jump to the joiner ULT.  A stack-copying joiner is
+             * resumed by the scheduler. */
             ABTD_atomic_store_uint32((uint32_t *)&p_thread->state,
                                      ABT_THREAD_STATE_TERMINATED);
             LOG_EVENT("[U%" PRIu64 ":E%d] terminated\n",
@@ -156,7 +168,7 @@ static inline void ABTD_thread_terminate_sched(ABTI_local *p_local,
     ABTDI_thread_terminate(p_local, p_thread, ABT_TRUE);
 }
 
-#if ABT_CONFIG_THREAD_TYPE == ABT_THREAD_TYPE_DYNAMIC_PROMOTION
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
 void ABTD_thread_terminate_thread_no_arg()
 {
     ABTI_local *p_local = ABTI_local_get_local();
@@ -176,6 +188,13 @@ void ABTD_thread_cancel(ABTI_local *p_local, ABTI_thread *p_thread)
      * context switch to the joiner ULT and need to always wake it up. */
     ABTD_thread_context *p_ctx = &p_thread->ctx;
 
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
+    /* The saved frames of a stack-copying ULT are discarded. */
+    if (ABTI_thread_is_stack_copy(p_thread)) {
+        ABTI_thread_release_copy_stack(p_local, p_thread);
+    }
+#endif
+
     /* acquire load is not needed here. */
     if (p_ctx->p_link) {
         /* If p_link is set, it means that other ULT has called the join. */
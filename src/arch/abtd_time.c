@@ -4,49 +4,117 @@
  */
 
 #include "abti.h"
+#if defined(__x86_64__)
+#include <cpuid.h>
+#endif
+
+/* How long the tick rate is measured if it is not reported by the CPU */
+#define ABTD_TIME_TSC_CALIB_NSEC    5000000
+
+ABTD_time_tsc_clock g_ABTD_time_tsc;
 
 #if defined(ABT_CONFIG_USE_MACH_ABSOLUTE_TIME)
 static double g_time_mult = 0.0;
 #endif
-void ABTD_time_init(void)
-{
-#if defined(ABT_CONFIG_USE_MACH_ABSOLUTE_TIME)
-    mach_timebase_info_data_t info;
-    mach_timebase_info(&info);
-    g_time_mult = 1.0e-9 * ((double)info.numer / (double)info.denom);
-#endif
-}
 
-/* Obtain the time value */
-int ABTD_time_get(ABTD_time *p_time)
+/* Obtain the time of the OS monotonic clock in nanoseconds */
+uint64_t ABTD_time_get_os_nsec(void)
 {
-    int abt_errno = ABT_SUCCESS;
-
 #if defined(ABT_CONFIG_USE_CLOCK_GETTIME)
-    clock_gettime(CLOCK_REALTIME, p_time);
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
 #elif defined(ABT_CONFIG_USE_MACH_ABSOLUTE_TIME)
-    *p_time = mach_absolute_time();
+    if (g_time_mult == 0.0) {
+        mach_timebase_info_data_t info;
+        mach_timebase_info(&info);
+        g_time_mult = (double)info.numer / (double)info.denom;
+    }
+    return (uint64_t)(mach_absolute_time() * g_time_mult);
 #elif defined(ABT_CONFIG_USE_GETTIMEOFDAY)
-    gettimeofday(p_time, NULL);
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint64_t)tv.tv_sec * 1000000000 + (uint64_t)tv.tv_usec * 1000;
 #endif
-
-    return abt_errno;
 }
 
-/* Read the time value as seconds (double precision) */
-double ABTD_time_read_sec(ABTD_time *p_time)
+/* Obtain the wall-clock time (i.e., the time of CLOCK_REALTIME) in seconds */
+double ABTD_time_get_realtime_sec(void)
 {
-    double secs;
+#if defined(HAVE_CLOCK_GETTIME)
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ((double)ts.tv_sec) + 1.0e-9 * ((double)ts.tv_nsec);
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return ((double)tv.tv_sec) + 1.0e-6 * ((double)tv.tv_usec);
+#endif
+}
 
-#if defined(ABT_CONFIG_USE_CLOCK_GETTIME)
-    secs = ((double)p_time->tv_sec) + 1.0e-9 * ((double)p_time->tv_nsec);
-#elif defined(ABT_CONFIG_USE_MACH_ABSOLUTE_TIME)
-    if (g_time_mult == 0.0) ABTD_time_init();
-    secs = *p_time * g_time_mult;
-#elif defined(ABT_CONFIG_USE_GETTIMEOFDAY)
-    secs = ((double)p_time->tv_sec) + 1.0e-6 * ((double)p_time->tv_usec);
+#ifdef ABTD_TIME_USE_TSC
+/* Check whether the tick counter runs at a constant rate.  The rate is set to
+ * *p_freq if the CPU reports it, and 0 otherwise. */
+static ABT_bool ABTD_time_tsc_is_invariant(uint64_t *p_freq)
+{
+#if defined(__x86_64__)
+    unsigned int eax, ebx, ecx, edx;
+    *p_freq = 0;
+    if (!__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) ||
+        eax < 0x80000007) {
+        return ABT_FALSE;
+    }
+    __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+    return (edx & (1 << 8)) ? ABT_TRUE : ABT_FALSE;
+#elif defined(__aarch64__)
+    uint64_t freq;
+    __asm__ __volatile__ ("mrs %0, cntfrq_el0" : "=r" (freq));
+    *p_freq = freq;
+    return freq ? ABT_TRUE : ABT_FALSE;
 #endif
+}
 
-    return secs;
+/* Read the tick counter and the OS clock at the same moment. */
+static void ABTD_time_tsc_read_pair(uint64_t *p_tsc, uint64_t *p_nsec)
+{
+    uint64_t tsc_before = ABTD_tsc_read();
+    *p_nsec = ABTD_time_get_os_nsec();
+    uint64_t tsc_after = ABTD_tsc_read();
+    *p_tsc = tsc_before + (tsc_after - tsc_before) / 2;
 }
+#endif
 
+void ABTD_time_init(ABT_bool use_tsc)
+{
+#ifdef ABTD_TIME_USE_TSC
+    uint64_t freq, tsc0, nsec0, tsc1, nsec1, mult;
+
+    if (use_tsc == ABT_FALSE) {
+        ABTD_atomic_store_uint32(&g_ABTD_time_tsc.enabled, 0);
+        return;
+    }
+    /* The tick rate is measured only once per process. */
+    if (ABTD_atomic_load_uint32(&g_ABTD_time_tsc.enabled)) return;
+    if (ABTD_time_tsc_is_invariant(&freq) == ABT_FALSE) return;
+
+    ABTD_time_tsc_read_pair(&tsc0, &nsec0);
+    if (freq == 0) {
+        do {
+            ABTD_time_tsc_read_pair(&tsc1, &nsec1);
+        } while (nsec1 - nsec0 < ABTD_TIME_TSC_CALIB_NSEC);
+        if (tsc1 <= tsc0) return;
+        mult = ((nsec1 - nsec0) << 32) / (tsc1 - tsc0);
+    } else {
+        tsc1 = tsc0;
+        nsec1 = nsec0;
+        mult = (UINT64_C(1000000000) << 32) / freq;
+    }
+
+    g_ABTD_time_tsc.tsc_base = tsc1;
+    g_ABTD_time_tsc.nsec_base = nsec1;
+    g_ABTD_time_tsc.mult = mult;
+    ABTD_atomic_store_uint32(&g_ABTD_time_tsc.enabled, 1);
+#else
+    ABTI_UNUSED(use_tsc);
+#endif
+}
@@ -29,7 +29,8 @@ int ABT_barrier_create(uint32_t num_waiters, ABT_barrier *newbarrier)
     int abt_errno = ABT_SUCCESS;
     ABTI_barrier *p_newbarrier;
 
-    p_newbarrier = (ABTI_barrier *)ABTU_malloc(sizeof(ABTI_barrier));
+    p_newbarrier = (ABTI_barrier *)ABTI_mem_alloc_slab(ABTI_local_get_local(),
+                                                       sizeof(ABTI_barrier));
 
     ABTI_spinlock_clear(&p_newbarrier->lock);
     p_newbarrier->num_waiters = num_waiters;
@@ -118,7 +119,7 @@ int ABT_barrier_free(ABT_barrier *barrier)
 
     ABTU_free(p_barrier->waiters);
     ABTU_free(p_barrier->waiter_type);
-    ABTU_free(p_barrier);
+    ABTI_mem_free_slab(ABTI_local_get_local(), p_barrier);
 
     /* Return value */
     *barrier = ABT_BARRIER_NULL;
@@ -131,25 +132,61 @@ int ABT_barrier_free(ABT_barrier *barrier)
     goto fn_exit;
 }
 
-/**
- * @ingroup BARRIER
- * @brief   Wait on the barrier.
- *
- * The ULT calling \c ABT_barrier_wait() waits on the barrier until all the
- * ULTs reach the barrier.
- *
- * @param[in] barrier  handle to the barrier
- * @return Error code
- * @retval ABT_SUCCESS on success
- */
-int ABT_barrier_wait(ABT_barrier barrier)
+/* Remove p_waiter from the waiters of p_barrier.  Returns ABT_FALSE if all
+ * the waiters have been released. */
+static ABT_bool barrier_remove_waiter(ABTI_barrier *p_barrier,
+                                      ABTI_thread *p_waiter)
+{
+    ABT_bool removed = ABT_FALSE;
+    uint32_t i;
+
+    ABTI_spinlock_acquire(&p_barrier->lock);
+    for (i = 0; i < p_barrier->counter; i++) {
+        if (p_barrier->waiters[i] == p_waiter) {
+            /* Fill the hole with the last waiter. */
+            uint32_t last = --p_barrier->counter;
+            p_barrier->waiters[i] = p_barrier->waiters[last];
+            p_barrier->waiter_type[i] = p_barrier->waiter_type[last];
+            p_barrier->waiters[last] = NULL;
+            removed = ABT_TRUE;
+            break;
+        }
+    }
+    ABTI_spinlock_release(&p_barrier->lock);
+
+    return removed;
+}
+
+static ABT_bool barrier_remove_thread(ABTI_thread *p_thread, void *p_obj)
+{
+    return barrier_remove_waiter((ABTI_barrier *)p_obj, p_thread);
+}
+
+/* Wait until all the waiters reach p_barrier or the time reaches
+ * deadline_nsec.  deadline_nsec is UINT64_MAX if there is no timeout. */
+static int barrier_wait(ABTI_local **pp_local, ABTI_barrier *p_barrier,
+                        uint64_t deadline_nsec)
 {
     int abt_errno = ABT_SUCCESS;
-    ABTI_local *p_local = ABTI_local_get_local();
-    ABTI_barrier *p_barrier = ABTI_barrier_get_ptr(barrier);
-    ABTI_CHECK_NULL_BARRIER_PTR(p_barrier);
+    ABTI_local *p_local = *pp_local;
+    ABTI_thread *p_thread;
+    ABT_unit_type type;
+    uint32_t ext_signal = 0;
     uint32_t pos;
 
+    if (p_local != NULL) {
+        p_thread = p_local->p_thread;
+        if (p_thread == NULL) {
+            abt_errno = ABT_ERR_BARRIER;
+            goto fn_fail;
+        }
+        type = ABT_UNIT_TYPE_THREAD;
+    } else {
+        /* external thread */
+        p_thread = (ABTI_thread *)&ext_signal;
+        type = ABT_UNIT_TYPE_EXT;
+    }
+
     ABTI_spinlock_acquire(&p_barrier->lock);
 
     ABTI_ASSERT(p_barrier->counter < p_barrier->num_waiters);
@@ -157,23 +194,6 @@ int ABT_barrier_wait(ABT_barrier barrier)
 
     /* If we do not have all the waiters yet */
     if (p_barrier->counter < p_barrier->num_waiters) {
-        ABTI_thread *p_thread;
-        ABT_unit_type type;
-        int32_t ext_signal = 0;
-
-        if (p_local != NULL) {
-            p_thread = p_local->p_thread;
-            if (p_thread == NULL) {
-                abt_errno = ABT_ERR_BARRIER;
-                goto fn_fail;
-            }
-            type = ABT_UNIT_TYPE_THREAD;
-        } else {
-            /* external thread */
-            p_thread = (ABTI_thread *)&ext_signal;
-            type = ABT_UNIT_TYPE_EXT;
-        }
-
         /* Keep the waiter's information */
         p_barrier->waiters[pos] = p_thread;
         p_barrier->waiter_type[pos] = type;
@@ -187,11 +207,25 @@ int ABT_barrier_wait(ABT_barrier barrier)
 
         if (type == ABT_UNIT_TYPE_THREAD) {
             /* Suspend the current ULT */
-            ABTI_thread_suspend(&p_local, p_thread);
+            if (deadline_nsec == UINT64_MAX) {
+                ABTI_thread_suspend(pp_local, p_thread);
+            } else if (ABTI_thread_suspend_until(pp_local, p_thread,
+                                                 deadline_nsec,
+                                                 barrier_remove_thread,
+                                                 p_barrier) == ABT_TRUE) {
+                abt_errno = ABT_ERR_TIMEDOUT;
+            }
         } else {
-            /* External thread is waiting here polling ext_signal. */
-            /* FIXME: need a better implementation */
-            while (!ABTD_atomic_load_int32(&ext_signal));
+            /* External thread is blocked here until ext_signal is set. */
+            if (ABTD_futex_signal_wait_until(&ext_signal, deadline_nsec)
+                    == ABT_FALSE) {
+                if (barrier_remove_waiter(p_barrier, p_thread) == ABT_TRUE) {
+                    abt_errno = ABT_ERR_TIMEDOUT;
+                } else {
+                    /* All the waiters have reached it concurrently. */
+                    ABTD_futex_signal_wait(&ext_signal);
+                }
+            }
         }
     } else {
         /* Signal all the waiting ULTs */
@@ -202,8 +236,7 @@ int ABT_barrier_wait(ABT_barrier barrier)
                 ABTI_thread_set_ready(p_local, p_thread);
             } else {
                 /* When p_cur is an external thread */
-                int32_t *p_ext_signal = (int32_t *)p_thread;
-                ABTD_atomic_store_int32(p_ext_signal, 1);
+                ABTD_futex_signal_set((uint32_t *)p_thread);
             }
 
             p_barrier->waiters[i] = NULL;
@@ -223,6 +256,72 @@ int ABT_barrier_wait(ABT_barrier barrier)
     goto fn_exit;
 }
 
+/**
+ * @ingroup BARRIER
+ * @brief   Wait on the barrier.
+ *
+ * The ULT calling \c ABT_barrier_wait() waits on the barrier until all the
+ * ULTs reach the barrier.
+ *
+ * @param[in] barrier  handle to the barrier
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_barrier_wait(ABT_barrier barrier)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_local *p_local = ABTI_local_get_local();
+    ABTI_barrier *p_barrier = ABTI_barrier_get_ptr(barrier);
+    ABTI_CHECK_NULL_BARRIER_PTR(p_barrier);
+
+    abt_errno = barrier_wait(&p_local, p_barrier, UINT64_MAX);
+    ABTI_CHECK_ERROR(abt_errno);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup BARRIER
+ * @brief   Wait on the barrier with a timeout.
+ *
+ * \c ABT_barrier_timedwait() is the same as \c ABT_barrier_wait() except
+ * that it gives up waiting when the absolute time specified by \c abstime
+ * passes.  As with \c ABT_cond_timedwait(), \c abstime is based on
+ * \c CLOCK_REALTIME.  A waiter that has timed out is not counted as reaching
+ * the barrier, so the barrier still needs the given number of waiters.
+ *
+ * @param[in] barrier  handle to the barrier
+ * @param[in] abstime  absolute time for timeout
+ * @return Error code
+ * @retval ABT_SUCCESS       on success
+ * @retval ABT_ERR_TIMEDOUT  timeout
+ */
+int ABT_barrier_timedwait(ABT_barrier barrier, const struct timespec *abstime)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_local *p_local = ABTI_local_get_local();
+    ABTI_barrier *p_barrier = ABTI_barrier_get_ptr(barrier);
+    ABTI_CHECK_NULL_BARRIER_PTR(p_barrier);
+
+    abt_errno = barrier_wait(&p_local, p_barrier,
+                             ABTI_get_deadline_nsec(abstime));
+    /* A timeout is not an error of this routine. */
+    if (abt_errno == ABT_ERR_TIMEDOUT) goto fn_exit;
+    ABTI_CHECK_ERROR(abt_errno);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
 /**
  * @ingroup BARRIER
  * @brief   Get the number of waiters for the barrier.
@@ -29,7 +29,8 @@ int ABT_cond_create(ABT_cond *newcond)
     int abt_errno = ABT_SUCCESS;
     ABTI_cond *p_newcond;
 
-    p_newcond = (ABTI_cond *)ABTU_malloc(sizeof(ABTI_cond));
+    p_newcond = (ABTI_cond *)ABTI_mem_alloc_slab(ABTI_local_get_local(),
+                                                 sizeof(ABTI_cond));
     ABTI_cond_init(p_newcond);
 
     /* Return value */
@@ -60,7 +61,7 @@ int ABT_cond_free(ABT_cond *cond)
     ABTI_CHECK_TRUE(p_cond->num_waiters == 0, ABT_ERR_COND);
 
     ABTI_cond_fini(p_cond);
-    ABTU_free(p_cond);
+    ABTI_mem_free_slab(ABTI_local_get_local(), p_cond);
 
     /* Return value */
     *cond = ABT_COND_NULL;
@@ -112,24 +113,18 @@ int ABT_cond_wait(ABT_cond cond, ABT_mutex mutex)
 }
 
 
+/* Remove p_unit from the waiters of p_cond.  Returns ABT_FALSE if p_unit has
+ * already been removed by a signal. */
 static inline
-double convert_timespec_to_sec(const struct timespec *p_ts)
+ABT_bool remove_unit(ABTI_cond *p_cond, ABTI_unit *p_unit)
 {
-    double secs;
-    secs = ((double)p_ts->tv_sec) + 1.0e-9 * ((double)p_ts->tv_nsec);
-    return secs;
-}
-
-static inline
-void remove_unit(ABTI_cond *p_cond, ABTI_unit *p_unit)
-{
-    if (p_unit->p_next == NULL) return;
+    if (p_unit->p_next == NULL) return ABT_FALSE;
 
     ABTI_spinlock_acquire(&p_cond->lock);
 
     if (p_unit->p_next == NULL) {
         ABTI_spinlock_release(&p_cond->lock);
-        return ;
+        return ABT_FALSE;
     }
 
     /* If p_unit is still in the queue, we have to remove it. */
@@ -152,6 +147,12 @@ void remove_unit(ABTI_cond *p_cond, ABTI_unit *p_unit)
 
     p_unit->p_prev = NULL;
     p_unit->p_next = NULL;
+    return ABT_TRUE;
+}
+
+static ABT_bool remove_thread(ABTI_thread *p_thread, void *p_obj)
+{
+    return remove_unit((ABTI_cond *)p_obj, &p_thread->unit_def);
 }
 
 /**
@@ -161,7 +162,13 @@ void remove_unit(ABTI_cond *p_cond, ABTI_unit *p_unit)
  * The ULT calling \c ABT_cond_timedwait() waits on the condition variable
  * until it is signaled or the absolute time specified by \c abstime passes.
  * If system time equals or exceeds \c abstime before \c cond is signaled,
- * the error code \c ABT_ERR_COND_TIMEDOUT is returned.
+ * the error code \c ABT_ERR_COND_TIMEDOUT is returned.  As with
+ * \c pthread_cond_timedwait(), \c abstime is based on \c CLOCK_REALTIME, but
+ * it is converted into a timeout on a monotonic clock when this routine is
+ * called.
+ *
+ * A waiting ULT is blocked without polling the clock; it is woken up by the
+ * ES on which it started waiting when the timeout expires.
  *
  * The user should call this routine while the mutex specified as \c mutex is
  * locked. The mutex will be automatically released while waiting. After signal
@@ -186,14 +193,25 @@ int ABT_cond_timedwait(ABT_cond cond, ABT_mutex mutex,
     ABTI_mutex *p_mutex = ABTI_mutex_get_ptr(mutex);
     ABTI_CHECK_NULL_MUTEX_PTR(p_mutex);
 
-    double tar_time = convert_timespec_to_sec(abstime);
+    uint64_t deadline = ABTI_get_deadline_nsec(abstime);
 
+    ABTI_thread *p_thread = p_local ? p_local->p_thread : NULL;
     ABTI_unit *p_unit;
-    int32_t ext_signal = 0;
-
-    p_unit = (ABTI_unit *)ABTU_calloc(1, sizeof(ABTI_unit));
-    p_unit->pool = (ABT_pool)&ext_signal;
-    p_unit->type = ABT_UNIT_TYPE_EXT;
+    ABT_unit_type type;
+    uint32_t ext_signal = 0;
+
+    if (p_thread != NULL) {
+        type = ABT_UNIT_TYPE_THREAD;
+        p_unit = &p_thread->unit_def;
+        p_unit->handle.thread = ABTI_thread_get_handle(p_thread);
+        p_unit->type = type;
+    } else {
+        /* external thread or tasklet */
+        type = ABT_UNIT_TYPE_EXT;
+        p_unit = (ABTI_unit *)ABTU_calloc(1, sizeof(ABTI_unit));
+        p_unit->pool = (ABT_pool)&ext_signal;
+        p_unit->type = type;
+    }
 
     ABTI_spinlock_acquire(&p_cond->lock);
 
@@ -204,7 +222,8 @@ int ABT_cond_timedwait(ABT_cond cond, ABT_mutex mutex,
         if (result == ABT_FALSE) {
             ABTI_spinlock_release(&p_cond->lock);
             abt_errno = ABT_ERR_INV_MUTEX;
-            ABTU_free(p_unit);
+            if (type == ABT_UNIT_TYPE_EXT)
+                ABTU_free(p_unit);
             goto fn_fail;
         }
     }
@@ -224,27 +243,35 @@ int ABT_cond_timedwait(ABT_cond cond, ABT_mutex mutex,
 
     p_cond->num_waiters++;
 
-    ABTI_spinlock_release(&p_cond->lock);
+    if (type == ABT_UNIT_TYPE_THREAD) {
+        /* Change the ULT's state to BLOCKED */
+        ABTI_thread_set_blocked(p_thread);
 
-    /* Unlock the mutex that the calling ULT is holding */
-    ABTI_mutex_unlock(p_local, p_mutex);
+        ABTI_spinlock_release(&p_cond->lock);
+
+        /* Unlock the mutex that the calling ULT is holding */
+        ABTI_mutex_unlock(p_local, p_mutex);
 
-    while (!ABTD_atomic_load_int32(&ext_signal)) {
-        double cur_time = ABTI_get_wtime();
-        if (cur_time >= tar_time) {
-            remove_unit(p_cond, p_unit);
+        /* Suspend the current ULT until it is signaled or timed out */
+        if (ABTI_thread_suspend_until(&p_local, p_thread, deadline,
+                                      remove_thread, p_cond) == ABT_TRUE) {
             abt_errno = ABT_ERR_COND_TIMEDOUT;
-            break;
         }
-#ifndef ABT_CONFIG_DISABLE_EXT_THREAD
-        if (ABTI_self_get_type(p_local) != ABT_UNIT_TYPE_THREAD) {
-            ABTD_atomic_pause();
-            continue;
+    } else {
+        ABTI_spinlock_release(&p_cond->lock);
+        ABTI_mutex_unlock(p_local, p_mutex);
+
+        /* External thread is blocked here until ext_signal is set. */
+        if (ABTD_futex_signal_wait_until(&ext_signal, deadline) == ABT_FALSE) {
+            if (remove_unit(p_cond, p_unit) == ABT_TRUE) {
+                abt_errno = ABT_ERR_COND_TIMEDOUT;
+            } else {
+                /* It has been signaled concurrently. */
+                ABTD_futex_signal_wait(&ext_signal);
+            }
         }
-#endif
-        ABTI_thread_yield(&p_local, p_local->p_thread);
+        ABTU_free(p_unit);
     }
-    ABTU_free(p_unit);
 
     /* Lock the mutex again */
     ABTI_mutex_lock(&p_local, p_mutex);
@@ -307,8 +334,7 @@ int ABT_cond_signal(ABT_cond cond)
         ABTI_thread_set_ready(p_local, p_thread);
     } else {
         /* When the head is an external thread */
-        int32_t *p_ext_signal = (int32_t *)p_unit->pool;
-        ABTD_atomic_store_int32(p_ext_signal, 1);
+        ABTD_futex_signal_set((uint32_t *)p_unit->pool);
     }
 
     ABTI_spinlock_release(&p_cond->lock);
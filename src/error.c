@@ -80,11 +80,13 @@ int ABT_error_get_str(int err, char *str, size_t *len)
         "ABT_ERR_MIGRATION_TARGET",
         "ABT_ERR_MIGRATION_NA",
         "ABT_ERR_MISSING_JOIN",
-        "ABT_ERR_FEATURE_NA"
+        "ABT_ERR_FEATURE_NA",
+        "ABT_ERR_INV_QUERY_KIND",
+        "ABT_ERR_TIMEDOUT"
     };
 
     int abt_errno = ABT_SUCCESS;
-    ABTI_CHECK_TRUE(err >= ABT_SUCCESS && err <= ABT_ERR_FEATURE_NA,
+    ABTI_CHECK_TRUE(err >= ABT_SUCCESS && err <= ABT_ERR_TIMEDOUT,
                     ABT_ERR_OTHER);
     if (str) ABTU_strcpy(str, err_str[err]);
     if (len) *len = strlen(err_str[err]);
@@ -34,12 +34,17 @@ int ABT_eventual_create(int nbytes, ABT_eventual *neweventual)
 {
     int abt_errno = ABT_SUCCESS;
     ABTI_eventual *p_eventual;
+    /* The memory buffer follows the eventual. */
+    size_t value_offset = (sizeof(ABTI_eventual) + 15) / 16 * 16;
 
-    p_eventual = (ABTI_eventual *)ABTU_malloc(sizeof(ABTI_eventual));
+    p_eventual = (ABTI_eventual *)ABTI_mem_alloc_slab(ABTI_local_get_local(),
+                                                      value_offset + nbytes);
     ABTI_spinlock_clear(&p_eventual->lock);
     p_eventual->ready = ABT_FALSE;
     p_eventual->nbytes = nbytes;
-    p_eventual->value = (nbytes == 0) ? NULL : ABTU_malloc(nbytes);
+    p_eventual->value = (nbytes == 0) ? NULL
+                                      : (void *)((char *)p_eventual
+                                                 + value_offset);
     p_eventual->p_head = NULL;
     p_eventual->p_tail = NULL;
 
@@ -71,8 +76,7 @@ int ABT_eventual_free(ABT_eventual *eventual)
      * freed here. */
     ABTI_spinlock_acquire(&p_eventual->lock);
 
-    if (p_eventual->value) ABTU_free(p_eventual->value);
-    ABTU_free(p_eventual);
+    ABTI_mem_free_slab(ABTI_local_get_local(), p_eventual);
 
     *eventual = ABT_EVENTUAL_NULL;
 
@@ -84,40 +88,61 @@ int ABT_eventual_free(ABT_eventual *eventual)
     goto fn_exit;
 }
 
-/**
- * @ingroup EVENTUAL
- * @brief   Wait on the eventual.
- *
- * \c ABT_eventual_wait blocks the caller ULT until the eventual \c eventual
- * is resolved. If the eventual is not ready, the ULT calling this routine
- * suspends and goes to the state BLOCKED. Internally, an entry is created
- * per each blocked ULT to be awaken when the eventual is signaled.
- * If the eventual is ready, the pointer pointed to by \c value will point to
- * the memory buffer associated with the eventual. The system keeps a list of
- * all the ULTs waiting on the eventual.
- *
- * @param[in]  eventual handle to the eventual
- * @param[out] value    pointer to the memory buffer of the eventual
- * @return Error code
- * @retval ABT_SUCCESS on success
- */
-int ABT_eventual_wait(ABT_eventual eventual, void **value)
+/* Remove p_unit from the waiters of p_eventual.  Returns ABT_FALSE if p_unit
+ * has already been woken up. */
+static ABT_bool eventual_remove_unit(ABTI_eventual *p_eventual,
+                                     ABTI_unit *p_unit)
+{
+    ABT_bool removed = ABT_FALSE;
+
+    ABTI_spinlock_acquire(&p_eventual->lock);
+    if (p_unit->p_prev != NULL || p_eventual->p_head == p_unit) {
+        if (p_unit->p_prev) {
+            p_unit->p_prev->p_next = p_unit->p_next;
+        } else {
+            p_eventual->p_head = p_unit->p_next;
+        }
+        if (p_unit->p_next) {
+            p_unit->p_next->p_prev = p_unit->p_prev;
+        } else {
+            p_eventual->p_tail = p_unit->p_prev;
+        }
+        p_unit->p_prev = NULL;
+        p_unit->p_next = NULL;
+        removed = ABT_TRUE;
+    }
+    ABTI_spinlock_release(&p_eventual->lock);
+
+    return removed;
+}
+
+static ABT_bool eventual_remove_thread(ABTI_thread *p_thread, void *p_obj)
+{
+    return eventual_remove_unit((ABTI_eventual *)p_obj, &p_thread->unit_def);
+}
+
+/* Wait until p_eventual becomes ready or the time reaches deadline_nsec.
+ * deadline_nsec is UINT64_MAX if there is no timeout. */
+static int eventual_wait(ABTI_local **pp_local, ABTI_eventual *p_eventual,
+                         void **value, uint64_t deadline_nsec)
 {
     int abt_errno = ABT_SUCCESS;
-    ABTI_local *p_local = ABTI_local_get_local();
-    ABTI_eventual *p_eventual = ABTI_eventual_get_ptr(eventual);
-    ABTI_CHECK_NULL_EVENTUAL_PTR(p_eventual);
+    ABTI_local *p_local = *pp_local;
 
     ABTI_spinlock_acquire(&p_eventual->lock);
     if (p_eventual->ready == ABT_FALSE) {
         ABTI_thread *p_current;
         ABTI_unit *p_unit;
         ABT_unit_type type;
-        int32_t ext_signal = 0;
+        uint32_t ext_signal = 0;
 
         if (p_local != NULL) {
             p_current = p_local->p_thread;
-            ABTI_CHECK_TRUE(p_current != NULL, ABT_ERR_EVENTUAL);
+            if (p_current == NULL) {
+                ABTI_spinlock_release(&p_eventual->lock);
+                abt_errno = ABT_ERR_EVENTUAL;
+                goto fn_fail;
+            }
 
             type = ABT_UNIT_TYPE_THREAD;
             p_unit = &p_current->unit_def;
@@ -132,6 +157,7 @@ int ABT_eventual_wait(ABT_eventual eventual, void **value)
         }
 
         p_unit->p_next = NULL;
+        p_unit->p_prev = p_eventual->p_tail;
         if (p_eventual->p_head == NULL) {
             p_eventual->p_head = p_unit;
             p_eventual->p_tail = p_unit;
@@ -146,20 +172,108 @@ int ABT_eventual_wait(ABT_eventual eventual, void **value)
             ABTI_spinlock_release(&p_eventual->lock);
 
             /* Suspend the current ULT */
-            ABTI_thread_suspend(&p_local, p_current);
+            if (deadline_nsec == UINT64_MAX) {
+                ABTI_thread_suspend(pp_local, p_current);
+            } else if (ABTI_thread_suspend_until(pp_local, p_current,
+                                                 deadline_nsec,
+                                                 eventual_remove_thread,
+                                                 p_eventual) == ABT_TRUE) {
+                abt_errno = ABT_ERR_TIMEDOUT;
+            }
 
         } else {
             ABTI_spinlock_release(&p_eventual->lock);
 
-            /* External thread is waiting here polling ext_signal. */
-            /* FIXME: need a better implementation */
-            while (!ABTD_atomic_load_int32(&ext_signal));
+            /* External thread is blocked here until ext_signal is set. */
+            if (ABTD_futex_signal_wait_until(&ext_signal, deadline_nsec)
+                    == ABT_FALSE) {
+                if (eventual_remove_unit(p_eventual, p_unit) == ABT_TRUE) {
+                    abt_errno = ABT_ERR_TIMEDOUT;
+                } else {
+                    /* It has been set concurrently. */
+                    ABTD_futex_signal_wait(&ext_signal);
+                }
+            }
             ABTU_free(p_unit);
         }
     } else {
         ABTI_spinlock_release(&p_eventual->lock);
     }
-    if (value) *value = p_eventual->value;
+    if (value && abt_errno == ABT_SUCCESS) *value = p_eventual->value;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup EVENTUAL
+ * @brief   Wait on the eventual.
+ *
+ * \c ABT_eventual_wait blocks the caller ULT until the eventual \c eventual
+ * is resolved. If the eventual is not ready, the ULT calling this routine
+ * suspends and goes to the state BLOCKED. Internally, an entry is created
+ * per each blocked ULT to be awaken when the eventual is signaled.
+ * If the eventual is ready, the pointer pointed to by \c value will point to
+ * the memory buffer associated with the eventual. The system keeps a list of
+ * all the ULTs waiting on the eventual.
+ *
+ * @param[in]  eventual handle to the eventual
+ * @param[out] value    pointer to the memory buffer of the eventual
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_eventual_wait(ABT_eventual eventual, void **value)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_local *p_local = ABTI_local_get_local();
+    ABTI_eventual *p_eventual = ABTI_eventual_get_ptr(eventual);
+    ABTI_CHECK_NULL_EVENTUAL_PTR(p_eventual);
+
+    abt_errno = eventual_wait(&p_local, p_eventual, value, UINT64_MAX);
+    ABTI_CHECK_ERROR(abt_errno);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup EVENTUAL
+ * @brief   Wait on the eventual with a timeout.
+ *
+ * \c ABT_eventual_timedwait is the same as \c ABT_eventual_wait except that
+ * it gives up waiting when the absolute time specified by \c abstime passes.
+ * As with \c ABT_cond_timedwait(), \c abstime is based on
+ * \c CLOCK_REALTIME.  On timeout, the caller is removed from the waiters
+ * of the eventual and \c value is not updated.
+ *
+ * @param[in]  eventual handle to the eventual
+ * @param[out] value    pointer to the memory buffer of the eventual
+ * @param[in]  abstime  absolute time for timeout
+ * @return Error code
+ * @retval ABT_SUCCESS       on success
+ * @retval ABT_ERR_TIMEDOUT  timeout
+ */
+int ABT_eventual_timedwait(ABT_eventual eventual, void **value,
+                           const struct timespec *abstime)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_local *p_local = ABTI_local_get_local();
+    ABTI_eventual *p_eventual = ABTI_eventual_get_ptr(eventual);
+    ABTI_CHECK_NULL_EVENTUAL_PTR(p_eventual);
+
+    abt_errno = eventual_wait(&p_local, p_eventual, value,
+                              ABTI_get_deadline_nsec(abstime));
+    /* A timeout is not an error of this routine. */
+    if (abt_errno == ABT_ERR_TIMEDOUT) goto fn_exit;
+    ABTI_CHECK_ERROR(abt_errno);
 
   fn_exit:
     return abt_errno;
@@ -251,6 +365,7 @@ int ABT_eventual_set(ABT_eventual eventual, void *value, int nbytes)
         ABTI_unit *p_next = p_unit->p_next;
         ABT_unit_type type = p_unit->type;
 
+        p_unit->p_prev = NULL;
         p_unit->p_next = NULL;
 
         if (type == ABT_UNIT_TYPE_THREAD) {
@@ -258,8 +373,7 @@ int ABT_eventual_set(ABT_eventual eventual, void *value, int nbytes)
             ABTI_thread_set_ready(p_local, p_thread);
         } else {
             /* When the head is an external thread */
-            int32_t *p_ext_signal = (int32_t *)p_unit->pool;
-            ABTD_atomic_store_int32(p_ext_signal, 1);
+            ABTD_futex_signal_set((uint32_t *)p_unit->pool);
         }
 
         /* Next ULT */
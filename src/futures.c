@@ -60,12 +60,14 @@ int ABT_future_create(uint32_t compartments, void (*cb_func)(void **arg),
     int abt_errno = ABT_SUCCESS;
     ABTI_future *p_future;
 
-    p_future = (ABTI_future *)ABTU_malloc(sizeof(ABTI_future));
+    /* The array of compartments follows the future. */
+    p_future = (ABTI_future *)ABTI_mem_alloc_slab(ABTI_local_get_local(),
+                    sizeof(ABTI_future) + compartments * sizeof(void *));
     ABTI_spinlock_clear(&p_future->lock);
     p_future->ready = ABT_FALSE;
     p_future->counter = 0;
     p_future->compartments = compartments;
-    p_future->array = ABTU_malloc(compartments * sizeof(void *));
+    p_future->array = (void **)(p_future + 1);
     p_future->p_callback = cb_func;
     p_future->p_head = NULL;
     p_future->p_tail = NULL;
@@ -98,8 +100,7 @@ int ABT_future_free(ABT_future *future)
      * freed here. */
     ABTI_spinlock_acquire(&p_future->lock);
 
-    ABTU_free(p_future->array);
-    ABTU_free(p_future);
+    ABTI_mem_free_slab(ABTI_local_get_local(), p_future);
 
     *future = ABT_FUTURE_NULL;
 
@@ -111,38 +112,60 @@ int ABT_future_free(ABT_future *future)
     goto fn_exit;
 }
 
-/**
- * @ingroup FUTURE
- * @brief   Wait on the future.
- *
- * \c ABT_future_wait blocks the caller ULT until the future \c future is
- * resolved. If the future is not ready, the ULT calling this routine
- * suspends and goes to state BLOCKED. Internally, an entry is created per
- * each blocked ULT to be awaken when the future is signaled. If the future
- * is ready, this routine returns immediately. The system keeps a list of
- * all the ULTs waiting on the future.
- *
- * @param[in] future  handle to the future
- * @return Error code
- * @retval ABT_SUCCESS on success
- */
-int ABT_future_wait(ABT_future future)
+/* Remove p_unit from the waiters of p_future.  Returns ABT_FALSE if p_unit has
+ * already been woken up. */
+static ABT_bool future_remove_unit(ABTI_future *p_future, ABTI_unit *p_unit)
+{
+    ABT_bool removed = ABT_FALSE;
+
+    ABTI_spinlock_acquire(&p_future->lock);
+    if (p_unit->p_prev != NULL || p_future->p_head == p_unit) {
+        if (p_unit->p_prev) {
+            p_unit->p_prev->p_next = p_unit->p_next;
+        } else {
+            p_future->p_head = p_unit->p_next;
+        }
+        if (p_unit->p_next) {
+            p_unit->p_next->p_prev = p_unit->p_prev;
+        } else {
+            p_future->p_tail = p_unit->p_prev;
+        }
+        p_unit->p_prev = NULL;
+        p_unit->p_next = NULL;
+        removed = ABT_TRUE;
+    }
+    ABTI_spinlock_release(&p_future->lock);
+
+    return removed;
+}
+
+static ABT_bool future_remove_thread(ABTI_thread *p_thread, void *p_obj)
+{
+    return future_remove_unit((ABTI_future *)p_obj, &p_thread->unit_def);
+}
+
+/* Wait until p_future becomes ready or the time reaches deadline_nsec.
+ * deadline_nsec is UINT64_MAX if there is no timeout. */
+static int future_wait(ABTI_local **pp_local, ABTI_future *p_future,
+                       uint64_t deadline_nsec)
 {
     int abt_errno = ABT_SUCCESS;
-    ABTI_local *p_local = ABTI_local_get_local();
-    ABTI_future *p_future = ABTI_future_get_ptr(future);
-    ABTI_CHECK_NULL_FUTURE_PTR(p_future);
+    ABTI_local *p_local = *pp_local;
 
     ABTI_spinlock_acquire(&p_future->lock);
     if (p_future->ready == ABT_FALSE) {
         ABTI_thread *p_current;
         ABTI_unit *p_unit;
         ABT_unit_type type;
-        int32_t ext_signal = 0;
+        uint32_t ext_signal = 0;
 
         if (p_local != NULL) {
             p_current = p_local->p_thread;
-            ABTI_CHECK_TRUE(p_current != NULL, ABT_ERR_FUTURE);
+            if (p_current == NULL) {
+                ABTI_spinlock_release(&p_future->lock);
+                abt_errno = ABT_ERR_FUTURE;
+                goto fn_fail;
+            }
 
             type = ABT_UNIT_TYPE_THREAD;
             p_unit = &p_current->unit_def;
@@ -157,6 +180,7 @@ int ABT_future_wait(ABT_future future)
         }
 
         p_unit->p_next = NULL;
+        p_unit->p_prev = p_future->p_tail;
         if (p_future->p_head == NULL) {
             p_future->p_head = p_unit;
             p_future->p_tail = p_unit;
@@ -171,14 +195,28 @@ int ABT_future_wait(ABT_future future)
             ABTI_spinlock_release(&p_future->lock);
 
             /* Suspend the current ULT */
-            ABTI_thread_suspend(&p_local, p_current);
+            if (deadline_nsec == UINT64_MAX) {
+                ABTI_thread_suspend(pp_local, p_current);
+            } else if (ABTI_thread_suspend_until(pp_local, p_current,
+                                                 deadline_nsec,
+                                                 future_remove_thread,
+                                                 p_future) == ABT_TRUE) {
+                abt_errno = ABT_ERR_TIMEDOUT;
+            }
 
         } else {
             ABTI_spinlock_release(&p_future->lock);
 
-            /* External thread is waiting here polling ext_signal. */
-            /* FIXME: need a better implementation */
-            while (!ABTD_atomic_load_int32(&ext_signal));
+            /* External thread is blocked here until ext_signal is set. */
+            if (ABTD_futex_signal_wait_until(&ext_signal, deadline_nsec)
+                    == ABT_FALSE) {
+                if (future_remove_unit(p_future, p_unit) == ABT_TRUE) {
+                    abt_errno = ABT_ERR_TIMEDOUT;
+                } else {
+                    /* It has been set concurrently. */
+                    ABTD_futex_signal_wait(&ext_signal);
+                }
+            }
             ABTU_free(p_unit);
         }
     } else {
@@ -193,6 +231,76 @@ int ABT_future_wait(ABT_future future)
     goto fn_exit;
 }
 
+/**
+ * @ingroup FUTURE
+ * @brief   Wait on the future.
+ *
+ * \c ABT_future_wait blocks the caller ULT until the future \c future is
+ * resolved. If the future is not ready, the ULT calling this routine
+ * suspends and goes to state BLOCKED. Internally, an entry is created per
+ * each blocked ULT to be awaken when the future is signaled. If the future
+ * is ready, this routine returns immediately. The system keeps a list of
+ * all the ULTs waiting on the future.
+ *
+ * @param[in] future  handle to the future
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_future_wait(ABT_future future)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_local *p_local = ABTI_local_get_local();
+    ABTI_future *p_future = ABTI_future_get_ptr(future);
+    ABTI_CHECK_NULL_FUTURE_PTR(p_future);
+
+    abt_errno = future_wait(&p_local, p_future, UINT64_MAX);
+    ABTI_CHECK_ERROR(abt_errno);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup FUTURE
+ * @brief   Wait on the future with a timeout.
+ *
+ * \c ABT_future_timedwait is the same as \c ABT_future_wait except that it
+ * gives up waiting when the absolute time specified by \c abstime passes.
+ * As with \c ABT_cond_timedwait(), \c abstime is based on
+ * \c CLOCK_REALTIME.  On timeout, the caller is removed from the waiters
+ * of the future.
+ *
+ * @param[in] future   handle to the future
+ * @param[in] abstime  absolute time for timeout
+ * @return Error code
+ * @retval ABT_SUCCESS       on success
+ * @retval ABT_ERR_TIMEDOUT  timeout
+ */
+int ABT_future_timedwait(ABT_future future, const struct timespec *abstime)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_local *p_local = ABTI_local_get_local();
+    ABTI_future *p_future = ABTI_future_get_ptr(future);
+    ABTI_CHECK_NULL_FUTURE_PTR(p_future);
+
+    abt_errno = future_wait(&p_local, p_future,
+                            ABTI_get_deadline_nsec(abstime));
+    /* A timeout is not an error of this routine. */
+    if (abt_errno == ABT_ERR_TIMEDOUT) goto fn_exit;
+    ABTI_CHECK_ERROR(abt_errno);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
 /**
  * @ingroup FUTURE
  * @brief   Test whether the future is ready.
@@ -262,23 +370,29 @@ int ABT_future_set(ABT_future future, void *value)
             goto fn_exit;
         }
 
-        /* Wake up all waiting ULTs */
+        /* Wake up all waiting ULTs.  ULTs are made ready in batches. */
+        ABTI_thread *p_threads[ABTI_POOL_PUSH_BATCH];
+        int num_threads = 0;
         ABTI_unit *p_head = p_future->p_head;
         ABTI_unit *p_unit = p_head;
         while (1) {
             ABTI_unit *p_next = p_unit->p_next;
             ABT_unit_type type = p_unit->type;
 
+            p_unit->p_prev = NULL;
             p_unit->p_next = NULL;
 
             if (type == ABT_UNIT_TYPE_THREAD) {
-                ABTI_thread *p_thread =
+                p_threads[num_threads++] =
                     ABTI_thread_get_ptr(p_unit->handle.thread);
-                ABTI_thread_set_ready(p_local, p_thread);
+                if (num_threads == ABTI_POOL_PUSH_BATCH) {
+                    ABTI_thread_set_ready_many(p_local, num_threads,
+                                               p_threads);
+                    num_threads = 0;
+                }
             } else {
                 /* When the head is an external thread */
-                int32_t *p_ext_signal = (int32_t *)p_unit->pool;
-                ABTD_atomic_store_int32(p_ext_signal, 1);
+                ABTD_futex_signal_set((uint32_t *)p_unit->pool);
             }
 
             /* Next ULT */
@@ -288,6 +402,9 @@ int ABT_future_set(ABT_future future, void *value)
                 break;
             }
         }
+        if (num_threads > 0) {
+            ABTI_thread_set_ready_many(p_local, num_threads, p_threads);
+        }
         p_future->p_head = NULL;
         p_future->p_tail = NULL;
     }
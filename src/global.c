@@ -54,6 +54,14 @@ int ABT_init(int argc, char **argv)
     /* Initialize the system environment */
     ABTD_env_init(gp_ABTI_global);
 
+#ifdef ABT_CONFIG_USE_TRACE
+    /* Initialize the trace buffers */
+    ABTI_trace_init(gp_ABTI_global);
+#endif
+
+    /* Initialize the table of stack usages */
+    ABTI_stack_usage_init(gp_ABTI_global);
+
     /* Initialize memory pool */
     ABTI_mem_init(gp_ABTI_global);
 
@@ -192,6 +200,14 @@ int ABT_finalize(void)
     abt_errno = ABTI_local_finalize(&p_local);
     ABTI_CHECK_ERROR(abt_errno);
 
+#ifdef ABT_CONFIG_USE_TRACE
+    /* Dump and free the trace buffers */
+    ABTI_trace_finalize(gp_ABTI_global);
+#endif
+
+    /* Free the table of stack usages */
+    ABTI_stack_usage_finalize(gp_ABTI_global);
+
     /* Free the ES array */
     ABTU_free(gp_ABTI_global->p_xstreams);
 
@@ -202,6 +218,7 @@ int ABT_finalize(void)
     if (gp_ABTI_global->set_affinity == ABT_TRUE) {
         ABTD_affinity_finalize();
     }
+    ABTD_affinity_topology_finalize();
 
     /* Free the ABTI_global structure */
     ABTU_free(gp_ABTI_global);
@@ -241,6 +258,44 @@ int ABT_initialized(void)
     return abt_errno;
 }
 
+/**
+ * @ingroup ENV
+ * @brief   Release the memory of unused ULT stacks.
+ *
+ * \c ABT_mem_trim() releases the memory of all stacks that are kept in the
+ * stack pool for future ULTs, except for their headers, and frees stack pages
+ * whose stacks are all unused.  The stacks of the caller's ES and the global
+ * stack pool are trimmed immediately, and the other ESs trim their stacks the
+ * next time their schedulers check events.  The stacks stay in the pool and
+ * are used again on demand.
+ *
+ * Unused stacks are also trimmed periodically after they have not been used
+ * for \c ABT_MEM_TRIM_INTERVAL_MSEC milliseconds.
+ *
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_mem_trim(void)
+{
+    int abt_errno = ABT_SUCCESS;
+
+    ABTI_CHECK_INITIALIZED();
+
+#ifdef ABT_CONFIG_USE_MEM_POOL
+    ABTI_local *p_local = ABTI_local_get_local();
+    ABTD_atomic_fetch_add_uint32(&gp_ABTI_global->mem_trim_epoch, 1);
+    if (p_local) ABTI_mem_trim_local(p_local, ABT_TRUE);
+    ABTI_mem_trim_global(ABT_TRUE);
+#endif
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
 /* If new_size is equal to zero, we double max_xstreams.
  * NOTE: This function currently cannot decrease max_xstreams.
  */
@@ -12,6 +12,7 @@ noinst_HEADERS = \
 	include/abtd_context.h \
 	include/abtd_fcontext.h \
 	include/abtd_thread.h \
+	include/abtd_tsc.h \
 	include/abtd_ucontext.h \
 	include/abti.h \
 	include/abti_barrier.h \
@@ -35,6 +36,7 @@ noinst_HEADERS = \
 	include/abti_stream.h \
 	include/abti_task.h \
 	include/abti_timer.h \
+	include/abti_trace.h \
 	include/abti_thread.h \
 	include/abti_thread_attr.h \
 	include/abti_thread_htable.h \
@@ -44,9 +44,32 @@ int ABTD_affinity_set_cpuset(ABTD_xstream_context ctx, int cpuset_size,
                              int *p_cpuset);
 int ABTD_affinity_get_cpuset(ABTD_xstream_context ctx, int cpuset_size,
                              int *p_cpuset, int *p_num_cpus);
+int ABTD_affinity_get_self_cpu(void);
+
+/* CPU Topology */
+enum {
+    ABTD_AFFINITY_DIST_SMT,     /* Same core */
+    ABTD_AFFINITY_DIST_LLC,     /* Same last-level cache */
+    ABTD_AFFINITY_DIST_NODE,    /* Same NUMA node */
+    ABTD_AFFINITY_DIST_REMOTE,  /* Others or unknown */
+    ABTD_AFFINITY_NUM_DISTS
+};
+int ABTD_affinity_get_distance(int cpu1, int cpu2);
+int ABTD_affinity_get_num_nodes(void);
+int ABTD_affinity_get_node(int cpu);
+int ABTD_affinity_get_self_node(void);
+void ABTD_affinity_topology_finalize(void);
 
 #include "abtd_stream.h"
 
+/* Futex */
+void ABTD_futex_wait(uint32_t *p_addr, uint32_t val, uint64_t timeout_nsec);
+void ABTD_futex_wake(uint32_t *p_addr, int num_waiters);
+ABT_bool ABTD_futex_signal_wait_until(uint32_t *p_signal,
+                                      uint64_t deadline_nsec);
+void ABTD_futex_signal_wait(uint32_t *p_signal);
+void ABTD_futex_signal_set(uint32_t *p_signal);
+
 /* ULT Context */
 #include "abtd_thread.h"
 void ABTD_thread_exit(ABTI_local *p_local, ABTI_thread *p_thread);
@@ -54,20 +77,18 @@ void ABTD_thread_cancel(ABTI_local *p_local, ABTI_thread *p_thread);
 
 #if defined(ABT_CONFIG_USE_CLOCK_GETTIME)
 #include <time.h>
-typedef struct timespec ABTD_time;
-
 #elif defined(ABT_CONFIG_USE_MACH_ABSOLUTE_TIME)
 #include <mach/mach_time.h>
-typedef uint64_t ABTD_time;
-
 #elif defined(ABT_CONFIG_USE_GETTIMEOFDAY)
 #include <sys/time.h>
-typedef struct timeval ABTD_time;
-
 #endif
 
-void   ABTD_time_init(void);
-int    ABTD_time_get(ABTD_time *p_time);
-double ABTD_time_read_sec(ABTD_time *p_time);
+/* Time in nanoseconds since an arbitrary point in the past */
+typedef uint64_t ABTD_time;
+
+void     ABTD_time_init(ABT_bool use_tsc);
+uint64_t ABTD_time_get_os_nsec(void);
+double   ABTD_time_get_realtime_sec(void);
+#include "abtd_tsc.h"
 
 #endif /* ABTD_H_INCLUDED */
@@ -730,6 +730,18 @@ void ABTD_atomic_mem_barrier(void)
 #endif
 }
 
+/* Unlike ABTD_atomic_mem_barrier(), this also orders a store before a
+ * subsequent load. */
+static inline
+void ABTD_atomic_full_barrier(void)
+{
+#ifdef ABT_CONFIG_HAVE_ATOMIC_BUILTIN
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+#else
+    __sync_synchronize();
+#endif
+}
+
 static inline
 void ABTD_compiler_barrier(void)
 {
@@ -32,7 +32,7 @@ static void ABTD_thread_context_jump(ABTD_thread_context *p_old,
                                      ABTD_thread_context *p_new, void *arg);
 static void ABTD_thread_context_take(ABTD_thread_context *p_old,
                                      ABTD_thread_context *p_new, void *arg);
-#if ABT_CONFIG_THREAD_TYPE == ABT_THREAD_TYPE_DYNAMIC_PROMOTION
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
 static void ABTD_thread_context_init_and_call(ABTD_thread_context *p_ctx,
                                               void *sp,
                                               void (*thread_func)(void *),
@@ -18,7 +18,7 @@ fcontext_t make_fcontext(void *sp, size_t size, void (*thread_func)(void *))
                          ABT_API_PRIVATE;
 void *jump_fcontext(fcontext_t *old, fcontext_t new, void *arg) ABT_API_PRIVATE;
 void *take_fcontext(fcontext_t *old, fcontext_t new, void *arg) ABT_API_PRIVATE;
-#if ABT_CONFIG_THREAD_TYPE == ABT_THREAD_TYPE_DYNAMIC_PROMOTION
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
 void init_and_call_fcontext(void *p_arg, void (*f_thread)(void *),
                             void *p_stacktop, fcontext_t *old);
 #endif
@@ -30,6 +30,14 @@ void ABTD_thread_context_make(ABTD_thread_context *p_ctx, void *sp, size_t size,
     p_ctx->p_ctx = make_fcontext(sp, size, thread_func);
 }
 
+/* Return the stack pointer of the suspended context p_ctx.  The frames of the
+ * context are between it and the stack top. */
+static inline
+void *ABTD_thread_context_get_sp(ABTD_thread_context *p_ctx)
+{
+    return p_ctx->p_ctx;
+}
+
 static inline
 void ABTD_thread_context_jump(ABTD_thread_context *p_old,
                               ABTD_thread_context *p_new, void *arg)
@@ -44,7 +52,7 @@ void ABTD_thread_context_take(ABTD_thread_context *p_old,
     take_fcontext(&p_old->p_ctx, p_new->p_ctx, arg);
 }
 
-#if ABT_CONFIG_THREAD_TYPE == ABT_THREAD_TYPE_DYNAMIC_PROMOTION
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
 static inline
 void ABTD_thread_context_init_and_call(ABTD_thread_context *p_ctx, void *sp,
                                        void (*thread_func)(void *), void *arg)
@@ -14,7 +14,7 @@
 
 void ABTD_thread_func_wrapper_thread(void *p_arg);
 void ABTD_thread_func_wrapper_sched(void *p_arg);
-#if ABT_CONFIG_THREAD_TYPE == ABT_THREAD_TYPE_DYNAMIC_PROMOTION
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
 void ABTD_thread_terminate_thread_no_arg();
 #endif
 
@@ -66,7 +66,7 @@ static inline
 int ABTD_thread_context_invalidate(ABTD_thread_context *p_newctx)
 {
     int abt_errno = ABT_SUCCESS;
-#if ABT_CONFIG_THREAD_TYPE == ABT_THREAD_TYPE_DYNAMIC_PROMOTION
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
     /* p_ctx is used to check whether the context requires dynamic promotion is
      * necessary or not, so this value must not be NULL. */
     p_newctx->p_ctx = (void *)((intptr_t)0x1);
@@ -79,7 +79,7 @@ int ABTD_thread_context_invalidate(ABTD_thread_context *p_newctx)
     return abt_errno;
 }
 
-#if ABT_CONFIG_THREAD_TYPE == ABT_THREAD_TYPE_DYNAMIC_PROMOTION
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
 static inline
 int ABTD_thread_context_init(ABTD_thread_context *p_link,
                              void (*f_thread)(void *), void *p_arg,
@@ -128,12 +128,21 @@ void ABTD_thread_finish_context(ABTD_thread_context *p_old,
     ABTD_thread_context_take(p_old, p_new, p_new);
 }
 
-#if ABT_CONFIG_THREAD_TYPE == ABT_THREAD_TYPE_DYNAMIC_PROMOTION
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
+/* The stack top used by dynamic promotion must be 16-byte aligned on both
+ * x86-64 and AArch64, but a stack of an arbitrary size may end anywhere. */
+static inline
+void *ABTDI_thread_context_align_stacktop(void *p_stacktop)
+{
+    return (void *)((uintptr_t)p_stacktop & ~(uintptr_t)0xf);
+}
+
 static inline
 void ABTD_thread_context_make_and_call(ABTD_thread_context *p_old,
                                        void (*f_thread)(void *), void *p_arg,
                                        void *p_stacktop)
 {
+    p_stacktop = ABTDI_thread_context_align_stacktop(p_stacktop);
     ABTD_thread_context_init_and_call(p_old, p_stacktop, f_thread, p_arg);
 }
 
@@ -148,11 +157,25 @@ ABT_bool ABTD_thread_context_is_dynamic_promoted(ABTD_thread_context *p_ctx)
 static inline
 void ABTDI_thread_context_dynamic_promote(void *p_stacktop, void *jump_f)
 {
-    /* Perform dynamic promotion */
+    /* Perform dynamic promotion.  init_and_call_fcontext restores the stack
+     * pointer saved at the stack top after the ULT function returns, so the
+     * saved one is replaced with a stack pointer that leads to jump_f. */
+    p_stacktop = ABTDI_thread_context_align_stacktop(p_stacktop);
+#if defined(__aarch64__)
+    /* On AArch64, init_and_call_fcontext branches to [ptr - 0x08] with the
+     * stack pointer loaded from [ptr - 0x10]. */
+    void ***p_stack_pointer = (void ***)(((char *) p_stacktop) - 0x10);
+    void **p_return_address = (void **)(((char *) p_stacktop) - 0x08);
+    *p_stack_pointer = (void **)p_stack_pointer;
+    *p_return_address = jump_f;
+#else
+    /* On x86-64, `ret` pops [ptr - 0x10] after the stack pointer is loaded
+     * from [ptr - 0x08]. */
     void **p_return_address = (void **)(((char *) p_stacktop) - 0x10);
     void ***p_stack_pointer = (void ***)(((char *) p_stacktop) - 0x08);
     *p_stack_pointer = p_return_address;
     *p_return_address = jump_f;
+#endif
 }
 
 static inline
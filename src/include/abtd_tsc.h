@@ -0,0 +1,89 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef ABTD_TSC_H_INCLUDED
+#define ABTD_TSC_H_INCLUDED
+
+/* Ticks can be converted to time without a system call only where the counter
+ * runs at a constant rate and 128-bit multiplication is available. */
+#if (defined(__x86_64__) || defined(__aarch64__)) && defined(__GNUC__)
+#define ABTD_TIME_USE_TSC
+#endif
+
+/* Read a cheap, monotonically increasing tick counter.  The time stamp
+ * counter is used on x86 and the virtual counter on AArch64.  The tick rate is
+ * not known here, so callers need to calibrate it against another clock.  On
+ * other architectures, nanoseconds of CLOCK_MONOTONIC are returned. */
+static inline
+uint64_t ABTD_tsc_read(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    uint32_t lo, hi;
+    __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+    return ((uint64_t)hi << 32) | lo;
+#elif defined(__aarch64__)
+    uint64_t val;
+    __asm__ __volatile__ ("mrs %0, cntvct_el0" : "=r" (val));
+    return val;
+#elif defined(ABT_CONFIG_USE_CLOCK_GETTIME)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint64_t)tv.tv_sec * 1000000000 + tv.tv_usec * 1000;
+#endif
+}
+
+/* Calibrated tick counter.  Once ABTD_time_init() has found an invariant
+ * counter, time is computed as nsec_base + (ticks - tsc_base) * mult / 2^32,
+ * which continues the OS clock returned by ABTD_time_get_os_nsec().  Until
+ * then, or if no invariant counter is available, the OS clock is used. */
+typedef struct {
+    uint32_t enabled;
+    uint64_t tsc_base;
+    uint64_t nsec_base;
+    uint64_t mult;
+} ABTD_time_tsc_clock;
+
+extern ABTD_time_tsc_clock g_ABTD_time_tsc;
+
+static inline
+ABT_bool ABTD_time_uses_tsc(void)
+{
+    return ABTD_atomic_load_uint32(&g_ABTD_time_tsc.enabled) ? ABT_TRUE
+                                                             : ABT_FALSE;
+}
+
+static inline
+void ABTD_time_get(ABTD_time *p_time)
+{
+#ifdef ABTD_TIME_USE_TSC
+    if (ABTU_likely(ABTD_atomic_load_uint32(&g_ABTD_time_tsc.enabled))) {
+        uint64_t ticks = ABTD_tsc_read() - g_ABTD_time_tsc.tsc_base;
+        *p_time = g_ABTD_time_tsc.nsec_base
+                + (uint64_t)(((__uint128_t)ticks * g_ABTD_time_tsc.mult) >> 32);
+        return;
+    }
+#endif
+    *p_time = ABTD_time_get_os_nsec();
+}
+
+/* Read the time value as seconds (double precision) */
+static inline
+double ABTD_time_read_sec(ABTD_time *p_time)
+{
+    return 1.0e-9 * (double)*p_time;
+}
+
+/* Read the time value as nanoseconds */
+static inline
+uint64_t ABTD_time_read_nsec(ABTD_time *p_time)
+{
+    return *p_time;
+}
+
+#endif /* ABTD_TSC_H_INCLUDED */
@@ -66,7 +66,7 @@ void ABTD_thread_context_take(ABTD_thread_context *p_old,
     /* Unreachable. */
 }
 
-#if ABT_CONFIG_THREAD_TYPE == ABT_THREAD_TYPE_DYNAMIC_PROMOTION
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
 #error "ABTD_thread_context_make_and_call is not implemented."
 #endif
 
@@ -54,6 +54,55 @@
 
 #define ABTI_INDENT                 4
 
+/* Number of units that are pushed at once when many ULTs are readied */
+#define ABTI_POOL_PUSH_BATCH        32
+
+/* Block size classes of the per-ES slab caches for synchronization objects.
+ * Class i holds blocks of (ABTI_MEM_SLAB_MIN_BLK_SIZE << i) bytes including
+ * the block header. */
+#define ABTI_MEM_NUM_SLABS          6
+#define ABTI_MEM_SLAB_MIN_BLK_SIZE  64
+/* Slab pages are small so that each size class commits only a few OS pages
+ * per ES. */
+#define ABTI_MEM_SLAB_PAGE_OS_PAGES 4
+
+/* Maximum number of stack size classes of the memory pool */
+#define ABTI_MEM_MAX_STACK_CLASSES  8
+
+/* Maximum number of NUMA nodes that have their own global free lists.  Nodes
+ * beyond it share the lists with other nodes. */
+#define ABTI_MEM_MAX_NODES          16
+
+/* Number of buckets of the table of stack usages of ULT functions */
+#define ABTI_STACK_USAGE_TABLE_SIZE 256
+
+/* Timer wheel: a tick is 2^ABTI_TWHEEL_TICK_SHIFT nanoseconds (about 1 us),
+ * and six levels of 64 slots cover about 19 hours.  Longer timeouts are
+ * cascaded again when they reach the last level. */
+#define ABTI_TWHEEL_TICK_SHIFT      10
+#define ABTI_TWHEEL_SLOT_BITS       6
+#define ABTI_TWHEEL_NUM_SLOTS       (1 << ABTI_TWHEEL_SLOT_BITS)
+#define ABTI_TWHEEL_NUM_LEVELS      6
+
+/* State of a waiter of a FIFO mutex.  The values match the signal word of
+ * ABTD_futex_signal_wait(). */
+#define ABTI_MUTEX_QNODE_WAITING    0
+#define ABTI_MUTEX_QNODE_GRANTED    1
+#define ABTI_MUTEX_QNODE_SLEEPING   2
+
+/* Bounds of the adaptive spin count of the first waiter of a FIFO mutex */
+#define ABTI_MUTEX_SPIN_MIN         16
+#define ABTI_MUTEX_SPIN_MAX         4096
+
+/* Number of reader counters of a rwlock.  Readers on ES r use the counter
+ * r % ABTI_RWLOCK_NUM_SHARDS.  This must be a power of two. */
+#define ABTI_RWLOCK_NUM_SHARDS      16
+
+/* write_flag of a rwlock */
+#define ABTI_RWLOCK_WRITE_NONE      0   /* No writer */
+#define ABTI_RWLOCK_WRITE_PENDING   1   /* A writer waits for readers to leave */
+#define ABTI_RWLOCK_WRITE_LOCKED    2   /* A writer holds the lock */
+
 #define ABT_THREAD_TYPE_FULLY_FLEDGED      0
 #define ABT_THREAD_TYPE_DYNAMIC_PROMOTION  1
 
@@ -71,12 +120,14 @@ enum ABTI_sched_used {
 enum ABTI_thread_type {
     ABTI_THREAD_TYPE_MAIN,
     ABTI_THREAD_TYPE_MAIN_SCHED,
-    ABTI_THREAD_TYPE_USER
+    ABTI_THREAD_TYPE_USER,
+    ABTI_THREAD_TYPE_TASK       /* Lends its stack to tasklets */
 };
 
 enum ABTI_mutex_attr_val {
     ABTI_MUTEX_ATTR_NONE = 0,
-    ABTI_MUTEX_ATTR_RECURSIVE = 1 << 0
+    ABTI_MUTEX_ATTR_RECURSIVE = 1 << 0,
+    ABTI_MUTEX_ATTR_FIFO = 1 << 1
 };
 
 enum ABTI_stack_type {
@@ -84,6 +135,7 @@ enum ABTI_stack_type {
     ABTI_STACK_TYPE_MALLOC,      /* Stack allocated by malloc in Argobots */
     ABTI_STACK_TYPE_USER,        /* Stack given by a user */
     ABTI_STACK_TYPE_MAIN,        /* Stack of a main ULT. */
+    ABTI_STACK_TYPE_COPY,        /* Stack shared by stack-copying ULTs */
 };
 
 /* Macro functions */
@@ -118,12 +170,27 @@ typedef struct ABTI_ktelem          ABTI_ktelem;
 typedef struct ABTI_ktable          ABTI_ktable;
 typedef struct ABTI_mutex_attr      ABTI_mutex_attr;
 typedef struct ABTI_mutex           ABTI_mutex;
+typedef struct ABTI_mutex_qnode     ABTI_mutex_qnode;
 typedef struct ABTI_cond            ABTI_cond;
 typedef struct ABTI_rwlock          ABTI_rwlock;
+typedef struct ABTI_rwlock_shard    ABTI_rwlock_shard;
+typedef struct ABTI_rwlock_waiter   ABTI_rwlock_waiter;
 typedef struct ABTI_eventual        ABTI_eventual;
 typedef struct ABTI_future          ABTI_future;
 typedef struct ABTI_barrier         ABTI_barrier;
 typedef struct ABTI_timer           ABTI_timer;
+typedef struct ABTI_park_link       ABTI_park_link;
+typedef struct ABTI_twheel          ABTI_twheel;
+typedef struct ABTI_twheel_entry    ABTI_twheel_entry;
+typedef struct ABTI_thread_timeout  ABTI_thread_timeout;
+typedef struct ABTI_stack_usage     ABTI_stack_usage;
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+typedef struct ABTI_xstream_perf    ABTI_xstream_perf;
+#endif
+#ifdef ABT_CONFIG_USE_TRACE
+typedef struct ABTI_trace_event     ABTI_trace_event;
+typedef struct ABTI_trace_buffer    ABTI_trace_buffer;
+#endif
 #ifdef ABT_CONFIG_USE_MEM_POOL
 typedef struct ABTI_stack_header    ABTI_stack_header;
 typedef struct ABTI_page_header     ABTI_page_header;
@@ -156,12 +223,25 @@ struct ABTI_mutex_attr {
     uint32_t max_wakeups;       /* max. # of wakeups */
 };
 
+/* Queue node of a unit waiting for a FIFO mutex, allocated on its stack */
+struct ABTI_mutex_qnode {
+    ABTI_mutex_qnode *p_next;       /* next waiter */
+    ABTI_thread *p_thread;          /* NULL if the waiter cannot suspend */
+    uint32_t state;                 /* ABTI_MUTEX_QNODE_XXX */
+};
+
 struct ABTI_mutex {
     uint32_t val;                   /* 0: unlocked, 1: locked */
     ABTI_mutex_attr attr;           /* attributes */
-    ABTI_thread_htable *p_htable;   /* a set of queues */
+    ABTI_thread_htable *p_htable;   /* a set of queues (NULL until the
+                                       mutex is contended) */
     ABTI_thread *p_handover;        /* next ULT for the mutex handover */
     ABTI_thread *p_giver;           /* current ULT that hands over the mutex */
+    /* For ABTI_MUTEX_ATTR_FIFO.  p_tail is NULL if unlocked, and &qhead if
+     * locked without waiters.  qhead.p_next is the first waiter. */
+    ABTI_mutex_qnode *p_tail;
+    ABTI_mutex_qnode qhead;
+    uint32_t spin_limit;            /* iterations a waiter spins */
 };
 
 struct ABTI_global {
@@ -181,6 +261,15 @@ struct ABTI_global {
     size_t sched_stacksize;     /* Default stack size for sched (in bytes) */
     uint32_t sched_event_freq;  /* Default check frequency for sched */
     long sched_sleep_nsec;      /* Default nanoseconds for scheduler sleep */
+#ifdef ABT_CONFIG_USE_SCHED_PARK
+    uint32_t sched_park_spin_usec;    /* Idle time before parking */
+    uint32_t sched_park_timeout_usec; /* Max. time of each parking */
+#endif
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
+    ABT_bool task_blockable;    /* Whether tasklets can suspend */
+    size_t copy_stacksize;      /* Size of the stack that each ES shares
+                                   among stack-copying ULTs */
+#endif
     ABTI_thread *p_thread_main; /* ULT of the main function */
 
     uint32_t mutex_max_handovers;      /* Default max. # of local handovers */
@@ -188,17 +277,59 @@ struct ABTI_global {
     uint32_t os_page_size;             /* OS page size */
     uint32_t huge_page_size;           /* Huge page size */
 #ifdef ABT_CONFIG_USE_MEM_POOL
-    ABTI_spinlock mem_task_lock;       /* Spinlock protecting p_mem_task */
+    ABTI_spinlock mem_task_lock;       /* Spinlock protecting p_mem_task and
+                                          p_mem_slab */
     uint32_t mem_page_size;            /* Page size for memory allocation */
     uint32_t mem_sp_size;              /* Stack page size */
-    uint32_t mem_max_stacks;           /* Max. # of stacks kept in each ES */
+    uint32_t mem_max_stacks;           /* Max. # of stacks of each size class
+                                          kept in each ES */
+    uint32_t mem_num_stack_classes;    /* # of stack size classes */
+    size_t mem_stack_classes[ABTI_MEM_MAX_STACK_CLASSES]; /* Stack sizes in
+                                          ascending order */
     int mem_lp_alloc;                  /* How to allocate large pages */
-    ABTI_stack_header *p_mem_stack;    /* List of ULT stack */
-    ABTI_page_header *p_mem_task;      /* List of task block pages */
+    ABT_bool mem_numa;                 /* Whether to place memory on the
+                                          NUMA node of each ES */
+    int mem_num_nodes;                 /* # of global free lists per kind */
+    ABTI_stack_header *p_mem_stack[ABTI_MEM_MAX_STACK_CLASSES]
+                                  [ABTI_MEM_MAX_NODES]; /* Lists of ULT
+                                          stacks of each size class and node */
+    ABTI_page_header *p_mem_task[ABTI_MEM_MAX_NODES]; /* Lists of task block
+                                          pages of each node */
+    ABTI_page_header *p_mem_slab[ABTI_MEM_NUM_SLABS]
+                                [ABTI_MEM_MAX_NODES]; /* Lists of slab pages
+                                          of each node */
     ABTI_sp_header *p_mem_sph;         /* List of stack pages */
+    ABTI_spinlock mem_trim_lock;       /* Spinlock serializing the trimming of
+                                          the global stack lists */
+    uint64_t mem_trim_nsec;            /* Idle time before stacks are trimmed
+                                          (0: never) */
+    uint64_t mem_trim_next;            /* Time of the next global trimming */
+    uint32_t mem_trim_gen;             /* Generation of the global stacks */
+    uint32_t mem_trim_epoch;           /* # of ABT_mem_trim() calls */
+    ABT_bool mem_stack_guard;          /* Whether pooled stacks have a guard
+                                          page */
 #endif
 
     ABT_bool print_config;      /* Whether to print config on ABT_init */
+
+    ABT_bool stack_watermark;          /* Whether to measure the stack usage of
+                                          ULTs */
+    ABT_bool stack_adaptive;           /* Whether to choose stack sizes from
+                                          the measured stack usage */
+    uint32_t stack_adaptive_pct;       /* Percentile of the usage covered by
+                                          the chosen stack size */
+    uint32_t stack_adaptive_samples;   /* Min. # of samples to choose it */
+    ABTI_spinlock stack_usage_lock;    /* Spinlock protecting p_stack_usages */
+    ABTI_stack_usage **p_stack_usages; /* Hash table of stack usages */
+
+#ifdef ABT_CONFIG_USE_TRACE
+    uint32_t trace_buffer_size;        /* # of events in each trace buffer */
+    char *trace_file;                  /* File written on ABT_finalize */
+    ABTI_spinlock trace_lock;          /* Spinlock protecting p_trace_bufs */
+    ABTI_trace_buffer *p_trace_bufs;   /* List of trace buffers */
+    uint64_t trace_start_tsc;          /* Tick count when tracing started */
+    uint64_t trace_start_nsec;         /* Time when tracing started */
+#endif
 };
 
 struct ABTI_local_func {
@@ -213,12 +344,27 @@ struct ABTI_local {
     ABTI_xstream *p_xstream;    /* Current ES */
     ABTI_thread *p_thread;      /* Current running ULT */
     ABTI_task *p_task;          /* Current running tasklet */
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
+    ABTI_thread *p_task_thread; /* ULT whose stack is lent to tasklets */
+    void *p_copy_stack;         /* Stack shared by stack-copying ULTs */
+    ABTI_thread *p_copy_thread; /* Stack-copying ULT whose frames are on
+                                   p_copy_stack */
+#endif
 
 #ifdef ABT_CONFIG_USE_MEM_POOL
-    uint32_t num_stacks;                /* Current # of stacks */
-    ABTI_stack_header *p_mem_stack;     /* Free stack list */
+    uint32_t num_stacks[ABTI_MEM_MAX_STACK_CLASSES]; /* Current # of stacks */
+    ABTI_stack_header *p_mem_stack[ABTI_MEM_MAX_STACK_CLASSES]; /* Free stack
+                                                                  lists */
     ABTI_page_header *p_mem_task_head;  /* Head of page list */
     ABTI_page_header *p_mem_task_tail;  /* Tail of page list */
+    ABTI_page_header *p_mem_slab_head[ABTI_MEM_NUM_SLABS]; /* Heads of slab
+                                                             page lists */
+    ABTI_page_header *p_mem_slab_tail[ABTI_MEM_NUM_SLABS]; /* Tails of slab
+                                                             page lists */
+    uint32_t mem_trim_gen;              /* Generation of the free stacks */
+    uint32_t mem_trim_epoch;            /* Last ABT_mem_trim() trimmed */
+    uint64_t mem_trim_next;             /* Time of the next trimming */
+    void *p_sigstack;                   /* Signal stack for stack overflows */
 #endif
 };
 
@@ -237,8 +383,103 @@ struct ABTI_xstream {
     ABTI_sched *p_main_sched;   /* Main scheduler */
 
     ABTD_xstream_context ctx;   /* ES context */
+
+    uint32_t park_state;            /* 1 if parked, 0 otherwise (futex) */
+    ABTI_park_link *p_park_links;   /* Links to register in pools */
+    int num_park_links;             /* Number of p_park_links */
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+    ABTI_xstream_perf *p_perf;      /* Performance counters */
+#endif
+    ABTI_twheel *p_twheel;          /* Timer wheel (created on first use) */
+#ifdef ABT_CONFIG_USE_TRACE
+    ABTI_trace_buffer *p_trace;     /* Trace buffer (NULL if disabled) */
+#endif
+};
+
+/* Hierarchical timer wheel of an ES.  Level l has ABTI_TWHEEL_NUM_SLOTS slots,
+ * each of which spans 2^(ABTI_TWHEEL_SLOT_BITS * l) ticks, and entries of a
+ * slot of level l > 0 are moved to lower levels when the current tick reaches
+ * the slot.  Only the owner ES adds and expires entries; the lock is needed
+ * because other ESs may remove entries. */
+struct ABTI_twheel {
+    ABTI_spinlock lock;
+    uint64_t cur;                   /* Current tick */
+    uint32_t num_entries;
+    uint64_t occupied[ABTI_TWHEEL_NUM_LEVELS];  /* Bitmaps of non-empty slots */
+    ABTI_twheel_entry *slots[ABTI_TWHEEL_NUM_LEVELS][ABTI_TWHEEL_NUM_SLOTS];
+};
+
+struct ABTI_twheel_entry {
+    ABTI_twheel_entry *p_prev;
+    ABTI_twheel_entry *p_next;
+    ABTI_twheel *p_wheel;           /* Wheel to which this entry was added */
+    ABT_bool is_pending;            /* Whether it is in p_wheel */
+    uint32_t is_firing;             /* 1 until f_expire releases the entry */
+    int level;
+    int slot;
+    uint64_t deadline;              /* Nanoseconds of ABTI_get_wtime_nsec() */
+    /* Called by the owner ES of p_wheel when the deadline passes */
+    void (*f_expire)(ABTI_local *p_local, ABTI_twheel_entry *p_entry);
+    void *p_arg;
+};
+
+/* Timeout of a ULT blocked on a synchronization object */
+struct ABTI_thread_timeout {
+    ABTI_twheel_entry entry;        /* Must be the first member */
+    ABTI_thread *p_thread;          /* Blocked ULT */
+    /* Removes p_thread from the waiters of p_obj.  Returns ABT_FALSE if
+     * p_thread has already been woken up. */
+    ABT_bool (*f_remove)(ABTI_thread *p_thread, void *p_obj);
+    ABT_bool timed_out;
 };
 
+#ifdef ABT_CONFIG_USE_TRACE
+struct ABTI_trace_event {
+    uint64_t tsc;               /* Tick count (ABTD_tsc_read) */
+    uint64_t obj;               /* Address of the ULT, tasklet, or mutex */
+    uint32_t kind;              /* ABTI_TRACE_EVENT_XXX */
+    uint32_t arg;               /* Pool ID or reason */
+};
+
+/* Ring buffer of events recorded by an ES.  A buffer is kept until
+ * ABT_finalize() and reused by the next ES that has the same rank. */
+struct ABTI_trace_buffer {
+    ABTI_trace_buffer *p_next;
+    int rank;                   /* Rank of the ES */
+    ABT_bool in_use;            /* Whether an ES is using this buffer */
+    uint64_t mask;              /* Number of entries - 1 */
+    uint64_t pos;               /* Number of recorded events */
+    ABTI_trace_event *events;
+};
+#endif
+
+/* Stack usage of the ULTs that ran a function.  Entries are never removed
+ * until ABT_finalize(). */
+struct ABTI_stack_usage {
+    ABTI_stack_usage *p_next;
+    void (*f_thread)(void *);   /* ULT function */
+    uint64_t num_samples;       /* # of measured ULTs */
+    uint64_t total_usage;       /* Sum of the usage in bytes */
+    size_t max_usage;           /* Max. usage in bytes */
+#ifdef ABT_CONFIG_USE_MEM_POOL
+    uint64_t num_class_samples[ABTI_MEM_MAX_STACK_CLASSES + 1]; /* # of
+                                   samples that fit in each stack size class
+                                   (the last one: none of them) */
+    uint64_t stacksize;         /* Stack size chosen for the function (0: not
+                                   chosen) */
+#endif
+};
+
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+/* Only the owner ES updates the counters, so they are allocated apart from
+ * ABTI_xstream, which is written by other ESs. */
+struct ABTI_xstream_perf {
+    ABT_xstream_counters counters;
+    ABT_bool is_idle;           /* Whether the schedulers found no work unit */
+    ABTD_time idle_start;       /* When the idle period started */
+};
+#endif
+
 struct ABTI_sched {
     ABTI_sched_used used;       /* To know if it is used and how */
     ABT_bool automatic;         /* To know if automatic data free */
@@ -279,6 +520,10 @@ struct ABTI_pool {
     int32_t num_migrations;  /* Number of migrating ULTs */
     void *data;              /* Specific data */
     uint64_t id;             /* ID */
+    int32_t home_cpu;        /* CPU of the ES that owns the pool (-1 if
+                                unknown) */
+    ABTI_xstream *p_owner;   /* ES whose main scheduler has this pool as its
+                                first pool (NULL if none) */
 
     /* Functions to manage units */
     ABT_unit_get_type_fn           u_get_type;
@@ -298,6 +543,23 @@ struct ABTI_pool {
     ABT_pool_remove_fn             p_remove;
     ABT_pool_free_fn               p_free;
     ABT_pool_print_all_fn          p_print_all;
+    ABT_pool_pop_steal_fn          p_pop_steal;
+    ABT_pool_push_many_fn          p_push_many;
+    ABT_pool_pop_many_fn           p_pop_many;
+
+    /* ESs parked on this pool */
+    uint32_t park_enabled;         /* Nonzero if a scheduler that may park
+                                    * uses this pool */
+    ABTI_spinlock park_lock;       /* Lock protecting p_parked */
+    uint32_t num_parked;           /* Number of parked ESs */
+    ABTI_park_link *p_parked;      /* List of parked ESs */
+};
+
+struct ABTI_park_link {
+    ABTI_park_link *p_prev;
+    ABTI_park_link *p_next;
+    ABTI_xstream *p_xstream;       /* Parked ES */
+    ABTI_sched *p_sched;           /* Scheduler that parked p_xstream */
 };
 
 struct ABTI_unit {
@@ -320,6 +582,10 @@ struct ABTI_thread_attr {
     void (*f_cb)(ABT_thread, void *);   /* Callback function */
     void *p_cb_arg;                     /* Callback function argument */
 #endif
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
+    ABT_bool dynamic_promotion;         /* Whether the context is created
+                                           lazily */
+#endif
 };
 
 struct ABTI_thread {
@@ -342,6 +608,10 @@ struct ABTI_thread {
     ABTI_ktable *p_keytable;        /* ULT-specific data */
     ABTI_thread_attr attr;          /* Attributes */
     ABT_thread_id id;               /* ID */
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
+    void *p_copy_buf;               /* Saved frames of a stack-copying ULT */
+    size_t copy_size;               /* Size of the saved frames */
+#endif
 };
 
 #ifndef ABT_CONFIG_DISABLE_MIGRATION
@@ -410,11 +680,31 @@ struct ABTI_cond {
     ABTI_unit *p_tail;          /* Tail of waiters */
 };
 
+/* Reader counter in its own cache line.  A ULT may release a read lock on
+ * another ES, so a single counter can be negative; only the sum over all the
+ * shards is the number of readers. */
+struct ABTI_rwlock_shard {
+    int32_t count;
+    char padding[ABT_CONFIG_STATIC_CACHELINE_SIZE - sizeof(int32_t)];
+};
+
+/* Entry of a waiting reader or writer, allocated on the waiter's stack */
+struct ABTI_rwlock_waiter {
+    ABTI_rwlock_waiter *p_next;
+    ABTI_thread *p_thread;      /* NULL if an external thread */
+    uint32_t ext_signal;        /* Signal word of an external thread */
+    int shard;                  /* Reader counter to which a reader is added */
+};
+
 struct ABTI_rwlock {
-    ABTI_mutex mutex;
-    ABTI_cond  cond;
-    size_t reader_count;
-    int write_flag;
+    ABTI_rwlock_shard shards[ABTI_RWLOCK_NUM_SHARDS];
+    uint32_t write_flag;                /* ABTI_RWLOCK_WRITE_XXX */
+    ABTI_spinlock lock;                 /* Protects the waiters */
+    ABTI_rwlock_waiter *p_drain;        /* Writer waiting for readers */
+    ABTI_rwlock_waiter *p_rd_head;      /* Readers waiting for a writer */
+    ABTI_rwlock_waiter *p_rd_tail;
+    ABTI_rwlock_waiter *p_wr_head;      /* Writers waiting for a writer */
+    ABTI_rwlock_waiter *p_wr_tail;
 };
 
 struct ABTI_eventual {
@@ -482,6 +772,11 @@ int ABTI_xstream_schedule_thread(ABTI_local **pp_local,
                                  ABTI_thread *p_thread);
 void ABTI_xstream_schedule_task(ABTI_local *p_local, ABTI_xstream *p_xstream,
                                 ABTI_task *p_task);
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
+int ABTI_xstream_schedule_task_on_stack(ABTI_local **pp_local,
+                                        ABTI_xstream *p_xstream,
+                                        ABTI_task *p_task);
+#endif
 int ABTI_xstream_migrate_thread(ABTI_local *p_local, ABTI_thread *p_thread);
 int ABTI_xstream_set_main_sched(ABTI_local **pp_local, ABTI_xstream *p_xstream,
                                 ABTI_sched *p_sched);
@@ -495,6 +790,7 @@ ABT_sched_def *ABTI_sched_get_basic_def(void);
 ABT_sched_def *ABTI_sched_get_basic_wait_def(void);
 ABT_sched_def *ABTI_sched_get_prio_def(void);
 ABT_sched_def *ABTI_sched_get_randws_def(void);
+ABT_sched_def *ABTI_sched_get_topows_def(void);
 void ABTI_sched_finish(ABTI_sched *p_sched);
 void ABTI_sched_exit(ABTI_sched *p_sched);
 int ABTI_sched_create(ABT_sched_def *def, int num_pools, ABT_pool *pools,
@@ -506,6 +802,7 @@ int ABTI_sched_create_basic(ABT_sched_predef predef, int num_pools,
 int ABTI_sched_free(ABTI_local *p_local, ABTI_sched *p_sched);
 int ABTI_sched_get_migration_pool(ABTI_sched *, ABTI_pool *, ABTI_pool **);
 ABTI_sched_kind ABTI_sched_get_kind(ABT_sched_def *def);
+ABT_bool ABTI_sched_may_park(ABT_sched_def *def);
 ABT_bool ABTI_sched_has_to_stop(ABTI_local **pp_local, ABTI_sched *p_sched,
                                 ABTI_xstream *p_xstream);
 size_t ABTI_sched_get_size(ABTI_sched *p_sched);
@@ -514,6 +811,9 @@ size_t ABTI_sched_get_effective_size(ABTI_local *p_local, ABTI_sched *p_sched);
 void ABTI_sched_print(ABTI_sched *p_sched, FILE *p_os, int indent,
                       ABT_bool print_sub);
 void ABTI_sched_reset_id(void);
+void ABTI_sched_park(ABTI_sched *p_sched, ABTI_xstream *p_xstream,
+                     uint64_t timeout_nsec);
+void ABTI_sched_unpark(ABTI_sched *p_sched);
 
 /* Scheduler config */
 size_t ABTI_sched_config_type_size(ABT_sched_config_type type);
@@ -530,6 +830,9 @@ int ABTI_pool_create_basic(ABT_pool_kind kind, ABT_pool_access access,
 void ABTI_pool_free(ABTI_pool *p_pool);
 int ABTI_pool_get_fifo_def(ABT_pool_access access, ABT_pool_def *p_def);
 int ABTI_pool_get_fifo_wait_def(ABT_pool_access access, ABT_pool_def *p_def);
+int ABTI_pool_get_fifo_lockfree_def(ABT_pool_access access,
+                                    ABT_pool_def *p_def);
+int ABTI_pool_get_deque_def(ABT_pool_access access, ABT_pool_def *p_def);
 #ifndef ABT_CONFIG_DISABLE_POOL_CONSUMER_CHECK
 int ABTI_pool_set_consumer(ABTI_pool *p_pool,
                            ABTI_native_thread_id consumer_id);
@@ -541,9 +844,12 @@ int ABTI_pool_set_producer(ABTI_pool *p_pool,
 int ABTI_pool_accept_migration(ABTI_pool *p_pool, ABTI_pool *source);
 void ABTI_pool_print(ABTI_pool *p_pool, FILE *p_os, int indent);
 void ABTI_pool_reset_id(void);
+void ABTI_pool_unpark(ABTI_pool *p_pool, size_t num_xstreams);
 
 /* Work Unit */
 void ABTI_unit_set_associated_pool(ABT_unit unit, ABTI_pool *p_pool);
+ABT_unit ABTI_unit_move_to_pool(ABTI_pool *p_src, ABT_unit unit,
+                                ABTI_pool *p_dst);
 
 /* User-level Thread (ULT)  */
 int   ABTI_thread_migrate_to_pool(ABTI_local **pp_local, ABTI_thread *p_thread,
@@ -561,9 +867,25 @@ int   ABTI_thread_create_sched(ABTI_local *p_local, ABTI_pool *p_pool,
 void  ABTI_thread_free(ABTI_local *p_local, ABTI_thread *p_thread);
 void  ABTI_thread_free_main(ABTI_local *p_local, ABTI_thread *p_thread);
 void  ABTI_thread_free_main_sched(ABTI_local *p_local, ABTI_thread *p_thread);
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
+int   ABTI_thread_prepare_task_stack(ABTI_local *p_local, ABTI_pool *p_pool,
+                                     void (*thread_func)(void *), void *arg,
+                                     ABTI_thread **pp_thread);
+ABT_bool ABTI_thread_load_copy_stack(ABTI_local *p_local,
+                                     ABTI_thread *p_thread);
+void  ABTI_thread_release_copy_stack(ABTI_local *p_local,
+                                     ABTI_thread *p_thread);
+#endif
 int   ABTI_thread_set_blocked(ABTI_thread *p_thread);
+void  ABTI_thread_unset_blocked(ABTI_thread *p_thread);
 void  ABTI_thread_suspend(ABTI_local **pp_local, ABTI_thread *p_thread);
 int   ABTI_thread_set_ready(ABTI_local *p_local, ABTI_thread *p_thread);
+int   ABTI_thread_set_ready_many(ABTI_local *p_local, int num_threads,
+                                 ABTI_thread **p_threads);
+int   ABTI_thread_sleep_until(ABTI_local **pp_local, uint64_t deadline_nsec);
+ABT_bool ABTI_thread_suspend_until(ABTI_local **pp_local, ABTI_thread *p_thread,
+        uint64_t deadline_nsec,
+        ABT_bool (*f_remove)(ABTI_thread *p_thread, void *p_obj), void *p_obj);
 void  ABTI_thread_print(ABTI_thread *p_thread, FILE *p_os, int indent);
 int   ABTI_thread_print_stack(ABTI_thread *p_thread, FILE *p_os);
 #ifndef ABT_CONFIG_DISABLE_MIGRATION
@@ -598,6 +920,8 @@ ABTI_thread *ABTI_thread_htable_pop(ABTI_thread_htable *p_htable,
                                     ABTI_thread_queue *p_queue);
 ABTI_thread *ABTI_thread_htable_pop_low(ABTI_thread_htable *p_htable,
                                         ABTI_thread_queue *p_queue);
+ABT_bool ABTI_thread_htable_remove(ABTI_thread_htable *p_htable, int idx,
+                                   ABTI_thread *p_thread);
 ABT_bool ABTI_thread_htable_switch_low(ABTI_local **pp_local,
                                        ABTI_thread_queue *p_queue,
                                        ABTI_thread *p_thread,
@@ -607,6 +931,9 @@ ABT_bool ABTI_thread_htable_switch_low(ABTI_local **pp_local,
 int ABTI_task_create_sched(ABTI_local *p_local, ABTI_pool *p_pool,
                            ABTI_sched *p_sched);
 void ABTI_task_free(ABTI_local *p_local, ABTI_task *p_task);
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
+void ABTI_task_promote_to_thread(ABTI_local *p_local);
+#endif
 void ABTI_task_print(ABTI_task *p_task, FILE *p_os, int indent);
 void ABTI_task_retain(ABTI_task *p_task);
 void ABTI_task_release(ABTI_task *p_task);
@@ -619,20 +946,62 @@ void ABTI_ktable_free(ABTI_ktable *p_ktable);
 
 /* Mutex */
 void ABTI_mutex_wait(ABTI_local **pp_local, ABTI_mutex *p_mutex, int val);
+ABT_bool ABTI_mutex_wait_until(ABTI_local **pp_local, ABTI_mutex *p_mutex,
+                               int val, uint64_t deadline_nsec);
 void ABTI_mutex_wait_low(ABTI_local **pp_local, ABTI_mutex *p_mutex, int val);
 void ABTI_mutex_wake_se(ABTI_mutex *p_mutex, int num);
 void ABTI_mutex_wake_de(ABTI_local *p_local, ABTI_mutex *p_mutex);
+void ABTI_mutex_lock_fifo(ABTI_local **pp_local, ABTI_mutex *p_mutex,
+                          ABT_bool can_suspend);
+void ABTI_mutex_unlock_fifo(ABTI_local *p_local, ABTI_mutex *p_mutex);
+
+/* RWLock */
+int ABTI_rwlock_rdlock_wait(ABTI_local **pp_local, ABTI_rwlock *p_rwlock,
+                            int shard);
+int ABTI_rwlock_wrlock_wait(ABTI_local **pp_local, ABTI_rwlock *p_rwlock,
+                            ABT_bool is_pending);
+void ABTI_rwlock_wake_drain(ABTI_local *p_local, ABTI_rwlock *p_rwlock);
+void ABTI_rwlock_wrunlock(ABTI_local *p_local, ABTI_rwlock *p_rwlock);
 
 /* Mutex Attributes */
 void ABTI_mutex_attr_print(ABTI_mutex_attr *p_attr, FILE *p_os, int indent);
 void ABTI_mutex_attr_get_str(ABTI_mutex_attr *p_attr, char *p_buf);
 
+/* Timer Wheel */
+ABTI_twheel *ABTI_twheel_create(void);
+void ABTI_twheel_free(ABTI_twheel *p_wheel);
+void ABTI_twheel_add(ABTI_twheel *p_wheel, ABTI_twheel_entry *p_entry);
+ABT_bool ABTI_twheel_remove(ABTI_twheel_entry *p_entry);
+void ABTI_twheel_cancel(ABTI_twheel_entry *p_entry);
+void ABTI_twheel_fired(ABTI_twheel_entry *p_entry);
+void ABTI_twheel_advance(ABTI_local *p_local, ABTI_twheel *p_wheel,
+                         uint64_t now_nsec);
+uint64_t ABTI_twheel_get_next_nsec(ABTI_twheel *p_wheel);
+
 /* Information */
 int ABTI_info_print_config(FILE *fp);
 void ABTI_info_check_print_all_thread_stacks(void);
 
+/* Stack Usage */
+void ABTI_stack_usage_init(ABTI_global *p_global);
+void ABTI_stack_usage_finalize(ABTI_global *p_global);
+void ABTI_stack_usage_fill(ABTI_thread *p_thread);
+void ABTI_stack_usage_record(ABTI_thread *p_thread);
+size_t ABTI_stack_usage_get_stacksize(void (*f_thread)(void *));
+void ABTI_stack_usage_print(FILE *fp);
+
+/* Event Tracing */
+#ifdef ABT_CONFIG_USE_TRACE
+void ABTI_trace_init(ABTI_global *p_global);
+void ABTI_trace_finalize(ABTI_global *p_global);
+void ABTI_trace_xstream_init(ABTI_xstream *p_xstream);
+void ABTI_trace_xstream_finalize(ABTI_xstream *p_xstream);
+void ABTI_trace_print(ABTI_global *p_global, FILE *fp);
+#endif
+
 #include "abti_log.h"
 #include "abti_local.h"
+#include "abti_trace.h"
 #include "abti_global.h"
 #include "abti_pool.h"
 #include "abti_sched.h"
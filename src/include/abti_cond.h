@@ -71,7 +71,7 @@ int ABTI_cond_wait(ABTI_local **pp_local, ABTI_cond *p_cond,
     ABTI_thread *p_thread;
     ABTI_unit *p_unit;
     ABT_unit_type type;
-    int32_t ext_signal = 0;
+    uint32_t ext_signal = 0;
 
     if (p_local != NULL) {
         p_thread = p_local->p_thread;
@@ -136,9 +136,8 @@ int ABTI_cond_wait(ABTI_local **pp_local, ABTI_cond *p_cond,
         ABTI_spinlock_release(&p_cond->lock);
         ABTI_mutex_unlock(p_local, p_mutex);
 
-        /* External thread is waiting here polling ext_signal. */
-        /* FIXME: need a better implementation */
-        while (!ABTD_atomic_load_int32(&ext_signal));
+        /* External thread is blocked here until ext_signal is set. */
+        ABTD_futex_signal_wait(&ext_signal);
         ABTU_free(p_unit);
     }
 
@@ -163,7 +162,9 @@ void ABTI_cond_broadcast(ABTI_local *p_local, ABTI_cond *p_cond)
         return;
     }
 
-    /* Wake up all waiting ULTs */
+    /* Wake up all waiting ULTs.  ULTs are made ready in batches. */
+    ABTI_thread *p_threads[ABTI_POOL_PUSH_BATCH];
+    int num_threads = 0;
     ABTI_unit *p_head = p_cond->p_head;
     ABTI_unit *p_unit = p_head;
     while (1) {
@@ -173,12 +174,15 @@ void ABTI_cond_broadcast(ABTI_local *p_local, ABTI_cond *p_cond)
         p_unit->p_next = NULL;
 
         if (p_unit->type == ABT_UNIT_TYPE_THREAD) {
-            ABTI_thread *p_thread = ABTI_thread_get_ptr(p_unit->handle.thread);
-            ABTI_thread_set_ready(p_local, p_thread);
+            p_threads[num_threads++] =
+                ABTI_thread_get_ptr(p_unit->handle.thread);
+            if (num_threads == ABTI_POOL_PUSH_BATCH) {
+                ABTI_thread_set_ready_many(p_local, num_threads, p_threads);
+                num_threads = 0;
+            }
         } else {
             /* When the head is an external thread */
-            int32_t *p_ext_signal = (int32_t *)p_unit->pool;
-            ABTD_atomic_store_int32(p_ext_signal, 1);
+            ABTD_futex_signal_set((uint32_t *)p_unit->pool);
         }
 
         /* Next ULT */
@@ -188,6 +192,9 @@ void ABTI_cond_broadcast(ABTI_local *p_local, ABTI_cond *p_cond)
             break;
         }
     }
+    if (num_threads > 0) {
+        ABTI_thread_set_ready_many(p_local, num_threads, p_threads);
+    }
 
     p_cond->p_waiter_mutex = NULL;
     p_cond->num_waiters = 0;
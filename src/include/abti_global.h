@@ -32,6 +32,20 @@ long ABTI_global_get_sched_sleep_nsec(void)
     return gp_ABTI_global->sched_sleep_nsec;
 }
 
+#ifdef ABT_CONFIG_USE_SCHED_PARK
+static inline
+uint32_t ABTI_global_get_sched_park_spin_usec(void)
+{
+    return gp_ABTI_global->sched_park_spin_usec;
+}
+
+static inline
+uint32_t ABTI_global_get_sched_park_timeout_usec(void)
+{
+    return gp_ABTI_global->sched_park_timeout_usec;
+}
+#endif
+
 static inline
 ABTI_thread *ABTI_global_get_main(void)
 {
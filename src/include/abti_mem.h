@@ -29,16 +29,22 @@ struct ABTI_sp_header {
     uint32_t num_total_stacks;  /* Number of total stacks */
     uint32_t num_empty_stacks;  /* Number of empty stacks */
     size_t stacksize;           /* Stack size */
+    int stack_class;            /* Index of the stack size class */
+    int node;                   /* NUMA node (-1: unknown) */
     uint64_t id;                /* ID */
     ABT_bool is_mmapped;        /* ABT_TRUE if it is mmapped */
+    uint32_t num_trim_stacks;   /* Number of free stacks found by trimming */
     void *p_sp;                 /* Pointer to the allocated stack page */
     ABTI_sp_header *p_next;     /* Next stack page header */
+    ABTI_sp_header *p_trim_next; /* Next stack page freed by trimming */
 };
 
 struct ABTI_stack_header {
     ABTI_stack_header *p_next;
     ABTI_sp_header *p_sph;
     void *p_stack;
+    uint32_t trim_gen;          /* Trimming generation when it was freed */
+    ABT_bool is_trimmed;        /* ABT_TRUE if its memory has been released */
 };
 
 struct ABTI_page_header {
@@ -52,6 +58,7 @@ struct ABTI_page_header {
     ABTI_page_header *p_prev;   /* Prev page header */
     ABTI_page_header *p_next;   /* Next page header */
     ABT_bool is_mmapped;        /* ABT_TRUE if it is mmapped */
+    int node;                   /* NUMA node (-1: unknown) */
 };
 
 struct ABTI_blk_header {
@@ -65,15 +72,69 @@ void ABTI_mem_finalize(ABTI_global *p_global);
 void ABTI_mem_finalize_local(ABTI_local *p_local);
 int ABTI_mem_check_lp_alloc(int lp_alloc);
 
-char *ABTI_mem_take_global_stack(ABTI_local *p_local);
+int ABTI_mem_get_local_node(ABTI_local *p_local);
+char *ABTI_mem_take_global_stack(ABTI_local *p_local, int stack_class,
+                                 int node);
 void ABTI_mem_add_stack_to_global(ABTI_stack_header *p_sh);
-ABTI_page_header *ABTI_mem_alloc_page(ABTI_local *p_local, size_t blk_size);
-void ABTI_mem_free_page(ABTI_local *p_local, ABTI_page_header *p_ph);
+void ABTI_mem_trim_local(ABTI_local *p_local, ABT_bool trim_all);
+void ABTI_mem_trim_global(ABT_bool trim_all);
+ABTI_page_header *ABTI_mem_alloc_page(ABTI_local *p_local,
+                                      ABTI_page_header **pp_head,
+                                      ABTI_page_header **pp_tail,
+                                      size_t pgsize, size_t blk_size,
+                                      int node);
+void ABTI_mem_free_page(ABTI_page_header **pp_head, ABTI_page_header **pp_tail,
+                        ABTI_page_header *p_ph);
 void ABTI_mem_take_free(ABTI_page_header *p_ph);
 void ABTI_mem_free_remote(ABTI_page_header *p_ph, ABTI_blk_header *p_bh);
-ABTI_page_header *ABTI_mem_take_global_page(ABTI_local *p_local);
+ABTI_page_header *ABTI_mem_take_global_page(ABTI_local *p_local,
+                                            ABTI_page_header **pp_global,
+                                            ABTI_page_header **pp_head,
+                                            ABTI_page_header **pp_tail);
 
-char *ABTI_mem_alloc_sp(ABTI_local *p_local, size_t stacksize);
+char *ABTI_mem_alloc_sp(ABTI_local *p_local, int stack_class, int node);
+
+/* Return the index of the global free lists for the NUMA node node.  Memory
+ * of no node (-1) goes to the last lists, which are the only ones if
+ * NUMA-aware placement is disabled. */
+static inline
+int ABTI_mem_get_node_index(int node)
+{
+    int num_nodes = gp_ABTI_global->mem_num_nodes - 1;
+    return (node < 0 || num_nodes == 0) ? num_nodes : node % num_nodes;
+}
+
+/* Return the end of the guard page of a pooled stack whose stack area starts
+ * at p_stack.  The guard page is the lowest OS page that lies entirely in the
+ * stack area. */
+static inline
+char *ABTI_mem_get_stack_guard_end(void *p_stack)
+{
+    uintptr_t pgsize = (uintptr_t)gp_ABTI_global->os_page_size;
+    uintptr_t guard = ((uintptr_t)p_stack + pgsize - 1) & ~(pgsize - 1);
+    return (char *)(guard + pgsize);
+}
+
+/* Return the smallest stack size class whose stacks are not smaller than a
+ * stack of stacksize bytes allocated by ABTU_malloc, or -1 if there is no such
+ * class.  A class of exactly stacksize bytes is also used as the default stack
+ * size is. */
+static inline
+int ABTI_mem_get_stack_class(size_t stacksize)
+{
+    int i;
+    /* A guard page and its alignment take up to two OS pages. */
+    size_t guard_size = (gp_ABTI_global->mem_stack_guard == ABT_TRUE)
+                      ? 2 * gp_ABTI_global->os_page_size : 0;
+    for (i = 0; i < gp_ABTI_global->mem_num_stack_classes; i++) {
+        size_t class_size = gp_ABTI_global->mem_stack_classes[i];
+        if (stacksize == class_size ||
+            stacksize + sizeof(ABTI_stack_header) + guard_size <= class_size) {
+            return i;
+        }
+    }
+    return -1;
+}
 
 
 /******************************************************************************
@@ -139,24 +200,16 @@ ABTI_thread *ABTI_mem_alloc_thread(ABTI_local *p_local,
      * ABTI_stack_header and ABTI_thread. So, the effective stack area is
      * reduced as much as the size of ABTI_stack_header and ABTI_thread. */
 
-    size_t stacksize, def_stacksize, actual_stacksize;
+    size_t stacksize, actual_stacksize;
     char *p_blk = NULL;
     ABTI_thread *p_thread;
     ABTI_stack_header *p_sh;
     void *p_stack;
+    int stack_class;
 
     /* Get the stack size */
-    def_stacksize = ABTI_global_get_thread_stacksize();
     if (p_attr == NULL) {
-        stacksize = def_stacksize;
-
-#ifndef ABT_CONFIG_DISABLE_EXT_THREAD
-        /* If an external thread allocates a stack, we use ABTU_malloc. */
-        if (p_local == NULL) {
-            return ABTI_mem_alloc_thread_with_stacksize(stacksize, NULL);
-        }
-#endif
-
+        stacksize = ABTI_global_get_thread_stacksize();
     } else {
         ABTI_stack_type stacktype = p_attr->stacktype;
         if (stacktype == ABTI_STACK_TYPE_USER ||
@@ -172,48 +225,87 @@ ABTI_thread *ABTI_mem_alloc_thread(ABTI_local *p_local,
             }
             return p_thread;
         }
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
+        if (stacktype == ABTI_STACK_TYPE_COPY) {
+            /* A stack-copying ULT runs on the stack shared in an ES, which is
+             * chosen when it runs for the first time.  Its context is created
+             * on that stack, so it always uses dynamic promotion. */
+            p_thread = (ABTI_thread *)ABTU_malloc(sizeof(ABTI_thread));
+            ABTI_thread_attr_copy(&p_thread->attr, p_attr);
+            p_thread->attr.p_stack = NULL;
+            p_thread->attr.stacksize = gp_ABTI_global->copy_stacksize;
+            p_thread->attr.dynamic_promotion = ABT_TRUE;
+#ifndef ABT_CONFIG_DISABLE_MIGRATION
+            /* Its frames refer to the shared stack of the ES. */
+            p_thread->attr.migratable = ABT_FALSE;
+#endif
+            return p_thread;
+        }
+#endif
 
         stacksize = p_attr->stacksize;
-        if (stacksize != def_stacksize || stacktype == ABTI_STACK_TYPE_MALLOC) {
-            /* Since the stack size requested is not the same as default one,
-             * we use ABTU_malloc. */
+        if (stacktype == ABTI_STACK_TYPE_MALLOC) {
             return ABTI_mem_alloc_thread_with_stacksize(stacksize, p_attr);
         }
     }
 
-    /* Use the stack pool */
-    if (p_local->p_mem_stack) {
+    /* Stacks larger than any size class are allocated by ABTU_malloc. */
+    stack_class = ABTI_mem_get_stack_class(stacksize);
+    if (stack_class < 0) {
+        return ABTI_mem_alloc_thread_with_stacksize(stacksize, p_attr);
+    }
+
+#ifndef ABT_CONFIG_DISABLE_EXT_THREAD
+    /* If an external thread allocates a stack, we use ABTU_malloc. */
+    if (p_local == NULL) {
+        return ABTI_mem_alloc_thread_with_stacksize(stacksize, p_attr);
+    }
+#endif
+
+    /* Use the stack pool of the size class */
+    if (p_local->p_mem_stack[stack_class]) {
         /* ES's stack pool has an available stack */
-        p_sh = p_local->p_mem_stack;
-        p_local->p_mem_stack = p_sh->p_next;
-        p_local->num_stacks--;
+        p_sh = p_local->p_mem_stack[stack_class];
+        p_local->p_mem_stack[stack_class] = p_sh->p_next;
+        p_local->num_stacks[stack_class]--;
 
         p_sh->p_next = NULL;
         p_blk = (char *)p_sh - sizeof(ABTI_thread);
 
     } else {
-        /* Check stacks in the global data */
-        if (gp_ABTI_global->p_mem_stack) {
-            p_blk = ABTI_mem_take_global_stack(p_local);
+        /* Check stacks in the global data of the NUMA node of the ES */
+        int node = ABTI_mem_get_local_node(p_local);
+        int idx = ABTI_mem_get_node_index(node);
+        if (gp_ABTI_global->p_mem_stack[stack_class][idx]) {
+            p_blk = ABTI_mem_take_global_stack(p_local, stack_class, node);
             if (p_blk == NULL) {
-                p_blk = ABTI_mem_alloc_sp(p_local, stacksize);
+                p_blk = ABTI_mem_alloc_sp(p_local, stack_class, node);
             }
         } else {
             /* Allocate a new stack if we don't have any empty stack */
-            p_blk = ABTI_mem_alloc_sp(p_local, stacksize);
+            p_blk = ABTI_mem_alloc_sp(p_local, stack_class, node);
         }
 
         p_sh = (ABTI_stack_header *)(p_blk + sizeof(ABTI_thread));
         p_sh->p_next = NULL;
     }
+    p_sh->is_trimmed = ABT_FALSE;
 
     /* Actual stack size */
+    stacksize = gp_ABTI_global->mem_stack_classes[stack_class];
     actual_stacksize = stacksize - ABTI_MEM_SH_SIZE;
 
     /* Get the ABTI_thread pointer and stack pointer */
     p_thread = (ABTI_thread *)p_blk;
     p_stack  = p_sh->p_stack;
 
+    /* The guard page is not a part of the usable stack. */
+    if (gp_ABTI_global->mem_stack_guard == ABT_TRUE) {
+        char *p_guard_end = ABTI_mem_get_stack_guard_end(p_stack);
+        actual_stacksize -= p_guard_end - (char *)p_stack;
+        p_stack = (void *)p_guard_end;
+    }
+
     /* Set attributes */
     if (p_attr == NULL) {
         ABTI_thread_attr *p_myattr = &p_thread->attr;
@@ -250,34 +342,30 @@ void ABTI_mem_free_thread(ABTI_local *p_local, ABTI_thread *p_thread)
     }
 #endif
 
-    if (p_local->num_stacks <= gp_ABTI_global->mem_max_stacks) {
-        p_sh->p_next = p_local->p_mem_stack;
-        p_local->p_mem_stack = p_sh;
-        p_local->num_stacks++;
+    int stack_class = p_sh->p_sph->stack_class;
+    if (p_local->num_stacks[stack_class] <= gp_ABTI_global->mem_max_stacks) {
+        p_sh->trim_gen = p_local->mem_trim_gen;
+        p_sh->p_next = p_local->p_mem_stack[stack_class];
+        p_local->p_mem_stack[stack_class] = p_sh;
+        p_local->num_stacks[stack_class]++;
     } else {
         ABTI_mem_add_stack_to_global(p_sh);
     }
 }
 
+/* Take an empty block of blk_size bytes from the page list of the calling ES
+ * given by pp_head and pp_tail.  If no page has an empty block, a page is
+ * taken from the global list of the NUMA node of the ES in pp_globals or a
+ * page of pgsize bytes is newly allocated. */
 static inline
-ABTI_task *ABTI_mem_alloc_task(ABTI_local *p_local)
+ABTI_blk_header *ABTI_mem_alloc_blk(ABTI_local *p_local,
+                                    ABTI_page_header **pp_head,
+                                    ABTI_page_header **pp_tail,
+                                    ABTI_page_header **pp_globals,
+                                    size_t pgsize, size_t blk_size)
 {
-    ABTI_task *p_task = NULL;
-    const size_t blk_size = sizeof(ABTI_blk_header) + sizeof(ABTI_task);
-
-#ifndef ABT_CONFIG_DISABLE_EXT_THREAD
-    if (p_local == NULL) {
-        /* For external threads */
-        char *p_blk = (char *)ABTU_malloc(blk_size);
-        ABTI_blk_header *p_blk_header = (ABTI_blk_header *)p_blk;
-        p_blk_header->p_ph = NULL;
-        p_task = (ABTI_task *)(p_blk + sizeof(ABTI_blk_header));
-        return p_task;
-    }
-#endif
-
     /* Find the page that has an empty block */
-    ABTI_page_header *p_ph = p_local->p_mem_task_head;
+    ABTI_page_header *p_ph = *pp_head;
     while (p_ph) {
         if (p_ph->p_head) break;
         if (p_ph->p_free) {
@@ -286,7 +374,7 @@ ABTI_task *ABTI_mem_alloc_task(ABTI_local *p_local)
         }
 
         p_ph = p_ph->p_next;
-        if (p_ph == p_local->p_mem_task_head) {
+        if (p_ph == *pp_head) {
             p_ph = NULL;
             break;
         }
@@ -295,14 +383,20 @@ ABTI_task *ABTI_mem_alloc_task(ABTI_local *p_local)
     /* If there is no page that has an empty block */
     if (p_ph == NULL) {
         /* Check pages in the global data */
-        if (gp_ABTI_global->p_mem_task) {
-            p_ph = ABTI_mem_take_global_page(p_local);
+        int node = ABTI_mem_get_local_node(p_local);
+        ABTI_page_header **pp_global =
+            &pp_globals[ABTI_mem_get_node_index(node)];
+        if (*pp_global) {
+            p_ph = ABTI_mem_take_global_page(p_local, pp_global, pp_head,
+                                             pp_tail);
             if (p_ph == NULL) {
-                p_ph = ABTI_mem_alloc_page(p_local, blk_size);
+                p_ph = ABTI_mem_alloc_page(p_local, pp_head, pp_tail,
+                                           pgsize, blk_size, node);
             }
         } else {
             /* Allocate a new page */
-            p_ph = ABTI_mem_alloc_page(p_local, blk_size);
+            p_ph = ABTI_mem_alloc_page(p_local, pp_head, pp_tail, pgsize,
+                                       blk_size, node);
         }
     }
 
@@ -310,27 +404,24 @@ ABTI_task *ABTI_mem_alloc_task(ABTI_local *p_local)
     p_ph->p_head = p_head->p_next;
     p_ph->num_empty_blks--;
 
-    p_task = (ABTI_task *)((char *)p_head + sizeof(ABTI_blk_header));
-
-    return p_task;
+    return p_head;
 }
 
+/* Return a block to its page.  A block whose page is NULL is freed by
+ * ABTU_free. */
 static inline
-void ABTI_mem_free_task(ABTI_local *p_local, ABTI_task *p_task)
+void ABTI_mem_free_blk(ABTI_local *p_local, ABTI_blk_header *p_head)
 {
-    ABTI_blk_header *p_head;
-    ABTI_page_header *p_ph;
+    ABTI_page_header *p_ph = p_head->p_ph;
 
-    p_head = (ABTI_blk_header *)((char *)p_task - sizeof(ABTI_blk_header));
-    p_ph = p_head->p_ph;
-
-#ifndef ABT_CONFIG_DISABLE_EXT_THREAD
     if (p_ph == NULL) {
-        /* This was allocated by an external thread. */
+        /* This was allocated by an external thread or by ABTU_malloc. */
         ABTU_free(p_head);
         return;
-    } else if (!p_local) {
-        /* This task has been allocated internally,
+    }
+#ifndef ABT_CONFIG_DISABLE_EXT_THREAD
+    if (!p_local) {
+        /* This block has been allocated internally,
          * but now is being freed by an external thread. */
         ABTI_mem_free_remote(p_ph, p_head);
         return;
@@ -343,19 +434,104 @@ void ABTI_mem_free_task(ABTI_local *p_local, ABTI_task *p_task)
         p_ph->num_empty_blks++;
 
         /* TODO: Need to decrease the number of pages */
-        /* ABTI_mem_free_page(p_local, p_ph); */
+        /* ABTI_mem_free_page(pp_head, pp_tail, p_ph); */
     } else {
         /* Remote free */
         ABTI_mem_free_remote(p_ph, p_head);
     }
 }
 
+static inline
+ABTI_task *ABTI_mem_alloc_task(ABTI_local *p_local)
+{
+    const size_t blk_size = sizeof(ABTI_blk_header) + sizeof(ABTI_task);
+    ABTI_blk_header *p_head;
+
+#ifndef ABT_CONFIG_DISABLE_EXT_THREAD
+    if (p_local == NULL) {
+        /* For external threads */
+        p_head = (ABTI_blk_header *)ABTU_malloc(blk_size);
+        p_head->p_ph = NULL;
+        return (ABTI_task *)((char *)p_head + sizeof(ABTI_blk_header));
+    }
+#endif
+
+    p_head = ABTI_mem_alloc_blk(p_local, &p_local->p_mem_task_head,
+                                &p_local->p_mem_task_tail,
+                                gp_ABTI_global->p_mem_task,
+                                gp_ABTI_global->mem_page_size, blk_size);
+    return (ABTI_task *)((char *)p_head + sizeof(ABTI_blk_header));
+}
+
+static inline
+void ABTI_mem_free_task(ABTI_local *p_local, ABTI_task *p_task)
+{
+    ABTI_mem_free_blk(p_local, (ABTI_blk_header *)
+                      ((char *)p_task - sizeof(ABTI_blk_header)));
+}
+
+/* Allocate size bytes for a synchronization object (e.g., a mutex) from the
+ * slab cache of the calling ES.  The block size class is the smallest one
+ * that fits the object and the block header.  External threads and objects
+ * larger than the largest class use ABTU_malloc. */
+static inline
+void *ABTI_mem_alloc_slab(ABTI_local *p_local, size_t size)
+{
+    size_t blk_size = ABTI_MEM_SLAB_MIN_BLK_SIZE;
+    ABTI_blk_header *p_head;
+    int i;
+
+    for (i = 0; i < ABTI_MEM_NUM_SLABS; i++) {
+        if (sizeof(ABTI_blk_header) + size <= blk_size) break;
+        blk_size <<= 1;
+    }
+
+    if (p_local == NULL || i == ABTI_MEM_NUM_SLABS) {
+        p_head = (ABTI_blk_header *)
+            ABTU_malloc(sizeof(ABTI_blk_header) + size);
+        p_head->p_ph = NULL;
+    } else {
+        size_t pgsize = (size_t)gp_ABTI_global->os_page_size
+                      * ABTI_MEM_SLAB_PAGE_OS_PAGES;
+        p_head = ABTI_mem_alloc_blk(p_local, &p_local->p_mem_slab_head[i],
+                                    &p_local->p_mem_slab_tail[i],
+                                    gp_ABTI_global->p_mem_slab[i], pgsize,
+                                    blk_size);
+    }
+    return (void *)((char *)p_head + sizeof(ABTI_blk_header));
+}
+
+/* Free an object allocated by ABTI_mem_alloc_slab().  It can be freed by any
+ * ES or external thread. */
+static inline
+void ABTI_mem_free_slab(ABTI_local *p_local, void *p_obj)
+{
+    ABTI_mem_free_blk(p_local, (ABTI_blk_header *)
+                      ((char *)p_obj - sizeof(ABTI_blk_header)));
+}
+
+/* Trim the free stacks of the calling ES if ABT_mem_trim() has been called or
+ * the trimming interval has passed.  Schedulers call this periodically. */
+static inline
+void ABTI_mem_check_trim(ABTI_local *p_local)
+{
+    ABTI_global *p_global = gp_ABTI_global;
+    if (p_local->mem_trim_epoch !=
+        ABTD_atomic_load_uint32(&p_global->mem_trim_epoch)) {
+        ABTI_mem_trim_local(p_local, ABT_TRUE);
+    } else if (p_global->mem_trim_nsec > 0 &&
+               ABTI_get_wtime_nsec() >= p_local->mem_trim_next) {
+        ABTI_mem_trim_local(p_local, ABT_FALSE);
+    }
+}
+
 #else /* ABT_CONFIG_USE_MEM_POOL */
 
 #define ABTI_mem_init(p)
 #define ABTI_mem_init_local(p)
 #define ABTI_mem_finalize(p)
 #define ABTI_mem_finalize_local(p)
+#define ABTI_mem_check_trim(p)
 
 static inline
 ABTI_thread *ABTI_mem_alloc_thread_with_stacksize(size_t *p_stacksize)
@@ -452,7 +628,33 @@ void ABTI_mem_free_task(ABTI_task *p_task)
     ABTU_free(p_task);
 }
 
+#define ABTI_mem_alloc_slab(p_local, size)  ABTU_malloc(size)
+#define ABTI_mem_free_slab(p_local, p_obj)  ABTU_free(p_obj)
+
 #endif /* ABT_CONFIG_USE_MEM_POOL */
 
+/* Return size bytes for an object that others access while the calling ULT
+ * waits, e.g., a queue node.  p_stack_obj on the stack of the caller is
+ * returned unless the caller is a stack-copying ULT, whose stack is used by
+ * other ULTs while it waits.  The object is released by
+ * ABTI_mem_free_wait_obj(). */
+static inline
+void *ABTI_mem_alloc_wait_obj(ABTI_local *p_local, void *p_stack_obj,
+                              size_t size)
+{
+    if (p_local && p_local->p_thread &&
+        ABTI_thread_is_stack_copy(p_local->p_thread) == ABT_TRUE) {
+        return ABTI_mem_alloc_slab(p_local, size);
+    }
+    return p_stack_obj;
+}
+
+static inline
+void ABTI_mem_free_wait_obj(ABTI_local *p_local, void *p_obj,
+                            void *p_stack_obj)
+{
+    if (p_obj != p_stack_obj) ABTI_mem_free_slab(p_local, p_obj);
+}
+
 #endif /* ABTI_MEM_H_INCLUDED */
 
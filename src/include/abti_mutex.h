@@ -45,8 +45,12 @@ void ABTI_mutex_init(ABTI_mutex *p_mutex)
     p_mutex->attr.attrs = ABTI_MUTEX_ATTR_NONE;
     p_mutex->attr.max_handovers = ABTI_global_get_mutex_max_handovers();
     p_mutex->attr.max_wakeups = ABTI_global_get_mutex_max_wakeups();
+    p_mutex->p_tail = NULL;
+    p_mutex->qhead.p_next = NULL;
+    p_mutex->spin_limit = ABTI_MUTEX_SPIN_MIN;
 #ifndef ABT_CONFIG_USE_SIMPLE_MUTEX
-    p_mutex->p_htable = ABTI_thread_htable_create(gp_ABTI_global->max_xstreams);
+    /* The wait queues are created on the first contention. */
+    p_mutex->p_htable = NULL;
     p_mutex->p_handover = NULL;
     p_mutex->p_giver = NULL;
 #endif
@@ -58,13 +62,35 @@ void ABTI_mutex_init(ABTI_mutex *p_mutex)
 static inline
 void ABTI_mutex_fini(ABTI_mutex *p_mutex)
 {
-    ABTI_thread_htable_free(p_mutex->p_htable);
+    if (p_mutex->p_htable) ABTI_thread_htable_free(p_mutex->p_htable);
 }
 #endif
 
+static inline
+ABT_bool ABTI_mutex_is_fifo(ABTI_mutex *p_mutex)
+{
+    return (p_mutex->attr.attrs & ABTI_MUTEX_ATTR_FIFO) ? ABT_TRUE : ABT_FALSE;
+}
+
+/* Lock a FIFO mutex if it is not locked */
+static inline
+ABT_bool ABTI_mutex_trylock_fifo(ABTI_mutex *p_mutex)
+{
+    return ABTD_atomic_bool_cas_strong_ptr((void **)&p_mutex->p_tail, NULL,
+                                           &p_mutex->qhead) ? ABT_TRUE
+                                                            : ABT_FALSE;
+}
+
 static inline
 void ABTI_mutex_spinlock(ABTI_mutex *p_mutex)
 {
+    if (ABTI_mutex_is_fifo(p_mutex)) {
+        if (ABTI_mutex_trylock_fifo(p_mutex) == ABT_FALSE) {
+            ABTI_local *p_local = ABTI_local_get_local();
+            ABTI_mutex_lock_fifo(&p_local, p_mutex, ABT_FALSE);
+        }
+        return;
+    }
     /* ABTI_spinlock_ functions cannot be used since p_mutex->val can take
      * other values (i.e., not UNLOCKED nor LOCKED.) */
     while (!ABTD_atomic_bool_cas_weak_uint32(&p_mutex->val, 0, 1)) {
@@ -76,14 +102,24 @@ void ABTI_mutex_spinlock(ABTI_mutex *p_mutex)
 static inline
 void ABTI_mutex_lock(ABTI_local **pp_local, ABTI_mutex *p_mutex)
 {
+    if (ABTI_mutex_is_fifo(p_mutex)) {
+        if (ABTI_mutex_trylock_fifo(p_mutex) == ABT_FALSE) {
+            ABTI_mutex_lock_fifo(pp_local, p_mutex, ABT_TRUE);
+        }
+        return;
+    }
+
 #ifdef ABT_CONFIG_USE_SIMPLE_MUTEX
     ABTI_local *p_local = *pp_local;
-    ABT_unit_type type = ABTI_self_get_type(p_local);
+    ABT_unit_type type = ABTI_self_get_suspend_type(p_local);
     if (type == ABT_UNIT_TYPE_THREAD) {
         LOG_EVENT("%p: lock - try\n", p_mutex);
-        while (!ABTD_atomic_bool_cas_weak_uint32(&p_mutex->val, 0, 1)) {
-            ABTI_thread_yield(pp_local, p_local->p_thread);
-            p_local = *pp_local;
+        if (!ABTD_atomic_bool_cas_weak_uint32(&p_mutex->val, 0, 1)) {
+            ABTI_TRACE_XSTREAM(p_local->p_xstream, MUTEX_CONTENDED, p_mutex, 0);
+            do {
+                ABTI_thread_yield(pp_local, p_local->p_thread);
+                p_local = *pp_local;
+            } while (!ABTD_atomic_bool_cas_weak_uint32(&p_mutex->val, 0, 1));
         }
         LOG_EVENT("%p: lock - acquired\n", p_mutex);
     } else {
@@ -91,7 +127,7 @@ void ABTI_mutex_lock(ABTI_local **pp_local, ABTI_mutex *p_mutex)
     }
 #else
     int abt_errno;
-    ABT_unit_type type = ABTI_self_get_type(*pp_local);
+    ABT_unit_type type = ABTI_self_get_suspend_type(*pp_local);
 
     /* Only ULTs can yield when the mutex has been locked. For others,
      * just call mutex_spinlock. */
@@ -99,6 +135,8 @@ void ABTI_mutex_lock(ABTI_local **pp_local, ABTI_mutex *p_mutex)
         LOG_EVENT("%p: lock - try\n", p_mutex);
         int c;
         if ((c = ABTD_atomic_val_cas_strong_uint32(&p_mutex->val, 0, 1)) != 0) {
+            ABTI_TRACE_XSTREAM((*pp_local)->p_xstream, MUTEX_CONTENDED,
+                               p_mutex, 0);
             if (c != 2) {
                 c = ABTD_atomic_exchange_uint32(&p_mutex->val, 2);
             }
@@ -143,6 +181,10 @@ void ABTI_mutex_lock(ABTI_local **pp_local, ABTI_mutex *p_mutex)
 static inline
 int ABTI_mutex_trylock(ABTI_mutex *p_mutex)
 {
+    if (ABTI_mutex_is_fifo(p_mutex)) {
+        return (ABTI_mutex_trylock_fifo(p_mutex) == ABT_TRUE)
+               ? ABT_SUCCESS : ABT_ERR_MUTEX_LOCKED;
+    }
     if (!ABTD_atomic_bool_cas_strong_uint32(&p_mutex->val, 0, 1)) {
         return ABT_ERR_MUTEX_LOCKED;
     }
@@ -152,6 +194,16 @@ int ABTI_mutex_trylock(ABTI_mutex *p_mutex)
 static inline
 void ABTI_mutex_unlock(ABTI_local *p_local, ABTI_mutex *p_mutex)
 {
+    if (ABTI_mutex_is_fifo(p_mutex)) {
+        /* Without waiters, just unlock it. */
+        if (ABTD_atomic_load_ptr((void **)&p_mutex->qhead.p_next) != NULL ||
+            !ABTD_atomic_bool_cas_strong_ptr((void **)&p_mutex->p_tail,
+                                             &p_mutex->qhead, NULL)) {
+            ABTI_mutex_unlock_fifo(p_local, p_mutex);
+        }
+        return;
+    }
+
 #ifdef ABT_CONFIG_USE_SIMPLE_MUTEX
     ABTD_atomic_mem_barrier();
     *(volatile uint32_t *)&p_mutex->val = 0;
@@ -68,6 +68,66 @@ void ABTI_pool_dec_num_migrations(ABTI_pool *p_pool)
     ABTD_atomic_fetch_sub_int32(&p_pool->num_migrations, 1);
 }
 
+/* Make p_xstream the owner of p_pool unless another ES owns it.  Pools such
+ * as DEQUE give their owner a faster path. */
+static inline
+void ABTI_pool_bind_owner(ABTI_pool *p_pool, ABTI_xstream *p_xstream)
+{
+    ABTD_atomic_bool_cas_strong_ptr((void **)&p_pool->p_owner, NULL,
+                                    (void *)p_xstream);
+}
+
+/* Release p_pool if it is owned by p_xstream. */
+static inline
+void ABTI_pool_unbind_owner(ABTI_pool *p_pool, ABTI_xstream *p_xstream)
+{
+    ABTD_atomic_bool_cas_strong_ptr((void **)&p_pool->p_owner,
+                                    (void *)p_xstream, NULL);
+}
+
+/* Return ABT_TRUE if the caller runs on the ES that owns p_pool. */
+static inline
+ABT_bool ABTI_pool_is_owner(ABTI_pool *p_pool, ABTI_local *p_local)
+{
+    return (p_local != NULL && p_local->p_xstream != NULL &&
+            (void *)p_local->p_xstream ==
+            ABTD_atomic_load_ptr((void **)&p_pool->p_owner))
+           ? ABT_TRUE : ABT_FALSE;
+}
+
+/* Called after num_units units are pushed to p_pool.  One parked ES is woken
+ * up per unit.  The full barrier pairs with the one in ABTI_sched_park() so
+ * that either the pusher sees the parked ES or the parked ES sees the pushed
+ * unit.  Pools that no parking scheduler uses skip the barrier. */
+static inline
+void ABTI_pool_wake_parked(ABTI_pool *p_pool, size_t num_units)
+{
+    if (ABTD_atomic_load_uint32(&p_pool->park_enabled) == 0) return;
+    ABTD_atomic_full_barrier();
+    if (ABTD_atomic_load_uint32(&p_pool->num_parked) > 0) {
+        ABTI_pool_unpark(p_pool, num_units);
+    }
+}
+
+/* Push units with p_push_many if the pool defines it.  Otherwise, push them
+ * one by one. */
+static inline
+void ABTI_pool_push_many_internal(ABTI_pool *p_pool, const ABT_unit *units,
+                                  size_t num_units)
+{
+    ABT_pool pool = ABTI_pool_get_handle(p_pool);
+    size_t i;
+
+    if (p_pool->p_push_many) {
+        p_pool->p_push_many(pool, units, num_units);
+    } else {
+        for (i = 0; i < num_units; i++) {
+            p_pool->p_push(pool, units[i]);
+        }
+    }
+    ABTI_pool_wake_parked(p_pool, num_units);
+}
+
 #ifdef ABT_CONFIG_DISABLE_POOL_PRODUCER_CHECK
 static inline
 void ABTI_pool_push(ABTI_pool *p_pool, ABT_unit unit)
@@ -77,6 +137,8 @@ void ABTI_pool_push(ABTI_pool *p_pool, ABT_unit unit)
 
     /* Push unit into pool */
     p_pool->p_push(ABTI_pool_get_handle(p_pool), unit);
+    ABTI_TRACE(POOL_PUSH, unit, (uint32_t)p_pool->id);
+    ABTI_pool_wake_parked(p_pool, 1);
 }
 
 static inline
@@ -89,9 +151,35 @@ void ABTI_pool_add_thread(ABTI_thread *p_thread)
     ABTI_pool_push(p_thread->p_pool, p_thread->unit);
 }
 
+static inline
+void ABTI_pool_push_many(ABTI_pool *p_pool, const ABT_unit *units,
+                         size_t num_units)
+{
+#ifdef ABT_CONFIG_USE_DEBUG_LOG
+    size_t i;
+    ABTI_native_thread_id producer_id =
+        ABTI_self_get_native_thread_id(ABTI_local_get_local());
+    for (i = 0; i < num_units; i++) {
+        LOG_EVENT_POOL_PUSH(p_pool, units[i], producer_id);
+    }
+#endif
+
+    /* Push units into pool */
+    ABTI_pool_push_many_internal(p_pool, units, num_units);
+#ifdef ABT_CONFIG_USE_TRACE
+    size_t k;
+    for (k = 0; k < num_units; k++) {
+        ABTI_TRACE(POOL_PUSH, units[k], (uint32_t)p_pool->id);
+    }
+#endif
+}
+
 #define ABTI_POOL_PUSH(p_pool,unit,p_producer)      \
     ABTI_pool_push(p_pool, unit)
 
+#define ABTI_POOL_PUSH_MANY(p_pool,units,num_units,p_producer) \
+    ABTI_pool_push_many(p_pool, units, num_units)
+
 #define ABTI_POOL_ADD_THREAD(p_thread,p_producer)   \
     ABTI_pool_add_thread(p_thread)
 
@@ -110,6 +198,42 @@ int ABTI_pool_push(ABTI_pool *p_pool, ABT_unit unit, ABTI_native_thread_id produ
 
     /* Push unit into pool */
     p_pool->p_push(ABTI_pool_get_handle(p_pool), unit);
+    ABTI_TRACE(POOL_PUSH, unit, (uint32_t)p_pool->id);
+    ABTI_pool_wake_parked(p_pool, 1);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+static inline
+int ABTI_pool_push_many(ABTI_pool *p_pool, const ABT_unit *units,
+                        size_t num_units, ABTI_native_thread_id producer_id)
+{
+    int abt_errno = ABT_SUCCESS;
+
+#ifdef ABT_CONFIG_USE_DEBUG_LOG
+    size_t i;
+    for (i = 0; i < num_units; i++) {
+        LOG_EVENT_POOL_PUSH(p_pool, units[i], producer_id);
+    }
+#endif
+
+    /* Save the producer ES information in the pool */
+    abt_errno = ABTI_pool_set_producer(p_pool, producer_id);
+    ABTI_CHECK_ERROR(abt_errno);
+
+    /* Push units into pool */
+    ABTI_pool_push_many_internal(p_pool, units, num_units);
+#ifdef ABT_CONFIG_USE_TRACE
+    size_t k;
+    for (k = 0; k < num_units; k++) {
+        ABTI_TRACE(POOL_PUSH, units[k], (uint32_t)p_pool->id);
+    }
+#endif
 
   fn_exit:
     return abt_errno;
@@ -145,6 +269,13 @@ int ABTI_pool_add_thread(ABTI_thread *p_thread, ABTI_native_thread_id producer_i
         ABTI_CHECK_ERROR_MSG(abt_errno, "ABTI_pool_push");       \
     } while(0)
 
+#define ABTI_POOL_PUSH_MANY(p_pool,units,num_units,producer_id)           \
+    do {                                                                  \
+        abt_errno = ABTI_pool_push_many(p_pool, units, num_units,         \
+                                        producer_id);                     \
+        ABTI_CHECK_ERROR_MSG(abt_errno, "ABTI_pool_push_many");           \
+    } while(0)
+
 #define ABTI_POOL_ADD_THREAD(p_thread,producer_id)               \
     do {                                                         \
         abt_errno = ABTI_pool_add_thread(p_thread, producer_id); \
@@ -218,6 +349,9 @@ ABT_unit ABTI_pool_pop_timedwait(ABTI_pool *p_pool, double abstime_secs)
 
     unit = p_pool->p_pop_timedwait(ABTI_pool_get_handle(p_pool), abstime_secs);
     LOG_EVENT_POOL_POP(p_pool, unit);
+    if (unit != ABT_UNIT_NULL) {
+        ABTI_TRACE(POOL_POP, unit, (uint32_t)p_pool->id);
+    }
 
     return unit;
 }
@@ -229,6 +363,62 @@ ABT_unit ABTI_pool_pop(ABTI_pool *p_pool)
 
     unit = p_pool->p_pop(ABTI_pool_get_handle(p_pool));
     LOG_EVENT_POOL_POP(p_pool, unit);
+    if (unit != ABT_UNIT_NULL) {
+        ABTI_TRACE(POOL_POP, unit, (uint32_t)p_pool->id);
+    }
+
+    return unit;
+}
+
+/* Pop up to max_units units.  Pools without p_pop_many are popped one by
+ * one. */
+static inline
+size_t ABTI_pool_pop_many(ABTI_pool *p_pool, ABT_unit *units, size_t max_units)
+{
+    ABT_pool pool = ABTI_pool_get_handle(p_pool);
+    size_t num_units = 0;
+
+    if (p_pool->p_pop_many) {
+        num_units = p_pool->p_pop_many(pool, units, max_units);
+    } else {
+        while (num_units < max_units) {
+            ABT_unit unit = p_pool->p_pop(pool);
+            if (unit == ABT_UNIT_NULL) break;
+            units[num_units++] = unit;
+        }
+    }
+#ifdef ABT_CONFIG_USE_DEBUG_LOG
+    size_t i;
+    for (i = 0; i < num_units; i++) {
+        LOG_EVENT_POOL_POP(p_pool, units[i]);
+    }
+#endif
+#ifdef ABT_CONFIG_USE_TRACE
+    size_t k;
+    for (k = 0; k < num_units; k++) {
+        ABTI_TRACE(POOL_POP, units[k], (uint32_t)p_pool->id);
+    }
+#endif
+
+    return num_units;
+}
+
+/* Pop a unit on behalf of another ES.  Pools that do not distinguish thieves
+ * from the owner fall back to p_pop. */
+static inline
+ABT_unit ABTI_pool_pop_steal(ABTI_pool *p_pool)
+{
+    ABT_unit unit;
+
+    if (p_pool->p_pop_steal) {
+        unit = p_pool->p_pop_steal(ABTI_pool_get_handle(p_pool));
+    } else {
+        unit = p_pool->p_pop(ABTI_pool_get_handle(p_pool));
+    }
+    LOG_EVENT_POOL_POP(p_pool, unit);
+    if (unit != ABT_UNIT_NULL) {
+        ABTI_TRACE(POOL_POP, unit, (uint32_t)p_pool->id);
+    }
 
     return unit;
 }
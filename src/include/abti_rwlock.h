@@ -6,9 +6,6 @@
 #ifndef ABTI_RWLOCK_H_INCLUDED
 #define ABTI_RWLOCK_H_INCLUDED
 
-#include "abti_mutex.h"
-#include "abti_cond.h"
-
 /* Inlined functions for RWLock */
 
 static inline
@@ -46,74 +43,115 @@ ABT_rwlock ABTI_rwlock_get_handle(ABTI_rwlock *p_rwlock)
 static inline
 void ABTI_rwlock_init(ABTI_rwlock *p_rwlock)
 {
-    ABTI_mutex_init(&p_rwlock->mutex);
-    ABTI_cond_init(&p_rwlock->cond);
-    p_rwlock->reader_count = 0;
-    p_rwlock->write_flag = 0;
+    int i;
+    for (i = 0; i < ABTI_RWLOCK_NUM_SHARDS; i++) {
+        p_rwlock->shards[i].count = 0;
+    }
+    p_rwlock->write_flag = ABTI_RWLOCK_WRITE_NONE;
+    ABTI_spinlock_clear(&p_rwlock->lock);
+    p_rwlock->p_drain = NULL;
+    p_rwlock->p_rd_head = NULL;
+    p_rwlock->p_rd_tail = NULL;
+    p_rwlock->p_wr_head = NULL;
+    p_rwlock->p_wr_tail = NULL;
 }
 
 static inline
 void ABTI_rwlock_fini(ABTI_rwlock *p_rwlock)
 {
-    ABTI_mutex_fini(&p_rwlock->mutex);
-    ABTI_cond_fini(&p_rwlock->cond);
+    /* The lock needs to be acquired to safely free the rwlock structure.
+     * However, we do not have to unlock it because the entire structure is
+     * freed here. */
+    ABTI_spinlock_acquire(&p_rwlock->lock);
 }
 
+/* Return the reader counter used by the caller.  External threads share the
+ * first one. */
 static inline
-int ABTI_rwlock_rdlock(ABTI_local **pp_local, ABTI_rwlock *p_rwlock)
+int ABTI_rwlock_get_shard(ABTI_local *p_local)
 {
-    int abt_errno = ABT_SUCCESS;
+    if (p_local == NULL) return 0;
+    return p_local->p_xstream->rank & (ABTI_RWLOCK_NUM_SHARDS - 1);
+}
 
-    ABTI_mutex_lock(pp_local, &p_rwlock->mutex);
+/* Check if no reader holds p_rwlock.  New readers must have been stopped by
+ * write_flag. */
+static inline
+ABT_bool ABTI_rwlock_is_drained(ABTI_rwlock *p_rwlock)
+{
+    int32_t sum = 0;
+    int i;
+    for (i = 0; i < ABTI_RWLOCK_NUM_SHARDS; i++) {
+        sum += ABTD_atomic_load_int32(&p_rwlock->shards[i].count);
+    }
+    return (sum == 0) ? ABT_TRUE : ABT_FALSE;
+}
 
-    while (p_rwlock->write_flag && abt_errno == ABT_SUCCESS) {
-        abt_errno = ABTI_cond_wait(pp_local, &p_rwlock->cond, &p_rwlock->mutex);
+static inline
+void ABTI_rwlock_rdunlock(ABTI_local *p_local, ABTI_rwlock *p_rwlock,
+                          int shard)
+{
+    ABTD_atomic_fetch_sub_int32(&p_rwlock->shards[shard].count, 1);
+    ABTD_atomic_full_barrier();
+    if (ABTD_atomic_load_uint32(&p_rwlock->write_flag)
+            == ABTI_RWLOCK_WRITE_PENDING) {
+        /* The last reader wakes up the waiting writer. */
+        ABTI_rwlock_wake_drain(p_local, p_rwlock);
     }
+}
 
-    if (abt_errno == ABT_SUCCESS) {
-        p_rwlock->reader_count++;
+/* A reader only touches the counter of its ES unless a writer is waiting or
+ * holds the lock.  Readers arriving after a writer wait for it. */
+static inline
+int ABTI_rwlock_rdlock(ABTI_local **pp_local, ABTI_rwlock *p_rwlock)
+{
+    int shard = ABTI_rwlock_get_shard(*pp_local);
+
+    ABTD_atomic_fetch_add_int32(&p_rwlock->shards[shard].count, 1);
+    /* Pairs with the barrier in ABTI_rwlock_wrlock(). */
+    ABTD_atomic_full_barrier();
+    if (ABTU_likely(ABTD_atomic_load_uint32(&p_rwlock->write_flag)
+                        == ABTI_RWLOCK_WRITE_NONE)) {
+        return ABT_SUCCESS;
     }
 
-    ABTI_mutex_unlock(*pp_local, &p_rwlock->mutex);
-    return abt_errno;
+    ABTI_rwlock_rdunlock(*pp_local, p_rwlock, shard);
+    return ABTI_rwlock_rdlock_wait(pp_local, p_rwlock, shard);
 }
 
 static inline
 int ABTI_rwlock_wrlock(ABTI_local **pp_local, ABTI_rwlock *p_rwlock)
 {
-    int abt_errno = ABT_SUCCESS;
-    ABTI_mutex_lock(pp_local, &p_rwlock->mutex);
-
-    while ((p_rwlock->write_flag || p_rwlock->reader_count)
-            && abt_errno == ABT_SUCCESS) {
-        abt_errno = ABTI_cond_wait(pp_local, &p_rwlock->cond, &p_rwlock->mutex);
+    ABT_bool is_pending = ABT_FALSE;
+
+    if (ABTD_atomic_bool_cas_strong_uint32(&p_rwlock->write_flag,
+                                           ABTI_RWLOCK_WRITE_NONE,
+                                           ABTI_RWLOCK_WRITE_PENDING)) {
+        /* Pairs with the barrier in ABTI_rwlock_rdlock(). */
+        ABTD_atomic_full_barrier();
+        if (ABTI_rwlock_is_drained(p_rwlock) == ABT_TRUE) {
+            ABTD_atomic_store_uint32(&p_rwlock->write_flag,
+                                     ABTI_RWLOCK_WRITE_LOCKED);
+            return ABT_SUCCESS;
+        }
+        is_pending = ABT_TRUE;
     }
-
-    if (abt_errno == ABT_SUCCESS) {
-        p_rwlock->write_flag = 1;
-    }
-
-    ABTI_mutex_unlock(*pp_local, &p_rwlock->mutex);
-    return abt_errno;
+    return ABTI_rwlock_wrlock_wait(pp_local, p_rwlock, is_pending);
 }
 
 static inline
 void ABTI_rwlock_unlock(ABTI_local **pp_local, ABTI_rwlock *p_rwlock)
 {
-    ABTI_mutex_lock(pp_local, &p_rwlock->mutex);
-
-    if (p_rwlock->write_flag) {
-        p_rwlock->write_flag = 0;
-    }
-    else {
-        p_rwlock->reader_count--;
-    }
-
-    /* TODO: elision */
     ABTI_local *p_local = *pp_local;
-    ABTI_cond_broadcast(p_local, &p_rwlock->cond);
 
-    ABTI_mutex_unlock(p_local, &p_rwlock->mutex);
+    /* While a writer holds the lock, no reader does. */
+    if (ABTD_atomic_load_uint32(&p_rwlock->write_flag)
+            == ABTI_RWLOCK_WRITE_LOCKED) {
+        ABTI_rwlock_wrunlock(p_local, p_rwlock);
+    } else {
+        ABTI_rwlock_rdunlock(p_local, p_rwlock,
+                             ABTI_rwlock_get_shard(p_local));
+    }
 }
 
 #endif /* ABTI_RWLOCK_H_INCLUDED */
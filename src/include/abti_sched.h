@@ -57,6 +57,8 @@ static inline
 void ABTI_sched_set_request(ABTI_sched *p_sched, uint32_t req)
 {
     ABTD_atomic_fetch_or_uint32(&p_sched->request, req);
+    /* The ES parked in p_sched needs to handle the request. */
+    ABTI_sched_unpark(p_sched);
 }
 
 static inline
@@ -81,17 +83,57 @@ ABT_bool ABTI_sched_has_unit(ABTI_sched *p_sched)
     return ABT_FALSE;
 }
 
-#ifdef ABT_CONFIG_USE_SCHED_SLEEP
+#ifdef ABT_CONFIG_USE_SCHED_PARK
+/* Park the ES if its scheduler has been idle for the spin budget.
+ * *p_idle_since is the time when the scheduler became idle, or zero if it
+ * has been running work units. */
+static inline
+void ABTI_sched_park_if_idle(ABTI_sched *p_sched, ABTI_xstream *p_xstream,
+                             ABT_bool idle, double *p_idle_since)
+{
+    if (idle == ABT_FALSE) {
+        *p_idle_since = 0.0;
+        return;
+    }
+
+    ABTD_time t;
+    ABTD_time_get(&t);
+    double now = ABTD_time_read_sec(&t);
+    if (*p_idle_since == 0.0) {
+        *p_idle_since = now;
+    } else if ((now - *p_idle_since) * 1.0e6
+               >= ABTI_global_get_sched_park_spin_usec()) {
+        uint64_t timeout_nsec =
+            (uint64_t)ABTI_global_get_sched_park_timeout_usec() * 1000;
+        ABTI_sched_park(p_sched, p_xstream, timeout_nsec);
+        *p_idle_since = 0.0;
+    }
+}
+#endif
+
+#if defined(ABT_CONFIG_USE_SCHED_SLEEP) || defined(ABT_CONFIG_USE_SCHED_PARK)
 #define CNT_DECL(c)         int c
 #define CNT_INIT(c,v)       c = v
 #define CNT_INC(c)          c++
-#define SCHED_SLEEP(c,t)    if (c == 0) nanosleep(&(t), NULL)
 #else
 #define CNT_DECL(c)
 #define CNT_INIT(c,v)
 #define CNT_INC(c)
+#endif
+
+#ifdef ABT_CONFIG_USE_SCHED_SLEEP
+#define SCHED_SLEEP(c,t)    if (c == 0) nanosleep(&(t), NULL)
+#else
 #define SCHED_SLEEP(c,t)
 #endif
 
+#ifdef ABT_CONFIG_USE_SCHED_PARK
+#define PARK_DECL(t)        double t = 0.0
+#define SCHED_PARK(c,t,s,x) ABTI_sched_park_if_idle(s, x, (c) == 0, &(t))
+#else
+#define PARK_DECL(t)
+#define SCHED_PARK(c,t,s,x)
+#endif
+
 #endif /* ABTI_SCHED_H_INCLUDED */
 
@@ -66,5 +66,21 @@ ABT_unit_type ABTI_self_get_type(ABTI_local *p_local)
     }
 }
 
+/* Return the type of the caller to decide whether it can suspend.  Unlike
+ * ABTI_self_get_type(), a tasklet that runs on a lent stack is regarded as a
+ * ULT because it is promoted to a ULT when it suspends. */
+static inline
+ABT_unit_type ABTI_self_get_suspend_type(ABTI_local *p_local)
+{
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
+    if (p_local != NULL && p_local->p_task != NULL &&
+        p_local->p_task_thread != NULL &&
+        p_local->p_thread == p_local->p_task_thread) {
+        return ABT_UNIT_TYPE_THREAD;
+    }
+#endif
+    return ABTI_self_get_type(p_local);
+}
+
 #endif /* ABTI_SELF_H_INCLUDED */
 
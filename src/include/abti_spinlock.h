@@ -24,6 +24,13 @@ static inline void ABTI_spinlock_acquire(ABTI_spinlock *p_lock)
     }
 }
 
+/* Return ABT_TRUE if the lock has been acquired. */
+static inline ABT_bool ABTI_spinlock_try_acquire(ABTI_spinlock *p_lock)
+{
+    return ABTD_atomic_test_and_set_uint8((uint8_t *)&p_lock->val)
+         ? ABT_FALSE : ABT_TRUE;
+}
+
 static inline void ABTI_spinlock_release(ABTI_spinlock *p_lock)
 {
     ABTD_atomic_clear_uint8((uint8_t *)&p_lock->val);
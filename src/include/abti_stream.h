@@ -40,10 +40,25 @@ ABT_xstream ABTI_xstream_get_handle(ABTI_xstream *p_xstream)
 #endif
 }
 
+/* Wake up p_xstream if it is parked.  Returns ABT_TRUE if this call has
+ * woken it up. */
+static inline
+ABT_bool ABTI_xstream_unpark(ABTI_xstream *p_xstream)
+{
+    if (ABTD_atomic_load_uint32(&p_xstream->park_state) == 1 &&
+        ABTD_atomic_bool_cas_strong_uint32(&p_xstream->park_state, 1, 0)) {
+        ABTD_futex_wake(&p_xstream->park_state, 1);
+        return ABT_TRUE;
+    }
+    return ABT_FALSE;
+}
+
 static inline
 void ABTI_xstream_set_request(ABTI_xstream *p_xstream, uint32_t req)
 {
     ABTD_atomic_fetch_or_uint32(&p_xstream->request, req);
+    /* The parked ES needs to handle the request. */
+    ABTI_xstream_unpark(p_xstream);
 }
 
 static inline
@@ -116,6 +131,17 @@ ABTI_pool *ABTI_xstream_get_main_pool(ABTI_xstream *p_xstream)
     return ABTI_pool_get_ptr(pool);
 }
 
+/* Get the timer wheel of p_xstream.  It is created on first use by a work unit
+ * running on p_xstream. */
+static inline
+ABTI_twheel *ABTI_xstream_get_twheel(ABTI_xstream *p_xstream)
+{
+    if (p_xstream->p_twheel == NULL) {
+        p_xstream->p_twheel = ABTI_twheel_create();
+    }
+    return p_xstream->p_twheel;
+}
+
 static inline
 void ABTI_xstream_terminate_thread(ABTI_local *p_local, ABTI_thread *p_thread)
 {
@@ -168,6 +194,41 @@ void ABTI_xstream_terminate_task(ABTI_local *p_local, ABTI_task *p_task)
     }
 }
 
+/* Performance counters.  They are updated only by the ES that owns them. */
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+#define ABTI_XSTREAM_PERF_INC(p_xstream,name)       \
+    ((p_xstream)->p_perf->counters.name++)
+
+/* Called when a scheduler of p_xstream finds no work unit. */
+static inline
+void ABTI_xstream_perf_begin_idle(ABTI_xstream *p_xstream)
+{
+    ABTI_xstream_perf *p_perf = p_xstream->p_perf;
+    if (p_perf->is_idle == ABT_FALSE) {
+        p_perf->is_idle = ABT_TRUE;
+        ABTD_time_get(&p_perf->idle_start);
+    }
+}
+
+/* Called when p_xstream runs a work unit. */
+static inline
+void ABTI_xstream_perf_end_idle(ABTI_xstream *p_xstream)
+{
+    ABTI_xstream_perf *p_perf = p_xstream->p_perf;
+    if (p_perf->is_idle == ABT_TRUE) {
+        ABTD_time now;
+        ABTD_time_get(&now);
+        p_perf->counters.idle_nsec += ABTD_time_read_nsec(&now)
+                                    - ABTD_time_read_nsec(&p_perf->idle_start);
+        p_perf->is_idle = ABT_FALSE;
+    }
+}
+#else
+#define ABTI_XSTREAM_PERF_INC(p_xstream,name)   do { } while (0)
+#define ABTI_xstream_perf_begin_idle(p_xstream) do { } while (0)
+#define ABTI_xstream_perf_end_idle(p_xstream)   do { } while (0)
+#endif
+
 /* Get the native thread id associated with the target xstream. */
 static inline
 ABTI_native_thread_id ABTI_xstream_get_native_thread_id(ABTI_xstream *p_xstream)
@@ -52,5 +52,18 @@ void ABTI_task_unset_request(ABTI_task *p_task, uint32_t req)
     ABTD_atomic_fetch_and_uint32(&p_task->request, ~req);
 }
 
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
+/* Whether p_task runs on a lent stack so that it can suspend.  Tasklets of
+ * schedulers always run on the stack of the ES. */
+static inline
+ABT_bool ABTI_task_is_blockable(ABTI_task *p_task)
+{
+#ifndef ABT_CONFIG_DISABLE_STACKABLE_SCHED
+    if (p_task->is_sched != NULL) return ABT_FALSE;
+#endif
+    return gp_ABTI_global->task_blockable;
+}
+#endif
+
 #endif /* ABTI_TASK_H_INCLUDED */
 
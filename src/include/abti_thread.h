@@ -40,7 +40,22 @@ ABT_thread ABTI_thread_get_handle(ABTI_thread *p_thread)
 #endif
 }
 
-#if ABT_CONFIG_THREAD_TYPE == ABT_THREAD_TYPE_DYNAMIC_PROMOTION
+/* A stack-copying ULT runs on the stack shared in its ES.  Its frames are put
+ * on that stack by the scheduler, so other ULTs must not switch to it
+ * directly. */
+static inline
+ABT_bool ABTI_thread_is_stack_copy(ABTI_thread *p_thread)
+{
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
+    return (p_thread->attr.stacktype == ABTI_STACK_TYPE_COPY)
+         ? ABT_TRUE : ABT_FALSE;
+#else
+    ABTI_UNUSED(p_thread);
+    return ABT_FALSE;
+#endif
+}
+
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
 static inline
 ABT_bool ABTI_thread_is_dynamic_promoted(ABTI_thread *p_thread)
 {
@@ -104,7 +119,8 @@ ABT_bool ABTI_thread_is_dynamic_promoted(ABTI_thread *p_thread)
      * context switch.
      *
      * For example, the stack will be as follows at [1] and [2] in the x86-64
-     * case. Note that ptr points to the stack top (= p_stack + stacksize).
+     * case. Note that ptr points to the stack top (= p_stack + stacksize,
+     * aligned down to 16 bytes).
      *
      * In the case of [1] (no suspension):
      *  [0x12345600] : (the original instruction pointer)
@@ -118,6 +134,16 @@ ABT_bool ABTI_thread_is_dynamic_promoted(ABTI_thread *p_thread)
      *  [ptr - 0x10] : the address of ABTD_thread_terminate_thread_no_arg
      *  [ptr - xxxx] : used by thread_f
      *
+     * On AArch64, the two slots are swapped and the saved link register takes
+     * the place of the return address:
+     *  [ptr - 0x08] : the original link register, or the address of
+     *                 ABTD_thread_terminate_thread_no_arg after suspension
+     *  [ptr - 0x10] : the original stack pointer, or (ptr - 0x10) after
+     *                 suspension
+     *
+     * Whether a ULT uses this technique is chosen by its attribute, so ULTs
+     * whose contexts are created eagerly always look promoted here.
+     *
      * This technique was introduced as a "return-on-completion" thread in the
      * following paper:
      *   Lessons Learned from Analyzing Dynamic Promotion for User-Level
@@ -131,6 +157,11 @@ void ABTI_thread_dynamic_promote_thread(ABTI_thread *p_thread)
 {
     LOG_EVENT("[U%" PRIu64 "] dynamic-promote ULT\n",
               ABTI_thread_get_id(p_thread));
+    ABTI_local *p_local = ABTI_local_get_local();
+    if (p_local->p_task_thread == p_thread) {
+        /* A tasklet is suspending on the lent stack. */
+        ABTI_task_promote_to_thread(p_local);
+    }
     void *p_stack = p_thread->attr.p_stack;
     size_t stacksize = p_thread->attr.stacksize;
     void *p_stacktop = (void *)(((char *)p_stack) + stacksize);
@@ -147,8 +178,14 @@ void ABTI_thread_context_switch_thread_to_thread_internal(ABTI_local *p_local,
 #ifndef ABT_CONFIG_DISABLE_STACKABLE_SCHED
     ABTI_ASSERT(!p_old->is_sched && !p_new->is_sched);
 #endif
+    ABTI_ASSERT(!ABTI_thread_is_stack_copy(p_new));
     p_local->p_thread = p_new;
-#if ABT_CONFIG_THREAD_TYPE == ABT_THREAD_TYPE_DYNAMIC_PROMOTION
+    ABTI_XSTREAM_PERF_INC(p_local->p_xstream, num_ctxsw);
+    ABTI_TRACE_XSTREAM(p_local->p_xstream, THREAD_STOP, p_old,
+                       is_finish ? ABTI_TRACE_STOP_TERMINATE
+                                 : ABTI_TRACE_STOP_SWITCH);
+    ABTI_TRACE_XSTREAM(p_local->p_xstream, THREAD_RUN, p_new, 0);
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
     /* Dynamic promotion is unnecessary if p_old is discarded. */
     if (!is_finish && !ABTI_thread_is_dynamic_promoted(p_old)) {
         ABTI_thread_dynamic_promote_thread(p_old);
@@ -175,7 +212,7 @@ void ABTI_thread_context_switch_thread_to_sched_internal(ABTI_thread *p_old,
     ABTI_ASSERT(!p_old->is_sched);
 #endif
     ABTI_LOG_SET_SCHED(p_new);
-#if ABT_CONFIG_THREAD_TYPE == ABT_THREAD_TYPE_DYNAMIC_PROMOTION
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
     /* Dynamic promotion is unnecessary if p_old is discarded. */
     if (!is_finish && !ABTI_thread_is_dynamic_promoted(p_old))
         ABTI_thread_dynamic_promote_thread(p_old);
@@ -202,7 +239,7 @@ void ABTI_thread_context_switch_sched_to_thread_internal(ABTI_local *p_local,
     ABTI_LOG_SET_SCHED(NULL);
     p_local->p_thread = p_new;
     p_local->p_task = NULL; /* A tasklet scheduler can invoke ULT. */
-#if ABT_CONFIG_THREAD_TYPE == ABT_THREAD_TYPE_DYNAMIC_PROMOTION
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
     /* Schedulers' contexts must be eagerly initialized. */
     ABTI_ASSERT(!p_old->p_thread
                 || ABTI_thread_is_dynamic_promoted(p_old->p_thread));
@@ -220,6 +257,14 @@ void ABTI_thread_context_switch_sched_to_thread_internal(ABTI_local *p_local,
         ABTI_thread *p_prev = p_local->p_thread;
         if (!ABTI_thread_is_dynamic_promoted(p_prev)) {
             ABTI_ASSERT(p_prev == p_new);
+            /* A tasklet running on a lent stack is not measured. */
+            if (gp_ABTI_global->stack_watermark == ABT_TRUE &&
+                p_prev->type == ABTI_THREAD_TYPE_USER) {
+                ABTI_stack_usage_record(p_prev);
+            }
+            if (ABTI_thread_is_stack_copy(p_prev)) {
+                ABTI_thread_release_copy_stack(p_local, p_prev);
+            }
             /* See ABTDI_thread_terminate for details.
              * TODO: avoid making a copy of the code. */
             ABTD_thread_context *p_ctx = &p_prev->ctx;
@@ -268,7 +313,7 @@ void ABTI_thread_context_switch_sched_to_sched_internal(ABTI_sched *p_old,
                                                         ABT_bool is_finish)
 {
     ABTI_LOG_SET_SCHED(p_new);
-#if ABT_CONFIG_THREAD_TYPE == ABT_THREAD_TYPE_DYNAMIC_PROMOTION
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
     /* Schedulers' contexts must be initialized eagerly. */
     ABTI_ASSERT(!p_old->p_thread
                 || ABTI_thread_is_dynamic_promoted(p_old->p_thread));
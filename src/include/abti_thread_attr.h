@@ -84,6 +84,11 @@ void ABTI_thread_attr_init(ABTI_thread_attr *p_attr, void *p_stack,
 #ifndef ABT_CONFIG_DISABLE_MIGRATION
     ABTI_thread_attr_init_migration(p_attr, migratable);
 #endif
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
+    p_attr->dynamic_promotion =
+        (ABT_CONFIG_THREAD_TYPE == ABT_THREAD_TYPE_DYNAMIC_PROMOTION)
+        ? ABT_TRUE : ABT_FALSE;
+#endif
 }
 
 static inline
@@ -16,6 +16,27 @@ double ABTI_get_wtime(void)
     return ABTD_time_read_sec(&t);
 }
 
+static inline
+uint64_t ABTI_get_wtime_nsec(void)
+{
+    ABTD_time t;
+    ABTD_time_get(&t);
+    return ABTD_time_read_nsec(&t);
+}
+
+/* Convert the wall-clock time p_abstime (i.e., CLOCK_REALTIME) into the time
+ * of ABTI_get_wtime_nsec() so that the timeout is not affected by later
+ * changes of the system time. */
+static inline
+uint64_t ABTI_get_deadline_nsec(const struct timespec *p_abstime)
+{
+    double rel_secs = ((double)p_abstime->tv_sec)
+                    + 1.0e-9 * ((double)p_abstime->tv_nsec)
+                    - ABTD_time_get_realtime_sec();
+    double deadline = 1.0e-9 * (double)ABTI_get_wtime_nsec() + rel_secs;
+    return (deadline <= 0.0) ? 0 : (uint64_t)(deadline * 1.0e9);
+}
+
 static inline
 ABTI_timer *ABTI_timer_get_ptr(ABT_timer timer)
 {
@@ -0,0 +1,78 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef ABTI_TRACE_H_INCLUDED
+#define ABTI_TRACE_H_INCLUDED
+
+/* Kinds of trace events */
+enum {
+    ABTI_TRACE_EVENT_THREAD_CREATE,     /* A ULT is created */
+    ABTI_TRACE_EVENT_THREAD_RUN,        /* A ULT starts or resumes running */
+    ABTI_TRACE_EVENT_THREAD_STOP,       /* A ULT stops running (arg: reason) */
+    ABTI_TRACE_EVENT_THREAD_RESUME,     /* A blocked ULT becomes ready */
+    ABTI_TRACE_EVENT_TASK_RUN,          /* A tasklet starts running */
+    ABTI_TRACE_EVENT_TASK_END,          /* A tasklet finishes */
+    ABTI_TRACE_EVENT_POOL_PUSH,         /* A unit is pushed (arg: pool ID) */
+    ABTI_TRACE_EVENT_POOL_POP,          /* A unit is popped (arg: pool ID) */
+    ABTI_TRACE_EVENT_STEAL,             /* A unit is stolen (arg: pool ID) */
+    ABTI_TRACE_EVENT_MUTEX_CONTENDED,   /* A mutex is found locked */
+    ABTI_TRACE_NUM_EVENTS
+};
+
+/* Reasons of ABTI_TRACE_EVENT_THREAD_STOP */
+enum {
+    ABTI_TRACE_STOP_YIELD,              /* Yielded to the scheduler */
+    ABTI_TRACE_STOP_BLOCK,              /* Blocked */
+    ABTI_TRACE_STOP_TERMINATE,          /* Terminated or canceled */
+    ABTI_TRACE_STOP_SWITCH,             /* Switched to another ULT directly */
+    ABTI_TRACE_STOP_OTHER,              /* Migrated, orphaned, etc. */
+    ABTI_TRACE_NUM_STOPS
+};
+
+#ifdef ABT_CONFIG_USE_TRACE
+
+/* Record an event in the trace buffer of p_xstream.  Only the ES that owns the
+ * buffer writes to it, so no atomic operation is needed. */
+static inline
+void ABTI_trace_record(ABTI_xstream *p_xstream, uint32_t kind, void *obj,
+                       uint32_t arg)
+{
+    ABTI_trace_buffer *p_buf = p_xstream->p_trace;
+    if (p_buf == NULL) return;
+
+    uint64_t pos = p_buf->pos;
+    ABTI_trace_event *p_event = &p_buf->events[pos & p_buf->mask];
+    p_event->tsc  = ABTD_tsc_read();
+    p_event->obj  = (uint64_t)(uintptr_t)obj;
+    p_event->kind = kind;
+    p_event->arg  = arg;
+    p_buf->pos = pos + 1;
+}
+
+/* Record an event in the trace buffer of the calling ES.  Events of external
+ * threads are not recorded. */
+static inline
+void ABTI_trace_record_self(uint32_t kind, void *obj, uint32_t arg)
+{
+    /* The uninlined version is used since this can be called after a context
+     * switch. */
+    ABTI_local *p_local = ABTI_local_get_local_uninlined();
+    if (p_local == NULL || p_local->p_xstream == NULL) return;
+    ABTI_trace_record(p_local->p_xstream, kind, obj, arg);
+}
+
+#define ABTI_TRACE_XSTREAM(p_xstream,kind,obj,arg)  \
+    ABTI_trace_record(p_xstream, ABTI_TRACE_EVENT_##kind, (void *)(obj), arg)
+#define ABTI_TRACE(kind,obj,arg)                    \
+    ABTI_trace_record_self(ABTI_TRACE_EVENT_##kind, (void *)(obj), arg)
+
+#else /* ABT_CONFIG_USE_TRACE */
+
+#define ABTI_TRACE_XSTREAM(p_xstream,kind,obj,arg)  do { } while (0)
+#define ABTI_TRACE(kind,obj,arg)                    do { } while (0)
+
+#endif /* ABT_CONFIG_USE_TRACE */
+
+#endif /* ABTI_TRACE_H_INCLUDED */
@@ -98,6 +98,18 @@
  * - ABT_INFO_QUERY_KIND_DEFAULT_SCHED_SLEEP_NSEC
  *   \c val must be a pointer to a variable of the type uint64_t.  The default
  *   sleep time (nanoseconds) of predefined schedulers is set to \c *val.
+ * - ABT_INFO_QUERY_KIND_ENABLED_PERF_COUNTERS
+ *   \c val must be a pointer to a variable of the type ABT_bool.  ABT_TRUE is
+ *   set to \c *val if the Argobots library is configured to enable per-ES
+ *   performance counters.  Otherwise, ABT_FALSE is set.
+ * - ABT_INFO_QUERY_KIND_ENABLED_TRACE
+ *   \c val must be a pointer to a variable of the type ABT_bool.  ABT_TRUE is
+ *   set to \c *val if the Argobots library is configured to enable per-ES
+ *   event tracing.  Otherwise, ABT_FALSE is set.
+ * - ABT_INFO_QUERY_KIND_ENABLED_BLOCKABLE_TASK
+ *   \c val must be a pointer to a variable of the type ABT_bool.  ABT_TRUE is
+ *   set to \c *val if tasklets run on lent stacks and can suspend (see
+ *   ABT_TASK_BLOCKABLE).  Otherwise, ABT_FALSE is set.
  *
  * @param[in]  query_kind  query kind
  * @param[out] val         a pointer to a result
@@ -223,6 +235,27 @@ int ABT_info_query_config(ABT_info_query_kind query_kind, void *val)
         case ABT_INFO_QUERY_KIND_DEFAULT_SCHED_SLEEP_NSEC:
             *((uint64_t *)val) = gp_ABTI_global->sched_sleep_nsec;
             break;
+        case ABT_INFO_QUERY_KIND_ENABLED_PERF_COUNTERS:
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+            *((ABT_bool *)val) = ABT_TRUE;
+#else
+            *((ABT_bool *)val) = ABT_FALSE;
+#endif
+            break;
+        case ABT_INFO_QUERY_KIND_ENABLED_TRACE:
+#ifdef ABT_CONFIG_USE_TRACE
+            *((ABT_bool *)val) = ABT_TRUE;
+#else
+            *((ABT_bool *)val) = ABT_FALSE;
+#endif
+            break;
+        case ABT_INFO_QUERY_KIND_ENABLED_BLOCKABLE_TASK:
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
+            *((ABT_bool *)val) = gp_ABTI_global->task_blockable;
+#else
+            *((ABT_bool *)val) = ABT_FALSE;
+#endif
+            break;
         default:
             abt_errno = ABT_ERR_INV_QUERY_KIND;
             ABTI_CHECK_ERROR(abt_errno);
@@ -256,6 +289,186 @@ int ABT_info_print_config(FILE *fp)
 }
 
 
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+static void ABTI_info_add_xstream_counters(ABTI_xstream *p_xstream,
+                                           ABT_xstream_counters *p_counters)
+{
+    ABT_xstream_counters *p_src = &p_xstream->p_perf->counters;
+    p_counters->num_threads += ABTD_atomic_load_uint64(&p_src->num_threads);
+    p_counters->num_tasks += ABTD_atomic_load_uint64(&p_src->num_tasks);
+    p_counters->num_ctxsw += ABTD_atomic_load_uint64(&p_src->num_ctxsw);
+    p_counters->num_steals += ABTD_atomic_load_uint64(&p_src->num_steals);
+    p_counters->num_failed_steals +=
+        ABTD_atomic_load_uint64(&p_src->num_failed_steals);
+    p_counters->idle_nsec += ABTD_atomic_load_uint64(&p_src->idle_nsec);
+}
+#endif
+
+/**
+ * @ingroup INFO
+ * @brief   Get the performance counters of the target ES.
+ *
+ * \c ABT_info_query_xstream_counters() writes the performance counters of the
+ * target ES \c xstream to \c counters.  The counters are updated only by
+ * \c xstream, so the values read by another ES may be slightly out of date.
+ * \c idle_nsec includes only idle periods that have ended.
+ *
+ * This routine is available only if Argobots is configured with
+ * \c --enable-perf-counters.
+ *
+ * @param[in]  xstream   handle to the target ES
+ * @param[out] counters  performance counters
+ * @return Error code
+ * @retval ABT_SUCCESS         on success
+ * @retval ABT_ERR_FEATURE_NA  the performance counters are not enabled
+ */
+int ABT_info_query_xstream_counters(ABT_xstream xstream,
+                                    ABT_xstream_counters *counters)
+{
+    int abt_errno = ABT_SUCCESS;
+
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+    ABTI_xstream *p_xstream = ABTI_xstream_get_ptr(xstream);
+    ABTI_CHECK_NULL_XSTREAM_PTR(p_xstream);
+
+    memset(counters, 0, sizeof(ABT_xstream_counters));
+    ABTI_info_add_xstream_counters(p_xstream, counters);
+#else
+    abt_errno = ABT_ERR_FEATURE_NA;
+    ABTI_CHECK_ERROR(abt_errno);
+#endif
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+
+/**
+ * @ingroup INFO
+ * @brief   Get the sum of the performance counters of all ESs.
+ *
+ * \c ABT_info_query_all_xstream_counters() writes the sum of the performance
+ * counters of all ESs that currently exist to \c counters.  See
+ * \c ABT_info_query_xstream_counters() for details.
+ *
+ * @param[out] counters  performance counters
+ * @return Error code
+ * @retval ABT_SUCCESS            on success
+ * @retval ABT_ERR_UNINITIALIZED  Argobots has not been initialized
+ * @retval ABT_ERR_FEATURE_NA     the performance counters are not enabled
+ */
+int ABT_info_query_all_xstream_counters(ABT_xstream_counters *counters)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_CHECK_INITIALIZED();
+
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+    ABTI_global *p_global = gp_ABTI_global;
+    int i;
+
+    memset(counters, 0, sizeof(ABT_xstream_counters));
+
+    ABTI_spinlock_acquire(&p_global->xstreams_lock);
+    for (i = 0; i < p_global->num_xstreams; i++) {
+        ABTI_xstream *p_xstream = p_global->p_xstreams[i];
+        if (p_xstream) {
+            ABTI_info_add_xstream_counters(p_xstream, counters);
+        }
+    }
+    ABTI_spinlock_release(&p_global->xstreams_lock);
+#else
+    abt_errno = ABT_ERR_FEATURE_NA;
+    ABTI_CHECK_ERROR(abt_errno);
+#endif
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup INFO
+ * @brief   Write the trace events of all ESs to the output stream.
+ *
+ * \c ABT_info_print_trace() writes the events recorded by all ESs, including
+ * ESs that have been freed, to \c fp in the Chrome trace event format, which
+ * can be loaded by chrome://tracing or Perfetto.  Each ES keeps only its
+ * latest \c ABT_TRACE_BUFFER_SIZE events.  Events that are being recorded
+ * while this routine runs may be inconsistent.  This routine is available only
+ * when Argobots is configured with \c --enable-trace.
+ *
+ * @param[in] fp  output stream
+ * @return Error code
+ * @retval ABT_SUCCESS         on success
+ * @retval ABT_ERR_FEATURE_NA  tracing is not enabled
+ */
+int ABT_info_print_trace(FILE *fp)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_CHECK_INITIALIZED();
+
+#ifdef ABT_CONFIG_USE_TRACE
+    ABTI_trace_print(gp_ABTI_global, fp);
+#else
+    ABTI_UNUSED(fp);
+    abt_errno = ABT_ERR_FEATURE_NA;
+    ABTI_CHECK_ERROR(abt_errno);
+#endif
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+
+/**
+ * @ingroup INFO
+ * @brief   Write the measured stack usage of ULT functions to the output
+ *          stream.
+ *
+ * \c ABT_info_print_stack_usage() writes, for each function that terminated
+ * ULTs have run, the number of measured ULTs and the maximum and the average
+ * stack usage in bytes to \c fp.  When adaptive stack sizing is enabled, the
+ * stack size chosen for the function is also written (0 if not chosen yet).
+ * Stacks given by the user, the stacks of stack-copying ULTs, and schedulers
+ * are not measured.  This routine is available only when the environment
+ * variable \c ABT_STACK_WATERMARK or \c ABT_STACK_ADAPTIVE is set.
+ *
+ * @param[in] fp  output stream
+ * @return Error code
+ * @retval ABT_SUCCESS         on success
+ * @retval ABT_ERR_FEATURE_NA  stack watermarking is not enabled
+ */
+int ABT_info_print_stack_usage(FILE *fp)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_CHECK_INITIALIZED();
+
+    if (gp_ABTI_global->stack_watermark == ABT_FALSE) {
+        abt_errno = ABT_ERR_FEATURE_NA;
+        ABTI_CHECK_ERROR(abt_errno);
+    }
+    ABTI_stack_usage_print(fp);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+
 /**
  * @ingroup INFO
  * @brief   Write the information of all created ESs to the output stream.
@@ -821,6 +1034,22 @@ int ABTI_info_print_config(FILE *fp)
                 (unsigned)(p_global->sched_stacksize / 1024));
     fprintf(fp, " - scheduler event check frequency: %u\n",
                 p_global->sched_event_freq);
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
+    fprintf(fp, " - blockable tasklets: %s\n",
+                (p_global->task_blockable == ABT_TRUE) ? "on" : "off");
+    fprintf(fp, " - stack-copying ULT stack size: %u KB\n",
+                (unsigned)(p_global->copy_stacksize / 1024));
+#endif
+
+    fprintf(fp, " - stack watermarking: %s\n",
+                (p_global->stack_watermark == ABT_TRUE) ? "on" : "off");
+    if (p_global->stack_adaptive == ABT_TRUE) {
+        fprintf(fp, " - adaptive stack sizes: %u percentile of %u samples\n",
+                    p_global->stack_adaptive_pct,
+                    p_global->stack_adaptive_samples);
+    } else {
+        fprintf(fp, " - adaptive stack sizes: off\n");
+    }
 
     fprintf(fp, " - timer function: "
 #if defined(ABT_CONFIG_USE_CLOCK_GETTIME)
@@ -831,13 +1060,31 @@ int ABTI_info_print_config(FILE *fp)
                 "gettimeofday"
 #endif
                 "\n");
+    fprintf(fp, " - TSC-based timer: %s\n",
+                (ABTD_time_uses_tsc() == ABT_TRUE) ? "on" : "off");
 
 #ifdef ABT_CONFIG_USE_MEM_POOL
+    uint32_t i;
     fprintf(fp, "Memory Pool:\n");
     fprintf(fp, " - page size for allocation: %u KB\n",
                 p_global->mem_page_size / 1024);
     fprintf(fp, " - stack page size: %u KB\n", p_global->mem_sp_size / 1024);
     fprintf(fp, " - max. # of stacks per ES: %u\n", p_global->mem_max_stacks);
+    fprintf(fp, " - pooled stack sizes:");
+    for (i = 0; i < p_global->mem_num_stack_classes; i++) {
+        fprintf(fp, " %zu", p_global->mem_stack_classes[i]);
+    }
+    fprintf(fp, "\n");
+    fprintf(fp, " - stack trimming interval: %" PRIu64 " ms\n",
+                p_global->mem_trim_nsec / 1000000);
+    fprintf(fp, " - stack guard pages: %s\n",
+                (p_global->mem_stack_guard == ABT_TRUE) ? "on" : "off");
+    if (p_global->mem_numa == ABT_TRUE) {
+        fprintf(fp, " - NUMA-aware placement: on (%d nodes)\n",
+                    p_global->mem_num_nodes - 1);
+    } else {
+        fprintf(fp, " - NUMA-aware placement: off\n");
+    }
     switch (p_global->mem_lp_alloc) {
         case ABTI_MEM_LP_MALLOC:
             fprintf(fp, " - large page allocation: malloc\n");
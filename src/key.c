@@ -126,22 +126,23 @@ int ABT_key_set(ABT_key key, void *value)
     ABTI_CHECK_INITIALIZED();
     ABTI_CHECK_TRUE(p_local != NULL, ABT_ERR_INV_XSTREAM);
 
-    /* Obtain the key-value table pointer. */
-    p_thread = p_local->p_thread;
-    if (p_thread) {
-        if (p_thread->p_keytable == NULL) {
-            int key_table_size = gp_ABTI_global->key_table_size;
-            p_thread->p_keytable = ABTI_ktable_alloc(key_table_size);
-        }
-        p_ktable = p_thread->p_keytable;
-    } else {
-        p_task = p_local->p_task;
-        ABTI_CHECK_TRUE(p_task != NULL, ABT_ERR_INV_TASK);
+    /* Obtain the key-value table pointer.  A tasklet running on a lent stack
+     * has both p_task and p_thread, and the tasklet's table is used. */
+    p_task = p_local->p_task;
+    if (p_task) {
         if (p_task->p_keytable == NULL) {
             int key_table_size = gp_ABTI_global->key_table_size;
             p_task->p_keytable = ABTI_ktable_alloc(key_table_size);
         }
         p_ktable = p_task->p_keytable;
+    } else {
+        p_thread = p_local->p_thread;
+        ABTI_CHECK_TRUE(p_thread != NULL, ABT_ERR_INV_THREAD);
+        if (p_thread->p_keytable == NULL) {
+            int key_table_size = gp_ABTI_global->key_table_size;
+            p_thread->p_keytable = ABTI_ktable_alloc(key_table_size);
+        }
+        p_ktable = p_thread->p_keytable;
     }
 
     /* Save the value in the key-value table */
@@ -187,17 +188,17 @@ int ABT_key_get(ABT_key key, void **value)
     ABTI_CHECK_TRUE(p_local != NULL, ABT_ERR_INV_XSTREAM);
 
     /* Obtain the key-value table pointer */
-    p_thread = p_local->p_thread;
-    if (p_thread) {
-        p_ktable = p_thread->p_keytable;
+    p_task = p_local->p_task;
+    if (p_task) {
+        p_ktable = p_task->p_keytable;
         if (p_ktable) {
             /* Retrieve the value from the key-value table */
             keyval = ABTI_ktable_get(p_ktable, p_key);
         }
     } else {
-        p_task = p_local->p_task;
-        ABTI_CHECK_TRUE(p_task != NULL, ABT_ERR_INV_TASK);
-        p_ktable = p_task->p_keytable;
+        p_thread = p_local->p_thread;
+        ABTI_CHECK_TRUE(p_thread != NULL, ABT_ERR_INV_THREAD);
+        p_ktable = p_thread->p_keytable;
         if (p_ktable) {
             /* Retrieve the value from the key-value table */
             keyval = ABTI_ktable_get(p_ktable, p_key);
@@ -44,6 +44,11 @@ int ABTI_local_init(ABTI_local **pp_local)
     p_local->p_xstream = NULL;
     p_local->p_thread = NULL;
     p_local->p_task = NULL;
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
+    p_local->p_task_thread = NULL;
+    p_local->p_copy_stack = NULL;
+    p_local->p_copy_thread = NULL;
+#endif
     ABTI_local_set_local(p_local);
 
     ABTI_mem_init_local(p_local);
@@ -64,6 +69,16 @@ int ABTI_local_finalize(ABTI_local **pp_local)
     int abt_errno = ABT_SUCCESS;
     ABTI_local *p_local = *pp_local;
     ABTI_CHECK_TRUE(p_local != NULL, ABT_ERR_OTHER);
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
+    if (p_local->p_task_thread) {
+        /* It has neither a unit nor a key table to free. */
+        ABTI_mem_free_thread(p_local, p_local->p_task_thread);
+    }
+    if (p_local->p_copy_stack) {
+        ABTI_VALGRIND_UNREGISTER_STACK(p_local->p_copy_stack);
+        ABTU_free(p_local->p_copy_stack);
+    }
+#endif
     ABTI_mem_finalize_local(p_local);
     ABTU_free(p_local);
     lp_ABTI_local = NULL;
@@ -6,15 +6,36 @@
 #include "abti.h"
 
 #ifdef ABT_CONFIG_USE_MEM_POOL
-/* Currently the total memory allocated for stacks and task block pages is not
- * shrunk to avoid the thrashing overhead except that ESs are terminated or
- * ABT_finalize is called.  When an ES terminates its execution, stacks and
- * empty pages that it holds are deallocated.  Non-empty pages are added to the
- * global data.  When ABTI_finalize is called, all memory objects that we have
- * allocated are returned to the higher-level memory allocator. */
+/* Currently the total memory allocated for task block pages is not shrunk to
+ * avoid the thrashing overhead except that ESs are terminated or ABT_finalize
+ * is called.  When an ES terminates its execution, stacks and empty pages that
+ * it holds are deallocated.  Non-empty pages are added to the global data.
+ * When ABTI_finalize is called, all memory objects that we have allocated are
+ * returned to the higher-level memory allocator.
+ *
+ * Free stacks are trimmed instead: the memory of stacks that have stayed in a
+ * free list for ABT_MEM_TRIM_INTERVAL is released by madvise() while their
+ * headers are kept, and stack pages whose stacks are all in one free list are
+ * freed.  ABT_mem_trim() trims all free stacks at once.
+ *
+ * If ABT_MEM_STACK_GUARD is set, the lowest OS page of each pooled stack is
+ * made inaccessible when its stack page is allocated.  A stack overflow then
+ * raises SIGSEGV, which is caught on a per-ES signal stack to report the ULT
+ * that overflowed.
+ *
+ * If ABT_MEM_NUMA is set on a NUMA machine, stack pages and task block pages
+ * are preferably placed on the NUMA node of the ES that allocates them, and
+ * the global lists of free stacks and pages are kept per node so that an ES
+ * only reuses the memory of its own node.  Free stacks and pages return to
+ * the lists of the node where they were placed. */
 
 #include <sys/types.h>
 #include <sys/mman.h>
+#include <signal.h>
+#include <unistd.h>
+#ifdef HAVE_SYS_SYSCALL_H
+#include <sys/syscall.h>
+#endif
 
 #define PROTS           (PROT_READ | PROT_WRITE)
 
@@ -43,60 +64,181 @@
 static inline void ABTI_mem_free_stack_list(ABTI_stack_header *p_stack);
 static inline void ABTI_mem_free_page_list(ABTI_page_header *p_ph);
 static inline void ABTI_mem_add_page(ABTI_local *p_local,
+                                     ABTI_page_header **pp_head,
+                                     ABTI_page_header **pp_tail,
                                      ABTI_page_header *p_ph);
-static inline void ABTI_mem_add_pages_to_global(ABTI_page_header *p_head,
-                                                ABTI_page_header *p_tail);
+static inline void ABTI_mem_add_pages_to_global(ABTI_page_header **pp_globals,
+                                                ABTI_page_header *p_head);
+static void ABTI_mem_finalize_page_list(ABTI_page_header **pp_head,
+                                        ABTI_page_header **pp_tail,
+                                        ABTI_page_header **pp_globals);
+static void ABTI_mem_bind_node(char *p_page, size_t size, int node);
 static inline void ABTI_mem_free_sph_list(ABTI_sp_header *p_sph);
+static void ABTI_mem_trim_stack_list(ABTI_stack_header **pp_list,
+                                     uint32_t *p_num_stacks, uint32_t gen,
+                                     ABT_bool trim_all);
+static void ABTI_mem_trim_global_locked(ABT_bool trim_all);
+static void ABTI_mem_unlink_sph(ABTI_sp_header *p_sph);
+static void ABTI_mem_free_sp(ABTI_sp_header *p_sph);
+static inline void ABTI_mem_protect_stack_guard(void *p_stack);
+static void ABTI_mem_stack_guard_handler(int sig, siginfo_t *p_info,
+                                         void *p_ucontext);
 static uint64_t g_sp_id = 0;
 
+/* Size of the signal stack of each ES used by the stack guard handler */
+#define ABTI_MEM_SIGSTACK_SIZE  (64*1024)
+static struct sigaction g_old_segv_action;
+static struct sigaction g_old_bus_action;
+
 
 void ABTI_mem_init(ABTI_global *p_global)
 {
-    p_global->p_mem_stack = NULL;
+    int i, n;
+
+    for (n = 0; n < ABTI_MEM_MAX_NODES; n++) {
+        for (i = 0; i < ABTI_MEM_MAX_STACK_CLASSES; i++) {
+            p_global->p_mem_stack[i][n] = NULL;
+        }
+        p_global->p_mem_task[n] = NULL;
+        for (i = 0; i < ABTI_MEM_NUM_SLABS; i++) {
+            p_global->p_mem_slab[i][n] = NULL;
+        }
+    }
     ABTI_spinlock_clear(&p_global->mem_task_lock);
-    p_global->p_mem_task = NULL;
     p_global->p_mem_sph = NULL;
 
+    ABTI_spinlock_clear(&p_global->mem_trim_lock);
+    p_global->mem_trim_next = ABTI_get_wtime_nsec() + p_global->mem_trim_nsec;
+    p_global->mem_trim_gen = 0;
+    p_global->mem_trim_epoch = 0;
+
+    if (p_global->mem_stack_guard == ABT_TRUE) {
+        /* The handler runs on the signal stack of each ES since the stack of
+         * the overflowing ULT cannot be used. */
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_sigaction = ABTI_mem_stack_guard_handler;
+        action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGSEGV, &action, &g_old_segv_action);
+        sigaction(SIGBUS, &action, &g_old_bus_action);
+    }
+
     g_sp_id = 0;
 }
 
 void ABTI_mem_init_local(ABTI_local *p_local)
 {
+    int i;
+
     /* TODO: preallocate some stacks? */
-    p_local->num_stacks = 0;
-    p_local->p_mem_stack = NULL;
+    for (i = 0; i < ABTI_MEM_MAX_STACK_CLASSES; i++) {
+        p_local->num_stacks[i] = 0;
+        p_local->p_mem_stack[i] = NULL;
+    }
 
     /* TODO: preallocate some task blocks? */
     p_local->p_mem_task_head = NULL;
     p_local->p_mem_task_tail = NULL;
+
+    /* Slab pages are allocated on demand as well. */
+    for (i = 0; i < ABTI_MEM_NUM_SLABS; i++) {
+        p_local->p_mem_slab_head[i] = NULL;
+        p_local->p_mem_slab_tail[i] = NULL;
+    }
+
+    p_local->mem_trim_gen = 0;
+    p_local->mem_trim_epoch =
+        ABTD_atomic_load_uint32(&gp_ABTI_global->mem_trim_epoch);
+    p_local->mem_trim_next = ABTI_get_wtime_nsec()
+                           + gp_ABTI_global->mem_trim_nsec;
+
+    /* Set up the signal stack for the stack guard handler */
+    p_local->p_sigstack = NULL;
+    if (gp_ABTI_global->mem_stack_guard == ABT_TRUE) {
+        stack_t ss;
+        p_local->p_sigstack = ABTU_malloc(ABTI_MEM_SIGSTACK_SIZE);
+        ss.ss_sp = p_local->p_sigstack;
+        ss.ss_size = ABTI_MEM_SIGSTACK_SIZE;
+        ss.ss_flags = 0;
+        sigaltstack(&ss, NULL);
+    }
 }
 
 void ABTI_mem_finalize(ABTI_global *p_global)
 {
-    /* Free all ramaining stacks */
-    ABTI_mem_free_stack_list(p_global->p_mem_stack);
-    p_global->p_mem_stack = NULL;
+    int i, n;
 
-    /* Free all task blocks */
-    ABTI_mem_free_page_list(p_global->p_mem_task);
-    p_global->p_mem_task = NULL;
+    for (n = 0; n < p_global->mem_num_nodes; n++) {
+        /* Free all ramaining stacks */
+        for (i = 0; i < ABTI_MEM_MAX_STACK_CLASSES; i++) {
+            ABTI_mem_free_stack_list(p_global->p_mem_stack[i][n]);
+            p_global->p_mem_stack[i][n] = NULL;
+        }
+
+        /* Free all task blocks */
+        ABTI_mem_free_page_list(p_global->p_mem_task[n]);
+        p_global->p_mem_task[n] = NULL;
+
+        /* Free all slab pages */
+        for (i = 0; i < ABTI_MEM_NUM_SLABS; i++) {
+            ABTI_mem_free_page_list(p_global->p_mem_slab[i][n]);
+            p_global->p_mem_slab[i][n] = NULL;
+        }
+    }
 
     /* Free all stack pages */
     ABTI_mem_free_sph_list(p_global->p_mem_sph);
     p_global->p_mem_sph = NULL;
+
+    if (p_global->mem_stack_guard == ABT_TRUE) {
+        sigaction(SIGSEGV, &g_old_segv_action, NULL);
+        sigaction(SIGBUS, &g_old_bus_action, NULL);
+    }
 }
 
 void ABTI_mem_finalize_local(ABTI_local *p_local)
 {
+    int i;
+
     /* Free all ramaining stacks */
-    ABTI_mem_free_stack_list(p_local->p_mem_stack);
-    p_local->num_stacks = 0;
-    p_local->p_mem_stack = NULL;
+    for (i = 0; i < ABTI_MEM_MAX_STACK_CLASSES; i++) {
+        ABTI_mem_free_stack_list(p_local->p_mem_stack[i]);
+        p_local->num_stacks[i] = 0;
+        p_local->p_mem_stack[i] = NULL;
+    }
 
     /* Free all task block pages */
+    ABTI_mem_finalize_page_list(&p_local->p_mem_task_head,
+                                &p_local->p_mem_task_tail,
+                                gp_ABTI_global->p_mem_task);
+
+    /* Free all slab pages */
+    for (i = 0; i < ABTI_MEM_NUM_SLABS; i++) {
+        ABTI_mem_finalize_page_list(&p_local->p_mem_slab_head[i],
+                                    &p_local->p_mem_slab_tail[i],
+                                    gp_ABTI_global->p_mem_slab[i]);
+    }
+
+    /* Free the signal stack */
+    if (p_local->p_sigstack) {
+        stack_t ss;
+        memset(&ss, 0, sizeof(ss));
+        ss.ss_flags = SS_DISABLE;
+        sigaltstack(&ss, NULL);
+        ABTU_free(p_local->p_sigstack);
+        p_local->p_sigstack = NULL;
+    }
+}
+
+/* Free the empty pages of a page list of an ES.  Non-empty pages are moved to
+ * the global lists of their NUMA nodes in pp_globals. */
+static void ABTI_mem_finalize_page_list(ABTI_page_header **pp_head,
+                                        ABTI_page_header **pp_tail,
+                                        ABTI_page_header **pp_globals)
+{
     ABTI_page_header *p_rem_head = NULL;
-    ABTI_page_header *p_rem_tail = NULL;
-    ABTI_page_header *p_cur = p_local->p_mem_task_head;
+    ABTI_page_header *p_cur = *pp_head;
     while (p_cur) {
         ABTI_page_header *p_tmp = p_cur;
         p_cur = p_cur->p_next;
@@ -117,20 +259,17 @@ void ABTI_mem_finalize_local(ABTI_local *p_local)
             p_tmp->p_prev = NULL;
             p_tmp->p_next = p_rem_head;
             p_rem_head = p_tmp;
-            if (p_rem_tail == NULL) {
-                p_rem_tail = p_tmp;
-            }
         }
 
-        if (p_cur == p_local->p_mem_task_head) break;
+        if (p_cur == *pp_head) break;
     }
-    p_local->p_mem_task_head = NULL;
-    p_local->p_mem_task_tail = NULL;
+    *pp_head = NULL;
+    *pp_tail = NULL;
 
     /* If there are pages that have not been fully freed, we move them to the
-     * global task page list. */
+     * global page list. */
     if (p_rem_head) {
-        ABTI_mem_add_pages_to_global(p_rem_head, p_rem_tail);
+        ABTI_mem_add_pages_to_global(pp_globals, p_rem_head);
     }
 }
 
@@ -229,49 +368,74 @@ static inline void ABTI_mem_free_page_list(ABTI_page_header *p_ph)
 }
 
 static inline void ABTI_mem_add_page(ABTI_local *p_local,
+                                     ABTI_page_header **pp_head,
+                                     ABTI_page_header **pp_tail,
                                      ABTI_page_header *p_ph)
 {
     p_ph->owner_id = ABTI_self_get_native_thread_id(p_local);
 
     /* Add the page to the head */
-    if (p_local->p_mem_task_head != NULL) {
-        p_ph->p_prev = p_local->p_mem_task_tail;
-        p_ph->p_next = p_local->p_mem_task_head;
-        p_local->p_mem_task_head->p_prev = p_ph;
-        p_local->p_mem_task_tail->p_next = p_ph;
-        p_local->p_mem_task_head = p_ph;
+    if (*pp_head != NULL) {
+        p_ph->p_prev = *pp_tail;
+        p_ph->p_next = *pp_head;
+        (*pp_head)->p_prev = p_ph;
+        (*pp_tail)->p_next = p_ph;
+        *pp_head = p_ph;
     } else {
         p_ph->p_prev = p_ph;
         p_ph->p_next = p_ph;
-        p_local->p_mem_task_head = p_ph;
-        p_local->p_mem_task_tail = p_ph;
+        *pp_head = p_ph;
+        *pp_tail = p_ph;
     }
 }
 
-static inline void ABTI_mem_add_pages_to_global(ABTI_page_header *p_head,
-                                                ABTI_page_header *p_tail)
+static inline void ABTI_mem_add_pages_to_global(ABTI_page_header **pp_globals,
+                                                ABTI_page_header *p_head)
 {
     ABTI_global *p_global = gp_ABTI_global;
+    ABTI_page_header *p_ph;
 
-    /* Add the page list to the global list */
+    /* Add each page to the global list of its node */
     ABTI_spinlock_acquire(&p_global->mem_task_lock);
-    p_tail->p_next = p_global->p_mem_task;
-    p_global->p_mem_task = p_head;
+    while (p_head) {
+        ABTI_page_header **pp_global =
+            &pp_globals[ABTI_mem_get_node_index(p_head->node)];
+        p_ph = p_head;
+        p_head = p_head->p_next;
+        p_ph->p_next = *pp_global;
+        *pp_global = p_ph;
+    }
     ABTI_spinlock_release(&p_global->mem_task_lock);
 }
 
-char *ABTI_mem_take_global_stack(ABTI_local *p_local)
+/* Return the NUMA node to which the affinity of the calling ES is confined,
+ * or -1 if NUMA-aware placement is disabled or the ES may run on CPUs of
+ * several nodes.  Memory of node -1 goes to the shared global lists and is
+ * not bound.  The node is looked up whenever memory is taken from the global
+ * data or newly allocated since the affinity of the ES can be changed. */
+int ABTI_mem_get_local_node(ABTI_local *p_local)
+{
+    ABTI_UNUSED(p_local);
+    if (gp_ABTI_global->mem_numa == ABT_FALSE) return -1;
+    return ABTD_affinity_get_self_node();
+}
+
+/* Move the stacks of stack_class in the global list of node to the calling
+ * ES and return the first one. */
+char *ABTI_mem_take_global_stack(ABTI_local *p_local, int stack_class,
+                                 int node)
 {
     ABTI_global *p_global = gp_ABTI_global;
     ABTI_stack_header *p_sh, *p_cur;
     uint32_t cnt_stacks = 0;
+    int idx = ABTI_mem_get_node_index(node);
 
     void **ptr;
     void *old;
     do {
-        p_sh = (ABTI_stack_header *)
-            ABTD_atomic_load_ptr((void **)&p_global->p_mem_stack);
-        ptr = (void **)&p_global->p_mem_stack;
+        p_sh = (ABTI_stack_header *)ABTD_atomic_load_ptr(
+            (void **)&p_global->p_mem_stack[stack_class][idx]);
+        ptr = (void **)&p_global->p_mem_stack[stack_class][idx];
         old = (void *)p_sh;
     } while (!ABTD_atomic_bool_cas_weak_ptr(ptr, old, NULL));
 
@@ -284,12 +448,13 @@ char *ABTI_mem_take_global_stack(ABTI_local *p_local)
     p_cur = p_sh;
     while (p_cur->p_next) {
         p_cur = p_cur->p_next;
+        p_cur->trim_gen = p_local->mem_trim_gen;
         cnt_stacks++;
     }
 
     /* Return the first one and keep the rest in p_local */
-    p_local->num_stacks = cnt_stacks;
-    p_local->p_mem_stack = p_sh->p_next;
+    p_local->num_stacks[stack_class] = cnt_stacks;
+    p_local->p_mem_stack[stack_class] = p_sh->p_next;
 
     return (char *)p_sh - sizeof(ABTI_thread);
 }
@@ -299,18 +464,26 @@ void ABTI_mem_add_stack_to_global(ABTI_stack_header *p_sh)
     ABTI_global *p_global = gp_ABTI_global;
     void **ptr;
     void *old, *new;
+    int stack_class = p_sh->p_sph->stack_class;
+    int idx = ABTI_mem_get_node_index(p_sh->p_sph->node);
 
+    /* The stack goes back to the list of the node where it is placed. */
+    p_sh->trim_gen = ABTD_atomic_load_uint32(&p_global->mem_trim_gen);
     do {
         ABTI_stack_header *p_mem_stack = (ABTI_stack_header *)
-            ABTD_atomic_load_ptr((void **)&p_global->p_mem_stack);
+            ABTD_atomic_load_ptr(
+                (void **)&p_global->p_mem_stack[stack_class][idx]);
         p_sh->p_next = p_mem_stack;
-        ptr = (void **)&p_global->p_mem_stack;
+        ptr = (void **)&p_global->p_mem_stack[stack_class][idx];
         old = (void *)p_mem_stack;
         new = (void *)p_sh;
     } while (!ABTD_atomic_bool_cas_weak_ptr(ptr, old, new));
 }
 
-static char *ABTI_mem_alloc_large_page(int pgsize, ABT_bool *p_is_mmapped)
+/* Allocate a large page of pgsize bytes.  If node is not -1, the page is
+ * preferably placed on NUMA node node. */
+static char *ABTI_mem_alloc_large_page(int pgsize, ABT_bool *p_is_mmapped,
+                                       int node)
 {
     char *p_page = NULL;
 
@@ -388,24 +561,72 @@ static char *ABTI_mem_alloc_large_page(int pgsize, ABT_bool *p_is_mmapped)
             break;
     }
 
+    if (node >= 0 && p_page) {
+        ABTI_mem_bind_node(p_page, pgsize, node);
+    }
     return p_page;
 }
 
-ABTI_page_header *ABTI_mem_alloc_page(ABTI_local *p_local, size_t blk_size)
+/* Set the memory policy of the OS pages that lie entirely in [p_page, p_page +
+ * size) to prefer NUMA node node.  mbind() is called directly so as not to
+ * depend on libnuma.  It only affects pages that have not been touched, and
+ * the pages are placed by the kernel as usual if it fails. */
+static void ABTI_mem_bind_node(char *p_page, size_t size, int node)
+{
+#if defined(SYS_mbind)
+    /* MPOL_PREFERRED of <linux/mempolicy.h> */
+    const int mode = 1;
+    unsigned long nodemask[16];
+    const unsigned long maxnode = sizeof(nodemask) * 8;
+    const size_t bits = sizeof(unsigned long) * 8;
+    uintptr_t pgmask = (uintptr_t)gp_ABTI_global->os_page_size - 1;
+    uintptr_t start = ((uintptr_t)p_page + pgmask) & ~pgmask;
+    uintptr_t end = ((uintptr_t)p_page + size) & ~pgmask;
+
+    /* The kernel reads maxnode - 1 bits of the mask. */
+    if (start >= end || (unsigned long)node + 1 >= maxnode) return;
+    memset(nodemask, 0, sizeof(nodemask));
+    nodemask[node / bits] = 1UL << (node % bits);
+    if (syscall(SYS_mbind, (void *)start, (unsigned long)(end - start), mode,
+                nodemask, maxnode, 0)) {
+        LOG_DEBUG("failed to bind a page to node %d: %p\n", node, p_page);
+    }
+#else
+    ABTI_UNUSED(p_page);
+    ABTI_UNUSED(size);
+    ABTI_UNUSED(node);
+#endif
+}
+
+/* Allocate a page of pgsize bytes on NUMA node node, split it into blocks of
+ * blk_size bytes, and add it to the page list of the calling ES given by
+ * pp_head and pp_tail.  Pages smaller than mem_page_size are not backed by
+ * large pages. */
+ABTI_page_header *ABTI_mem_alloc_page(ABTI_local *p_local,
+                                      ABTI_page_header **pp_head,
+                                      ABTI_page_header **pp_tail,
+                                      size_t pgsize, size_t blk_size,
+                                      int node)
 {
     int i;
     ABTI_page_header *p_ph;
     ABTI_blk_header *p_cur;
     ABTI_global *p_global = gp_ABTI_global;
     const uint32_t clsize = ABT_CONFIG_STATIC_CACHELINE_SIZE;
-    size_t pgsize = p_global->mem_page_size;
+    char *p_page;
     ABT_bool is_mmapped;
 
     /* Make the page header size a multiple of cache line size */
     const size_t ph_size = (sizeof(ABTI_page_header)+clsize) / clsize * clsize;
 
     uint32_t num_blks = (pgsize - ph_size) / blk_size;
-    char *p_page = ABTI_mem_alloc_large_page(pgsize, &is_mmapped);
+    if (pgsize < p_global->mem_page_size) {
+        is_mmapped = ABT_FALSE;
+        p_page = (char *)ABTU_memalign(p_global->os_page_size, pgsize);
+        if (node >= 0) ABTI_mem_bind_node(p_page, pgsize, node);
+    } else {
+        p_page = ABTI_mem_alloc_large_page(pgsize, &is_mmapped, node);
+    }
 
     /* Set the page header */
     p_ph = (ABTI_page_header *)p_page;
@@ -415,8 +636,9 @@ ABTI_page_header *ABTI_mem_alloc_page(ABTI_local *p_local, size_t blk_size)
     p_ph->num_remote_free = 0;
     p_ph->p_head = (ABTI_blk_header *)(p_page + ph_size);
     p_ph->p_free = NULL;
-    ABTI_mem_add_page(p_local, p_ph);
+    ABTI_mem_add_page(p_local, pp_head, pp_tail, p_ph);
     p_ph->is_mmapped = is_mmapped;
+    p_ph->node = node;
 
     /* Make a liked list of all free blocks */
     p_cur = p_ph->p_head;
@@ -431,10 +653,11 @@ ABTI_page_header *ABTI_mem_alloc_page(ABTI_local *p_local, size_t blk_size)
     return p_ph;
 }
 
-void ABTI_mem_free_page(ABTI_local *p_local, ABTI_page_header *p_ph)
+void ABTI_mem_free_page(ABTI_page_header **pp_head, ABTI_page_header **pp_tail,
+                        ABTI_page_header *p_ph)
 {
     /* We keep one page for future use. */
-    if (p_local->p_mem_task_head == p_local->p_mem_task_tail) return;
+    if (*pp_head == *pp_tail) return;
 
     uint32_t num_free_blks = p_ph->num_empty_blks + p_ph->num_remote_free;
     if (num_free_blks == p_ph->num_total_blks) {
@@ -442,10 +665,10 @@ void ABTI_mem_free_page(ABTI_local *p_local, ABTI_page_header *p_ph)
         /* Remove from the list and free the page */
         p_ph->p_prev->p_next = p_ph->p_next;
         p_ph->p_next->p_prev = p_ph->p_prev;
-        if (p_ph == p_local->p_mem_task_head) {
-            p_local->p_mem_task_head = p_ph->p_next;
-        } else if (p_ph == p_local->p_mem_task_tail) {
-            p_local->p_mem_task_tail = p_ph->p_prev;
+        if (p_ph == *pp_head) {
+            *pp_head = p_ph->p_next;
+        } else if (p_ph == *pp_tail) {
+            *pp_tail = p_ph->p_prev;
         }
         if (p_ph->is_mmapped == ABT_TRUE) {
             munmap(p_ph, gp_ABTI_global->mem_page_size);
@@ -496,21 +719,26 @@ void ABTI_mem_free_remote(ABTI_page_header *p_ph, ABTI_blk_header *p_bh)
     ABTD_atomic_fetch_add_uint32(&p_ph->num_remote_free, 1);
 }
 
-ABTI_page_header *ABTI_mem_take_global_page(ABTI_local *p_local)
+/* Move the first page of the global list *pp_global to the page list of the
+ * calling ES.  NULL is returned if the page has no empty block. */
+ABTI_page_header *ABTI_mem_take_global_page(ABTI_local *p_local,
+                                            ABTI_page_header **pp_global,
+                                            ABTI_page_header **pp_head,
+                                            ABTI_page_header **pp_tail)
 {
     ABTI_global *p_global = gp_ABTI_global;
     ABTI_page_header *p_ph = NULL;
 
     /* Take the first page out */
     ABTI_spinlock_acquire(&p_global->mem_task_lock);
-    if (p_global->p_mem_task) {
-        p_ph = p_global->p_mem_task;
-        p_global->p_mem_task = p_ph->p_next;
+    if (*pp_global) {
+        p_ph = *pp_global;
+        *pp_global = p_ph->p_next;
     }
     ABTI_spinlock_release(&p_global->mem_task_lock);
 
     if (p_ph) {
-        ABTI_mem_add_page(p_local, p_ph);
+        ABTI_mem_add_page(p_local, pp_head, pp_tail, p_ph);
         if (p_ph->p_free) ABTI_mem_take_free(p_ph);
         if (p_ph->p_head == NULL) p_ph = NULL;
     }
@@ -532,20 +760,131 @@ static inline void ABTI_mem_free_sph_list(ABTI_sp_header *p_sph)
                       p_tmp->num_total_stacks - p_tmp->num_empty_stacks);
         }
 
-        if (p_tmp->is_mmapped == ABT_TRUE) {
-            if (munmap(p_tmp->p_sp, gp_ABTI_global->mem_sp_size)) {
-                ABTI_ASSERT(0);
-            }
-        } else {
-            ABTU_free(p_tmp->p_sp);
+        ABTI_mem_free_sp(p_tmp);
+    }
+}
+
+/* Free a stack page and its header. */
+static void ABTI_mem_free_sp(ABTI_sp_header *p_sph)
+{
+    size_t sp_size = gp_ABTI_global->mem_sp_size;
+
+    if (p_sph->is_mmapped == ABT_TRUE) {
+        if (munmap(p_sph->p_sp, sp_size)) {
+            ABTI_ASSERT(0);
+        }
+    } else {
+        if (gp_ABTI_global->mem_stack_guard == ABT_TRUE) {
+            /* Make the guard pages accessible again before the page is
+             * returned to the allocator.  They are all in the OS pages that
+             * lie entirely in the stack page. */
+            uintptr_t pgmask = (uintptr_t)gp_ABTI_global->os_page_size - 1;
+            uintptr_t start = ((uintptr_t)p_sph->p_sp + pgmask) & ~pgmask;
+            uintptr_t end = ((uintptr_t)p_sph->p_sp + sp_size) & ~pgmask;
+            mprotect((void *)start, end - start, PROTS);
         }
-        ABTU_free(p_tmp);
+        ABTU_free(p_sph->p_sp);
+    }
+    ABTU_free(p_sph);
+}
+
+/* Make the guard page of a pooled stack inaccessible. */
+static inline void ABTI_mem_protect_stack_guard(void *p_stack)
+{
+    size_t pgsize = gp_ABTI_global->os_page_size;
+    char *p_guard = ABTI_mem_get_stack_guard_end(p_stack) - pgsize;
+    if (mprotect(p_guard, pgsize, PROT_NONE)) {
+        LOG_DEBUG("failed to protect the stack guard page: %p\n", p_guard);
     }
 }
 
-/* Allocate a stack page and divide it to multiple stacks by making a liked
- * list.  Then, the first stack is returned. */
-char *ABTI_mem_alloc_sp(ABTI_local *p_local, size_t stacksize)
+/* Append the string str to buf of size bytes, which has len bytes, and
+ * return the new length.  This and ABTI_mem_sig_append_num() are used in
+ * the signal handler, so they only touch the given buffer. */
+static size_t ABTI_mem_sig_append_str(char *buf, size_t len, size_t size,
+                                      const char *str)
+{
+    while (*str && len < size) buf[len++] = *str++;
+    return len;
+}
+
+/* Append val in base 10 or 16 (with "0x") to buf like
+ * ABTI_mem_sig_append_str(). */
+static size_t ABTI_mem_sig_append_num(char *buf, size_t len, size_t size,
+                                      uint64_t val, int base)
+{
+    char digits[24];
+    int n = 0;
+
+    if (base == 16) len = ABTI_mem_sig_append_str(buf, len, size, "0x");
+    do {
+        digits[n++] = "0123456789abcdef"[val % base];
+        val /= base;
+    } while (val);
+    while (n > 0 && len < size) buf[len++] = digits[--n];
+    return len;
+}
+
+/* SIGSEGV and SIGBUS handler installed if ABT_MEM_STACK_GUARD is set.  If the
+ * fault is in the guard page of the running ULT, the overflow is reported,
+ * the previous handler is restored, and the faulting access is retried so
+ * that the signal is handled as it would be without Argobots.  Other faults
+ * are passed to the previous handler, which stays installed.  Only
+ * async-signal-safe functions are called. */
+static void ABTI_mem_stack_guard_handler(int sig, siginfo_t *p_info,
+                                         void *p_ucontext)
+{
+    ABTI_local *p_local = ABTI_local_get_local();
+    ABTI_thread *p_thread = p_local ? p_local->p_thread : NULL;
+    char *p_addr = (char *)p_info->si_addr;
+    struct sigaction *p_old = (sig == SIGSEGV) ? &g_old_segv_action
+                                               : &g_old_bus_action;
+
+    if (p_thread && p_thread->attr.stacktype == ABTI_STACK_TYPE_MEMPOOL) {
+        ABTI_stack_header *p_sh = (ABTI_stack_header *)
+            ((char *)p_thread + sizeof(ABTI_thread));
+        char *p_stack = (char *)p_sh->p_stack;
+        if (p_addr >= p_stack &&
+            p_addr < ABTI_mem_get_stack_guard_end(p_stack)) {
+            char *p_begin = (char *)p_thread->attr.p_stack;
+            char msg[160];
+            size_t len = 0;
+            len = ABTI_mem_sig_append_str(msg, len, sizeof(msg), "[ABT] ULT ");
+            len = ABTI_mem_sig_append_num(msg, len, sizeof(msg),
+                      (uint64_t)ABTI_thread_get_id(p_thread), 10);
+            len = ABTI_mem_sig_append_str(msg, len, sizeof(msg),
+                                          " overflowed its stack (");
+            len = ABTI_mem_sig_append_num(msg, len, sizeof(msg),
+                                          (uintptr_t)p_begin, 16);
+            len = ABTI_mem_sig_append_str(msg, len, sizeof(msg), "-");
+            len = ABTI_mem_sig_append_num(msg, len, sizeof(msg),
+                      (uintptr_t)(p_begin + p_thread->attr.stacksize), 16);
+            len = ABTI_mem_sig_append_str(msg, len, sizeof(msg), ") at ");
+            len = ABTI_mem_sig_append_num(msg, len, sizeof(msg),
+                                          (uintptr_t)p_addr, 16);
+            len = ABTI_mem_sig_append_str(msg, len, sizeof(msg), "\n");
+            ssize_t ret = write(STDERR_FILENO, msg, len);
+            ABTI_UNUSED(ret);
+
+            sigaction(sig, p_old, NULL);
+            return;
+        }
+    }
+
+    if (p_old->sa_flags & SA_SIGINFO) {
+        p_old->sa_sigaction(sig, p_info, p_ucontext);
+    } else if (p_old->sa_handler != SIG_DFL && p_old->sa_handler != SIG_IGN) {
+        p_old->sa_handler(sig);
+    } else {
+        /* The default action cannot be called, so it is restored. */
+        sigaction(sig, p_old, NULL);
+    }
+}
+
+/* Allocate a stack page on NUMA node node and divide it to multiple stacks of
+ * the size class stack_class by making a liked list.  Then, the first stack is
+ * returned. */
+char *ABTI_mem_alloc_sp(ABTI_local *p_local, int stack_class, int node)
 {
     char *p_sp, *p_first;
     ABTI_sp_header *p_sph;
@@ -555,6 +894,7 @@ char *ABTI_mem_alloc_sp(ABTI_local *p_local, size_t stacksize)
 
     uint32_t header_size = ABTI_MEM_SH_SIZE;
     uint32_t sp_size = gp_ABTI_global->mem_sp_size;
+    size_t stacksize = gp_ABTI_global->mem_stack_classes[stack_class];
     size_t actual_stacksize = stacksize - header_size;
     void *p_stack = NULL;
 
@@ -564,10 +904,13 @@ char *ABTI_mem_alloc_sp(ABTI_local *p_local, size_t stacksize)
     p_sph->num_total_stacks = num_stacks;
     p_sph->num_empty_stacks = 0;
     p_sph->stacksize = stacksize;
+    p_sph->stack_class = stack_class;
+    p_sph->node = node;
     p_sph->id = ABTD_atomic_fetch_add_uint64(&g_sp_id, 1);
+    p_sph->num_trim_stacks = 0;
 
     /* Allocate a stack page */
-    p_sp = ABTI_mem_alloc_large_page(sp_size, &p_sph->is_mmapped);
+    p_sp = ABTI_mem_alloc_large_page(sp_size, &p_sph->is_mmapped, node);
 
     /* Save the stack page pointer */
     p_sph->p_sp = p_sp;
@@ -577,16 +920,20 @@ char *ABTI_mem_alloc_sp(ABTI_local *p_local, size_t stacksize)
     p_first = p_sp + actual_stacksize * first_pos;
     p_sh = (ABTI_stack_header *)(p_first + sizeof(ABTI_thread));
     p_sh->p_sph = p_sph;
+    p_sh->is_trimmed = ABT_FALSE;
     p_stack = (first_pos == 0)
             ? (void *)(p_first + header_size * num_stacks) : (void *)p_sp;
     p_sh->p_stack = p_stack;
+    if (gp_ABTI_global->mem_stack_guard == ABT_TRUE) {
+        ABTI_mem_protect_stack_guard(p_stack);
+    }
 
     if (num_stacks > 1) {
         /* Make a linked list with remaining stacks */
         p_sh = (ABTI_stack_header *)((char *)p_sh + header_size);
 
-        p_local->num_stacks = num_stacks - 1;
-        p_local->p_mem_stack = p_sh;
+        p_local->num_stacks[stack_class] = num_stacks - 1;
+        p_local->p_mem_stack[stack_class] = p_sh;
 
         for (i = 1; i < num_stacks; i++) {
             p_next = (i + 1) < num_stacks
@@ -594,6 +941,8 @@ char *ABTI_mem_alloc_sp(ABTI_local *p_local, size_t stacksize)
                    : NULL;
             p_sh->p_next = p_next;
             p_sh->p_sph = p_sph;
+            p_sh->trim_gen = p_local->mem_trim_gen;
+            p_sh->is_trimmed = ABT_FALSE;
             if (first_pos == 0) {
                 p_sh->p_stack = (void *)((char *)p_stack + i * actual_stacksize);
             } else {
@@ -604,6 +953,9 @@ char *ABTI_mem_alloc_sp(ABTI_local *p_local, size_t stacksize)
                                   + (i - first_pos) * actual_stacksize);
                 }
             }
+            if (gp_ABTI_global->mem_stack_guard == ABT_TRUE) {
+                ABTI_mem_protect_stack_guard(p_sh->p_stack);
+            }
 
             p_sh = p_next;
         }
@@ -620,5 +972,174 @@ char *ABTI_mem_alloc_sp(ABTI_local *p_local, size_t stacksize)
     return p_first;
 }
 
-#endif /* ABT_CONFIG_USE_MEM_POOL */
+/* Trim the free stacks of the calling ES.  If trim_all is ABT_FALSE, only
+ * stacks that have been in the free lists since the last trimming are
+ * trimmed, so a stack is trimmed after it has been idle for one to two
+ * trimming intervals, and the trimming is retried later if another ES is
+ * trimming. */
+void ABTI_mem_trim_local(ABTI_local *p_local, ABT_bool trim_all)
+{
+    ABTI_global *p_global = gp_ABTI_global;
+    int i;
+
+    /* Trimming is serialized since it counts the free stacks of each stack
+     * page, which may be in the free lists of several ESs. */
+    if (trim_all == ABT_TRUE) {
+        ABTI_spinlock_acquire(&p_global->mem_trim_lock);
+    } else if (!ABTI_spinlock_try_acquire(&p_global->mem_trim_lock)) {
+        return;
+    }
+
+    for (i = 0; i < p_global->mem_num_stack_classes; i++) {
+        ABTI_mem_trim_stack_list(&p_local->p_mem_stack[i],
+                                 &p_local->num_stacks[i],
+                                 p_local->mem_trim_gen, trim_all);
+    }
 
+    /* The global stacks are trimmed by whichever ES comes here first. */
+    if (trim_all == ABT_FALSE && ABTI_get_wtime_nsec() >=
+        ABTD_atomic_load_uint64(&p_global->mem_trim_next)) {
+        ABTI_mem_trim_global_locked(ABT_FALSE);
+    }
+    ABTI_spinlock_release(&p_global->mem_trim_lock);
+
+    p_local->mem_trim_gen++;
+    p_local->mem_trim_epoch =
+        ABTD_atomic_load_uint32(&p_global->mem_trim_epoch);
+    p_local->mem_trim_next = ABTI_get_wtime_nsec() + p_global->mem_trim_nsec;
+}
+
+/* Trim the stacks in the global stack lists. */
+void ABTI_mem_trim_global(ABT_bool trim_all)
+{
+    ABTI_global *p_global = gp_ABTI_global;
+
+    ABTI_spinlock_acquire(&p_global->mem_trim_lock);
+    ABTI_mem_trim_global_locked(trim_all);
+    ABTI_spinlock_release(&p_global->mem_trim_lock);
+}
+
+static void ABTI_mem_trim_global_locked(ABT_bool trim_all)
+{
+    ABTI_global *p_global = gp_ABTI_global;
+    uint32_t gen = ABTD_atomic_load_uint32(&p_global->mem_trim_gen);
+    int i, n;
+
+    for (i = 0; i < p_global->mem_num_stack_classes; i++) {
+        for (n = 0; n < p_global->mem_num_nodes; n++) {
+            ABTI_stack_header *p_sh, *p_tail;
+            void **ptr = (void **)&p_global->p_mem_stack[i][n];
+            void *old;
+
+            /* Take the whole list out so that it can be trimmed without
+             * blocking ESs that free stacks. */
+            do {
+                p_sh = (ABTI_stack_header *)ABTD_atomic_load_ptr(ptr);
+                old = (void *)p_sh;
+            } while (!ABTD_atomic_bool_cas_weak_ptr(ptr, old, NULL));
+            if (p_sh == NULL) continue;
+
+            ABTI_mem_trim_stack_list(&p_sh, NULL, gen, trim_all);
+            if (p_sh == NULL) continue;
+
+            /* Put the remaining stacks back */
+            p_tail = p_sh;
+            while (p_tail->p_next) p_tail = p_tail->p_next;
+            do {
+                p_tail->p_next = (ABTI_stack_header *)ABTD_atomic_load_ptr(ptr);
+                old = (void *)p_tail->p_next;
+            } while (!ABTD_atomic_bool_cas_weak_ptr(ptr, old, (void *)p_sh));
+        }
+    }
+
+    ABTD_atomic_fetch_add_uint32(&p_global->mem_trim_gen, 1);
+    ABTD_atomic_store_uint64(&p_global->mem_trim_next,
+                             ABTI_get_wtime_nsec() + p_global->mem_trim_nsec);
+}
+
+/* Release the memory of the stacks in *pp_list except their headers.  Stacks
+ * freed in generation gen are skipped unless trim_all is ABT_TRUE.  Stack
+ * pages whose stacks are all in the list are removed from the list and
+ * freed.  If p_num_stacks is not NULL, it is decreased by the number of
+ * removed stacks.  The caller must hold mem_trim_lock. */
+static void ABTI_mem_trim_stack_list(ABTI_stack_header **pp_list,
+                                     uint32_t *p_num_stacks, uint32_t gen,
+                                     ABT_bool trim_all)
+{
+    ABTI_global *p_global = gp_ABTI_global;
+    const uintptr_t pgmask = (uintptr_t)p_global->os_page_size - 1;
+    ABTI_stack_header *p_sh, **pp_prev;
+    ABTI_sp_header *p_free_sph = NULL;
+
+    if (*pp_list == NULL) return;
+
+    /* Count the free stacks of each stack page */
+    for (p_sh = *pp_list; p_sh; p_sh = p_sh->p_next) {
+        p_sh->p_sph->num_trim_stacks = 0;
+    }
+    for (p_sh = *pp_list; p_sh; p_sh = p_sh->p_next) {
+        p_sh->p_sph->num_trim_stacks++;
+    }
+
+    pp_prev = pp_list;
+    while ((p_sh = *pp_prev) != NULL) {
+        ABTI_sp_header *p_sph = p_sh->p_sph;
+
+        if (p_sph->num_trim_stacks >= p_sph->num_total_stacks) {
+            /* All stacks of this page are free.  The page is freed after the
+             * list has been walked because it contains the stack headers. */
+            if (p_sph->num_trim_stacks == p_sph->num_total_stacks) {
+                p_sph->num_trim_stacks++;
+                p_sph->p_trim_next = p_free_sph;
+                p_free_sph = p_sph;
+            }
+            *pp_prev = p_sh->p_next;
+            if (p_num_stacks) (*p_num_stacks)--;
+            continue;
+        }
+
+        if (trim_all == ABT_TRUE ||
+            (p_sh->is_trimmed == ABT_FALSE && p_sh->trim_gen != gen)) {
+            /* Only whole OS pages inside the stack area are released. */
+            uintptr_t start = ((uintptr_t)p_sh->p_stack + pgmask) & ~pgmask;
+            uintptr_t end = ((uintptr_t)p_sh->p_stack + p_sph->stacksize
+                             - ABTI_MEM_SH_SIZE) & ~pgmask;
+            if (start < end) {
+                /* MADV_FREE is not used since it does not reduce RSS until
+                 * the system runs short of memory.  madvise() fails for
+                 * hugetlb pages, which are kept as they are. */
+                madvise((void *)start, end - start, MADV_DONTNEED);
+            }
+            p_sh->is_trimmed = ABT_TRUE;
+        }
+        pp_prev = &p_sh->p_next;
+    }
+
+    while (p_free_sph) {
+        ABTI_sp_header *p_sph = p_free_sph;
+        p_free_sph = p_sph->p_trim_next;
+        ABTI_mem_unlink_sph(p_sph);
+        LOG_DEBUG("free an idle stack page (%u): %p\n",
+                  p_global->mem_sp_size, p_sph->p_sp);
+        ABTI_mem_free_sp(p_sph);
+    }
+}
+
+/* Remove a stack page from the global stack page list.  The caller must hold
+ * mem_trim_lock.  Since ABTI_mem_alloc_sp() only changes the head of the list,
+ * other pages can be unlinked without atomic operations. */
+static void ABTI_mem_unlink_sph(ABTI_sp_header *p_sph)
+{
+    void **ptr = (void **)&gp_ABTI_global->p_mem_sph;
+    ABTI_sp_header *p_prev;
+
+    if (ABTD_atomic_bool_cas_strong_ptr(ptr, (void *)p_sph,
+                                        (void *)p_sph->p_next)) {
+        return;
+    }
+    p_prev = (ABTI_sp_header *)ABTD_atomic_load_ptr(ptr);
+    while (p_prev->p_next != p_sph) p_prev = p_prev->p_next;
+    p_prev->p_next = p_sph->p_next;
+}
+
+#endif /* ABT_CONFIG_USE_MEM_POOL */
@@ -6,6 +6,11 @@
 #include "abti.h"
 #include "abti_thread_htable.h"
 
+static ABTI_thread_htable *ABTI_mutex_get_htable(ABTI_mutex *p_mutex);
+static inline void ABTI_mutex_wait_qnode(ABTI_local **pp_local,
+                                         ABTI_mutex *p_mutex,
+                                         ABTI_mutex_qnode *p_node,
+                                         ABT_bool is_first);
 
 /** @defgroup MUTEX Mutex
  * Mutex is a synchronization method to support mutual exclusion between ULTs.
@@ -17,6 +22,13 @@
  * The mutex is basically intended to be used by ULTs but it can also be used
  * by tasklets or external threads.  In that case, the mutex will behave like
  * a spinlock.
+ *
+ * A mutex created with the FIFO attribute (see \c ABT_mutex_attr_set_fifo())
+ * keeps its waiters in a queue and hands the mutex over to the first waiter
+ * on unlock, regardless of which ES it runs on.  Waiters spin on their own
+ * queue nodes, and the first ULT waiter spins for an adaptive period before
+ * it is suspended.  Tasklets and external threads in the queue block their
+ * native threads instead of spinning.
  */
 
 /**
@@ -38,7 +50,9 @@ int ABT_mutex_create(ABT_mutex *newmutex)
     int abt_errno = ABT_SUCCESS;
     ABTI_mutex *p_newmutex;
 
-    p_newmutex = (ABTI_mutex *)ABTU_calloc(1, sizeof(ABTI_mutex));
+    p_newmutex = (ABTI_mutex *)ABTI_mem_alloc_slab(ABTI_local_get_local(),
+                                                   sizeof(ABTI_mutex));
+    memset(p_newmutex, 0, sizeof(ABTI_mutex));
     ABTI_mutex_init(p_newmutex);
 
     /* Return value */
@@ -70,7 +84,8 @@ int ABT_mutex_create_with_attr(ABT_mutex_attr attr, ABT_mutex *newmutex)
     ABTI_CHECK_NULL_MUTEX_ATTR_PTR(p_attr);
     ABTI_mutex *p_newmutex;
 
-    p_newmutex = (ABTI_mutex *)ABTU_malloc(sizeof(ABTI_mutex));
+    p_newmutex = (ABTI_mutex *)ABTI_mem_alloc_slab(ABTI_local_get_local(),
+                                                   sizeof(ABTI_mutex));
     ABTI_mutex_init(p_newmutex);
     ABTI_mutex_attr_copy(&p_newmutex->attr, p_attr);
 
@@ -108,7 +123,7 @@ int ABT_mutex_free(ABT_mutex *mutex)
     ABTI_CHECK_NULL_MUTEX_PTR(p_mutex);
 
     ABTI_mutex_fini(p_mutex);
-    ABTU_free(p_mutex);
+    ABTI_mem_free_slab(ABTI_local_get_local(), p_mutex);
 
     /* Return value */
     *mutex = ABT_MUTEX_NULL;
@@ -174,12 +189,149 @@ int ABT_mutex_lock(ABT_mutex mutex)
     goto fn_exit;
 }
 
+/* Lock p_mutex like ABTI_mutex_lock(), but give up when the time reaches
+ * deadline_nsec. */
+static inline
+int ABTI_mutex_timedlock(ABTI_local **pp_local, ABTI_mutex *p_mutex,
+                         uint64_t deadline_nsec)
+{
+    ABTI_local *p_local = *pp_local;
+    ABT_unit_type type = ABTI_self_get_suspend_type(p_local);
+
+    if (ABTI_mutex_is_fifo(p_mutex)) {
+        /* Timed waiters do not join the queue because they cannot leave it.
+         * They retry until the deadline instead. */
+        while (ABTI_mutex_trylock_fifo(p_mutex) == ABT_FALSE) {
+            if (ABTI_get_wtime_nsec() >= deadline_nsec) return ABT_ERR_TIMEDOUT;
+            if (type == ABT_UNIT_TYPE_THREAD) {
+                ABTI_thread_yield(pp_local, (*pp_local)->p_thread);
+            } else {
+                ABTD_atomic_pause();
+            }
+        }
+        return ABT_SUCCESS;
+    }
+
+    if (type != ABT_UNIT_TYPE_THREAD) {
+        /* Others spin until the deadline. */
+        while (!ABTD_atomic_bool_cas_weak_uint32(&p_mutex->val, 0, 1)) {
+            if (ABTI_get_wtime_nsec() >= deadline_nsec) return ABT_ERR_TIMEDOUT;
+            ABTD_atomic_pause();
+        }
+        return ABT_SUCCESS;
+    }
+
+#ifdef ABT_CONFIG_USE_SIMPLE_MUTEX
+    while (!ABTD_atomic_bool_cas_weak_uint32(&p_mutex->val, 0, 1)) {
+        if (ABTI_get_wtime_nsec() >= deadline_nsec) return ABT_ERR_TIMEDOUT;
+        ABTI_thread_yield(pp_local, p_local->p_thread);
+        p_local = *pp_local;
+    }
+#else
+    LOG_EVENT("%p: timedlock - try\n", p_mutex);
+    int c;
+    if ((c = ABTD_atomic_val_cas_strong_uint32(&p_mutex->val, 0, 1)) != 0) {
+        ABTI_TRACE_XSTREAM(p_local->p_xstream, MUTEX_CONTENDED, p_mutex, 0);
+        if (c != 2) {
+            c = ABTD_atomic_exchange_uint32(&p_mutex->val, 2);
+        }
+        while (c != 0) {
+            if (ABTI_mutex_wait_until(pp_local, p_mutex, 2, deadline_nsec)
+                == ABT_TRUE) {
+                /* p_mutex->val stays 2, which only causes an extra attempt to
+                 * wake up waiters in unlock. */
+                LOG_EVENT("%p: timedlock - timed out\n", p_mutex);
+                return ABT_ERR_TIMEDOUT;
+            }
+
+            /* See ABTI_mutex_lock() for the handover. */
+            if (p_mutex->p_handover) {
+                ABTI_thread *p_self = (*pp_local)->p_thread;
+                if (p_self == p_mutex->p_handover) {
+                    p_mutex->p_handover = NULL;
+                    p_mutex->val = 2;
+
+                    /* Push the previous ULT to its pool */
+                    ABTI_thread *p_giver = p_mutex->p_giver;
+                    p_giver->state = ABT_THREAD_STATE_READY;
+                    ABTI_POOL_PUSH(p_giver->p_pool, p_giver->unit,
+                        ABTI_self_get_native_thread_id(*pp_local));
+                    break;
+                }
+            }
+
+            c = ABTD_atomic_exchange_uint32(&p_mutex->val, 2);
+        }
+    }
+    LOG_EVENT("%p: timedlock - acquired\n", p_mutex);
+#endif
+    return ABT_SUCCESS;
+}
+
+/**
+ * @ingroup MUTEX
+ * @brief   Lock the mutex with a timeout.
+ *
+ * \c ABT_mutex_timedlock() locks the mutex \c mutex like \c ABT_mutex_lock(),
+ * but gives up waiting when the absolute time specified by \c abstime passes.
+ * As with \c ABT_cond_timedwait(), \c abstime is based on
+ * \c CLOCK_REALTIME.  A ULT waiting for the mutex is blocked and is woken up
+ * on timeout by the ES on which it started waiting, while other work units
+ * spin until the deadline.
+ *
+ * @param[in] mutex    handle to the mutex
+ * @param[in] abstime  absolute time for timeout
+ * @return Error code
+ * @retval ABT_SUCCESS       on success
+ * @retval ABT_ERR_TIMEDOUT  timeout
+ */
+int ABT_mutex_timedlock(ABT_mutex mutex, const struct timespec *abstime)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_local *p_local = ABTI_local_get_local();
+    ABTI_mutex *p_mutex = ABTI_mutex_get_ptr(mutex);
+    ABTI_CHECK_NULL_MUTEX_PTR(p_mutex);
+
+    uint64_t deadline = ABTI_get_deadline_nsec(abstime);
+
+    if (p_mutex->attr.attrs & ABTI_MUTEX_ATTR_RECURSIVE) {
+        /* recursive mutex */
+        ABTI_unit_id self_id = ABTI_self_get_unit_id(p_local);
+        if (self_id != p_mutex->attr.owner_id) {
+            abt_errno = ABTI_mutex_timedlock(&p_local, p_mutex, deadline);
+            if (abt_errno == ABT_SUCCESS) {
+                p_mutex->attr.owner_id = self_id;
+                ABTI_ASSERT(p_mutex->attr.nesting_cnt == 0);
+            }
+        } else {
+            p_mutex->attr.nesting_cnt++;
+        }
+
+    } else {
+        /* default or unknown attributes */
+        abt_errno = ABTI_mutex_timedlock(&p_local, p_mutex, deadline);
+    }
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
 static inline
 void ABTI_mutex_lock_low(ABTI_local **pp_local, ABTI_mutex *p_mutex)
 {
+    if (ABTI_mutex_is_fifo(p_mutex)) {
+        /* FIFO mutexes have no priorities. */
+        ABTI_mutex_lock(pp_local, p_mutex);
+        return;
+    }
+
 #ifdef ABT_CONFIG_USE_SIMPLE_MUTEX
     ABTI_local *p_local = *pp_local;
-    ABT_unit_type type = ABTI_self_get_type(p_local);
+    ABT_unit_type type = ABTI_self_get_suspend_type(p_local);
     if (type == ABT_UNIT_TYPE_THREAD) {
         LOG_EVENT("%p: lock_low - try\n", p_mutex);
         while (!ABTD_atomic_bool_cas_weak_uint32(&p_mutex->val, 0, 1)) {
@@ -193,7 +345,7 @@ void ABTI_mutex_lock_low(ABTI_local **pp_local, ABTI_mutex *p_mutex)
 #else
     int abt_errno;
     ABTI_local *p_local = *pp_local;
-    ABT_unit_type type = ABTI_self_get_type(p_local);
+    ABT_unit_type type = ABTI_self_get_suspend_type(p_local);
 
     /* Only ULTs can yield when the mutex has been locked. For others,
      * just call mutex_spinlock. */
@@ -204,12 +356,13 @@ void ABTI_mutex_lock_low(ABTI_local **pp_local, ABTI_mutex *p_mutex)
         /* If other ULTs associated with the same ES are waiting on the
          * low-mutex queue, we give the header ULT a chance to try to get
          * the mutex by context switching to it. */
-        ABTI_thread_htable *p_htable = p_mutex->p_htable;
+        ABTI_thread_htable *p_htable = (ABTI_thread_htable *)
+            ABTD_atomic_load_ptr((void **)&p_mutex->p_htable);
         ABTI_thread *p_self = p_local->p_thread;
         ABTI_xstream *p_xstream = p_self->p_last_xstream;
         int rank = (int)p_xstream->rank;
-        ABTI_thread_queue *p_queue = &p_htable->queue[rank];
-        if (p_queue->low_num_threads > 0) {
+        ABTI_thread_queue *p_queue = p_htable ? &p_htable->queue[rank] : NULL;
+        if (p_queue && p_queue->low_num_threads > 0) {
             ABT_bool ret = ABTI_thread_htable_switch_low(pp_local, p_queue,
                                                          p_self, p_htable);
             if (ret == ABT_TRUE) {
@@ -470,6 +623,14 @@ int ABTI_mutex_unlock_se(ABTI_local **pp_local, ABTI_mutex *p_mutex)
 {
     int abt_errno = ABT_SUCCESS;
 
+    if (ABTI_mutex_is_fifo(p_mutex)) {
+        /* The mutex is handed over to the first waiter on any ES. */
+        ABTI_mutex_unlock(*pp_local, p_mutex);
+        if (ABTI_self_get_type(*pp_local) == ABT_UNIT_TYPE_THREAD)
+            ABTI_thread_yield(pp_local, (*pp_local)->p_thread);
+        return abt_errno;
+    }
+
 #ifdef ABT_CONFIG_USE_SIMPLE_MUTEX
     ABTD_atomic_store_uint32(&p_mutex->val, 0);
     LOG_EVENT("%p: unlock_se\n", p_mutex);
@@ -502,9 +663,19 @@ int ABTI_mutex_unlock_se(ABTI_local **pp_local, ABTI_mutex *p_mutex)
     }
 
     /* There are ULTs waiting in the mutex queue */
-    ABTI_thread_htable *p_htable = p_mutex->p_htable;
+    ABTI_thread_htable *p_htable = (ABTI_thread_htable *)
+        ABTD_atomic_load_ptr((void **)&p_mutex->p_htable);
 
     p_thread = (*pp_local)->p_thread;
+    if (p_htable == NULL) {
+        /* The waiter has not created the queues yet. */
+        ABTD_atomic_store_uint32(&p_mutex->val, 0); /* Unlock */
+        LOG_EVENT("%p: unlock_se\n", p_mutex);
+        ABTI_mutex_wake_de(*pp_local, p_mutex);
+        ABTI_thread_yield(pp_local, p_thread);
+        return abt_errno;
+    }
+
     p_xstream = p_thread->p_last_xstream;
     ABTI_ASSERT(p_xstream == (*pp_local)->p_xstream);
     i = (int)p_xstream->rank;
@@ -550,6 +721,16 @@ int ABTI_mutex_unlock_se(ABTI_local **pp_local, ABTI_mutex *p_mutex)
     }
 
   handover:
+    if (ABTI_thread_is_stack_copy(p_next) == ABT_TRUE) {
+        /* A stack-copying ULT is resumed by the scheduler, so it is woken up
+         * instead of getting the mutex handed over. */
+        ABTD_atomic_store_uint32(&p_mutex->val, 0); /* Unlock */
+        LOG_EVENT("%p: unlock_se\n", p_mutex);
+        ABTI_thread_set_ready(*pp_local, p_next);
+        ABTI_thread_yield(pp_local, p_thread);
+        return abt_errno;
+    }
+
     /* We don't push p_thread to the pool. Instead, we will yield_to p_thread
      * directly at the end of this function. */
     p_queue->num_handovers++;
@@ -667,7 +848,7 @@ int ABT_mutex_equal(ABT_mutex mutex1, ABT_mutex mutex2, ABT_bool *result)
 void ABTI_mutex_wait(ABTI_local **pp_local, ABTI_mutex *p_mutex, int val)
 {
     ABTI_local *p_local = *pp_local;
-    ABTI_thread_htable *p_htable = p_mutex->p_htable;
+    ABTI_thread_htable *p_htable = ABTI_mutex_get_htable(p_mutex);
     ABTI_thread *p_self = p_local->p_thread;
     ABTI_xstream *p_xstream = p_self->p_last_xstream;
 
@@ -718,10 +899,59 @@ void ABTI_mutex_wait(ABTI_local **pp_local, ABTI_mutex *p_mutex, int val)
     ABTI_thread_suspend(pp_local, p_self);
 }
 
+static ABT_bool ABTI_mutex_remove_thread(ABTI_thread *p_thread, void *p_obj)
+{
+    ABTI_mutex *p_mutex = (ABTI_mutex *)p_obj;
+    return ABTI_thread_htable_remove(p_mutex->p_htable,
+                                     (int)p_thread->p_last_xstream->rank,
+                                     p_thread);
+}
+
+/* Same as ABTI_mutex_wait(), but the caller ULT is woken up when the time
+ * reaches deadline_nsec.  Returns ABT_TRUE if it has timed out. */
+ABT_bool ABTI_mutex_wait_until(ABTI_local **pp_local, ABTI_mutex *p_mutex,
+                               int val, uint64_t deadline_nsec)
+{
+    ABTI_local *p_local = *pp_local;
+    ABTI_thread_htable *p_htable = ABTI_mutex_get_htable(p_mutex);
+    ABTI_thread *p_self = p_local->p_thread;
+    ABTI_xstream *p_xstream = p_self->p_last_xstream;
+
+    int rank = (int)p_xstream->rank;
+    ABTI_ASSERT(rank < p_htable->num_rows);
+    ABTI_thread_queue *p_queue = &p_htable->queue[rank];
+
+    if (ABTI_get_wtime_nsec() >= deadline_nsec) return ABT_TRUE;
+
+    ABTI_THREAD_HTABLE_LOCK(p_htable->mutex);
+
+    if (ABTD_atomic_load_uint32(&p_mutex->val) != val) {
+        ABTI_THREAD_HTABLE_UNLOCK(p_htable->mutex);
+        return ABT_FALSE;
+    }
+
+    if (p_queue->p_h_next == NULL) {
+        ABTI_thread_htable_add_h_node(p_htable, p_queue);
+    }
+
+    /* Change the ULT's state to BLOCKED */
+    ABTI_thread_set_blocked(p_self);
+
+    /* Push the current ULT to the queue */
+    ABTI_thread_htable_push(p_htable, rank, p_self);
+
+    /* Unlock */
+    ABTI_THREAD_HTABLE_UNLOCK(p_htable->mutex);
+
+    /* Suspend the current ULT until it is woken up or timed out */
+    return ABTI_thread_suspend_until(pp_local, p_self, deadline_nsec,
+                                     ABTI_mutex_remove_thread, p_mutex);
+}
+
 void ABTI_mutex_wait_low(ABTI_local **pp_local, ABTI_mutex *p_mutex, int val)
 {
     ABTI_local *p_local = *pp_local;
-    ABTI_thread_htable *p_htable = p_mutex->p_htable;
+    ABTI_thread_htable *p_htable = ABTI_mutex_get_htable(p_mutex);
     ABTI_thread *p_self = p_local->p_thread;
     ABTI_xstream *p_xstream = p_self->p_last_xstream;
 
@@ -776,10 +1006,22 @@ void ABTI_mutex_wake_de(ABTI_local *p_local, ABTI_mutex *p_mutex)
 {
     int n;
     ABTI_thread *p_thread;
-    ABTI_thread_htable *p_htable = p_mutex->p_htable;
+    ABTI_thread_htable *p_htable = (ABTI_thread_htable *)
+        ABTD_atomic_load_ptr((void **)&p_mutex->p_htable);
     int num = p_mutex->attr.max_wakeups;
     ABTI_thread_queue *p_start, *p_curr;
 
+    if (p_htable == NULL) {
+        /* The unlock must be visible before p_htable is checked again.  A
+         * waiter that creates the queues afterwards sees the unlocked value
+         * and does not sleep.  This orders a store and a later load, so it
+         * needs a full barrier. */
+        ABTD_atomic_full_barrier();
+        p_htable = (ABTI_thread_htable *)
+            ABTD_atomic_load_ptr((void **)&p_mutex->p_htable);
+        if (p_htable == NULL) return;
+    }
+
     /* Wake up num ULTs in a round-robin manner */
     for (n = 0; n < num; n++) {
         p_thread = NULL;
@@ -835,3 +1077,149 @@ void ABTI_mutex_wake_de(ABTI_local *p_local, ABTI_mutex *p_mutex)
     }
 }
 
+/* Wait in the queue of a FIFO mutex until the mutex is handed over.  If
+ * can_suspend is ABT_FALSE or the caller is not a ULT, the native thread is
+ * blocked instead of suspending the caller. */
+void ABTI_mutex_lock_fifo(ABTI_local **pp_local, ABTI_mutex *p_mutex,
+                          ABT_bool can_suspend)
+{
+    ABTI_local *p_local = *pp_local;
+    ABTI_mutex_qnode node, *p_node, *p_prev, *p_next;
+
+    p_node = (ABTI_mutex_qnode *)
+        ABTI_mem_alloc_wait_obj(p_local, &node, sizeof(node));
+    p_node->p_next = NULL;
+    p_node->p_thread = (can_suspend == ABT_TRUE &&
+                        ABTI_self_get_suspend_type(p_local)
+                            == ABT_UNIT_TYPE_THREAD)
+                     ? p_local->p_thread : NULL;
+    p_node->state = ABTI_MUTEX_QNODE_WAITING;
+
+    ABTI_TRACE(MUTEX_CONTENDED, p_mutex, 0);
+    LOG_EVENT("%p: lock - queued\n", p_mutex);
+    p_prev = (ABTI_mutex_qnode *)ABTD_atomic_exchange_ptr(
+                 (void **)&p_mutex->p_tail, p_node);
+    if (p_prev != NULL) {
+        ABTD_atomic_store_ptr((void **)&p_prev->p_next, p_node);
+        ABTI_mutex_wait_qnode(pp_local, p_mutex, p_node,
+                              (p_prev == &p_mutex->qhead) ? ABT_TRUE
+                                                          : ABT_FALSE);
+    }
+
+    /* p_node is released when this function returns, so qhead takes over its
+     * place in the queue. */
+    p_next = (ABTI_mutex_qnode *)
+        ABTD_atomic_load_ptr((void **)&p_node->p_next);
+    if (p_next == NULL) {
+        ABTD_atomic_store_ptr((void **)&p_mutex->qhead.p_next, NULL);
+        if (ABTD_atomic_bool_cas_strong_ptr((void **)&p_mutex->p_tail, p_node,
+                                            &p_mutex->qhead)) {
+            LOG_EVENT("%p: lock - acquired\n", p_mutex);
+            ABTI_mem_free_wait_obj(*pp_local, p_node, &node);
+            return;
+        }
+        /* A new waiter is linking itself to p_node. */
+        while ((p_next = (ABTI_mutex_qnode *)ABTD_atomic_load_ptr(
+                             (void **)&p_node->p_next)) == NULL) {
+            ABTD_atomic_pause();
+        }
+    }
+    ABTD_atomic_store_ptr((void **)&p_mutex->qhead.p_next, p_next);
+    LOG_EVENT("%p: lock - acquired\n", p_mutex);
+    ABTI_mem_free_wait_obj(*pp_local, p_node, &node);
+}
+
+/* Hand over a FIFO mutex to the first waiter. */
+void ABTI_mutex_unlock_fifo(ABTI_local *p_local, ABTI_mutex *p_mutex)
+{
+    ABTI_mutex_qnode *p_next;
+
+    /* A new waiter may not have linked itself yet. */
+    while ((p_next = (ABTI_mutex_qnode *)ABTD_atomic_load_ptr(
+                         (void **)&p_mutex->qhead.p_next)) == NULL) {
+        ABTD_atomic_pause();
+    }
+    ABTD_atomic_store_ptr((void **)&p_mutex->qhead.p_next, NULL);
+
+    /* p_next may be released as soon as its state is changed. */
+    ABTI_thread *p_thread = p_next->p_thread;
+    uint32_t *p_state = &p_next->state;
+    if (ABTD_atomic_exchange_uint32(p_state, ABTI_MUTEX_QNODE_GRANTED)
+            == ABTI_MUTEX_QNODE_SLEEPING) {
+        if (p_thread) {
+            ABTI_thread_set_ready(p_local, p_thread);
+        } else {
+            ABTD_futex_wake(p_state, 1);
+        }
+    }
+    LOG_EVENT("%p: unlock - handed over\n", p_mutex);
+}
+
+
+/*****************************************************************************/
+/* Internal static functions                                                 */
+/*****************************************************************************/
+
+/* Return the wait queues of p_mutex.  They are created when the mutex is
+ * contended for the first time so that uncontended mutexes do not need a
+ * queue per ES. */
+static ABTI_thread_htable *ABTI_mutex_get_htable(ABTI_mutex *p_mutex)
+{
+    ABTI_thread_htable *p_htable = (ABTI_thread_htable *)
+        ABTD_atomic_load_ptr((void **)&p_mutex->p_htable);
+    if (ABTU_likely(p_htable != NULL)) return p_htable;
+
+    p_htable = ABTI_thread_htable_create(gp_ABTI_global->max_xstreams);
+    if (!ABTD_atomic_bool_cas_strong_ptr((void **)&p_mutex->p_htable, NULL,
+                                         p_htable)) {
+        /* Another waiter has created them. */
+        ABTI_thread_htable_free(p_htable);
+        p_htable = (ABTI_thread_htable *)
+            ABTD_atomic_load_ptr((void **)&p_mutex->p_htable);
+    }
+    return p_htable;
+}
+
+/* Wait until p_node is granted the mutex.  Only the first waiter spins, and
+ * the spin period is doubled when the mutex arrives in time and halved
+ * otherwise. */
+static inline void ABTI_mutex_wait_qnode(ABTI_local **pp_local,
+                                         ABTI_mutex *p_mutex,
+                                         ABTI_mutex_qnode *p_node,
+                                         ABT_bool is_first)
+{
+    ABTI_thread *p_thread = p_node->p_thread;
+
+    if (p_thread == NULL) {
+        ABTD_futex_signal_wait(&p_node->state);
+        return;
+    }
+
+    if (is_first == ABT_TRUE) {
+        uint32_t limit = ABTD_atomic_load_uint32(&p_mutex->spin_limit);
+        uint32_t i;
+        for (i = 0; i < limit; i++) {
+            if (ABTD_atomic_load_uint32(&p_node->state)
+                    == ABTI_MUTEX_QNODE_GRANTED) {
+                if (limit < ABTI_MUTEX_SPIN_MAX) {
+                    ABTD_atomic_store_uint32(&p_mutex->spin_limit, limit * 2);
+                }
+                return;
+            }
+            ABTD_atomic_pause();
+        }
+        if (limit > ABTI_MUTEX_SPIN_MIN) {
+            ABTD_atomic_store_uint32(&p_mutex->spin_limit, limit / 2);
+        }
+    }
+
+    ABTI_thread_set_blocked(p_thread);
+    if (ABTD_atomic_bool_cas_strong_uint32(&p_node->state,
+                                           ABTI_MUTEX_QNODE_WAITING,
+                                           ABTI_MUTEX_QNODE_SLEEPING)) {
+        ABTI_thread_suspend(pp_local, p_thread);
+    } else {
+        /* The mutex has been handed over in the meantime. */
+        ABTI_thread_unset_blocked(p_thread);
+    }
+}
@@ -111,6 +111,47 @@ int ABT_mutex_attr_set_recursive(ABT_mutex_attr attr, ABT_bool recursive)
     goto fn_exit;
 }
 
+/**
+ * @ingroup MUTEX_ATTR
+ * @brief   Set the FIFO property in the attribute object.
+ *
+ * \c ABT_mutex_attr_set_fifo() sets the FIFO property (i.e., whether the
+ * mutex is handed over to its waiters in arrival order) in the attribute
+ * object associated with handle \c attr.  When a FIFO mutex is unlocked, the
+ * first waiter acquires it directly even if it runs on another ES.  Waiters
+ * that lock the mutex with a timeout do not keep their positions and retry
+ * until the mutex is free.  The priorities of \c ABT_mutex_lock_low() and
+ * \c ABT_mutex_lock_high() are ignored for a FIFO mutex.  Since the mutex
+ * can be handed over to a suspended ULT, a tasklet or a caller of
+ * \c ABT_mutex_spinlock() must not wait for a FIFO mutex on an ES whose ULTs
+ * may also wait for it.
+ *
+ * @param[in] attr  handle to the target attribute object
+ * @param[in] fifo  boolean value for the FIFO handover
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_mutex_attr_set_fifo(ABT_mutex_attr attr, ABT_bool fifo)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_mutex_attr *p_attr = ABTI_mutex_attr_get_ptr(attr);
+    ABTI_CHECK_NULL_MUTEX_ATTR_PTR(p_attr);
+
+    /* Set the value */
+    if (fifo == ABT_TRUE) {
+        p_attr->attrs |= ABTI_MUTEX_ATTR_FIFO;
+    } else {
+        p_attr->attrs &= ~ABTI_MUTEX_ATTR_FIFO;
+    }
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
 
 /*****************************************************************************/
 /* Private APIs                                                              */
@@ -6,5 +6,7 @@
 abt_sources += \
 	pool/fifo.c \
 	pool/fifo_wait.c \
+	pool/fifo_lockfree.c \
+	pool/deque.c \
 	pool/pool.c
 
@@ -0,0 +1,544 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+/* DEQUE pool implementation
+ *
+ * A Chase-Lev work-stealing deque.  The owner of the pool is the ES whose
+ * main scheduler has the pool as its first pool (ABTI_pool::p_owner); a pool
+ * that has no owner works as a deque that all ESs steal from.  The owner
+ * pushes and pops units at the bottom end in LIFO order, which needs no
+ * read-modify-write atomics unless the deque has one unit left, while other
+ * ESs steal units from the top end in FIFO order with a CAS on the top index
+ * (p_pop_steal).  The full barriers in deque_pop() and deque_steal() follow
+ * the C11 version of the deque by Le et al. (PPoPP 2013).
+ *
+ * Units pushed by other ESs or external threads, units that do not fit in the
+ * deque, and ULTs that yield on the owner ES are appended to an inbox list
+ * protected by a spinlock.  Yielding ULTs go to the inbox so that they do not
+ * starve the other units of the owner.  Both the owner and thieves take units
+ * from the inbox when the deque is empty.
+ *
+ * Each unit is claimed by swapping its cell with NULL, so a cell emptied by
+ * p_remove is skipped, and a cell is never overwritten while it still holds
+ * a unit.  A unit in the deque keeps its cell in p_prev (p_next is NULL),
+ * while a unit in the inbox is linked through p_prev and p_next. */
+
+#define POOL_DEQUE_SIZE 4096    /* Must be a power of two */
+
+static int      pool_init(ABT_pool pool, ABT_pool_config config);
+static int      pool_free(ABT_pool pool);
+static size_t   pool_get_size(ABT_pool pool);
+static void     pool_push(ABT_pool pool, ABT_unit unit);
+static ABT_unit pool_pop(ABT_pool pool);
+static ABT_unit pool_pop_steal(ABT_pool pool);
+static ABT_unit pool_pop_timedwait(ABT_pool pool, double abstime_secs);
+static int      pool_remove(ABT_pool pool, ABT_unit unit);
+static int      pool_print_all(ABT_pool pool, void *arg,
+                               void (*print_fn)(void *, ABT_unit));
+
+typedef ABTI_unit unit_t;
+static ABT_unit_type unit_get_type(ABT_unit unit);
+static ABT_thread unit_get_thread(ABT_unit unit);
+static ABT_task unit_get_task(ABT_unit unit);
+static ABT_bool unit_is_in_pool(ABT_unit unit);
+static ABT_unit unit_create_from_thread(ABT_thread thread);
+static ABT_unit unit_create_from_task(ABT_task task);
+static void unit_free(ABT_unit *unit);
+
+typedef struct {
+    unit_t *p_unit;
+} cell_t;
+
+struct data {
+    /* Owner end */
+    char pad0[ABT_CONFIG_STATIC_CACHELINE_SIZE];
+    int64_t bottom;
+    /* Thief end */
+    char pad1[ABT_CONFIG_STATIC_CACHELINE_SIZE - sizeof(int64_t)];
+    int64_t top;
+    char pad2[ABT_CONFIG_STATIC_CACHELINE_SIZE - sizeof(int64_t)];
+    /* Shared counters */
+    uint64_t num_units;
+    uint32_t num_inbox;
+    char pad3[ABT_CONFIG_STATIC_CACHELINE_SIZE - sizeof(uint64_t)
+              - sizeof(uint32_t)];
+    /* Inbox */
+    ABTI_spinlock inbox_lock;
+    unit_t *p_head;
+    unit_t *p_tail;
+    /* Deque */
+    int64_t mask;
+    cell_t *cells;
+};
+typedef struct data data_t;
+
+static inline data_t *pool_get_data_ptr(void *p_data)
+{
+    return (data_t *)p_data;
+}
+
+int ABTI_pool_get_deque_def(ABT_pool_access access, ABT_pool_def *p_def)
+{
+    int abt_errno = ABT_SUCCESS;
+
+    switch (access) {
+        case ABT_POOL_ACCESS_PRIV:
+        case ABT_POOL_ACCESS_SPSC:
+        case ABT_POOL_ACCESS_MPSC:
+        case ABT_POOL_ACCESS_SPMC:
+        case ABT_POOL_ACCESS_MPMC:
+            break;
+
+        default:
+            ABTI_CHECK_TRUE(0, ABT_ERR_INV_POOL_ACCESS);
+    }
+
+    p_def->access               = access;
+    p_def->p_init               = pool_init;
+    p_def->p_free               = pool_free;
+    p_def->p_get_size           = pool_get_size;
+    p_def->p_push               = pool_push;
+    p_def->p_pop                = pool_pop;
+    p_def->p_pop_timedwait      = pool_pop_timedwait;
+    p_def->p_remove             = pool_remove;
+    p_def->p_print_all          = pool_print_all;
+    p_def->p_pop_steal          = pool_pop_steal;
+    p_def->p_push_many          = NULL;
+    p_def->p_pop_many           = NULL;
+    p_def->u_get_type           = unit_get_type;
+    p_def->u_get_thread         = unit_get_thread;
+    p_def->u_get_task           = unit_get_task;
+    p_def->u_is_in_pool         = unit_is_in_pool;
+    p_def->u_create_from_thread = unit_create_from_thread;
+    p_def->u_create_from_task   = unit_create_from_task;
+    p_def->u_free               = unit_free;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+
+/* Deque functions */
+
+/* Only called by the owner.  Returns ABT_FALSE if the deque is full. */
+static inline ABT_bool deque_push(ABT_pool pool, data_t *p_data,
+                                  unit_t *p_unit)
+{
+    int64_t b = p_data->bottom;
+    int64_t t = ABTD_atomic_load_int64(&p_data->top);
+    if (b - t > p_data->mask) return ABT_FALSE;
+
+    /* A thief that has claimed this cell may not have taken the unit yet. */
+    cell_t *p_cell = &p_data->cells[b & p_data->mask];
+    if (ABTD_atomic_load_ptr((void **)&p_cell->p_unit) != NULL)
+        return ABT_FALSE;
+
+    p_unit->p_next = NULL;
+    p_unit->p_prev = (unit_t *)p_cell;
+    ABTD_atomic_store_ptr((void **)&p_unit->pool, (void *)pool);
+    ABTD_atomic_store_ptr((void **)&p_cell->p_unit, (void *)p_unit);
+    ABTD_atomic_store_int64(&p_data->bottom, b + 1);
+    return ABT_TRUE;
+}
+
+/* Only called by the owner.  Returns NULL if the deque is empty. */
+static inline unit_t *deque_pop(data_t *p_data)
+{
+    unit_t *p_unit;
+
+    while (1) {
+        int64_t b = p_data->bottom - 1;
+        ABTD_atomic_store_int64(&p_data->bottom, b);
+        /* Order the store of bottom before the load of top. */
+        ABTD_atomic_full_barrier();
+        int64_t t = ABTD_atomic_load_int64(&p_data->top);
+        if (t > b) {
+            ABTD_atomic_store_int64(&p_data->bottom, b + 1);
+            return NULL;
+        }
+
+        cell_t *p_cell = &p_data->cells[b & p_data->mask];
+        if (t == b) {
+            /* The last unit.  Race against thieves. */
+            ABT_bool won = ABTD_atomic_bool_cas_strong_int64(&p_data->top,
+                                                             t, t + 1)
+                         ? ABT_TRUE : ABT_FALSE;
+            ABTD_atomic_store_int64(&p_data->bottom, b + 1);
+            if (won == ABT_FALSE) return NULL;
+        }
+
+        /* NULL means that the unit has been removed by p_remove. */
+        p_unit = (unit_t *)ABTD_atomic_exchange_ptr((void **)&p_cell->p_unit,
+                                                    NULL);
+        if (p_unit != NULL || t == b) return p_unit;
+    }
+}
+
+/* Returns NULL if the deque is empty. */
+static inline unit_t *deque_steal(data_t *p_data)
+{
+    unit_t *p_unit;
+
+    while (1) {
+        int64_t t = ABTD_atomic_load_int64(&p_data->top);
+        /* Pairs with the barrier in deque_pop(). */
+        ABTD_atomic_full_barrier();
+        int64_t b = ABTD_atomic_load_int64(&p_data->bottom);
+        if (t >= b) return NULL;
+
+        if (!ABTD_atomic_bool_cas_weak_int64(&p_data->top, t, t + 1))
+            continue;
+
+        cell_t *p_cell = &p_data->cells[t & p_data->mask];
+        p_unit = (unit_t *)ABTD_atomic_exchange_ptr((void **)&p_cell->p_unit,
+                                                    NULL);
+        if (p_unit != NULL) return p_unit;
+    }
+}
+
+
+/* Inbox functions */
+
+static inline void inbox_push(ABT_pool pool, data_t *p_data, unit_t *p_unit)
+{
+    ABTI_spinlock_acquire(&p_data->inbox_lock);
+    if (p_data->num_inbox == 0) {
+        p_unit->p_prev = p_unit;
+        p_unit->p_next = p_unit;
+        p_data->p_head = p_unit;
+        p_data->p_tail = p_unit;
+    } else {
+        unit_t *p_head = p_data->p_head;
+        unit_t *p_tail = p_data->p_tail;
+        p_tail->p_next = p_unit;
+        p_head->p_prev = p_unit;
+        p_unit->p_prev = p_tail;
+        p_unit->p_next = p_head;
+        p_data->p_tail = p_unit;
+    }
+    ABTD_atomic_store_uint32(&p_data->num_inbox, p_data->num_inbox + 1);
+    ABTD_atomic_store_ptr((void **)&p_unit->pool, (void *)pool);
+    ABTI_spinlock_release(&p_data->inbox_lock);
+}
+
+/* Called with inbox_lock held. */
+static inline void inbox_unlink(data_t *p_data, unit_t *p_unit)
+{
+    if (p_data->num_inbox == 1) {
+        p_data->p_head = NULL;
+        p_data->p_tail = NULL;
+    } else {
+        p_unit->p_prev->p_next = p_unit->p_next;
+        p_unit->p_next->p_prev = p_unit->p_prev;
+        if (p_unit == p_data->p_head) {
+            p_data->p_head = p_unit->p_next;
+        } else if (p_unit == p_data->p_tail) {
+            p_data->p_tail = p_unit->p_prev;
+        }
+    }
+    ABTD_atomic_store_uint32(&p_data->num_inbox, p_data->num_inbox - 1);
+}
+
+static inline unit_t *inbox_pop(data_t *p_data)
+{
+    unit_t *p_unit = NULL;
+
+    if (ABTD_atomic_load_uint32(&p_data->num_inbox) == 0)
+        return NULL;
+
+    ABTI_spinlock_acquire(&p_data->inbox_lock);
+    if (p_data->num_inbox > 0) {
+        p_unit = p_data->p_head;
+        inbox_unlink(p_data, p_unit);
+    }
+    ABTI_spinlock_release(&p_data->inbox_lock);
+
+    return p_unit;
+}
+
+
+/* Pool functions */
+
+static int pool_init(ABT_pool pool, ABT_pool_config config)
+{
+    ABTI_UNUSED(config);
+    int abt_errno = ABT_SUCCESS;
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    int64_t i;
+
+    data_t *p_data = (data_t *)ABTU_malloc(sizeof(data_t));
+
+    p_data->bottom = 0;
+    p_data->top = 0;
+    p_data->num_units = 0;
+    p_data->num_inbox = 0;
+    ABTI_spinlock_clear(&p_data->inbox_lock);
+    p_data->p_head = NULL;
+    p_data->p_tail = NULL;
+
+    p_data->mask = POOL_DEQUE_SIZE - 1;
+    p_data->cells = (cell_t *)ABTU_malloc(sizeof(cell_t) * POOL_DEQUE_SIZE);
+    for (i = 0; i < POOL_DEQUE_SIZE; i++) {
+        p_data->cells[i].p_unit = NULL;
+    }
+
+    p_pool->data = p_data;
+
+    return abt_errno;
+}
+
+static int pool_free(ABT_pool pool)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+
+    ABTU_free(p_data->cells);
+    ABTU_free(p_data);
+
+    return abt_errno;
+}
+
+static size_t pool_get_size(ABT_pool pool)
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    return (size_t)ABTD_atomic_load_uint64(&p_data->num_units);
+}
+
+static void pool_push(ABT_pool pool, ABT_unit unit)
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    unit_t *p_unit = (unit_t *)unit;
+    ABTI_local *p_local = ABTI_local_get_local();
+
+    ABTD_atomic_fetch_add_uint64(&p_data->num_units, 1);
+
+    if (ABTI_pool_is_owner(p_pool, p_local) == ABT_TRUE) {
+        /* A ULT that yields is pushed while it is still running. */
+        ABT_bool yielding = (p_unit->type == ABT_UNIT_TYPE_THREAD &&
+                             p_local->p_thread != NULL &&
+                             p_unit->handle.thread ==
+                             ABTI_thread_get_handle(p_local->p_thread))
+                          ? ABT_TRUE : ABT_FALSE;
+        if (yielding == ABT_FALSE && deque_push(pool, p_data, p_unit))
+            return;
+    }
+
+    inbox_push(pool, p_data, p_unit);
+}
+
+static inline ABT_unit pool_take(data_t *p_data, unit_t *p_unit)
+{
+    if (p_unit == NULL) {
+        p_unit = inbox_pop(p_data);
+        if (p_unit == NULL) return ABT_UNIT_NULL;
+    }
+
+    p_unit->p_prev = NULL;
+    p_unit->p_next = NULL;
+    ABTD_atomic_store_ptr((void **)&p_unit->pool, (void *)ABT_POOL_NULL);
+    ABTD_atomic_fetch_sub_uint64(&p_data->num_units, 1);
+
+    return (ABT_unit)p_unit;
+}
+
+static ABT_unit pool_pop(ABT_pool pool)
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    ABTI_local *p_local = ABTI_local_get_local();
+
+    if (ABTI_pool_is_owner(p_pool, p_local) == ABT_TRUE) {
+        return pool_take(p_data, deque_pop(p_data));
+    } else {
+        return pool_take(p_data, deque_steal(p_data));
+    }
+}
+
+static ABT_unit pool_pop_steal(ABT_pool pool)
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+
+    return pool_take(p_data, deque_steal(p_data));
+}
+
+static ABT_unit pool_pop_timedwait(ABT_pool pool, double abstime_secs)
+{
+    ABT_unit h_unit;
+
+    while ((h_unit = pool_pop(pool)) == ABT_UNIT_NULL) {
+        if (ABTI_get_wtime() > abstime_secs)
+            break;
+        ABTD_atomic_pause();
+    }
+
+    return h_unit;
+}
+
+static int pool_remove(ABT_pool pool, ABT_unit unit)
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    unit_t *p_unit = (unit_t *)unit;
+
+    ABTI_CHECK_TRUE_RET(ABTD_atomic_load_uint64(&p_data->num_units) != 0,
+                        ABT_ERR_POOL);
+    ABTI_CHECK_TRUE_RET(p_unit->pool != ABT_POOL_NULL, ABT_ERR_POOL);
+    ABTI_CHECK_TRUE_MSG_RET(p_unit->pool == pool, ABT_ERR_POOL, "Not my pool");
+
+    /* The unit may be popped concurrently, so retry until it is removed or
+     * found not to be ours. */
+    while (ABTD_atomic_load_ptr((void **)&p_unit->pool) == (void *)pool) {
+        unit_t *p_next = (unit_t *)ABTD_atomic_load_ptr(
+                             (void **)&p_unit->p_next);
+        if (p_next != NULL) {
+            /* In the inbox */
+            ABT_bool removed = ABT_FALSE;
+            ABTI_spinlock_acquire(&p_data->inbox_lock);
+            if (p_unit->pool == pool && p_unit->p_next != NULL) {
+                inbox_unlink(p_data, p_unit);
+                removed = ABT_TRUE;
+            }
+            ABTI_spinlock_release(&p_data->inbox_lock);
+            if (removed == ABT_TRUE)
+                goto removed;
+        } else {
+            /* In the deque */
+            cell_t *p_cell = (cell_t *)ABTD_atomic_load_ptr(
+                                 (void **)&p_unit->p_prev);
+            if (p_cell != NULL &&
+                ABTD_atomic_bool_cas_strong_ptr((void **)&p_cell->p_unit,
+                                                (void *)p_unit, NULL)) {
+                goto removed;
+            }
+        }
+        ABTD_atomic_pause();
+    }
+    return ABT_ERR_POOL;
+
+  removed:
+    p_unit->p_prev = NULL;
+    p_unit->p_next = NULL;
+    ABTD_atomic_store_ptr((void **)&p_unit->pool, (void *)ABT_POOL_NULL);
+    ABTD_atomic_fetch_sub_uint64(&p_data->num_units, 1);
+
+    return ABT_SUCCESS;
+}
+
+/* This function is for debugging.  Units in the deque are printed from a
+ * snapshot of the indices, so units that are concurrently pushed or popped
+ * may be missed. */
+static int pool_print_all(ABT_pool pool, void *arg,
+                          void (*print_fn)(void *, ABT_unit))
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    int64_t pos, bottom;
+
+    ABTI_spinlock_acquire(&p_data->inbox_lock);
+
+    pos = ABTD_atomic_load_int64(&p_data->top);
+    bottom = ABTD_atomic_load_int64(&p_data->bottom);
+    for (; pos < bottom; pos++) {
+        cell_t *p_cell = &p_data->cells[pos & p_data->mask];
+        unit_t *p_unit = (unit_t *)ABTD_atomic_load_ptr(
+                             (void **)&p_cell->p_unit);
+        if (p_unit != NULL)
+            print_fn(arg, (ABT_unit)p_unit);
+    }
+
+    size_t num_units = p_data->num_inbox;
+    unit_t *p_unit = p_data->p_head;
+    while (num_units--) {
+        ABTI_ASSERT(p_unit);
+        ABT_unit unit = (ABT_unit)p_unit;
+        print_fn(arg, unit);
+        p_unit = p_unit->p_next;
+    }
+
+    ABTI_spinlock_release(&p_data->inbox_lock);
+
+    return ABT_SUCCESS;
+}
+
+
+/* Unit functions */
+
+static ABT_unit_type unit_get_type(ABT_unit unit)
+{
+   unit_t *p_unit = (unit_t *)unit;
+   return p_unit->type;
+}
+
+static ABT_thread unit_get_thread(ABT_unit unit)
+{
+    ABT_thread h_thread;
+    unit_t *p_unit = (unit_t *)unit;
+    if (p_unit->type == ABT_UNIT_TYPE_THREAD) {
+        h_thread = p_unit->handle.thread;
+    } else {
+        h_thread = ABT_THREAD_NULL;
+    }
+    return h_thread;
+}
+
+static ABT_task unit_get_task(ABT_unit unit)
+{
+    ABT_task h_task;
+    unit_t *p_unit = (unit_t *)unit;
+    if (p_unit->type == ABT_UNIT_TYPE_TASK) {
+        h_task = p_unit->handle.task;
+    } else {
+        h_task = ABT_TASK_NULL;
+    }
+    return h_task;
+}
+
+static ABT_bool unit_is_in_pool(ABT_unit unit)
+{
+    unit_t *p_unit = (unit_t *)unit;
+    void *pool = ABTD_atomic_load_ptr((void **)&p_unit->pool);
+    return (pool != (void *)ABT_POOL_NULL) ? ABT_TRUE : ABT_FALSE;
+}
+
+static ABT_unit unit_create_from_thread(ABT_thread thread)
+{
+    ABTI_thread *p_thread = ABTI_thread_get_ptr(thread);
+    unit_t *p_unit = &p_thread->unit_def;
+    p_unit->p_prev = NULL;
+    p_unit->p_next = NULL;
+    p_unit->pool   = ABT_POOL_NULL;
+    p_unit->handle.thread = thread;
+    p_unit->type   = ABT_UNIT_TYPE_THREAD;
+
+    return (ABT_unit)p_unit;
+}
+
+static ABT_unit unit_create_from_task(ABT_task task)
+{
+    ABTI_task *p_task = ABTI_task_get_ptr(task);
+    unit_t *p_unit = &p_task->unit_def;
+    p_unit->p_prev = NULL;
+    p_unit->p_next = NULL;
+    p_unit->pool   = ABT_POOL_NULL;
+    p_unit->handle.task = task;
+    p_unit->type   = ABT_UNIT_TYPE_TASK;
+
+    return (ABT_unit)p_unit;
+}
+
+static void unit_free(ABT_unit *unit)
+{
+    *unit = ABT_UNIT_NULL;
+}
@@ -6,23 +6,6 @@
 #include "abti.h"
 #include <time.h>
 
-static inline
-double get_cur_time(void)
-{
-#if defined(HAVE_CLOCK_GETTIME)
-    struct timespec ts;
-    clock_gettime(CLOCK_REALTIME, &ts);
-    return ((double)ts.tv_sec) + 1.0e-9 * ((double)ts.tv_nsec);
-#elif defined(HAVE_GETTIMEOFDAY)
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    return ((double)tv.tv_sec) + 1.0e-6 * ((double)tv.tv_usec);
-#else
-#error "No timer function available"
-    return 0.0;
-#endif
-}
-
 /* FIFO pool implementation */
 
 static int      pool_init(ABT_pool pool, ABT_pool_config config);
@@ -32,6 +15,14 @@ static void     pool_push_shared(ABT_pool pool, ABT_unit unit);
 static void     pool_push_private(ABT_pool pool, ABT_unit unit);
 static ABT_unit pool_pop_shared(ABT_pool pool);
 static ABT_unit pool_pop_private(ABT_pool pool);
+static void     pool_push_many_shared(ABT_pool pool, const ABT_unit *units,
+                                      size_t num_units);
+static void     pool_push_many_private(ABT_pool pool, const ABT_unit *units,
+                                       size_t num_units);
+static size_t   pool_pop_many_shared(ABT_pool pool, ABT_unit *units,
+                                     size_t max_units);
+static size_t   pool_pop_many_private(ABT_pool pool, ABT_unit *units,
+                                      size_t max_units);
 static ABT_unit pool_pop_timedwait(ABT_pool pool, double abstime_secs);
 static int      pool_remove_shared(ABT_pool pool, ABT_unit unit);
 static int      pool_remove_private(ABT_pool pool, ABT_unit unit);
@@ -73,6 +64,8 @@ int ABTI_pool_get_fifo_def(ABT_pool_access access, ABT_pool_def *p_def)
             p_def->p_push   = pool_push_private;
             p_def->p_pop    = pool_pop_private;
             p_def->p_remove = pool_remove_private;
+            p_def->p_push_many = pool_push_many_private;
+            p_def->p_pop_many  = pool_pop_many_private;
             break;
 
         case ABT_POOL_ACCESS_SPSC:
@@ -82,6 +75,8 @@ int ABTI_pool_get_fifo_def(ABT_pool_access access, ABT_pool_def *p_def)
             p_def->p_push   = pool_push_shared;
             p_def->p_pop    = pool_pop_shared;
             p_def->p_remove = pool_remove_shared;
+            p_def->p_push_many = pool_push_many_shared;
+            p_def->p_pop_many  = pool_pop_many_shared;
             break;
 
         default:
@@ -95,6 +90,7 @@ int ABTI_pool_get_fifo_def(ABT_pool_access access, ABT_pool_def *p_def)
     p_def->p_get_size           = pool_get_size;
     p_def->p_pop_timedwait      = pool_pop_timedwait;
     p_def->p_print_all          = pool_print_all;
+    p_def->p_pop_steal          = NULL;
     p_def->u_get_type           = unit_get_type;
     p_def->u_get_thread         = unit_get_thread;
     p_def->u_get_task           = unit_get_task;
@@ -216,8 +212,6 @@ static ABT_unit pool_pop_timedwait(ABT_pool pool, double abstime_secs)
     unit_t *p_unit = NULL;
     ABT_unit h_unit = ABT_UNIT_NULL;
 
-    double time_start = get_cur_time();
-
     do {
         ABTI_spinlock_acquire(&p_data->mutex);
         if (p_data->num_units > 0) {
@@ -245,8 +239,7 @@ static ABT_unit pool_pop_timedwait(ABT_pool pool, double abstime_secs)
             struct timespec ts = {0, sleep_nsecs};
             nanosleep(&ts, NULL);
 
-            double elapsed = get_cur_time() - time_start;
-            if (elapsed > abstime_secs)
+            if (ABTI_get_wtime() > abstime_secs)
                 break;
         }
     } while(h_unit == ABT_UNIT_NULL);
@@ -314,6 +307,107 @@ static ABT_unit pool_pop_private(ABT_pool pool)
     return h_unit;
 }
 
+/* Append units to the tail.  The caller must hold the lock if needed. */
+static inline void pool_push_many_internal(ABT_pool pool, data_t *p_data,
+                                           const ABT_unit *units,
+                                           size_t num_units)
+{
+    size_t i;
+
+    for (i = 0; i < num_units; i++) {
+        unit_t *p_unit = (unit_t *)units[i];
+        if (p_data->num_units == 0) {
+            p_unit->p_prev = p_unit;
+            p_unit->p_next = p_unit;
+            p_data->p_head = p_unit;
+            p_data->p_tail = p_unit;
+        } else {
+            unit_t *p_head = p_data->p_head;
+            unit_t *p_tail = p_data->p_tail;
+            p_tail->p_next = p_unit;
+            p_head->p_prev = p_unit;
+            p_unit->p_prev = p_tail;
+            p_unit->p_next = p_head;
+            p_data->p_tail = p_unit;
+        }
+        p_data->num_units++;
+
+        p_unit->pool = pool;
+    }
+}
+
+/* Detach up to max_units units from the head.  The caller must hold the lock
+ * if needed. */
+static inline size_t pool_pop_many_internal(data_t *p_data, ABT_unit *units,
+                                            size_t max_units)
+{
+    size_t num_units = 0;
+
+    while (num_units < max_units && p_data->num_units > 0) {
+        unit_t *p_unit = p_data->p_head;
+        if (p_data->num_units == 1) {
+            p_data->p_head = NULL;
+            p_data->p_tail = NULL;
+        } else {
+            p_unit->p_prev->p_next = p_unit->p_next;
+            p_unit->p_next->p_prev = p_unit->p_prev;
+            p_data->p_head = p_unit->p_next;
+        }
+        p_data->num_units--;
+
+        p_unit->p_prev = NULL;
+        p_unit->p_next = NULL;
+        p_unit->pool = ABT_POOL_NULL;
+
+        units[num_units++] = (ABT_unit)p_unit;
+    }
+
+    return num_units;
+}
+
+static void pool_push_many_shared(ABT_pool pool, const ABT_unit *units,
+                                  size_t num_units)
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+
+    ABTI_spinlock_acquire(&p_data->mutex);
+    pool_push_many_internal(pool, p_data, units, num_units);
+    ABTI_spinlock_release(&p_data->mutex);
+}
+
+static void pool_push_many_private(ABT_pool pool, const ABT_unit *units,
+                                   size_t num_units)
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+
+    pool_push_many_internal(pool, p_data, units, num_units);
+}
+
+static size_t pool_pop_many_shared(ABT_pool pool, ABT_unit *units,
+                                   size_t max_units)
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    size_t num_units;
+
+    ABTI_spinlock_acquire(&p_data->mutex);
+    num_units = pool_pop_many_internal(p_data, units, max_units);
+    ABTI_spinlock_release(&p_data->mutex);
+
+    return num_units;
+}
+
+static size_t pool_pop_many_private(ABT_pool pool, ABT_unit *units,
+                                    size_t max_units)
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+
+    return pool_pop_many_internal(p_data, units, max_units);
+}
+
 static int pool_remove_shared(ABT_pool pool, ABT_unit unit)
 {
     ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
@@ -0,0 +1,530 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+/* FIFO_LOCKFREE pool implementation
+ *
+ * Units are kept in a bounded ring of cells, each of which carries a sequence
+ * number (D. Vyukov's bounded MPMC queue).  Producers and consumers claim a
+ * cell with a single CAS on separate cache lines, so concurrent push and pop
+ * do not contend on a common lock.  When the ring is full, units are appended
+ * to an overflow list protected by a spinlock; while the overflow list is not
+ * empty, new units also go there, and consumers take units from the ring
+ * before the overflow list.
+ *
+ * The FIFO order is relaxed in one case.  A consumer that finds the next cell
+ * of the ring claimed but not yet filled by a concurrent producer does not
+ * wait for it and takes the head of the overflow list instead, so that unit
+ * may run before older units behind that cell in the ring.
+ *
+ * A unit in the ring remembers its cell in p_prev (p_next is NULL), so that
+ * p_remove can take it out by swapping the cell's unit pointer with NULL.  A
+ * consumer that claims such an emptied cell simply skips it.  A unit in the
+ * overflow list is linked through p_prev and p_next as in the FIFO pool. */
+
+#define POOL_RING_SIZE  1024    /* Must be a power of two */
+
+/* pool_pop_timedwait spins for a while and then sleeps for a period that
+ * doubles up to the maximum. */
+#define POOL_TIMEDWAIT_NUM_SPINS        100
+#define POOL_TIMEDWAIT_MIN_SLEEP_NSEC   1000
+#define POOL_TIMEDWAIT_MAX_SLEEP_NSEC   1000000
+
+static int      pool_init(ABT_pool pool, ABT_pool_config config);
+static int      pool_free(ABT_pool pool);
+static size_t   pool_get_size(ABT_pool pool);
+static void     pool_push(ABT_pool pool, ABT_unit unit);
+static ABT_unit pool_pop(ABT_pool pool);
+static ABT_unit pool_pop_timedwait(ABT_pool pool, double abstime_secs);
+static int      pool_remove(ABT_pool pool, ABT_unit unit);
+static int      pool_print_all(ABT_pool pool, void *arg,
+                               void (*print_fn)(void *, ABT_unit));
+
+typedef ABTI_unit unit_t;
+static ABT_unit_type unit_get_type(ABT_unit unit);
+static ABT_thread unit_get_thread(ABT_unit unit);
+static ABT_task unit_get_task(ABT_unit unit);
+static ABT_bool unit_is_in_pool(ABT_unit unit);
+static ABT_unit unit_create_from_thread(ABT_thread thread);
+static ABT_unit unit_create_from_task(ABT_task task);
+static void unit_free(ABT_unit *unit);
+
+typedef struct {
+    uint64_t seq;
+    unit_t *p_unit;
+} cell_t;
+
+struct data {
+    /* Producer index */
+    char pad0[ABT_CONFIG_STATIC_CACHELINE_SIZE];
+    uint64_t enq_pos;
+    /* Consumer index */
+    char pad1[ABT_CONFIG_STATIC_CACHELINE_SIZE - sizeof(uint64_t)];
+    uint64_t deq_pos;
+    char pad2[ABT_CONFIG_STATIC_CACHELINE_SIZE - sizeof(uint64_t)];
+    /* Shared counters */
+    uint64_t num_units;
+    uint32_t num_overflow;
+    char pad3[ABT_CONFIG_STATIC_CACHELINE_SIZE - sizeof(uint64_t)
+              - sizeof(uint32_t)];
+    /* Overflow list */
+    ABTI_spinlock overflow_lock;
+    unit_t *p_head;
+    unit_t *p_tail;
+    /* Ring */
+    uint64_t mask;
+    cell_t *cells;
+};
+typedef struct data data_t;
+
+static inline data_t *pool_get_data_ptr(void *p_data)
+{
+    return (data_t *)p_data;
+}
+
+int ABTI_pool_get_fifo_lockfree_def(ABT_pool_access access,
+                                    ABT_pool_def *p_def)
+{
+    int abt_errno = ABT_SUCCESS;
+
+    switch (access) {
+        case ABT_POOL_ACCESS_PRIV:
+        case ABT_POOL_ACCESS_SPSC:
+        case ABT_POOL_ACCESS_MPSC:
+        case ABT_POOL_ACCESS_SPMC:
+        case ABT_POOL_ACCESS_MPMC:
+            break;
+
+        default:
+            ABTI_CHECK_TRUE(0, ABT_ERR_INV_POOL_ACCESS);
+    }
+
+    p_def->access               = access;
+    p_def->p_init               = pool_init;
+    p_def->p_free               = pool_free;
+    p_def->p_get_size           = pool_get_size;
+    p_def->p_push               = pool_push;
+    p_def->p_pop                = pool_pop;
+    p_def->p_pop_timedwait      = pool_pop_timedwait;
+    p_def->p_remove             = pool_remove;
+    p_def->p_print_all          = pool_print_all;
+    p_def->p_pop_steal          = NULL;
+    p_def->p_push_many          = NULL;
+    p_def->p_pop_many           = NULL;
+    p_def->u_get_type           = unit_get_type;
+    p_def->u_get_thread         = unit_get_thread;
+    p_def->u_get_task           = unit_get_task;
+    p_def->u_is_in_pool         = unit_is_in_pool;
+    p_def->u_create_from_thread = unit_create_from_thread;
+    p_def->u_create_from_task   = unit_create_from_task;
+    p_def->u_free               = unit_free;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+
+/* Ring functions */
+
+/* Returns ABT_FALSE if the ring is full. */
+static inline ABT_bool ring_push(ABT_pool pool, data_t *p_data,
+                                 unit_t *p_unit)
+{
+    cell_t *p_cell;
+    uint64_t pos = ABTD_atomic_load_uint64(&p_data->enq_pos);
+
+    while (1) {
+        p_cell = &p_data->cells[pos & p_data->mask];
+        uint64_t seq = ABTD_atomic_load_uint64(&p_cell->seq);
+        int64_t diff = (int64_t)(seq - pos);
+        if (diff == 0) {
+            if (ABTD_atomic_bool_cas_weak_uint64(&p_data->enq_pos, pos,
+                                                 pos + 1))
+                break;
+            pos = ABTD_atomic_load_uint64(&p_data->enq_pos);
+        } else if (diff < 0) {
+            /* The ring is full. */
+            return ABT_FALSE;
+        } else {
+            pos = ABTD_atomic_load_uint64(&p_data->enq_pos);
+        }
+    }
+
+    /* The cell is ours.  Record where the unit lives before making it
+     * visible as a unit of this pool, and then publish it. */
+    p_unit->p_next = NULL;
+    p_unit->p_prev = (unit_t *)p_cell;
+    ABTD_atomic_store_ptr((void **)&p_unit->pool, (void *)pool);
+    ABTD_atomic_store_ptr((void **)&p_cell->p_unit, (void *)p_unit);
+    ABTD_atomic_store_uint64(&p_cell->seq, pos + 1);
+    return ABT_TRUE;
+}
+
+/* Returns NULL if the ring is empty. */
+static inline unit_t *ring_pop(data_t *p_data)
+{
+    cell_t *p_cell;
+    unit_t *p_unit;
+    uint64_t pos;
+
+    do {
+        pos = ABTD_atomic_load_uint64(&p_data->deq_pos);
+        while (1) {
+            p_cell = &p_data->cells[pos & p_data->mask];
+            uint64_t seq = ABTD_atomic_load_uint64(&p_cell->seq);
+            int64_t diff = (int64_t)(seq - (pos + 1));
+            if (diff == 0) {
+                if (ABTD_atomic_bool_cas_weak_uint64(&p_data->deq_pos, pos,
+                                                     pos + 1))
+                    break;
+                pos = ABTD_atomic_load_uint64(&p_data->deq_pos);
+            } else if (diff < 0) {
+                /* The ring is empty. */
+                return NULL;
+            } else {
+                pos = ABTD_atomic_load_uint64(&p_data->deq_pos);
+            }
+        }
+
+        /* NULL means that the unit has been removed by p_remove. */
+        p_unit = (unit_t *)ABTD_atomic_exchange_ptr((void **)&p_cell->p_unit,
+                                                    NULL);
+        ABTD_atomic_store_uint64(&p_cell->seq, pos + p_data->mask + 1);
+    } while (p_unit == NULL);
+
+    return p_unit;
+}
+
+
+/* Overflow list functions (called with overflow_lock held) */
+
+static inline void overflow_push(data_t *p_data, unit_t *p_unit)
+{
+    if (p_data->num_overflow == 0) {
+        p_unit->p_prev = p_unit;
+        p_unit->p_next = p_unit;
+        p_data->p_head = p_unit;
+        p_data->p_tail = p_unit;
+    } else {
+        unit_t *p_head = p_data->p_head;
+        unit_t *p_tail = p_data->p_tail;
+        p_tail->p_next = p_unit;
+        p_head->p_prev = p_unit;
+        p_unit->p_prev = p_tail;
+        p_unit->p_next = p_head;
+        p_data->p_tail = p_unit;
+    }
+    ABTD_atomic_store_uint32(&p_data->num_overflow, p_data->num_overflow + 1);
+}
+
+static inline void overflow_unlink(data_t *p_data, unit_t *p_unit)
+{
+    if (p_data->num_overflow == 1) {
+        p_data->p_head = NULL;
+        p_data->p_tail = NULL;
+    } else {
+        p_unit->p_prev->p_next = p_unit->p_next;
+        p_unit->p_next->p_prev = p_unit->p_prev;
+        if (p_unit == p_data->p_head) {
+            p_data->p_head = p_unit->p_next;
+        } else if (p_unit == p_data->p_tail) {
+            p_data->p_tail = p_unit->p_prev;
+        }
+    }
+    ABTD_atomic_store_uint32(&p_data->num_overflow, p_data->num_overflow - 1);
+}
+
+
+/* Pool functions */
+
+static int pool_init(ABT_pool pool, ABT_pool_config config)
+{
+    ABTI_UNUSED(config);
+    int abt_errno = ABT_SUCCESS;
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    uint64_t i;
+
+    data_t *p_data = (data_t *)ABTU_malloc(sizeof(data_t));
+
+    p_data->enq_pos = 0;
+    p_data->deq_pos = 0;
+    p_data->num_units = 0;
+    p_data->num_overflow = 0;
+    ABTI_spinlock_clear(&p_data->overflow_lock);
+    p_data->p_head = NULL;
+    p_data->p_tail = NULL;
+
+    p_data->mask = POOL_RING_SIZE - 1;
+    p_data->cells = (cell_t *)ABTU_malloc(sizeof(cell_t) * POOL_RING_SIZE);
+    for (i = 0; i < POOL_RING_SIZE; i++) {
+        p_data->cells[i].seq = i;
+        p_data->cells[i].p_unit = NULL;
+    }
+
+    p_pool->data = p_data;
+
+    return abt_errno;
+}
+
+static int pool_free(ABT_pool pool)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+
+    ABTU_free(p_data->cells);
+    ABTU_free(p_data);
+
+    return abt_errno;
+}
+
+static size_t pool_get_size(ABT_pool pool)
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    return (size_t)ABTD_atomic_load_uint64(&p_data->num_units);
+}
+
+static void pool_push(ABT_pool pool, ABT_unit unit)
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    unit_t *p_unit = (unit_t *)unit;
+
+    /* The size is increased first so that it is never underestimated. */
+    ABTD_atomic_fetch_add_uint64(&p_data->num_units, 1);
+
+    if (ABTD_atomic_load_uint32(&p_data->num_overflow) == 0) {
+        if (ring_push(pool, p_data, p_unit) == ABT_TRUE)
+            return;
+    }
+
+    ABTI_spinlock_acquire(&p_data->overflow_lock);
+    overflow_push(p_data, p_unit);
+    ABTD_atomic_store_ptr((void **)&p_unit->pool, (void *)pool);
+    ABTI_spinlock_release(&p_data->overflow_lock);
+}
+
+static ABT_unit pool_pop(ABT_pool pool)
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    unit_t *p_unit;
+
+    p_unit = ring_pop(p_data);
+    if (p_unit == NULL) {
+        if (ABTD_atomic_load_uint32(&p_data->num_overflow) == 0)
+            return ABT_UNIT_NULL;
+
+        ABTI_spinlock_acquire(&p_data->overflow_lock);
+        if (p_data->num_overflow > 0) {
+            p_unit = p_data->p_head;
+            overflow_unlink(p_data, p_unit);
+        }
+        ABTI_spinlock_release(&p_data->overflow_lock);
+        if (p_unit == NULL)
+            return ABT_UNIT_NULL;
+    }
+
+    p_unit->p_prev = NULL;
+    p_unit->p_next = NULL;
+    ABTD_atomic_store_ptr((void **)&p_unit->pool, (void *)ABT_POOL_NULL);
+    ABTD_atomic_fetch_sub_uint64(&p_data->num_units, 1);
+
+    return (ABT_unit)p_unit;
+}
+
+/* Producers do not wake up consumers, which would add a barrier to every
+ * push, so a waiting consumer backs off to sleeping instead of spinning until
+ * the deadline. */
+static ABT_unit pool_pop_timedwait(ABT_pool pool, double abstime_secs)
+{
+    ABT_unit h_unit;
+    int num_spins = 0;
+    long sleep_nsec = POOL_TIMEDWAIT_MIN_SLEEP_NSEC;
+
+    while ((h_unit = pool_pop(pool)) == ABT_UNIT_NULL) {
+        double wait_secs = abstime_secs - ABTI_get_wtime();
+        if (wait_secs <= 0.0)
+            break;
+        if (num_spins < POOL_TIMEDWAIT_NUM_SPINS) {
+            num_spins++;
+            ABTD_atomic_pause();
+            continue;
+        }
+
+        /* Do not sleep past the deadline. */
+        struct timespec ts = {0, sleep_nsec};
+        if (wait_secs * 1.0e9 < (double)sleep_nsec)
+            ts.tv_nsec = (long)(wait_secs * 1.0e9) + 1;
+        nanosleep(&ts, NULL);
+        if (sleep_nsec < POOL_TIMEDWAIT_MAX_SLEEP_NSEC)
+            sleep_nsec *= 2;
+    }
+
+    return h_unit;
+}
+
+static int pool_remove(ABT_pool pool, ABT_unit unit)
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    unit_t *p_unit = (unit_t *)unit;
+
+    ABTI_CHECK_TRUE_RET(ABTD_atomic_load_uint64(&p_data->num_units) != 0,
+                        ABT_ERR_POOL);
+    ABTI_CHECK_TRUE_RET(p_unit->pool != ABT_POOL_NULL, ABT_ERR_POOL);
+    ABTI_CHECK_TRUE_MSG_RET(p_unit->pool == pool, ABT_ERR_POOL, "Not my pool");
+
+    /* The unit may be popped or moved between the ring and the overflow list
+     * concurrently, so retry until it is removed or found not to be ours. */
+    while (ABTD_atomic_load_ptr((void **)&p_unit->pool) == (void *)pool) {
+        unit_t *p_next = (unit_t *)ABTD_atomic_load_ptr(
+                             (void **)&p_unit->p_next);
+        if (p_next != NULL) {
+            /* In the overflow list */
+            ABT_bool removed = ABT_FALSE;
+            ABTI_spinlock_acquire(&p_data->overflow_lock);
+            if (p_unit->pool == pool && p_unit->p_next != NULL) {
+                overflow_unlink(p_data, p_unit);
+                removed = ABT_TRUE;
+            }
+            ABTI_spinlock_release(&p_data->overflow_lock);
+            if (removed == ABT_TRUE)
+                goto removed;
+        } else {
+            /* In the ring */
+            cell_t *p_cell = (cell_t *)ABTD_atomic_load_ptr(
+                                 (void **)&p_unit->p_prev);
+            if (p_cell != NULL &&
+                ABTD_atomic_bool_cas_strong_ptr((void **)&p_cell->p_unit,
+                                                (void *)p_unit, NULL)) {
+                goto removed;
+            }
+        }
+        ABTD_atomic_pause();
+    }
+    return ABT_ERR_POOL;
+
+  removed:
+    p_unit->p_prev = NULL;
+    p_unit->p_next = NULL;
+    ABTD_atomic_store_ptr((void **)&p_unit->pool, (void *)ABT_POOL_NULL);
+    ABTD_atomic_fetch_sub_uint64(&p_data->num_units, 1);
+
+    return ABT_SUCCESS;
+}
+
+/* This function is for debugging.  Units in the ring are printed from a
+ * snapshot of the indices, so units that are concurrently pushed or popped
+ * may be missed. */
+static int pool_print_all(ABT_pool pool, void *arg,
+                          void (*print_fn)(void *, ABT_unit))
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    uint64_t pos, enq_pos;
+
+    ABTI_spinlock_acquire(&p_data->overflow_lock);
+
+    pos = ABTD_atomic_load_uint64(&p_data->deq_pos);
+    enq_pos = ABTD_atomic_load_uint64(&p_data->enq_pos);
+    for (; pos != enq_pos; pos++) {
+        cell_t *p_cell = &p_data->cells[pos & p_data->mask];
+        unit_t *p_unit = (unit_t *)ABTD_atomic_load_ptr(
+                             (void **)&p_cell->p_unit);
+        if (p_unit != NULL)
+            print_fn(arg, (ABT_unit)p_unit);
+    }
+
+    size_t num_units = p_data->num_overflow;
+    unit_t *p_unit = p_data->p_head;
+    while (num_units--) {
+        ABTI_ASSERT(p_unit);
+        ABT_unit unit = (ABT_unit)p_unit;
+        print_fn(arg, unit);
+        p_unit = p_unit->p_next;
+    }
+
+    ABTI_spinlock_release(&p_data->overflow_lock);
+
+    return ABT_SUCCESS;
+}
+
+
+/* Unit functions */
+
+static ABT_unit_type unit_get_type(ABT_unit unit)
+{
+   unit_t *p_unit = (unit_t *)unit;
+   return p_unit->type;
+}
+
+static ABT_thread unit_get_thread(ABT_unit unit)
+{
+    ABT_thread h_thread;
+    unit_t *p_unit = (unit_t *)unit;
+    if (p_unit->type == ABT_UNIT_TYPE_THREAD) {
+        h_thread = p_unit->handle.thread;
+    } else {
+        h_thread = ABT_THREAD_NULL;
+    }
+    return h_thread;
+}
+
+static ABT_task unit_get_task(ABT_unit unit)
+{
+    ABT_task h_task;
+    unit_t *p_unit = (unit_t *)unit;
+    if (p_unit->type == ABT_UNIT_TYPE_TASK) {
+        h_task = p_unit->handle.task;
+    } else {
+        h_task = ABT_TASK_NULL;
+    }
+    return h_task;
+}
+
+static ABT_bool unit_is_in_pool(ABT_unit unit)
+{
+    unit_t *p_unit = (unit_t *)unit;
+    void *pool = ABTD_atomic_load_ptr((void **)&p_unit->pool);
+    return (pool != (void *)ABT_POOL_NULL) ? ABT_TRUE : ABT_FALSE;
+}
+
+static ABT_unit unit_create_from_thread(ABT_thread thread)
+{
+    ABTI_thread *p_thread = ABTI_thread_get_ptr(thread);
+    unit_t *p_unit = &p_thread->unit_def;
+    p_unit->p_prev = NULL;
+    p_unit->p_next = NULL;
+    p_unit->pool   = ABT_POOL_NULL;
+    p_unit->handle.thread = thread;
+    p_unit->type   = ABT_UNIT_TYPE_THREAD;
+
+    return (ABT_unit)p_unit;
+}
+
+static ABT_unit unit_create_from_task(ABT_task task)
+{
+    ABTI_task *p_task = ABTI_task_get_ptr(task);
+    unit_t *p_unit = &p_task->unit_def;
+    p_unit->p_prev = NULL;
+    p_unit->p_next = NULL;
+    p_unit->pool   = ABT_POOL_NULL;
+    p_unit->handle.task = task;
+    p_unit->type   = ABT_UNIT_TYPE_TASK;
+
+    return (ABT_unit)p_unit;
+}
+
+static void unit_free(ABT_unit *unit)
+{
+    *unit = ABT_UNIT_NULL;
+}
@@ -5,7 +5,12 @@
 
 #include "abti.h"
 
-/* FIFO_WAIT pool implementation */
+/* FIFO_WAIT pool implementation
+ *
+ * Units are kept in a list protected by a spinlock as in the FIFO pool, so
+ * push and pop do not enter the kernel.  Only consumers in p_pop_timedwait
+ * block on a futex.  They announce themselves in num_waiters, and a pusher
+ * issues a wake-up only if num_waiters is not zero. */
 
 static int      pool_init(ABT_pool pool, ABT_pool_config config);
 static int      pool_free(ABT_pool pool);
@@ -27,11 +32,12 @@ static ABT_unit unit_create_from_task(ABT_task task);
 static void unit_free(ABT_unit *unit);
 
 struct data {
-    pthread_mutex_t mutex;
-    pthread_cond_t cond;
+    ABTI_spinlock mutex;
     size_t num_units;
     unit_t *p_head;
     unit_t *p_tail;
+    uint32_t num_waiters;   /* Number of consumers in p_pop_timedwait */
+    uint32_t futex_seq;     /* Incremented to wake up the waiters */
 };
 typedef struct data data_t;
 
@@ -51,6 +57,9 @@ int ABTI_pool_get_fifo_wait_def(ABT_pool_access access, ABT_pool_def *p_def)
     p_def->p_pop_timedwait      = pool_pop_timedwait;
     p_def->p_remove             = pool_remove;
     p_def->p_print_all          = pool_print_all;
+    p_def->p_pop_steal          = NULL;
+    p_def->p_push_many          = NULL;
+    p_def->p_pop_many           = NULL;
     p_def->u_get_type           = unit_get_type;
     p_def->u_get_thread         = unit_get_thread;
     p_def->u_get_task           = unit_get_task;
@@ -73,12 +82,13 @@ int pool_init(ABT_pool pool, ABT_pool_config config)
 
     data_t *p_data = (data_t *)ABTU_malloc(sizeof(data_t));
 
-    pthread_mutex_init(&p_data->mutex, NULL);
-    pthread_cond_init(&p_data->cond, NULL);
+    ABTI_spinlock_clear(&p_data->mutex);
 
     p_data->num_units = 0;
     p_data->p_head = NULL;
     p_data->p_tail = NULL;
+    p_data->num_waiters = 0;
+    p_data->futex_seq = 0;
 
     p_pool->data = p_data;
 
@@ -91,8 +101,6 @@ static int pool_free(ABT_pool pool)
     ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
     data_t *p_data = pool_get_data_ptr(p_pool->data);
 
-    pthread_mutex_destroy(&p_data->mutex);
-    pthread_cond_destroy(&p_data->cond);
     ABTU_free(p_data);
 
     return abt_errno;
@@ -111,7 +119,7 @@ static void pool_push(ABT_pool pool, ABT_unit unit)
     data_t *p_data = pool_get_data_ptr(p_pool->data);
     unit_t *p_unit = (unit_t *)unit;
 
-    pthread_mutex_lock(&p_data->mutex);
+    ABTI_spinlock_acquire(&p_data->mutex);
     if (p_data->num_units == 0) {
         p_unit->p_prev = p_unit;
         p_unit->p_next = p_unit;
@@ -129,52 +137,41 @@ static void pool_push(ABT_pool pool, ABT_unit unit)
     p_data->num_units++;
 
     p_unit->pool = pool;
-    pthread_cond_signal(&p_data->cond);
-    pthread_mutex_unlock(&p_data->mutex);
-}
-
-static inline void convert_double_sec_to_timespec(struct timespec *ts_out,
-    double seconds)
-{
-    ts_out->tv_sec = (time_t)seconds;
-    ts_out->tv_nsec = (long)((seconds-ts_out->tv_sec) * 1000000000.0);
+    ABTI_spinlock_release(&p_data->mutex);
+
+    /* Wake up a waiter only if there is any.  The full barrier pairs with
+     * the increment of num_waiters in pool_pop_timedwait. */
+    ABTD_atomic_full_barrier();
+    if (ABTD_atomic_load_uint32(&p_data->num_waiters) > 0) {
+        ABTD_atomic_fetch_add_uint32(&p_data->futex_seq, 1);
+        ABTD_futex_wake(&p_data->futex_seq, 1);
+    }
 }
 
 static ABT_unit pool_pop_timedwait(ABT_pool pool, double abstime_secs)
 {
     ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
     data_t *p_data = pool_get_data_ptr(p_pool->data);
-    unit_t *p_unit = NULL;
-    ABT_unit h_unit = ABT_UNIT_NULL;
-
-    pthread_mutex_lock(&p_data->mutex);
-
-    if(!p_data->num_units)
-    {
-        struct timespec ts;
-        convert_double_sec_to_timespec(&ts, abstime_secs);
-        pthread_cond_timedwait(&p_data->cond, &p_data->mutex, &ts);
-    }
-
-    if (p_data->num_units > 0) {
-        p_unit = p_data->p_head;
-        if (p_data->num_units == 1) {
-            p_data->p_head = NULL;
-            p_data->p_tail = NULL;
-        } else {
-            p_unit->p_prev->p_next = p_unit->p_next;
-            p_unit->p_next->p_prev = p_unit->p_prev;
-            p_data->p_head = p_unit->p_next;
-        }
-        p_data->num_units--;
-
-        p_unit->p_prev = NULL;
-        p_unit->p_next = NULL;
-        p_unit->pool = ABT_POOL_NULL;
-
-        h_unit = (ABT_unit)p_unit;
+    ABT_unit h_unit;
+
+    h_unit = pool_pop(pool);
+    if (h_unit != ABT_UNIT_NULL) return h_unit;
+
+    ABTD_atomic_fetch_add_uint32(&p_data->num_waiters, 1);
+    ABTD_atomic_full_barrier();
+    while (1) {
+        /* futex_seq is read before checking the pool, so a push after the
+         * check makes ABTD_futex_wait return immediately. */
+        uint32_t seq = ABTD_atomic_load_uint32(&p_data->futex_seq);
+        h_unit = pool_pop(pool);
+        if (h_unit != ABT_UNIT_NULL) break;
+
+        double wait_secs = abstime_secs - ABTI_get_wtime();
+        if (wait_secs <= 0.0) break;
+        ABTD_futex_wait(&p_data->futex_seq, seq,
+                        (uint64_t)(wait_secs * 1.0e9));
     }
-    pthread_mutex_unlock(&p_data->mutex);
+    ABTD_atomic_fetch_sub_uint32(&p_data->num_waiters, 1);
 
     return h_unit;
 }
@@ -186,7 +183,7 @@ static ABT_unit pool_pop(ABT_pool pool)
     unit_t *p_unit = NULL;
     ABT_unit h_unit = ABT_UNIT_NULL;
 
-    pthread_mutex_lock(&p_data->mutex);
+    ABTI_spinlock_acquire(&p_data->mutex);
     if (p_data->num_units > 0) {
         p_unit = p_data->p_head;
         if (p_data->num_units == 1) {
@@ -205,7 +202,7 @@ static ABT_unit pool_pop(ABT_pool pool)
 
         h_unit = (ABT_unit)p_unit;
     }
-    pthread_mutex_unlock(&p_data->mutex);
+    ABTI_spinlock_release(&p_data->mutex);
 
     return h_unit;
 }
@@ -220,7 +217,7 @@ static int pool_remove(ABT_pool pool, ABT_unit unit)
     ABTI_CHECK_TRUE_RET(p_unit->pool != ABT_POOL_NULL, ABT_ERR_POOL);
     ABTI_CHECK_TRUE_MSG_RET(p_unit->pool == pool, ABT_ERR_POOL, "Not my pool");
 
-    pthread_mutex_lock(&p_data->mutex);
+    ABTI_spinlock_acquire(&p_data->mutex);
     if (p_data->num_units == 1) {
         p_data->p_head = NULL;
         p_data->p_tail = NULL;
@@ -236,7 +233,7 @@ static int pool_remove(ABT_pool pool, ABT_unit unit)
     p_data->num_units--;
 
     p_unit->pool = ABT_POOL_NULL;
-    pthread_mutex_unlock(&p_data->mutex);
+    ABTI_spinlock_release(&p_data->mutex);
 
     p_unit->p_prev = NULL;
     p_unit->p_next = NULL;
@@ -249,7 +246,7 @@ static int pool_print_all(ABT_pool pool, void *arg,
     ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
     data_t *p_data = pool_get_data_ptr(p_pool->data);
 
-    pthread_mutex_lock(&p_data->mutex);
+    ABTI_spinlock_acquire(&p_data->mutex);
 
     size_t num_units = p_data->num_units;
     unit_t *p_unit = p_data->p_head;
@@ -260,7 +257,7 @@ static int pool_print_all(ABT_pool pool, void *arg,
         p_unit = p_unit->p_next;
     }
 
-    pthread_mutex_unlock(&p_data->mutex);
+    ABTI_spinlock_release(&p_data->mutex);
 
     return ABT_SUCCESS;
 }
@@ -247,6 +247,43 @@ int ABT_pool_pop_timedwait(ABT_pool pool, ABT_unit *p_unit, double abstime_secs)
     goto fn_exit;
 }
 
+/**
+ * @ingroup POOL
+ * @brief   Steal a unit from the target pool
+ *
+ * \c ABT_pool_pop_steal() pops a unit from \c pool on behalf of an ES that
+ * does not own the pool, e.g., in a work-stealing scheduler.  If the pool
+ * defines \c p_pop_steal, it is used; otherwise, this routine is the same as
+ * \c ABT_pool_pop().
+ *
+ * @param[in] pool handle to the pool
+ * @param[out] p_unit handle to the unit
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_pool_pop_steal(ABT_pool pool, ABT_unit *p_unit)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABT_unit unit;
+
+    /* If called by an external thread, return an error. */
+    ABTI_CHECK_TRUE(ABTI_local_get_local() != NULL, ABT_ERR_INV_XSTREAM);
+
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    ABTI_CHECK_NULL_POOL_PTR(p_pool);
+
+    unit = ABTI_pool_pop_steal(p_pool);
+
+  fn_exit:
+    *p_unit = unit;
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    unit = ABT_UNIT_NULL;
+    goto fn_exit;
+}
+
 /**
  * @ingroup POOL
  * @brief   Push a unit to the target pool
@@ -282,6 +319,90 @@ int ABT_pool_push(ABT_pool pool, ABT_unit unit)
     goto fn_exit;
 }
 
+/**
+ * @ingroup POOL
+ * @brief   Push multiple units to the target pool
+ *
+ * \c ABT_pool_push_many() pushes \c num_units units in \c units to \c pool
+ * in order.  If the pool defines \c p_push_many, all units are pushed by a
+ * single call to it, e.g., under a single lock acquisition; otherwise, this
+ * routine is the same as calling \c ABT_pool_push() for each unit.
+ *
+ * @param[in] pool      handle to the pool
+ * @param[in] units     array of unit handles
+ * @param[in] num_units number of units in \c units
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_pool_push_many(ABT_pool pool, const ABT_unit *units, size_t num_units)
+{
+    int abt_errno = ABT_SUCCESS;
+    size_t i;
+
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    ABTI_CHECK_NULL_POOL_PTR(p_pool);
+
+    for (i = 0; i < num_units; i++) {
+        ABTI_CHECK_TRUE(units[i] != ABT_UNIT_NULL, ABT_ERR_UNIT);
+    }
+    if (num_units == 0) goto fn_exit;
+
+#ifdef ABT_CONFIG_DISABLE_POOL_PRODUCER_CHECK
+    ABTI_pool_push_many(p_pool, units, num_units);
+#else
+    /* Save the producer ES information in the pool */
+    abt_errno = ABTI_pool_push_many(p_pool, units, num_units,
+        ABTI_self_get_native_thread_id(ABTI_local_get_local()));
+    ABTI_CHECK_ERROR(abt_errno);
+#endif
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup POOL
+ * @brief   Pop multiple units from the target pool
+ *
+ * \c ABT_pool_pop_many() pops at most \c max_units units from \c pool and
+ * stores them in \c units.  The number of popped units is returned through
+ * \c num_units; it is smaller than \c max_units only if the pool has become
+ * empty.
+ *
+ * @param[in]  pool      handle to the pool
+ * @param[out] units     array of unit handles
+ * @param[in]  max_units maximum number of units to pop
+ * @param[out] num_units number of popped units
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_pool_pop_many(ABT_pool pool, ABT_unit *units, size_t max_units,
+                      size_t *num_units)
+{
+    int abt_errno = ABT_SUCCESS;
+    size_t num = 0;
+
+    /* If called by an external thread, return an error. */
+    ABTI_CHECK_TRUE(ABTI_local_get_local() != NULL, ABT_ERR_INV_XSTREAM);
+
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    ABTI_CHECK_NULL_POOL_PTR(p_pool);
+
+    num = ABTI_pool_pop_many(p_pool, units, max_units);
+
+  fn_exit:
+    *num_units = num;
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
 /**
  * @ingroup POOL
  * @brief   Remove a specified unit from the target pool
@@ -555,6 +676,12 @@ int ABTI_pool_create(ABT_pool_def *def, ABT_pool_config config,
     p_pool->num_blocked          = 0;
     p_pool->num_migrations       = 0;
     p_pool->data                 = NULL;
+    p_pool->home_cpu             = -1;
+    p_pool->p_owner              = NULL;
+    p_pool->park_enabled         = 0;
+    ABTI_spinlock_clear(&p_pool->park_lock);
+    p_pool->num_parked           = 0;
+    p_pool->p_parked             = NULL;
 
     /* Set up the pool functions from def */
     p_pool->u_get_type           = def->u_get_type;
@@ -572,6 +699,9 @@ int ABTI_pool_create(ABT_pool_def *def, ABT_pool_config config,
     p_pool->p_remove             = def->p_remove;
     p_pool->p_free               = def->p_free;
     p_pool->p_print_all          = def->p_print_all;
+    p_pool->p_pop_steal          = def->p_pop_steal;
+    p_pool->p_push_many          = def->p_push_many;
+    p_pool->p_pop_many           = def->p_pop_many;
     p_pool->id                   = ABTI_pool_get_new_id();
     LOG_EVENT("[P%" PRIu64 "] created\n", p_pool->id);
 
@@ -606,6 +736,12 @@ int ABTI_pool_create_basic(ABT_pool_kind kind, ABT_pool_access access,
         case ABT_POOL_FIFO_WAIT:
             abt_errno = ABTI_pool_get_fifo_wait_def(access, &def);
             break;
+        case ABT_POOL_FIFO_LOCKFREE:
+            abt_errno = ABTI_pool_get_fifo_lockfree_def(access, &def);
+            break;
+        case ABT_POOL_DEQUE:
+            abt_errno = ABTI_pool_get_deque_def(access, &def);
+            break;
         default:
             abt_errno = ABT_ERR_INV_POOL_KIND;
             break;
@@ -837,6 +973,22 @@ void ABTI_pool_reset_id(void)
     g_pool_id = 0;
 }
 
+/* Wake up at most num_xstreams ESs parked on p_pool.  ESs that have already
+ * been woken up by others are skipped. */
+void ABTI_pool_unpark(ABTI_pool *p_pool, size_t num_xstreams)
+{
+    ABTI_park_link *p_link;
+
+    ABTI_spinlock_acquire(&p_pool->park_lock);
+    for (p_link = p_pool->p_parked; p_link != NULL && num_xstreams > 0;
+         p_link = p_link->p_next) {
+        if (ABTI_xstream_unpark(p_link->p_xstream) == ABT_TRUE) {
+            num_xstreams--;
+        }
+    }
+    ABTI_spinlock_release(&p_pool->park_lock);
+}
+
 /*****************************************************************************/
 /* Internal static functions                                                 */
 /*****************************************************************************/
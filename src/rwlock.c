@@ -5,9 +5,24 @@
 
 #include "abti.h"
 
+static inline void rwlock_init_waiter(ABTI_local *p_local,
+                                      ABTI_rwlock_waiter *p_waiter, int shard);
+static void rwlock_block(ABTI_local **pp_local, ABTI_rwlock *p_rwlock,
+                         ABTI_rwlock_waiter *p_waiter);
+static void rwlock_wake(ABTI_local *p_local, ABTI_rwlock_waiter *p_waiter);
+static inline void rwlock_enqueue(ABTI_rwlock_waiter **pp_head,
+                                  ABTI_rwlock_waiter **pp_tail,
+                                  ABTI_rwlock_waiter *p_waiter);
+
 /** @defgroup RWLOCK Readers Writer Lock
  * A Readers writer lock allows concurrent access for readers and exclusionary
  * access for writers.
+ *
+ * Readers are counted in per-ES counters, so readers on different ESs do not
+ * share a cache line unless a writer is involved.  A writer that is waiting
+ * for readers to leave blocks new readers (writer preference).  When a writer
+ * unlocks the rwlock, all the readers waiting for it acquire the rwlock before
+ * the next waiting writer, so neither readers nor writers starve.
  */
 
 /**
@@ -28,13 +43,12 @@ int ABT_rwlock_create(ABT_rwlock *newrwlock)
     int abt_errno = ABT_SUCCESS;
     ABTI_rwlock *p_newrwlock;
 
-    p_newrwlock = (ABTI_rwlock *)ABTU_malloc(sizeof(ABTI_rwlock));
-    if (p_newrwlock == NULL) {
-        abt_errno = ABT_ERR_MEM;
-    }
-    else {
-        ABTI_rwlock_init(p_newrwlock);
-    }
+    /* The rwlock may not be aligned to a cache line, but each cache line
+     * still holds only one reader counter since the stride of the counters
+     * is a cache line. */
+    p_newrwlock = (ABTI_rwlock *)ABTI_mem_alloc_slab(ABTI_local_get_local(),
+                                                     sizeof(ABTI_rwlock));
+    ABTI_rwlock_init(p_newrwlock);
 
     /* Return value */
     *newrwlock = ABTI_rwlock_get_handle(p_newrwlock);
@@ -65,7 +79,7 @@ int ABT_rwlock_free(ABT_rwlock *rwlock)
     ABTI_CHECK_NULL_RWLOCK_PTR(p_rwlock);
 
     ABTI_rwlock_fini(p_rwlock);
-    ABTU_free(p_rwlock);
+    ABTI_mem_free_slab(ABTI_local_get_local(), p_rwlock);
 
     /* Return value */
     *rwlock = ABT_RWLOCK_NULL;
@@ -86,8 +100,9 @@ int ABT_rwlock_free(ABT_rwlock *rwlock)
  * returns, the caller ULT acquires the rwlock. If the rwlock has been locked
  * by a writer, the caller ULT will be blocked until the rwlock becomes
  * available. rwlocks may be acquired by any number of readers concurrently.
- * When the caller ULT is blocked, the context is switched to the scheduler
- * of the associated ES to make progress of other work units.
+ * If a writer is waiting for the rwlock, the caller ULT is blocked until the
+ * writer unlocks it. When the caller ULT is blocked, the context is switched
+ * to the scheduler of the associated ES to make progress of other work units.
  *
  * The rwlock can be used only by ULTs. Tasklets must not call any blocking
  * routines like \c ABT_rwlock_rdlock.
@@ -176,3 +191,202 @@ int ABT_rwlock_unlock(ABT_rwlock rwlock)
     HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
     goto fn_exit;
 }
+
+
+/*****************************************************************************/
+/* Private APIs                                                              */
+/*****************************************************************************/
+
+/* Slow path of ABTI_rwlock_rdlock().  The caller has backed off from shard
+ * because a writer is waiting or holds the lock. */
+int ABTI_rwlock_rdlock_wait(ABTI_local **pp_local, ABTI_rwlock *p_rwlock,
+                            int shard)
+{
+    ABTI_rwlock_waiter waiter, *p_waiter;
+    p_waiter = (ABTI_rwlock_waiter *)
+        ABTI_mem_alloc_wait_obj(*pp_local, &waiter, sizeof(waiter));
+    rwlock_init_waiter(*pp_local, p_waiter, shard);
+
+    while (1) {
+        ABTI_spinlock_acquire(&p_rwlock->lock);
+        if (ABTD_atomic_load_uint32(&p_rwlock->write_flag)
+                != ABTI_RWLOCK_WRITE_NONE) {
+            /* The writer adds this reader to shard when it unlocks. */
+            rwlock_enqueue(&p_rwlock->p_rd_head, &p_rwlock->p_rd_tail,
+                           p_waiter);
+            rwlock_block(pp_local, p_rwlock, p_waiter);
+            break;
+        }
+        ABTI_spinlock_release(&p_rwlock->lock);
+
+        /* The writer has gone.  Try again. */
+        ABTD_atomic_fetch_add_int32(&p_rwlock->shards[shard].count, 1);
+        ABTD_atomic_full_barrier();
+        if (ABTD_atomic_load_uint32(&p_rwlock->write_flag)
+                == ABTI_RWLOCK_WRITE_NONE) {
+            break;
+        }
+        ABTI_rwlock_rdunlock(*pp_local, p_rwlock, shard);
+    }
+
+    ABTI_mem_free_wait_obj(*pp_local, p_waiter, &waiter);
+    return ABT_SUCCESS;
+}
+
+/* Slow path of ABTI_rwlock_wrlock().  If is_pending is ABT_TRUE, the caller
+ * has set write_flag to ABTI_RWLOCK_WRITE_PENDING and waits for readers. */
+int ABTI_rwlock_wrlock_wait(ABTI_local **pp_local, ABTI_rwlock *p_rwlock,
+                            ABT_bool is_pending)
+{
+    ABTI_rwlock_waiter waiter, *p_waiter;
+    p_waiter = (ABTI_rwlock_waiter *)
+        ABTI_mem_alloc_wait_obj(*pp_local, &waiter, sizeof(waiter));
+    rwlock_init_waiter(*pp_local, p_waiter, 0);
+
+    ABTI_spinlock_acquire(&p_rwlock->lock);
+    if (is_pending == ABT_FALSE &&
+        !ABTD_atomic_bool_cas_strong_uint32(&p_rwlock->write_flag,
+                                            ABTI_RWLOCK_WRITE_NONE,
+                                            ABTI_RWLOCK_WRITE_PENDING)) {
+        /* Another writer is ahead.  The lock is handed over to this writer
+         * when it is woken up. */
+        rwlock_enqueue(&p_rwlock->p_wr_head, &p_rwlock->p_wr_tail, p_waiter);
+        rwlock_block(pp_local, p_rwlock, p_waiter);
+        goto fn_exit;
+    }
+
+    /* Readers that leave after this check see p_drain. */
+    ABTD_atomic_full_barrier();
+    if (ABTI_rwlock_is_drained(p_rwlock) == ABT_TRUE) {
+        ABTD_atomic_store_uint32(&p_rwlock->write_flag,
+                                 ABTI_RWLOCK_WRITE_LOCKED);
+        ABTI_spinlock_release(&p_rwlock->lock);
+        goto fn_exit;
+    }
+    p_rwlock->p_drain = p_waiter;
+    rwlock_block(pp_local, p_rwlock, p_waiter);
+
+  fn_exit:
+    ABTI_mem_free_wait_obj(*pp_local, p_waiter, &waiter);
+    return ABT_SUCCESS;
+}
+
+/* Called by a reader that leaves while write_flag is
+ * ABTI_RWLOCK_WRITE_PENDING.  If it is the last reader, the waiting writer
+ * acquires the lock. */
+void ABTI_rwlock_wake_drain(ABTI_local *p_local, ABTI_rwlock *p_rwlock)
+{
+    ABTI_rwlock_waiter *p_waiter = NULL;
+
+    ABTI_spinlock_acquire(&p_rwlock->lock);
+    if (p_rwlock->p_drain && ABTI_rwlock_is_drained(p_rwlock) == ABT_TRUE) {
+        p_waiter = p_rwlock->p_drain;
+        p_rwlock->p_drain = NULL;
+        ABTD_atomic_store_uint32(&p_rwlock->write_flag,
+                                 ABTI_RWLOCK_WRITE_LOCKED);
+    }
+    ABTI_spinlock_release(&p_rwlock->lock);
+
+    if (p_waiter) rwlock_wake(p_local, p_waiter);
+}
+
+/* Unlock p_rwlock held by a writer.  The waiting readers acquire the lock
+ * first.  If there are none, the lock is handed over to the first waiting
+ * writer. */
+void ABTI_rwlock_wrunlock(ABTI_local *p_local, ABTI_rwlock *p_rwlock)
+{
+    ABTI_rwlock_waiter *p_readers, *p_writer = NULL, *p_next;
+
+    ABTI_spinlock_acquire(&p_rwlock->lock);
+    p_readers = p_rwlock->p_rd_head;
+    p_rwlock->p_rd_head = NULL;
+    p_rwlock->p_rd_tail = NULL;
+
+    if (p_readers) {
+        ABTI_rwlock_waiter *p_reader;
+        for (p_reader = p_readers; p_reader; p_reader = p_reader->p_next) {
+            ABTD_atomic_fetch_add_int32(
+                &p_rwlock->shards[p_reader->shard].count, 1);
+        }
+        if (p_rwlock->p_wr_head) {
+            /* The next writer waits for these readers. */
+            p_rwlock->p_drain = p_rwlock->p_wr_head;
+            p_rwlock->p_wr_head = p_rwlock->p_drain->p_next;
+            if (p_rwlock->p_wr_head == NULL) p_rwlock->p_wr_tail = NULL;
+            ABTD_atomic_store_uint32(&p_rwlock->write_flag,
+                                     ABTI_RWLOCK_WRITE_PENDING);
+        } else {
+            ABTD_atomic_store_uint32(&p_rwlock->write_flag,
+                                     ABTI_RWLOCK_WRITE_NONE);
+        }
+    } else if (p_rwlock->p_wr_head) {
+        /* write_flag stays ABTI_RWLOCK_WRITE_LOCKED. */
+        p_writer = p_rwlock->p_wr_head;
+        p_rwlock->p_wr_head = p_writer->p_next;
+        if (p_rwlock->p_wr_head == NULL) p_rwlock->p_wr_tail = NULL;
+    } else {
+        ABTD_atomic_store_uint32(&p_rwlock->write_flag,
+                                 ABTI_RWLOCK_WRITE_NONE);
+    }
+    ABTI_spinlock_release(&p_rwlock->lock);
+
+    if (p_writer) rwlock_wake(p_local, p_writer);
+    while (p_readers) {
+        p_next = p_readers->p_next;
+        rwlock_wake(p_local, p_readers);
+        p_readers = p_next;
+    }
+}
+
+
+/*****************************************************************************/
+/* Internal static functions                                                 */
+/*****************************************************************************/
+
+static inline
+void rwlock_init_waiter(ABTI_local *p_local, ABTI_rwlock_waiter *p_waiter,
+                        int shard)
+{
+    p_waiter->p_next = NULL;
+    p_waiter->p_thread = p_local ? p_local->p_thread : NULL;
+    p_waiter->ext_signal = 0;
+    p_waiter->shard = shard;
+}
+
+/* Block the caller until p_waiter is woken up.  p_rwlock->lock must be held,
+ * and it is released here. */
+static void rwlock_block(ABTI_local **pp_local, ABTI_rwlock *p_rwlock,
+                         ABTI_rwlock_waiter *p_waiter)
+{
+    if (p_waiter->p_thread) {
+        ABTI_thread_set_blocked(p_waiter->p_thread);
+        ABTI_spinlock_release(&p_rwlock->lock);
+        ABTI_thread_suspend(pp_local, p_waiter->p_thread);
+    } else {
+        /* External threads and tasklets block the native thread. */
+        ABTI_spinlock_release(&p_rwlock->lock);
+        ABTD_futex_signal_wait(&p_waiter->ext_signal);
+    }
+}
+
+/* p_waiter may be released by the waiter right after this call. */
+static void rwlock_wake(ABTI_local *p_local, ABTI_rwlock_waiter *p_waiter)
+{
+    if (p_waiter->p_thread) {
+        ABTI_thread_set_ready(p_local, p_waiter->p_thread);
+    } else {
+        ABTD_futex_signal_set(&p_waiter->ext_signal);
+    }
+}
+
+static inline
+void rwlock_enqueue(ABTI_rwlock_waiter **pp_head, ABTI_rwlock_waiter **pp_tail,
+                    ABTI_rwlock_waiter *p_waiter)
+{
+    if (*pp_tail) {
+        (*pp_tail)->p_next = p_waiter;
+    } else {
+        *pp_head = p_waiter;
+    }
+    *pp_tail = p_waiter;
+}
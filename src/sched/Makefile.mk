@@ -9,5 +9,6 @@ abt_sources += \
 	sched/config.c \
 	sched/prio.c \
 	sched/sched.c \
-	sched/randws.c
+	sched/randws.c \
+	sched/topows.c
 
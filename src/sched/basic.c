@@ -98,6 +98,7 @@ static void sched_run(ABT_sched sched)
     int num_pools;
     ABT_pool *pools;
     int i;
+    PARK_DECL(idle_since);
 
     ABTI_xstream *p_xstream = p_local->p_xstream;
     ABTI_sched *p_sched = ABTI_sched_get_ptr(sched);
@@ -117,6 +118,7 @@ static void sched_run(ABT_sched sched)
                 break;
             }
         }
+        if (unit == ABT_UNIT_NULL) ABTI_xstream_perf_begin_idle(p_xstream);
         /* if we attempted event_freq pops, check for events */
         if (pop_count >= event_freq) {
             ABTI_xstream_check_events(p_xstream, sched);
@@ -124,6 +126,7 @@ static void sched_run(ABT_sched sched)
                 == ABT_TRUE)
                 break;
             SCHED_SLEEP(unit != ABT_UNIT_NULL, p_data->sleep_time);
+            SCHED_PARK(unit != ABT_UNIT_NULL, idle_since, p_sched, p_xstream);
             pop_count = 0;
         }
     }
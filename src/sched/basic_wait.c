@@ -9,6 +9,11 @@
  * This group is for the basic waiting scheudler.
  */
 
+/* When all of its pools are empty, the basic_wait scheduler parks its ES with
+ * ABTI_sched_park().  A push to any of the pools wakes the ES up. */
+
+#define SCHED_BASIC_WAIT_TIMEOUT    0.1     /* Default timeout (seconds) */
+
 static int  sched_init(ABT_sched sched, ABT_sched_config config);
 static void sched_run(ABT_sched sched);
 static int  sched_free(ABT_sched);
@@ -24,6 +29,7 @@ static ABT_sched_def sched_basic_wait_def = {
 
 typedef struct {
     uint32_t event_freq;
+    double timeout;         /* Max. time of each wait (seconds) */
     int num_pools;
     ABT_pool *pools;
 } sched_data;
@@ -33,6 +39,11 @@ ABT_sched_config_var ABT_sched_basic_wait_freq = {
     .type = ABT_SCHED_CONFIG_INT
 };
 
+ABT_sched_config_var ABT_sched_basic_wait_timeout = {
+    .idx = 1,
+    .type = ABT_SCHED_CONFIG_DOUBLE
+};
+
 ABT_sched_def *ABTI_sched_get_basic_wait_def(void)
 {
     return &sched_basic_wait_def;
@@ -54,10 +65,12 @@ static int sched_init(ABT_sched sched, ABT_sched_config config)
     /* Default settings */
     sched_data *p_data = (sched_data *)ABTU_malloc(sizeof(sched_data));
     p_data->event_freq = ABTI_global_get_sched_event_freq();
+    p_data->timeout = SCHED_BASIC_WAIT_TIMEOUT;
 
     /* Set the variables from the config */
-    void *p_event_freq = &p_data->event_freq;
-    ABTI_sched_config_read(config, 1, 1, &p_event_freq);
+    void *p_vars[2] = { &p_data->event_freq, &p_data->timeout };
+    ABTI_sched_config_read(config, 1, 2, p_vars);
+    if (p_data->timeout < 0.0) p_data->timeout = 0.0;
 
     /* Save the list of pools */
     num_pools = p_sched->num_pools;
@@ -87,6 +100,7 @@ static void sched_run(ABT_sched sched)
     uint32_t work_count = 0;
     sched_data *p_data;
     uint32_t event_freq;
+    uint64_t timeout_nsec;
     int num_pools;
     ABT_pool *pools;
     int i;
@@ -98,6 +112,7 @@ static void sched_run(ABT_sched sched)
 
     p_data = sched_data_get_ptr(p_sched->data);
     event_freq = p_data->event_freq;
+    timeout_nsec = (uint64_t)(p_data->timeout * 1.0e9);
     num_pools  = p_data->num_pools;
     pools      = p_data->pools;
 
@@ -117,26 +132,18 @@ static void sched_run(ABT_sched sched)
             }
         }
 
-        /* Block briefly on pop_timedwait() if we didn't find work to do in
-         * main loop above.
+        /* Block until any of the pools gets a work unit if we didn't find
+         * work to do in main loop above.
          */
-        if(!run_cnt_nowait) {
-            double abstime = ABTI_get_wtime();
-            abstime += 0.1;
-            ABT_unit unit = ABTI_pool_pop_timedwait(
-                ABTI_pool_get_ptr(pools[0]), abstime);
-            if (unit != ABT_UNIT_NULL) {
-                ABTI_xstream_run_unit(&p_local, p_xstream, unit,
-                    ABTI_pool_get_ptr(pools[0]));
-                break;
-            }
+        if (!run_cnt_nowait) {
+            ABTI_xstream_perf_begin_idle(p_xstream);
+            ABTI_sched_park(p_sched, p_xstream, timeout_nsec);
         }
 
         /* If run_cnt_nowait is zero, that means that no units were
-         * found in first pass through pools and we must have called
-         * pop_timedwait above. We should check events regardless of
-         * work_count in that case for them to be processed in a timely
-         * manner
+         * found in first pass through pools and we must have waited
+         * above. We should check events regardless of work_count in that
+         * case for them to be processed in a timely manner
          */
         if (!run_cnt_nowait || (++work_count >= event_freq)) {
             ABTI_xstream_check_events(p_xstream, sched);
@@ -48,6 +48,10 @@ ABT_sched_config_var ABT_sched_config_automatic = {
  *     unused (ABT_TRUE by default)
  *   - for the basic scheduler:
  *     - ABT_sched_basic_freq; to set the frequency on checking events
+ *   - for the basic_wait scheduler:
+ *     - ABT_sched_basic_wait_freq; to set the frequency on checking events
+ *     - ABT_sched_basic_wait_timeout; to set the maximum time (in seconds, as
+ *     a double) of each wait for work units (0.1 by default)
  *
  * If you want to write your own scheduler and use this function, you can find
  * a good example in the test called \c sched_config.
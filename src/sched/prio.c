@@ -77,6 +77,7 @@ static void sched_run(ABT_sched sched)
     ABT_pool *p_pools;
     int i;
     CNT_DECL(run_cnt);
+    PARK_DECL(idle_since);
 
     ABTI_xstream *p_xstream = p_local->p_xstream;
     ABTI_sched *p_sched = ABTI_sched_get_ptr(sched);
@@ -105,6 +106,7 @@ static void sched_run(ABT_sched sched)
                 break;
             }
         }
+        if (i == num_pools) ABTI_xstream_perf_begin_idle(p_xstream);
 
         if (++work_count >= event_freq) {
             ABT_bool stop = ABTI_sched_has_to_stop(&p_local, p_sched,
@@ -113,6 +115,7 @@ static void sched_run(ABT_sched sched)
             work_count = 0;
             ABTI_xstream_check_events(p_xstream, sched);
             SCHED_SLEEP(run_cnt, p_data->sleep_time);
+            SCHED_PARK(run_cnt, idle_since, p_sched, p_xstream);
         }
     }
 
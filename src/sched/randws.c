@@ -71,6 +71,7 @@ static void sched_run(ABT_sched sched)
     int target;
     unsigned seed = time(NULL);
     CNT_DECL(run_cnt);
+    PARK_DECL(idle_since);
 
     ABTI_xstream *p_xstream = p_local->p_xstream;
     ABTI_sched *p_sched = ABTI_sched_get_ptr(sched);
@@ -96,13 +97,20 @@ static void sched_run(ABT_sched sched)
             target = (num_pools == 2) ? 1 : (rand_r(&seed) % (num_pools-1) + 1);
             pool = p_pools[target];
             p_pool = ABTI_pool_get_ptr(pool);
-            unit = ABTI_pool_pop(p_pool);
-            LOG_EVENT_POOL_POP(p_pool, unit);
+            unit = ABTI_pool_pop_steal(p_pool);
             if (unit != ABT_UNIT_NULL) {
+                ABTI_XSTREAM_PERF_INC(p_xstream, num_steals);
+                ABTI_TRACE_XSTREAM(p_xstream, STEAL, unit,
+                                   (uint32_t)p_pool->id);
                 ABTI_unit_set_associated_pool(unit, p_pool);
                 ABTI_xstream_run_unit(&p_local, p_xstream, unit, p_pool);
                 CNT_INC(run_cnt);
+            } else {
+                ABTI_XSTREAM_PERF_INC(p_xstream, num_failed_steals);
+                ABTI_xstream_perf_begin_idle(p_xstream);
             }
+        } else {
+            ABTI_xstream_perf_begin_idle(p_xstream);
         }
 
         if (++work_count >= p_data->event_freq) {
@@ -112,6 +120,7 @@ static void sched_run(ABT_sched sched)
             work_count = 0;
             ABTI_xstream_check_events(p_xstream, sched);
             SCHED_SLEEP(run_cnt, p_data->sleep_time);
+            SCHED_PARK(run_cnt, idle_since, p_sched, p_xstream);
         }
     }
 
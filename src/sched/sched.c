@@ -506,7 +506,9 @@ size_t ABTI_sched_get_total_size(ABTI_sched *p_sched)
  * not count the number of blocked ULTs if a pool has more than one consumer or
  * the caller ES is not the latest consumer. This is necessary when the ES
  * associated with the target scheduler has to be joined and the pool is shared
- * between different schedulers associated with different ESs. */
+ * between different schedulers associated with different ESs.
+ * Instead, the timers pending on the caller ES are counted for its main
+ * scheduler because only that ES can wake up the ULTs sleeping on them. */
 size_t ABTI_sched_get_effective_size(ABTI_local *p_local, ABTI_sched *p_sched)
 {
     size_t pool_size = 0;
@@ -543,6 +545,13 @@ size_t ABTI_sched_get_effective_size(ABTI_local *p_local, ABTI_sched *p_sched)
         }
     }
 
+    if (p_local && p_local->p_xstream &&
+        p_local->p_xstream->p_main_sched == p_sched &&
+        p_local->p_xstream->p_twheel) {
+        pool_size += ABTD_atomic_load_uint32(
+            &p_local->p_xstream->p_twheel->num_entries);
+    }
+
     return pool_size;
 }
 
@@ -592,6 +601,15 @@ int ABTI_sched_create(ABT_sched_def *def, int num_pools, ABT_pool *pools,
         ABTI_pool_retain(ABTI_pool_get_ptr(pool_list[p]));
     }
 
+    /* Pushers wake up parked ESs only in pools whose park_enabled is set.
+     * It is set before the scheduler runs and is never cleared. */
+    if (ABTI_sched_may_park(def)) {
+        for (p = 0; p < num_pools; p++) {
+            ABTI_pool *p_pool = ABTI_pool_get_ptr(pool_list[p]);
+            ABTD_atomic_store_uint32(&p_pool->park_enabled, 1);
+        }
+    }
+
     p_sched->used          = ABTI_SCHED_NOT_USED;
     p_sched->automatic     = automatic;
     p_sched->kind          = ABTI_sched_get_kind(def);
@@ -671,26 +689,27 @@ int ABTI_sched_create_basic(ABT_sched_predef predef, int num_pools,
             case ABT_SCHED_BASIC:
                 abt_errno = ABTI_sched_create(ABTI_sched_get_basic_def(),
                                               num_pools, pool_list,
-                                              ABT_SCHED_CONFIG_NULL,
-                                              automatic, pp_newsched);
+                                              config, automatic, pp_newsched);
                 break;
             case ABT_SCHED_BASIC_WAIT:
                 abt_errno = ABTI_sched_create(ABTI_sched_get_basic_wait_def(),
                                               num_pools, pool_list,
-                                              ABT_SCHED_CONFIG_NULL,
-                                              automatic, pp_newsched);
+                                              config, automatic, pp_newsched);
                 break;
             case ABT_SCHED_PRIO:
                 abt_errno = ABTI_sched_create(ABTI_sched_get_prio_def(),
                                               num_pools, pool_list,
-                                              ABT_SCHED_CONFIG_NULL,
-                                              automatic, pp_newsched);
+                                              config, automatic, pp_newsched);
                 break;
             case ABT_SCHED_RANDWS:
                 abt_errno = ABTI_sched_create(ABTI_sched_get_randws_def(),
                                               num_pools, pool_list,
-                                              ABT_SCHED_CONFIG_NULL,
-                                              automatic, pp_newsched);
+                                              config, automatic, pp_newsched);
+                break;
+            case ABT_SCHED_TOPOWS:
+                abt_errno = ABTI_sched_create(ABTI_sched_get_topows_def(),
+                                              num_pools, pool_list,
+                                              config, automatic, pp_newsched);
                 break;
             default:
                 abt_errno = ABT_ERR_INV_SCHED_PREDEF;
@@ -717,6 +736,7 @@ int ABTI_sched_create_basic(ABT_sched_predef predef, int num_pools,
                 num_pools = ABTI_SCHED_NUM_PRIO;
                 break;
             case ABT_SCHED_RANDWS:
+            case ABT_SCHED_TOPOWS:
                 num_pools = 1;
                 break;
             default:
@@ -760,6 +780,11 @@ int ABTI_sched_create_basic(ABT_sched_predef predef, int num_pools,
                                               num_pools, pool_list,
                                               config, automatic, pp_newsched);
                 break;
+            case ABT_SCHED_TOPOWS:
+                abt_errno = ABTI_sched_create(ABTI_sched_get_topows_def(),
+                                              num_pools, pool_list,
+                                              config, automatic, pp_newsched);
+                break;
             default:
                 abt_errno = ABT_ERR_INV_SCHED_PREDEF;
                 ABTI_CHECK_ERROR(abt_errno);
@@ -873,6 +898,22 @@ ABTI_sched_kind ABTI_sched_get_kind(ABT_sched_def *def)
   return (ABTI_sched_kind)def;
 }
 
+/* Return ABT_TRUE if a scheduler of def may park its ES with
+ * ABTI_sched_park().  User-defined schedulers never park. */
+ABT_bool ABTI_sched_may_park(ABT_sched_def *def)
+{
+    if (def == ABTI_sched_get_basic_wait_def()) return ABT_TRUE;
+#ifdef ABT_CONFIG_USE_SCHED_PARK
+    if (def == ABTI_sched_get_basic_def() ||
+        def == ABTI_sched_get_prio_def() ||
+        def == ABTI_sched_get_randws_def() ||
+        def == ABTI_sched_get_topows_def()) {
+        return ABT_TRUE;
+    }
+#endif
+    return ABT_FALSE;
+}
+
 void ABTI_sched_print(ABTI_sched *p_sched, FILE *p_os, int indent,
                       ABT_bool print_sub)
 {
@@ -983,6 +1024,105 @@ void ABTI_sched_reset_id(void)
     g_sched_id = 0;
 }
 
+/* Park p_xstream, which is running p_sched, until a work unit is pushed to
+ * one of the pools of p_sched, a request is set to p_xstream, or timeout_nsec
+ * nanoseconds pass.  The ES registers itself in every pool so that the pusher
+ * can wake it up, and checks the pools again before blocking to avoid missing
+ * units pushed in the meantime.  The timeout is shortened so that the ES wakes
+ * up when the next timer of p_xstream expires. */
+void ABTI_sched_park(ABTI_sched *p_sched, ABTI_xstream *p_xstream,
+                     uint64_t timeout_nsec)
+{
+    int i, num_pools = p_sched->num_pools;
+    ABTI_park_link *p_links;
+
+    if (num_pools > p_xstream->num_park_links) {
+        if (p_xstream->p_park_links) ABTU_free(p_xstream->p_park_links);
+        p_xstream->p_park_links = (ABTI_park_link *)ABTU_malloc(
+                                      num_pools * sizeof(ABTI_park_link));
+        p_xstream->num_park_links = num_pools;
+    }
+    p_links = p_xstream->p_park_links;
+
+    /* Wake up in time for the next timer of this ES */
+    if (p_xstream->p_twheel &&
+        ABTD_atomic_load_uint32(&p_xstream->p_twheel->num_entries) > 0) {
+        uint64_t next = ABTI_twheel_get_next_nsec(p_xstream->p_twheel);
+        uint64_t now = ABTI_get_wtime_nsec();
+        if (next <= now) return;
+        if (next - now < timeout_nsec) timeout_nsec = next - now;
+    }
+
+    ABTD_atomic_store_uint32(&p_xstream->park_state, 1);
+
+    /* Register this ES in the pools */
+    for (i = 0; i < num_pools; i++) {
+        ABTI_pool *p_pool = ABTI_pool_get_ptr(p_sched->pools[i]);
+        ABTI_park_link *p_link = &p_links[i];
+        p_link->p_xstream = p_xstream;
+        p_link->p_sched = p_sched;
+        p_link->p_prev = NULL;
+        ABTI_spinlock_acquire(&p_pool->park_lock);
+        p_link->p_next = p_pool->p_parked;
+        if (p_pool->p_parked) p_pool->p_parked->p_prev = p_link;
+        p_pool->p_parked = p_link;
+        ABTD_atomic_fetch_add_uint32(&p_pool->num_parked, 1);
+        ABTI_spinlock_release(&p_pool->park_lock);
+    }
+
+    /* Pairs with the barrier in ABTI_pool_wake_parked(). */
+    ABTD_atomic_full_barrier();
+
+    if (ABTD_atomic_load_uint32(&p_xstream->request) == 0 &&
+        ABTD_atomic_load_uint32(&p_sched->request) == 0 &&
+        ABTI_sched_has_unit(p_sched) == ABT_FALSE) {
+        LOG_EVENT("[E%d] parked\n", p_xstream->rank);
+        ABTD_futex_wait(&p_xstream->park_state, 1, timeout_nsec);
+        LOG_EVENT("[E%d] unparked\n", p_xstream->rank);
+    }
+
+    ABTD_atomic_store_uint32(&p_xstream->park_state, 0);
+
+    /* Deregister this ES */
+    for (i = 0; i < num_pools; i++) {
+        ABTI_pool *p_pool = ABTI_pool_get_ptr(p_sched->pools[i]);
+        ABTI_park_link *p_link = &p_links[i];
+        ABTI_spinlock_acquire(&p_pool->park_lock);
+        if (p_link->p_prev) {
+            p_link->p_prev->p_next = p_link->p_next;
+        } else {
+            p_pool->p_parked = p_link->p_next;
+        }
+        if (p_link->p_next) p_link->p_next->p_prev = p_link->p_prev;
+        ABTD_atomic_fetch_sub_uint32(&p_pool->num_parked, 1);
+        ABTI_spinlock_release(&p_pool->park_lock);
+    }
+}
+
+/* Wake up the ES parked in p_sched, if any.  A parked ES is registered in
+ * every pool of its scheduler, so it is found in the first pool.  The caller
+ * has set a request to p_sched before, which pairs with the barrier in
+ * ABTI_sched_park(). */
+void ABTI_sched_unpark(ABTI_sched *p_sched)
+{
+    ABTI_pool *p_pool;
+    ABTI_park_link *p_link;
+
+    if (p_sched->num_pools == 0) return;
+    p_pool = ABTI_pool_get_ptr(p_sched->pools[0]);
+    if (ABTD_atomic_load_uint32(&p_pool->park_enabled) == 0) return;
+    ABTD_atomic_full_barrier();
+    if (ABTD_atomic_load_uint32(&p_pool->num_parked) == 0) return;
+
+    ABTI_spinlock_acquire(&p_pool->park_lock);
+    for (p_link = p_pool->p_parked; p_link != NULL; p_link = p_link->p_next) {
+        if (p_link->p_sched == p_sched) {
+            ABTI_xstream_unpark(p_link->p_xstream);
+        }
+    }
+    ABTI_spinlock_release(&p_pool->park_lock);
+}
+
 /*****************************************************************************/
 /* Internal static functions                                                 */
 /*****************************************************************************/
@@ -0,0 +1,256 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+/* Topology-aware Work-stealing Scheduler Implementation
+ *
+ * The first pool is the scheduler's own pool and the others are victims.
+ * Each scheduler publishes the CPU of its ES as the home CPU of its own pool,
+ * and victims are grouped by the distance between the home CPUs (same core,
+ * same last-level cache, same NUMA node, and the others).  An idle scheduler
+ * tries one random victim per group, nearest first.  When a victim has more
+ * units, up to half of them are moved to the own pool at once. */
+
+static int  sched_init(ABT_sched sched, ABT_sched_config config);
+static void sched_run(ABT_sched sched);
+static int  sched_free(ABT_sched);
+
+static ABT_sched_def sched_topows_def = {
+    .type = ABT_SCHED_TYPE_TASK,
+    .init = sched_init,
+    .run = sched_run,
+    .free = sched_free,
+    .get_migr_pool = NULL,
+};
+
+typedef struct {
+    uint32_t event_freq;
+#ifdef ABT_CONFIG_USE_SCHED_SLEEP
+    struct timespec sleep_time;
+#endif
+    int cpu;                /* CPU of the ES running this scheduler */
+    ABT_bool topo_known;    /* Whether the home CPUs of all victims are known */
+    uint32_t update_interval; /* Event checks between updates of victims */
+    uint32_t update_count;
+    int *p_victims;         /* Victim pool indices sorted by distance */
+    int level_start[ABTD_AFFINITY_NUM_DISTS + 1];
+} sched_data;
+
+ABT_sched_def *ABTI_sched_get_topows_def(void)
+{
+    return &sched_topows_def;
+}
+
+static int sched_init(ABT_sched sched, ABT_sched_config config)
+{
+    int abt_errno = ABT_SUCCESS;
+
+    ABTI_sched *p_sched = ABTI_sched_get_ptr(sched);
+    ABTI_CHECK_NULL_SCHED_PTR(p_sched);
+
+    /* Default settings */
+    sched_data *p_data = (sched_data *)ABTU_malloc(sizeof(sched_data));
+    p_data->event_freq = ABTI_global_get_sched_event_freq();
+#ifdef ABT_CONFIG_USE_SCHED_SLEEP
+    p_data->sleep_time.tv_sec = 0;
+    p_data->sleep_time.tv_nsec = ABTI_global_get_sched_sleep_nsec();
+#endif
+    p_data->cpu = -1;
+    p_data->topo_known = ABT_FALSE;
+    p_data->update_interval = 1;
+    p_data->update_count = 0;
+    p_data->p_victims = (int *)ABTU_malloc(sizeof(int) * p_sched->num_pools);
+    memset(p_data->level_start, 0, sizeof(p_data->level_start));
+
+    /* Set the variables from the config */
+    void *p_event_freq = &p_data->event_freq;
+    ABTI_sched_config_read(config, 1, 1, &p_event_freq);
+
+    p_sched->data = p_data;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_WITH_CODE("topows: sched_init", abt_errno);
+    goto fn_exit;
+}
+
+/* Publish the CPU of the running ES and sort the victims by distance. */
+static void sched_update_victims(sched_data *p_data, int num_pools,
+                                 ABT_pool *p_pools)
+{
+    int num_victims[ABTD_AFFINITY_NUM_DISTS] = { 0 };
+    int *p_dists = (int *)ABTU_malloc(sizeof(int) * num_pools);
+    ABTI_pool *p_own_pool = ABTI_pool_get_ptr(p_pools[0]);
+    int i, level, cpu;
+
+    cpu = ABTD_affinity_get_self_cpu();
+    p_data->cpu = cpu;
+    ABTD_atomic_store_int32(&p_own_pool->home_cpu, cpu);
+
+    p_data->topo_known = (cpu >= 0) ? ABT_TRUE : ABT_FALSE;
+    for (i = 1; i < num_pools; i++) {
+        ABTI_pool *p_pool = ABTI_pool_get_ptr(p_pools[i]);
+        int home_cpu = ABTD_atomic_load_int32(&p_pool->home_cpu);
+        if (p_pool == p_own_pool) {
+            p_dists[i] = -1;
+            continue;
+        }
+        if (home_cpu < 0) p_data->topo_known = ABT_FALSE;
+        p_dists[i] = (cpu >= 0 && home_cpu >= 0)
+                   ? ABTD_affinity_get_distance(cpu, home_cpu)
+                   : ABTD_AFFINITY_DIST_REMOTE;
+        num_victims[p_dists[i]]++;
+    }
+
+    p_data->level_start[0] = 0;
+    for (level = 0; level < ABTD_AFFINITY_NUM_DISTS; level++) {
+        p_data->level_start[level + 1] = p_data->level_start[level]
+                                       + num_victims[level];
+        num_victims[level] = p_data->level_start[level];
+    }
+    for (i = 1; i < num_pools; i++) {
+        if (p_dists[i] < 0) continue;
+        p_data->p_victims[num_victims[p_dists[i]]++] = i;
+    }
+
+    ABTU_free(p_dists);
+}
+
+/* Move up to half of the units of p_victim to p_own_pool, after the first unit
+ * has been stolen. */
+static int sched_steal_half(ABTI_local *p_local, ABTI_pool *p_victim,
+                            ABTI_pool *p_own_pool)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABT_unit units[ABTI_POOL_PUSH_BATCH];
+    size_t num_units = 0, max_units;
+
+    /* The own pool must accept units pushed by this ES while other ESs steal
+     * from it. */
+    if (p_own_pool->access != ABT_POOL_ACCESS_MPSC &&
+        p_own_pool->access != ABT_POOL_ACCESS_MPMC) {
+        goto fn_exit;
+    }
+
+    max_units = ABTI_pool_get_size(p_victim) / 2;
+    if (max_units > ABTI_POOL_PUSH_BATCH) max_units = ABTI_POOL_PUSH_BATCH;
+    while (num_units < max_units) {
+        ABT_unit unit = ABTI_pool_pop_steal(p_victim);
+        if (unit == ABT_UNIT_NULL) break;
+        units[num_units++] = ABTI_unit_move_to_pool(p_victim, unit, p_own_pool);
+    }
+    if (num_units > 0) {
+        ABTI_POOL_PUSH_MANY(p_own_pool, units, num_units,
+                            ABTI_self_get_native_thread_id(p_local));
+    }
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_WITH_CODE("topows: sched_steal_half", abt_errno);
+    goto fn_exit;
+}
+
+static void sched_run(ABT_sched sched)
+{
+    ABTI_local *p_local = ABTI_local_get_local();
+    uint32_t work_count = 0;
+    sched_data *p_data;
+    int num_pools;
+    ABT_pool *p_pools;
+    ABT_unit unit;
+    int level, num_victims, target;
+    unsigned seed = time(NULL);
+    CNT_DECL(run_cnt);
+    PARK_DECL(idle_since);
+
+    ABTI_xstream *p_xstream = p_local->p_xstream;
+    ABTI_sched *p_sched = ABTI_sched_get_ptr(sched);
+    ABTI_ASSERT(p_sched);
+
+    p_data = (sched_data *)p_sched->data;
+    num_pools = p_sched->num_pools;
+    p_pools = (ABT_pool *)ABTU_malloc(num_pools * sizeof(ABT_pool));
+    memcpy(p_pools, p_sched->pools, sizeof(ABT_pool) * num_pools);
+    ABTI_pool *p_own_pool = ABTI_pool_get_ptr(p_pools[0]);
+
+    sched_update_victims(p_data, num_pools, p_pools);
+
+    while (1) {
+        CNT_INIT(run_cnt, 0);
+
+        /* Execute one work unit from the scheduler's pool */
+        unit = ABTI_pool_pop(p_own_pool);
+        if (unit != ABT_UNIT_NULL) {
+            ABTI_xstream_run_unit(&p_local, p_xstream, unit, p_own_pool);
+            CNT_INC(run_cnt);
+        } else {
+            /* Steal work units from the nearest victims first */
+            for (level = 0; level < ABTD_AFFINITY_NUM_DISTS; level++) {
+                num_victims = p_data->level_start[level + 1]
+                            - p_data->level_start[level];
+                if (num_victims == 0) continue;
+
+                target = p_data->level_start[level];
+                if (num_victims > 1) target += rand_r(&seed) % num_victims;
+                ABTI_pool *p_pool =
+                    ABTI_pool_get_ptr(p_pools[p_data->p_victims[target]]);
+                unit = ABTI_pool_pop_steal(p_pool);
+                if (unit == ABT_UNIT_NULL) {
+                    ABTI_XSTREAM_PERF_INC(p_xstream, num_failed_steals);
+                } else {
+                    ABTI_XSTREAM_PERF_INC(p_xstream, num_steals);
+                    ABTI_TRACE_XSTREAM(p_xstream, STEAL, unit,
+                                       (uint32_t)p_pool->id);
+                    sched_steal_half(p_local, p_pool, p_own_pool);
+                    ABTI_unit_set_associated_pool(unit, p_pool);
+                    ABTI_xstream_run_unit(&p_local, p_xstream, unit, p_pool);
+                    CNT_INC(run_cnt);
+                    break;
+                }
+            }
+            if (unit == ABT_UNIT_NULL) ABTI_xstream_perf_begin_idle(p_xstream);
+        }
+
+        if (++work_count >= p_data->event_freq) {
+            ABT_bool stop = ABTI_sched_has_to_stop(&p_local, p_sched,
+                                                   p_xstream);
+            if (stop == ABT_TRUE) break;
+            work_count = 0;
+            ABTI_xstream_check_events(p_xstream, sched);
+            /* Victims may publish their home CPUs later.  Pools that are not
+             * owned by this kind of scheduler never do, so the interval
+             * between updates is doubled each time. */
+            if (p_data->topo_known == ABT_FALSE &&
+                ++p_data->update_count >= p_data->update_interval) {
+                sched_update_victims(p_data, num_pools, p_pools);
+                p_data->update_count = 0;
+                if (p_data->update_interval < 1024) {
+                    p_data->update_interval *= 2;
+                }
+            }
+            SCHED_SLEEP(run_cnt, p_data->sleep_time);
+            SCHED_PARK(run_cnt, idle_since, p_sched, p_xstream);
+        }
+    }
+
+    ABTU_free(p_pools);
+}
+
+static int sched_free(ABT_sched sched)
+{
+    ABTI_sched *p_sched = ABTI_sched_get_ptr(sched);
+    ABTI_ASSERT(p_sched);
+
+    sched_data *p_data = (sched_data *)p_sched->data;
+    ABTU_free(p_data->p_victims);
+    ABTU_free(p_data);
+
+    return ABT_SUCCESS;
+}
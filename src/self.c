@@ -93,7 +93,8 @@ int ABT_self_is_primary(ABT_bool *flag)
     }
 #endif
 
-    p_thread = p_local->p_thread;
+    /* A tasklet running on a lent stack is not a ULT. */
+    p_thread = p_local->p_task ? NULL : p_local->p_thread;
     if (p_thread) {
         *flag = (p_thread->type == ABTI_THREAD_TYPE_MAIN)
               ? ABT_TRUE : ABT_FALSE;
@@ -199,12 +200,13 @@ int ABT_self_get_last_pool_id(int *pool_id)
     }
 #endif
 
-    if ((p_thread = p_local->p_thread)) {
-        ABTI_ASSERT(p_thread->p_pool);
-        *pool_id = (int)(p_thread->p_pool->id);
-    } else if ((p_task = p_local->p_task)) {
+    /* A tasklet running on a lent stack also has p_thread. */
+    if ((p_task = p_local->p_task)) {
         ABTI_ASSERT(p_task->p_pool);
         *pool_id = (int)(p_task->p_pool->id);
+    } else if ((p_thread = p_local->p_thread)) {
+        ABTI_ASSERT(p_thread->p_pool);
+        *pool_id = (int)(p_thread->p_pool->id);
     } else {
         abt_errno = ABT_ERR_OTHER;
         *pool_id = -1;
@@ -292,10 +294,11 @@ int ABT_self_set_arg(void *arg)
         goto fn_exit;
     }
 
-    if ((p_thread = p_local->p_thread)) {
-        ABTD_thread_context_set_arg(&p_thread->ctx, arg);
-    } else if ((p_task = p_local->p_task)) {
+    /* A tasklet running on a lent stack also has p_thread. */
+    if ((p_task = p_local->p_task)) {
         p_task->p_arg = arg;
+    } else if ((p_thread = p_local->p_thread)) {
+        ABTD_thread_context_set_arg(&p_thread->ctx, arg);
     } else {
         abt_errno = ABT_ERR_OTHER;
         goto fn_fail;
@@ -346,10 +349,11 @@ int ABT_self_get_arg(void **arg)
     }
 #endif
 
-    if ((p_thread = p_local->p_thread)) {
-        *arg = ABTD_thread_context_get_arg(&p_thread->ctx);
-    } else if ((p_task = p_local->p_task)) {
+    /* A tasklet running on a lent stack also has p_thread. */
+    if ((p_task = p_local->p_task)) {
         *arg = p_task->p_arg;
+    } else if ((p_thread = p_local->p_thread)) {
+        *arg = ABTD_thread_context_get_arg(&p_thread->ctx);
     } else {
         *arg = NULL;
         abt_errno = ABT_ERR_OTHER;
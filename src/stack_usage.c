@@ -0,0 +1,192 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+/* Stack usage watermarking.  The stack of a ULT is filled with a pattern when
+ * the ULT is created, and the lowest address whose pattern has been
+ * overwritten is searched when the ULT terminates.  The results are
+ * aggregated by the ULT function.  When adaptive stack sizing is enabled, a
+ * ULT of a function that has enough samples gets the smallest stack size class
+ * that covers the given percentile of them. */
+
+#define ABTI_STACK_USAGE_PATTERN        0xa5
+#define ABTI_STACK_USAGE_PATTERN_WORD   0xa5a5a5a5a5a5a5a5ULL
+
+static inline uint32_t ABTI_stack_usage_hash(void (*f_thread)(void *))
+{
+    uintptr_t val = (uintptr_t)f_thread;
+    val ^= val >> 17;
+    val ^= val >> 7;
+    return (uint32_t)(val & (ABTI_STACK_USAGE_TABLE_SIZE - 1));
+}
+
+static inline ABTI_stack_usage *ABTI_stack_usage_find(void (*f_thread)(void *))
+{
+    uint32_t h = ABTI_stack_usage_hash(f_thread);
+    ABTI_stack_usage *p_usage = (ABTI_stack_usage *)ABTD_atomic_load_ptr(
+                                    (void **)&gp_ABTI_global->p_stack_usages[h]);
+    while (p_usage) {
+        if (p_usage->f_thread == f_thread) break;
+        p_usage = p_usage->p_next;
+    }
+    return p_usage;
+}
+
+/* Return ABT_TRUE if the stack of p_thread is owned by p_thread.  Stacks given
+ * by the user or shared by stack-copying ULTs are not measured. */
+static inline ABT_bool ABTI_stack_usage_has_own_stack(ABTI_thread *p_thread)
+{
+    return (p_thread->attr.stacktype == ABTI_STACK_TYPE_MEMPOOL ||
+            p_thread->attr.stacktype == ABTI_STACK_TYPE_MALLOC)
+           ? ABT_TRUE : ABT_FALSE;
+}
+
+void ABTI_stack_usage_init(ABTI_global *p_global)
+{
+    ABTI_spinlock_clear(&p_global->stack_usage_lock);
+    p_global->p_stack_usages = NULL;
+    if (p_global->stack_watermark == ABT_TRUE) {
+        p_global->p_stack_usages = (ABTI_stack_usage **)ABTU_calloc(
+            ABTI_STACK_USAGE_TABLE_SIZE, sizeof(ABTI_stack_usage *));
+    }
+}
+
+void ABTI_stack_usage_finalize(ABTI_global *p_global)
+{
+    uint32_t i;
+    ABTI_stack_usage *p_usage, *p_next;
+
+    if (p_global->p_stack_usages == NULL) return;
+    for (i = 0; i < ABTI_STACK_USAGE_TABLE_SIZE; i++) {
+        for (p_usage = p_global->p_stack_usages[i]; p_usage; p_usage = p_next) {
+            p_next = p_usage->p_next;
+            ABTU_free(p_usage);
+        }
+    }
+    ABTU_free(p_global->p_stack_usages);
+    p_global->p_stack_usages = NULL;
+}
+
+/* Fill the stack of a user ULT p_thread with the pattern.  It must be called
+ * before the context of p_thread is created on the stack. */
+void ABTI_stack_usage_fill(ABTI_thread *p_thread)
+{
+    if (ABTI_stack_usage_has_own_stack(p_thread) == ABT_FALSE) return;
+    memset(p_thread->attr.p_stack, ABTI_STACK_USAGE_PATTERN,
+           p_thread->attr.stacksize);
+}
+
+/* Measure how deep the stack of a terminating user ULT p_thread has been used
+ * and record it for the function of p_thread.  It may be called on the stack
+ * of p_thread. */
+void ABTI_stack_usage_record(ABTI_thread *p_thread)
+{
+    ABTI_global *p_global = gp_ABTI_global;
+    void (*f_thread)(void *) = p_thread->ctx.f_thread;
+    char *p_stack, *p_stacktop;
+    uint64_t *p_word;
+    size_t usage;
+
+    if (ABTI_stack_usage_has_own_stack(p_thread) == ABT_FALSE) return;
+    if (f_thread == NULL) return;
+
+    /* The stack grows downward, so the first word that does not keep the
+     * pattern from the bottom is the deepest point. */
+    p_stack = (char *)p_thread->attr.p_stack;
+    p_stacktop = p_stack + p_thread->attr.stacksize;
+    p_word = (uint64_t *)(((uintptr_t)p_stack + 7) & ~(uintptr_t)7);
+    while ((char *)(p_word + 1) <= p_stacktop &&
+           *p_word == ABTI_STACK_USAGE_PATTERN_WORD) {
+        p_word++;
+    }
+    usage = ((char *)p_word < p_stacktop) ? p_stacktop - (char *)p_word : 0;
+
+    ABTI_spinlock_acquire(&p_global->stack_usage_lock);
+    ABTI_stack_usage *p_usage = ABTI_stack_usage_find(f_thread);
+    if (p_usage == NULL) {
+        uint32_t h = ABTI_stack_usage_hash(f_thread);
+        p_usage = (ABTI_stack_usage *)ABTU_calloc(1, sizeof(ABTI_stack_usage));
+        p_usage->f_thread = f_thread;
+        p_usage->p_next = p_global->p_stack_usages[h];
+        /* ABTI_stack_usage_get_stacksize reads the list without the lock. */
+        ABTD_atomic_store_ptr((void **)&p_global->p_stack_usages[h],
+                              (void *)p_usage);
+    }
+    p_usage->num_samples++;
+    p_usage->total_usage += usage;
+    if (usage > p_usage->max_usage) p_usage->max_usage = usage;
+
+#ifdef ABT_CONFIG_USE_MEM_POOL
+    /* Count the sample for the smallest size class whose usable stack is not
+     * smaller than the usage.  The last counter is for larger usages. */
+    uint32_t i, num_classes = p_global->mem_num_stack_classes;
+    size_t overhead = ABTI_MEM_SH_SIZE + ((p_global->mem_stack_guard == ABT_TRUE)
+                      ? 2 * p_global->os_page_size : 0);
+    for (i = 0; i < num_classes; i++) {
+        if (usage + overhead <= p_global->mem_stack_classes[i]) break;
+    }
+    p_usage->num_class_samples[i]++;
+
+    if (p_global->stack_adaptive == ABT_TRUE &&
+        p_usage->num_samples >= p_global->stack_adaptive_samples) {
+        uint64_t target = (p_usage->num_samples
+                           * p_global->stack_adaptive_pct + 99) / 100;
+        uint64_t count = 0;
+        uint64_t stacksize = 0;
+        for (i = 0; i < num_classes; i++) {
+            count += p_usage->num_class_samples[i];
+            if (count >= target) {
+                stacksize = (uint64_t)p_global->mem_stack_classes[i];
+                break;
+            }
+        }
+        ABTD_atomic_store_uint64(&p_usage->stacksize, stacksize);
+    }
+#endif
+    ABTI_spinlock_release(&p_global->stack_usage_lock);
+}
+
+/* Return the stack size chosen for ULTs running f_thread, or 0 if it has not
+ * been chosen yet. */
+size_t ABTI_stack_usage_get_stacksize(void (*f_thread)(void *))
+{
+#ifdef ABT_CONFIG_USE_MEM_POOL
+    ABTI_stack_usage *p_usage = ABTI_stack_usage_find(f_thread);
+    if (p_usage == NULL) return 0;
+    return (size_t)ABTD_atomic_load_uint64(&p_usage->stacksize);
+#else
+    ABTI_UNUSED(f_thread);
+    return 0;
+#endif
+}
+
+void ABTI_stack_usage_print(FILE *fp)
+{
+    ABTI_global *p_global = gp_ABTI_global;
+    ABTI_stack_usage *p_usage;
+    uint32_t i;
+
+    ABTI_spinlock_acquire(&p_global->stack_usage_lock);
+    fprintf(fp, "Stack usage of ULT functions:\n");
+    for (i = 0; i < ABTI_STACK_USAGE_TABLE_SIZE; i++) {
+        for (p_usage = p_global->p_stack_usages[i]; p_usage;
+             p_usage = p_usage->p_next) {
+            fprintf(fp, " - %p: samples=%" PRIu64 " max=%zu avg=%" PRIu64,
+                    (void *)(uintptr_t)p_usage->f_thread,
+                    p_usage->num_samples, p_usage->max_usage,
+                    p_usage->total_usage / p_usage->num_samples);
+#ifdef ABT_CONFIG_USE_MEM_POOL
+            if (p_global->stack_adaptive == ABT_TRUE) {
+                fprintf(fp, " stacksize=%" PRIu64,
+                        ABTD_atomic_load_uint64(&p_usage->stacksize));
+            }
+#endif
+            fprintf(fp, "\n");
+        }
+    }
+    fflush(fp);
+    ABTI_spinlock_release(&p_global->stack_usage_lock);
+}
@@ -79,6 +79,17 @@ int ABTI_xstream_create(ABTI_local **pp_local, ABTI_sched *p_sched,
     p_newxstream->request      = 0;
     p_newxstream->p_req_arg    = NULL;
     p_newxstream->p_main_sched = NULL;
+    p_newxstream->park_state     = 0;
+    p_newxstream->p_park_links   = NULL;
+    p_newxstream->num_park_links = 0;
+    p_newxstream->p_twheel       = NULL;
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+    p_newxstream->p_perf = (ABTI_xstream_perf *)
+        ABTU_calloc(1, sizeof(ABTI_xstream_perf));
+#endif
+#ifdef ABT_CONFIG_USE_TRACE
+    ABTI_trace_xstream_init(p_newxstream);
+#endif
 
     /* Initialize the spinlock */
     ABTI_spinlock_clear(&p_newxstream->sched_lock);
@@ -223,6 +234,17 @@ int ABT_xstream_create_with_rank(ABT_sched sched, int rank,
     p_newxstream->request      = 0;
     p_newxstream->p_req_arg    = NULL;
     p_newxstream->p_main_sched = NULL;
+    p_newxstream->park_state     = 0;
+    p_newxstream->p_park_links   = NULL;
+    p_newxstream->num_park_links = 0;
+    p_newxstream->p_twheel       = NULL;
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+    p_newxstream->p_perf = (ABTI_xstream_perf *)
+        ABTU_calloc(1, sizeof(ABTI_xstream_perf));
+#endif
+#ifdef ABT_CONFIG_USE_TRACE
+    ABTI_trace_xstream_init(p_newxstream);
+#endif
 
     /* Initialize the spinlock */
     ABTI_spinlock_clear(&p_newxstream->sched_lock);
@@ -494,7 +516,7 @@ int ABT_xstream_exit(void)
     /* Wait until the ES terminates */
     do {
 #ifndef ABT_CONFIG_DISABLE_EXT_THREAD
-        if (ABTI_self_get_type(p_local) != ABT_UNIT_TYPE_THREAD) {
+        if (ABTI_self_get_suspend_type(p_local) != ABT_UNIT_TYPE_THREAD) {
             ABTD_atomic_pause();
             continue;
         }
@@ -1018,9 +1040,12 @@ int ABTI_xstream_run_unit(ABTI_local **pp_local, ABTI_xstream *p_xstream,
 
     ABT_unit_type type = p_pool->u_get_type(unit);
 
+    ABTI_xstream_perf_end_idle(p_xstream);
+
     if (type == ABT_UNIT_TYPE_THREAD) {
         ABT_thread thread = p_pool->u_get_thread(unit);
         ABTI_thread *p_thread = ABTI_thread_get_ptr(thread);
+        ABTI_XSTREAM_PERF_INC(p_xstream, num_threads);
         /* Switch the context */
         abt_errno = ABTI_xstream_schedule_thread(pp_local, p_xstream, p_thread);
         ABTI_CHECK_ERROR(abt_errno);
@@ -1028,8 +1053,19 @@ int ABTI_xstream_run_unit(ABTI_local **pp_local, ABTI_xstream *p_xstream,
     } else if (type == ABT_UNIT_TYPE_TASK) {
         ABT_task task = p_pool->u_get_task(unit);
         ABTI_task *p_task = ABTI_task_get_ptr(task);
-        /* Execute the task */
-        ABTI_xstream_schedule_task(*pp_local, p_xstream, p_task);
+        ABTI_XSTREAM_PERF_INC(p_xstream, num_tasks);
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
+        if (ABTI_task_is_blockable(p_task) == ABT_TRUE) {
+            /* Execute the task on a lent stack */
+            abt_errno = ABTI_xstream_schedule_task_on_stack(pp_local,
+                                                            p_xstream, p_task);
+            ABTI_CHECK_ERROR(abt_errno);
+        } else
+#endif
+        {
+            /* Execute the task */
+            ABTI_xstream_schedule_task(*pp_local, p_xstream, p_task);
+        }
 
     } else {
         HANDLE_ERROR("Not supported type!");
@@ -1093,6 +1129,16 @@ int ABTI_xstream_check_events(ABTI_xstream *p_xstream, ABT_sched sched)
 
     ABTI_info_check_print_all_thread_stacks();
 
+    /* Wake up the ULTs whose timeouts have passed */
+    ABTI_twheel *p_twheel = p_xstream->p_twheel;
+    if (p_twheel && ABTD_atomic_load_uint32(&p_twheel->num_entries) > 0) {
+        ABTI_twheel_advance(ABTI_local_get_local(), p_twheel,
+                            ABTI_get_wtime_nsec());
+    }
+
+    /* Release the memory of unused stacks */
+    ABTI_mem_check_trim(ABTI_local_get_local());
+
     if (p_xstream->request & ABTI_XSTREAM_REQ_JOIN) {
         ABTI_sched_finish(p_sched);
     }
@@ -1308,7 +1354,7 @@ int ABTI_xstream_join(ABTI_local **pp_local, ABTI_xstream *p_xstream)
         while (ABTD_atomic_load_uint32((uint32_t *)&p_xstream->state)
                != ABT_XSTREAM_STATE_TERMINATED) {
 #ifndef ABT_CONFIG_DISABLE_EXT_THREAD
-            if (ABTI_self_get_type(p_local) != ABT_UNIT_TYPE_THREAD) {
+            if (ABTI_self_get_suspend_type(p_local) != ABT_UNIT_TYPE_THREAD) {
                 ABTD_atomic_pause();
                 continue;
             }
@@ -1344,6 +1390,10 @@ int ABTI_xstream_free(ABTI_local *p_local, ABTI_xstream *p_xstream)
     /* Free the scheduler */
     ABTI_sched *p_cursched = p_xstream->p_main_sched;
     if (p_cursched != NULL) {
+        if (p_cursched->num_pools > 0) {
+            ABTI_pool_unbind_owner(ABTI_pool_get_ptr(p_cursched->pools[0]),
+                                   p_xstream);
+        }
         abt_errno = ABTI_sched_discard_and_free(p_local, p_cursched);
         ABTI_CHECK_ERROR(abt_errno);
     }
@@ -1351,6 +1401,15 @@ int ABTI_xstream_free(ABTI_local *p_local, ABTI_xstream *p_xstream)
     /* Free the array of sched contexts */
     ABTU_free(p_xstream->scheds);
 
+    if (p_xstream->p_park_links) ABTU_free(p_xstream->p_park_links);
+    if (p_xstream->p_twheel) ABTI_twheel_free(p_xstream->p_twheel);
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+    ABTU_free(p_xstream->p_perf);
+#endif
+#ifdef ABT_CONFIG_USE_TRACE
+    ABTI_trace_xstream_finalize(p_xstream);
+#endif
+
     /* Free the context */
     abt_errno = ABTD_xstream_context_free(&p_xstream->ctx);
     ABTI_CHECK_ERROR(abt_errno);
@@ -1429,6 +1488,18 @@ int ABTI_xstream_schedule_thread(ABTI_local **pp_local, ABTI_xstream *p_xstream,
     int abt_errno = ABT_SUCCESS;
     ABTI_local *p_local = *pp_local;
 
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
+    if (ABTI_thread_is_stack_copy(p_thread) &&
+        ABTI_thread_load_copy_stack(p_local, p_thread) == ABT_FALSE) {
+        /* Its frames are on the shared stack of another ES, so it is put back
+         * for that ES. */
+        LOG_EVENT("[U%" PRIu64 ":E%d] skipped (stack-copying)\n",
+                  ABTI_thread_get_id(p_thread), p_xstream->rank);
+        ABTI_POOL_ADD_THREAD(p_thread, ABTI_self_get_native_thread_id(p_local));
+        goto fn_exit;
+    }
+#endif
+
 #ifndef ABT_CONFIG_DISABLE_THREAD_CANCEL
     if (p_thread->request & ABTI_THREAD_REQ_CANCEL) {
         LOG_EVENT("[U%" PRIu64 ":E%d] canceled\n",
@@ -1465,6 +1536,8 @@ int ABTI_xstream_schedule_thread(ABTI_local **pp_local, ABTI_xstream *p_xstream,
     /* Switch the context */
     LOG_EVENT("[U%" PRIu64 ":E%d] start running\n",
               ABTI_thread_get_id(p_thread), p_xstream->rank);
+    ABTI_XSTREAM_PERF_INC(p_xstream, num_ctxsw);
+    ABTI_TRACE_XSTREAM(p_xstream, THREAD_RUN, p_thread, 0);
     ABTI_sched *p_sched = ABTI_xstream_get_top_sched(p_xstream);
 #ifndef ABT_CONFIG_DISABLE_STACKABLE_SCHED
     if (p_thread->is_sched != NULL) {
@@ -1489,6 +1562,13 @@ int ABTI_xstream_schedule_thread(ABTI_local **pp_local, ABTI_xstream *p_xstream,
     p_xstream = p_thread->p_last_xstream;
     LOG_EVENT("[U%" PRIu64 ":E%d] stopped\n",
               ABTI_thread_get_id(p_thread), p_xstream->rank);
+    ABTI_TRACE_XSTREAM(p_xstream, THREAD_STOP, p_thread,
+        (p_thread->request & (ABTI_THREAD_REQ_STOP | ABTI_THREAD_REQ_CANCEL))
+            ? ABTI_TRACE_STOP_TERMINATE
+        : !(p_thread->request & ABTI_THREAD_REQ_NON_YIELD)
+            ? ABTI_TRACE_STOP_YIELD
+        : (p_thread->request & ABTI_THREAD_REQ_BLOCK)
+            ? ABTI_TRACE_STOP_BLOCK : ABTI_TRACE_STOP_OTHER);
 
 #ifndef ABT_CONFIG_DISABLE_STACKABLE_SCHED
     /* Delete the last scheduler if the ULT was a scheduler */
@@ -1580,6 +1660,7 @@ void ABTI_xstream_schedule_task(ABTI_local *p_local, ABTI_xstream *p_xstream,
 
     /* Set the associated ES */
     p_task->p_xstream = p_xstream;
+    ABTI_TRACE_XSTREAM(p_xstream, TASK_RUN, p_task, 0);
 
 #ifdef ABT_CONFIG_DISABLE_STACKABLE_SCHED
     /* Execute the task function */
@@ -1623,11 +1704,89 @@ void ABTI_xstream_schedule_task(ABTI_local *p_local, ABTI_xstream *p_xstream,
     ABTI_LOG_SET_SCHED(ABTI_xstream_get_top_sched(p_xstream));
     LOG_EVENT("[T%" PRIu64 ":E%d] stopped\n",
               ABTI_task_get_id(p_task), p_xstream->rank);
+    ABTI_TRACE_XSTREAM(p_xstream, TASK_END, p_task, 0);
 
     /* Terminate the tasklet */
     ABTI_xstream_terminate_task(p_local, p_task);
 }
 
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
+/* The function of the ULT that lends its stack to p_arg (ABTI_task) */
+static void ABTI_xstream_task_stack_func(void *p_arg)
+{
+    ABTI_task *p_task = (ABTI_task *)p_arg;
+    ABTI_local *p_local = ABTI_local_get_local();
+
+    /* It is a tasklet until it is promoted to a ULT. */
+    p_local->p_task = p_task;
+    p_task->f_task(p_task->p_arg);
+
+    p_local = ABTI_local_get_local();
+    if (p_local->p_task == p_task) {
+        /* ABTI_xstream_schedule_task_on_stack terminates the tasklet. */
+        p_local->p_task = NULL;
+    } else {
+        /* The tasklet has been promoted, so nobody else will terminate it. */
+        p_task->p_xstream = p_local->p_xstream;
+        LOG_EVENT("[T%" PRIu64 ":E%d] stopped\n",
+                  ABTI_task_get_id(p_task), p_local->p_xstream->rank);
+        ABTI_TRACE_XSTREAM(p_local->p_xstream, TASK_END, p_task, 0);
+        ABTI_xstream_terminate_task(p_local, p_task);
+    }
+}
+
+int ABTI_xstream_schedule_task_on_stack(ABTI_local **pp_local,
+                                        ABTI_xstream *p_xstream,
+                                        ABTI_task *p_task)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_local *p_local = *pp_local;
+    ABTI_thread *p_thread;
+
+#ifndef ABT_CONFIG_DISABLE_TASK_CANCEL
+    if (p_task->request & ABTI_TASK_REQ_CANCEL) {
+        ABTI_xstream_terminate_task(p_local, p_task);
+        goto fn_exit;
+    }
+#endif
+
+    /* The tasklet runs as a ULT that has not been dynamically promoted, which
+     * costs little more than a tasklet if it does not suspend. */
+    abt_errno = ABTI_thread_prepare_task_stack(p_local, p_task->p_pool,
+                                               ABTI_xstream_task_stack_func,
+                                               (void *)p_task, &p_thread);
+    ABTI_CHECK_ERROR(abt_errno);
+
+    p_task->state = ABT_TASK_STATE_RUNNING;
+    p_task->p_xstream = p_xstream;
+    LOG_EVENT("[T%" PRIu64 ":E%d] running on U%" PRIu64 "\n",
+              ABTI_task_get_id(p_task), p_xstream->rank,
+              ABTI_thread_get_id(p_thread));
+    ABTI_TRACE_XSTREAM(p_xstream, TASK_RUN, p_task, 0);
+
+    abt_errno = ABTI_xstream_schedule_thread(pp_local, p_xstream, p_thread);
+    ABTI_CHECK_ERROR(abt_errno);
+    p_local = *pp_local;
+
+    /* The tasklet has finished without suspending, so p_thread is still the
+     * ULT lent by this ES and the tasklet is terminated here.  A tasklet that
+     * suspended has been given p_thread and terminates as a ULT. */
+    if (p_local->p_task_thread == p_thread) {
+        LOG_EVENT("[T%" PRIu64 ":E%d] stopped\n",
+                  ABTI_task_get_id(p_task), p_xstream->rank);
+        ABTI_TRACE_XSTREAM(p_xstream, TASK_END, p_task, 0);
+        ABTI_xstream_terminate_task(p_local, p_task);
+    }
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+#endif
+
 int ABTI_xstream_migrate_thread(ABTI_local *p_local, ABTI_thread *p_thread)
 {
 #ifdef ABT_CONFIG_DISABLE_MIGRATION
@@ -1697,6 +1856,17 @@ int ABTI_xstream_set_main_sched(ABTI_local **pp_local, ABTI_xstream *p_xstream,
     }
 #endif
 
+    /* The ES owns the first pool of its main scheduler.  The first pool of
+     * the current main scheduler is released. */
+    if (p_xstream->p_main_sched != NULL &&
+        p_xstream->p_main_sched->num_pools > 0) {
+        ABTI_pool_unbind_owner(
+            ABTI_pool_get_ptr(p_xstream->p_main_sched->pools[0]), p_xstream);
+    }
+    if (p_sched->num_pools > 0) {
+        ABTI_pool_bind_owner(ABTI_pool_get_ptr(p_sched->pools[0]), p_xstream);
+    }
+
     /* The main scheduler will to be a ULT, not a tasklet */
     p_sched->type = ABT_SCHED_TYPE_ULT;
 
@@ -229,7 +229,7 @@ int ABT_task_free(ABT_task *task)
     while (ABTD_atomic_load_uint32((uint32_t *)&p_task->state)
            != ABT_TASK_STATE_TERMINATED) {
 #ifndef ABT_CONFIG_DISABLE_EXT_THREAD
-        if (ABTI_self_get_type(p_local) != ABT_UNIT_TYPE_THREAD) {
+        if (ABTI_self_get_suspend_type(p_local) != ABT_UNIT_TYPE_THREAD) {
             ABTD_atomic_pause();
             continue;
         }
@@ -275,7 +275,7 @@ int ABT_task_join(ABT_task task)
     while (ABTD_atomic_load_uint32((uint32_t *)&p_task->state)
            != ABT_TASK_STATE_TERMINATED) {
 #ifndef ABT_CONFIG_DISABLE_EXT_THREAD
-        if (ABTI_self_get_type(p_local) != ABT_UNIT_TYPE_THREAD) {
+        if (ABTI_self_get_suspend_type(p_local) != ABT_UNIT_TYPE_THREAD) {
             ABTD_atomic_pause();
             continue;
         }
@@ -859,6 +859,36 @@ void ABTI_task_free(ABTI_local *p_local, ABTI_task *p_task)
     ABTI_mem_free_task(p_local, p_task);
 }
 
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
+/* Promote the tasklet running on the lent stack of this ES to the ULT that
+ * lends the stack.  It is called when the tasklet suspends for the first
+ * time.  The ULT keeps the stack, so the ES prepares another one for the
+ * following tasklets. */
+void ABTI_task_promote_to_thread(ABTI_local *p_local)
+{
+    ABTI_task *p_task = p_local->p_task;
+    ABTI_thread *p_thread = p_local->p_task_thread;
+
+    LOG_EVENT("[T%" PRIu64 ":E%d] promoted to U%" PRIu64 "\n",
+              ABTI_task_get_id(p_task), p_local->p_xstream->rank,
+              ABTI_thread_get_id(p_thread));
+
+    /* The ULT can be pushed to the pool of the tasklet from now on. */
+    p_thread->unit = p_thread->p_pool->u_create_from_thread(
+                         ABTI_thread_get_handle(p_thread));
+
+    /* The tasklet-specific values are kept as the ULT-specific ones. */
+    p_thread->p_keytable = p_task->p_keytable;
+    p_task->p_keytable = NULL;
+
+    /* Nobody has a handle of the ULT, so it is freed when it terminates. */
+    p_thread->refcount = 0;
+
+    p_local->p_task = NULL;
+    p_local->p_task_thread = NULL;
+}
+#endif
+
 void ABTI_task_print(ABTI_task *p_task, FILE *p_os, int indent)
 {
     char *prefix = ABTU_get_indent_str(indent);
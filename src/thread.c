@@ -168,6 +168,10 @@ int ABT_thread_create_on_xstream(ABT_xstream xstream,
  * user-provided stack, it will return an error. When \c newthread_list is NULL,
  * unnamed threads are created.
  *
+ * If an error occurs, the ULTs that have been created are still pushed to
+ * their pools, and the elements of \c newthread_list for the other ULTs are
+ * set to \c ABT_THREAD_NULL.
+ *
  * @param[in] num               the number of array elements
  * @param[in] pool_list         array of pool handles
  * @param[in] thread_func_list  array of ULT functions
@@ -183,7 +187,11 @@ int ABT_thread_create_many(int num, ABT_pool *pool_list,
 {
     int abt_errno = ABT_SUCCESS;
     ABTI_local *p_local = ABTI_local_get_local();
-    int i;
+    ABT_unit units[ABTI_POOL_PUSH_BATCH];
+    ABTI_pool *p_batch_pool = NULL;
+    int num_units = 0;
+    int fail_errno;
+    int i = 0;
 
     if (attr != ABT_THREAD_ATTR_NULL) {
         if (ABTI_thread_attr_get_ptr(attr)->stacktype == ABTI_STACK_TYPE_USER) {
@@ -192,41 +200,59 @@ int ABT_thread_create_many(int num, ABT_pool *pool_list,
         }
     }
 
-    if (newthread_list == NULL) {
-        for (i = 0; i < num; i++) {
-            ABT_pool pool = pool_list[i];
-            ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
-            ABTI_CHECK_NULL_POOL_PTR(p_pool);
-
-            void (*thread_f)(void *) = thread_func_list[i];
-            void *arg = arg_list ? arg_list[i] : NULL;
-            abt_errno = ABTI_thread_create_internal(p_local, p_pool, thread_f,
-                arg, ABTI_thread_attr_get_ptr(attr), ABTI_THREAD_TYPE_USER,
-                NULL, 0, NULL, ABT_TRUE, NULL);
-            ABTI_CHECK_ERROR(abt_errno);
-        }
-    } else {
-        for (i = 0; i < num; i++) {
-            ABTI_thread *p_newthread;
-            ABT_pool pool = pool_list[i];
-            ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
-            ABTI_CHECK_NULL_POOL_PTR(p_pool);
-
-            void (*thread_f)(void *) = thread_func_list[i];
-            void *arg = arg_list ? arg_list[i] : NULL;
-            abt_errno = ABTI_thread_create_internal(p_local, p_pool, thread_f,
-                arg, ABTI_thread_attr_get_ptr(attr), ABTI_THREAD_TYPE_USER,
-                NULL, 1, NULL, ABT_TRUE, &p_newthread);
-            newthread_list[i] = ABTI_thread_get_handle(p_newthread);
-            /* TODO: Release threads that have been already created. */
-            ABTI_CHECK_ERROR(abt_errno);
+    /* New ULTs are pushed in batches of consecutive ULTs that share a pool,
+     * so that a pool that defines p_push_many is locked once per batch. */
+    for (i = 0; i < num; i++) {
+        ABTI_thread *p_newthread;
+        ABT_pool pool = pool_list[i];
+        ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+        ABTI_CHECK_NULL_POOL_PTR(p_pool);
+
+        if (num_units > 0 &&
+            (p_pool != p_batch_pool || num_units == ABTI_POOL_PUSH_BATCH)) {
+            ABTI_POOL_PUSH_MANY(p_batch_pool, units, num_units,
+                                ABTI_self_get_native_thread_id(p_local));
+            num_units = 0;
         }
+
+        void (*thread_f)(void *) = thread_func_list[i];
+        void *arg = arg_list ? arg_list[i] : NULL;
+        int refcount = newthread_list ? 1 : 0;
+        abt_errno = ABTI_thread_create_internal(p_local, p_pool, thread_f,
+            arg, ABTI_thread_attr_get_ptr(attr), ABTI_THREAD_TYPE_USER,
+            NULL, refcount, NULL, ABT_FALSE, &p_newthread);
+        ABTI_CHECK_ERROR(abt_errno);
+
+        ABT_thread h_newthread = ABTI_thread_get_handle(p_newthread);
+        p_newthread->unit = p_pool->u_create_from_thread(h_newthread);
+        if (newthread_list) newthread_list[i] = h_newthread;
+
+        p_batch_pool = p_pool;
+        units[num_units++] = p_newthread->unit;
+    }
+    if (num_units > 0) {
+        ABTI_POOL_PUSH_MANY(p_batch_pool, units, num_units,
+                            ABTI_self_get_native_thread_id(p_local));
     }
 
   fn_exit:
     return abt_errno;
 
   fn_fail:
+    /* The ULTs in the pending batch have been created, so they are pushed so
+     * that they run and their joiners do not wait forever.  If the push
+     * fails, we come back here with no pending ULT. */
+    if (num_units > 0) {
+        int num_pending = num_units;
+        fail_errno = abt_errno;
+        num_units = 0;
+        ABTI_POOL_PUSH_MANY(p_batch_pool, units, num_pending,
+                            ABTI_self_get_native_thread_id(p_local));
+        abt_errno = fail_errno;
+    }
+    if (newthread_list) {
+        for (; i < num; i++) newthread_list[i] = ABT_THREAD_NULL;
+    }
     HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
     goto fn_exit;
 }
@@ -438,7 +464,8 @@ int ABT_thread_exit(void)
         goto fn_exit;
     }
 
-    ABTI_thread *p_thread = p_local->p_thread;
+    /* A tasklet running on a lent stack is not a ULT. */
+    ABTI_thread *p_thread = p_local->p_task ? NULL : p_local->p_thread;
     ABTI_CHECK_NULL_THREAD_PTR(p_thread);
 
     /* Set the exit request */
@@ -526,7 +553,8 @@ int ABT_thread_self(ABT_thread *thread)
     }
 #endif
 
-    ABTI_thread *p_thread = p_local->p_thread;
+    /* A tasklet running on a lent stack is not a ULT. */
+    ABTI_thread *p_thread = p_local->p_task ? NULL : p_local->p_thread;
     if (p_thread != NULL) {
         *thread = ABTI_thread_get_handle(p_thread);
     } else {
@@ -569,7 +597,8 @@ int ABT_thread_self_id(ABT_thread_id *id)
     }
 #endif
 
-    ABTI_thread *p_thread = p_local->p_thread;
+    /* A tasklet running on a lent stack is not a ULT. */
+    ABTI_thread *p_thread = p_local->p_task ? NULL : p_local->p_thread;
     if (p_thread != NULL) {
         *id = ABTI_thread_get_id(p_thread);
     } else {
@@ -759,6 +788,12 @@ int ABT_thread_yield_to(ABT_thread thread)
         goto fn_exit;
     }
 
+    /* A stack-copying ULT is resumed by the scheduler, so just yield. */
+    if (ABTI_thread_is_stack_copy(p_tar_thread) == ABT_TRUE) {
+        ABTI_thread_yield(&p_local, p_cur_thread);
+        goto fn_exit;
+    }
+
     p_cur_thread->state = ABT_THREAD_STATE_READY;
 
     /* Add the current thread to the pool again */
@@ -842,6 +877,76 @@ int ABT_thread_yield(void)
     goto fn_exit;
 }
 
+/**
+ * @ingroup ULT
+ * @brief   Block the calling ULT for the given duration.
+ *
+ * \c ABT_thread_sleep() blocks the calling ULT for at least \c secs seconds.
+ * Unlike sleeping in the OS, the ES keeps scheduling other work units; the
+ * ULT is pushed back to its associated pool by the ES that it sleeps on when
+ * the time has passed.
+ *
+ * This routine must be called by a ULT.  Otherwise, it returns
+ * \c ABT_ERR_INV_THREAD without sleeping.
+ *
+ * @param[in] secs  duration in seconds
+ * @return Error code
+ * @retval ABT_SUCCESS          on success
+ * @retval ABT_ERR_INV_THREAD   called by a non-ULT
+ */
+int ABT_thread_sleep(double secs)
+{
+    return ABT_thread_sleep_until(ABTI_get_wtime() + secs);
+}
+
+/**
+ * @ingroup ULT
+ * @brief   Block the calling ULT until the given time.
+ *
+ * \c ABT_thread_sleep_until() blocks the calling ULT until the time returned
+ * by \c ABT_get_wtime() reaches \c abstime_secs.  If the time has already
+ * passed, it returns immediately.
+ *
+ * This routine must be called by a ULT.  Otherwise, it returns
+ * \c ABT_ERR_INV_THREAD without sleeping.
+ *
+ * @param[in] abstime_secs  absolute time in seconds
+ * @return Error code
+ * @retval ABT_SUCCESS          on success
+ * @retval ABT_ERR_INV_THREAD   called by a non-ULT
+ */
+int ABT_thread_sleep_until(double abstime_secs)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_local *p_local = ABTI_local_get_local();
+#ifdef ABT_CONFIG_DISABLE_EXT_THREAD
+    ABTI_thread *p_thread = p_local->p_thread;
+#else
+    ABTI_thread *p_thread = NULL;
+
+    /* If this routine is called by non-ULT, just return. */
+    if (p_local != NULL) {
+        p_thread = p_local->p_thread;
+    }
+#endif
+    if (p_thread == NULL) {
+        abt_errno = ABT_ERR_INV_THREAD;
+        goto fn_fail;
+    }
+
+    uint64_t deadline_nsec = (abstime_secs <= 0.0) ? 0
+                           : (uint64_t)(abstime_secs * 1.0e9);
+    abt_errno = ABTI_thread_sleep_until(&p_local, deadline_nsec);
+    ABTI_CHECK_ERROR(abt_errno);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
 /**
  * @ingroup ULT
  * @brief   Resume the target ULT.
@@ -1128,7 +1233,8 @@ int ABT_thread_set_callback(ABT_thread thread,
  * \c ABT_thread_set_migratable sets the secondary ULT's migratability. This
  * routine cannot be used for the primary ULT. If \c flag is \c ABT_TRUE, the
  * target ULT becomes migratable. On the other hand, if \c flag is \c
- * ABT_FALSE, the target ULT becomes unmigratable.
+ * ABT_FALSE, the target ULT becomes unmigratable.  Stack-copying ULTs are
+ * always unmigratable.
  *
  * @param[in] thread  handle to the target ULT
  * @param[in] flag    migratability flag (<tt>ABT_TRUE</tt>: migratable,
@@ -1143,7 +1249,9 @@ int ABT_thread_set_migratable(ABT_thread thread, ABT_bool flag)
     ABTI_thread *p_thread = ABTI_thread_get_ptr(thread);
     ABTI_CHECK_NULL_THREAD_PTR(p_thread);
 
-    if (p_thread->type == ABTI_THREAD_TYPE_USER) {
+    if ((p_thread->type == ABTI_THREAD_TYPE_USER ||
+         p_thread->type == ABTI_THREAD_TYPE_TASK) &&
+        ABTI_thread_is_stack_copy(p_thread) == ABT_FALSE) {
         p_thread->attr.migratable = flag;
     }
 
@@ -1470,9 +1578,34 @@ int ABTI_thread_create_internal(ABTI_local *p_local, ABTI_pool *p_pool,
     int abt_errno = ABT_SUCCESS;
     ABTI_thread *p_newthread;
     ABT_thread h_newthread;
+    ABTI_thread_attr adaptive_attr;
+
+    /* A ULT that does not specify its stack size gets the one chosen from the
+     * stack usage of the ULTs that ran the same function. */
+    if (gp_ABTI_global->stack_adaptive == ABT_TRUE &&
+        thread_type == ABTI_THREAD_TYPE_USER && p_sched == NULL &&
+        (p_attr == NULL ||
+         (p_attr->stacktype == ABTI_STACK_TYPE_MEMPOOL &&
+          p_attr->stacksize == ABTI_global_get_thread_stacksize()))) {
+        size_t stacksize = ABTI_stack_usage_get_stacksize(thread_func);
+        if (stacksize != 0) {
+            if (p_attr) {
+                ABTI_thread_attr_copy(&adaptive_attr, p_attr);
+                adaptive_attr.stacksize = stacksize;
+            } else {
+                ABTI_thread_attr_init(&adaptive_attr, NULL, stacksize,
+                                      ABTI_STACK_TYPE_MEMPOOL, ABT_TRUE);
+            }
+            p_attr = &adaptive_attr;
+        }
+    }
 
     /* Allocate a ULT object and its stack, then create a thread context. */
     p_newthread = ABTI_mem_alloc_thread(p_local, p_attr);
+    if (gp_ABTI_global->stack_watermark == ABT_TRUE &&
+        thread_type == ABTI_THREAD_TYPE_USER && p_sched == NULL) {
+        ABTI_stack_usage_fill(p_newthread);
+    }
     if ((thread_type == ABTI_THREAD_TYPE_MAIN ||
          thread_type == ABTI_THREAD_TYPE_MAIN_SCHED)
          && p_newthread->attr.p_stack == NULL) {
@@ -1480,18 +1613,19 @@ int ABTI_thread_create_internal(ABTI_local *p_local, ABTI_pool *p_pool,
          * 2. the main scheduler thread which runs on OS-level threads
          * (p_stack == NULL). Invalidate the context here. */
         abt_errno = ABTD_thread_context_invalidate(&p_newthread->ctx);
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
+    } else if (p_sched == NULL &&
+               p_newthread->attr.dynamic_promotion == ABT_TRUE) {
+        /* The context is not fully created now. */
+        abt_errno = ABTD_thread_context_init(NULL, thread_func, arg,
+                                             &p_newthread->ctx);
+#endif
     } else if (p_sched == NULL) {
-#if ABT_CONFIG_THREAD_TYPE != ABT_THREAD_TYPE_DYNAMIC_PROMOTION
         size_t stack_size = p_newthread->attr.stacksize;
         void *p_stack = p_newthread->attr.p_stack;
         abt_errno = ABTD_thread_context_create_thread(NULL, thread_func, arg,
                                                       stack_size, p_stack,
                                                       &p_newthread->ctx);
-#else
-        /* The context is not fully created now. */
-        abt_errno = ABTD_thread_context_init(NULL, thread_func, arg,
-                                             &p_newthread->ctx);
-#endif
     } else {
         size_t stack_size = p_newthread->attr.stacksize;
         void *p_stack = p_newthread->attr.p_stack;
@@ -1515,6 +1649,10 @@ int ABTI_thread_create_internal(ABTI_local *p_local, ABTI_pool *p_pool,
 #endif
     p_newthread->p_keytable     = NULL;
     p_newthread->id             = ABTI_THREAD_INIT_ID;
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
+    p_newthread->p_copy_buf     = NULL;
+    p_newthread->copy_size      = 0;
+#endif
 
 #ifndef ABT_CONFIG_DISABLE_MIGRATION
     /* Initialize a spinlock */
@@ -1533,6 +1671,7 @@ int ABTI_thread_create_internal(ABTI_local *p_local, ABTI_pool *p_pool,
         LOG_EVENT("[U%" PRIu64 "] created\n", thread_id);
     }
 #endif
+    ABTI_TRACE(THREAD_CREATE, p_newthread, 0);
 
     /* Create a wrapper unit */
     h_newthread = ABTI_thread_get_handle(p_newthread);
@@ -1600,6 +1739,9 @@ int ABTI_thread_migrate_to_pool(ABTI_local **pp_local, ABTI_thread *p_thread,
                     ABT_ERR_INV_THREAD);
     ABTI_CHECK_TRUE(p_thread->state != ABT_THREAD_STATE_TERMINATED,
                     ABT_ERR_INV_THREAD);
+    /* A stack-copying ULT can run only on the ES whose stack it uses. */
+    ABTI_CHECK_TRUE(ABTI_thread_is_stack_copy(p_thread) == ABT_FALSE,
+                    ABT_ERR_MIGRATION_NA);
 
     /* checking for migration to the same pool */
     ABTI_CHECK_TRUE(p_thread->p_pool != p_pool, ABT_ERR_MIGRATION_TARGET);
@@ -1811,6 +1953,111 @@ void ABTI_thread_free_main_sched(ABTI_local *p_local, ABTI_thread *p_thread)
     ABTI_mem_free_thread(p_local, p_thread);
 }
 
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
+/* Prepare the ULT whose stack is lent to tasklets running on this ES so that
+ * it calls thread_func(arg) as a ULT of p_pool.  The ULT is created on first
+ * use and reused until a tasklet is promoted to it.  It has no unit until the
+ * promotion because it is never pushed to a pool before that. */
+int ABTI_thread_prepare_task_stack(ABTI_local *p_local, ABTI_pool *p_pool,
+                                   void (*thread_func)(void *), void *arg,
+                                   ABTI_thread **pp_thread)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_thread *p_thread = p_local->p_task_thread;
+
+    if (p_thread == NULL) {
+        /* The stack runs many tasklets, so it is neither sized by nor
+         * measured for thread_func. */
+        abt_errno = ABTI_thread_create_internal(p_local, p_pool, thread_func,
+                                                arg, NULL,
+                                                ABTI_THREAD_TYPE_TASK, NULL, 1,
+                                                NULL, ABT_FALSE, &p_thread);
+        ABTI_CHECK_ERROR(abt_errno);
+        p_thread->attr.dynamic_promotion = ABT_TRUE;
+        p_local->p_task_thread = p_thread;
+    }
+
+    /* The context is not fully created until the tasklet suspends. */
+    abt_errno = ABTD_thread_context_init(NULL, thread_func, arg,
+                                         &p_thread->ctx);
+    ABTI_CHECK_ERROR(abt_errno);
+    p_thread->state   = ABT_THREAD_STATE_READY;
+    p_thread->request = 0;
+    p_thread->p_pool  = p_pool;
+
+    *pp_thread = p_thread;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/* Put the frames of the stack-copying ULT p_thread on the stack shared in
+ * this ES before the scheduler runs it.  The frames of the ULT that used the
+ * shared stack last are first saved to a buffer of their size.  ABT_FALSE is
+ * returned if p_thread has frames on the shared stack of another ES. */
+ABT_bool ABTI_thread_load_copy_stack(ABTI_local *p_local,
+                                     ABTI_thread *p_thread)
+{
+    size_t stacksize = gp_ABTI_global->copy_stacksize;
+    char *p_stacktop;
+
+    if (p_local->p_copy_stack == NULL) {
+        p_local->p_copy_stack = ABTU_malloc(stacksize);
+        ABTI_VALGRIND_REGISTER_STACK(p_local->p_copy_stack, stacksize);
+    }
+    if (p_thread->attr.p_stack == NULL) {
+        /* p_thread has not run yet. */
+        p_thread->attr.p_stack = p_local->p_copy_stack;
+    } else if (p_thread->attr.p_stack != p_local->p_copy_stack) {
+        return ABT_FALSE;
+    }
+
+    ABTI_thread *p_prev = p_local->p_copy_thread;
+    if (p_prev == p_thread) {
+        /* No other ULT has used the stack since p_thread stopped. */
+        return ABT_TRUE;
+    }
+    p_stacktop = (char *)p_local->p_copy_stack + stacksize;
+    if (p_prev) {
+        /* p_prev is suspended, so its frames are above its stack pointer. */
+        char *p_sp = (char *)ABTD_thread_context_get_sp(&p_prev->ctx);
+        size_t size = (size_t)(p_stacktop - p_sp);
+        p_prev->p_copy_buf = ABTU_malloc(size);
+        memcpy(p_prev->p_copy_buf, p_sp, size);
+        p_prev->copy_size = size;
+    }
+    if (p_thread->p_copy_buf) {
+        memcpy(p_stacktop - p_thread->copy_size, p_thread->p_copy_buf,
+               p_thread->copy_size);
+        ABTU_free(p_thread->p_copy_buf);
+        p_thread->p_copy_buf = NULL;
+        p_thread->copy_size = 0;
+    }
+    p_local->p_copy_thread = p_thread;
+    return ABT_TRUE;
+}
+
+/* Called when the stack-copying ULT p_thread terminates or is canceled on the
+ * ES whose shared stack it used.  Its frames are no longer needed. */
+void ABTI_thread_release_copy_stack(ABTI_local *p_local, ABTI_thread *p_thread)
+{
+    if (p_local->p_copy_thread == p_thread) {
+        p_local->p_copy_thread = NULL;
+    }
+    if (p_thread->p_copy_buf) {
+        ABTU_free(p_thread->p_copy_buf);
+        p_thread->p_copy_buf = NULL;
+        p_thread->copy_size = 0;
+    }
+    /* It can run on any ES if it is revived. */
+    p_thread->attr.p_stack = NULL;
+}
+#endif
+
 int ABTI_thread_set_blocked(ABTI_thread *p_thread)
 {
     int abt_errno = ABT_SUCCESS;
@@ -1840,6 +2087,18 @@ int ABTI_thread_set_blocked(ABTI_thread *p_thread)
     goto fn_exit;
 }
 
+/* Undo ABTI_thread_set_blocked() when p_thread, which is still running, does
+ * not need to be suspended. */
+void ABTI_thread_unset_blocked(ABTI_thread *p_thread)
+{
+    ABTI_pool_dec_num_blocked(p_thread->p_pool);
+    p_thread->state = ABT_THREAD_STATE_RUNNING;
+    ABTI_thread_unset_request(p_thread, ABTI_THREAD_REQ_BLOCK);
+
+    LOG_EVENT("[U%" PRIu64 ":E%d] unblocked\n",
+              ABTI_thread_get_id(p_thread), p_thread->p_last_xstream->rank);
+}
+
 /* NOTE: This routine should be called after ABTI_thread_set_blocked. */
 void ABTI_thread_suspend(ABTI_local **pp_local, ABTI_thread *p_thread)
 {
@@ -1859,6 +2118,92 @@ void ABTI_thread_suspend(ABTI_local **pp_local, ABTI_thread *p_thread)
               ABTI_thread_get_id(p_thread), p_thread->p_last_xstream->rank);
 }
 
+static void ABTI_thread_sleep_expire(ABTI_local *p_local,
+                                     ABTI_twheel_entry *p_entry)
+{
+    ABTI_thread_set_ready(p_local, (ABTI_thread *)p_entry->p_arg);
+}
+
+/* Block the calling ULT until the time returned by ABTI_get_wtime_nsec()
+ * reaches deadline_nsec.  The ULT is woken up by the timer wheel of the
+ * current ES. */
+int ABTI_thread_sleep_until(ABTI_local **pp_local, uint64_t deadline_nsec)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_local *p_local = *pp_local;
+    ABTI_thread *p_thread = p_local->p_thread;
+    ABTI_twheel_entry entry, *p_entry;
+
+    if (ABTI_get_wtime_nsec() >= deadline_nsec) goto fn_exit;
+
+    abt_errno = ABTI_thread_set_blocked(p_thread);
+    ABTI_CHECK_ERROR(abt_errno);
+
+    p_entry = (ABTI_twheel_entry *)
+        ABTI_mem_alloc_wait_obj(p_local, &entry, sizeof(entry));
+    p_entry->deadline = deadline_nsec;
+    p_entry->f_expire = ABTI_thread_sleep_expire;
+    p_entry->p_arg = (void *)p_thread;
+    ABTI_twheel_add(ABTI_xstream_get_twheel(p_local->p_xstream), p_entry);
+
+    ABTI_thread_suspend(pp_local, p_thread);
+    ABTI_mem_free_wait_obj(*pp_local, p_entry, &entry);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+static void ABTI_thread_timeout_expire(ABTI_local *p_local,
+                                       ABTI_twheel_entry *p_entry)
+{
+    ABTI_thread_timeout *p_timeout = (ABTI_thread_timeout *)p_entry;
+    ABTI_thread *p_thread = p_timeout->p_thread;
+
+    if (p_timeout->f_remove(p_thread, p_entry->p_arg) == ABT_TRUE) {
+        /* p_timeout is released by p_thread, so it must not be accessed after
+         * p_thread is made ready. */
+        p_timeout->timed_out = ABT_TRUE;
+        ABTI_thread_set_ready(p_local, p_thread);
+    } else {
+        /* p_thread has been woken up by the object. */
+        ABTI_twheel_fired(p_entry);
+    }
+}
+
+/* Suspend p_thread, which has been blocked by ABTI_thread_set_blocked() and
+ * added to the waiters of p_obj, until it is woken up or the time reaches
+ * deadline_nsec.  On timeout, f_remove is called on the current ES to remove
+ * p_thread from the waiters.  Returns ABT_TRUE if it has timed out. */
+ABT_bool ABTI_thread_suspend_until(ABTI_local **pp_local, ABTI_thread *p_thread,
+        uint64_t deadline_nsec,
+        ABT_bool (*f_remove)(ABTI_thread *p_thread, void *p_obj), void *p_obj)
+{
+    ABTI_thread_timeout timeout, *p_timeout;
+    ABTI_twheel *p_wheel = ABTI_xstream_get_twheel((*pp_local)->p_xstream);
+    ABT_bool timed_out;
+
+    p_timeout = (ABTI_thread_timeout *)
+        ABTI_mem_alloc_wait_obj(*pp_local, &timeout, sizeof(timeout));
+    p_timeout->entry.deadline = deadline_nsec;
+    p_timeout->entry.f_expire = ABTI_thread_timeout_expire;
+    p_timeout->entry.p_arg = p_obj;
+    p_timeout->p_thread = p_thread;
+    p_timeout->f_remove = f_remove;
+    p_timeout->timed_out = ABT_FALSE;
+    ABTI_twheel_add(p_wheel, &p_timeout->entry);
+
+    ABTI_thread_suspend(pp_local, p_thread);
+
+    timed_out = p_timeout->timed_out;
+    if (timed_out == ABT_FALSE) ABTI_twheel_cancel(&p_timeout->entry);
+    ABTI_mem_free_wait_obj(*pp_local, p_timeout, &timeout);
+    return timed_out;
+}
+
 int ABTI_thread_set_ready(ABTI_local *p_local, ABTI_thread *p_thread)
 {
     int abt_errno = ABT_SUCCESS;
@@ -1880,6 +2225,7 @@ int ABTI_thread_set_ready(ABTI_local *p_local, ABTI_thread *p_thread)
      * that has been pushed in ABTI_POOL_ADD_THREAD and change p_thread->p_pool
      * by ABT_unit_set_associated_pool. */
     ABTI_pool *p_pool = p_thread->p_pool;
+    ABTI_TRACE(THREAD_RESUME, p_thread, 0);
 
     /* Add the ULT to its associated pool */
     ABTI_POOL_ADD_THREAD(p_thread, ABTI_self_get_native_thread_id(p_local));
@@ -1895,6 +2241,74 @@ int ABTI_thread_set_ready(ABTI_local *p_local, ABTI_thread *p_thread)
     goto fn_exit;
 }
 
+/* Same as calling ABTI_thread_set_ready() for each ULT in p_threads, but
+ * consecutive ULTs associated with the same pool are pushed at once.  If a
+ * push fails, the ULTs of that push stay blocked, the other ULTs are still
+ * pushed, and then the first error is returned. */
+int ABTI_thread_set_ready_many(ABTI_local *p_local, int num_threads,
+                               ABTI_thread **p_threads)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABT_unit units[ABTI_POOL_PUSH_BATCH];
+    int i, j, num_units;
+
+    for (i = 0; i < num_threads; i++) {
+        ABTI_thread *p_thread = p_threads[i];
+        ABTI_CHECK_TRUE(p_thread->state == ABT_THREAD_STATE_BLOCKED,
+                        ABT_ERR_THREAD);
+
+        /* See ABTI_thread_set_ready(). */
+        while (ABTD_atomic_load_uint32((uint32_t *)&p_thread->request)
+               & ABTI_THREAD_REQ_BLOCK);
+
+        LOG_EVENT("[U%" PRIu64 ":E%d] set ready\n",
+                  ABTI_thread_get_id(p_thread),
+                  p_thread->p_last_xstream->rank);
+        ABTI_TRACE(THREAD_RESUME, p_thread, 0);
+    }
+
+    i = 0;
+    while (i < num_threads) {
+        /* p_pool is loaded before the push as in ABTI_thread_set_ready(). */
+        ABTI_pool *p_pool = p_threads[i]->p_pool;
+        num_units = 0;
+        while (i < num_threads && num_units < ABTI_POOL_PUSH_BATCH &&
+               p_threads[i]->p_pool == p_pool) {
+            p_threads[i]->state = ABT_THREAD_STATE_READY;
+            units[num_units++] = p_threads[i]->unit;
+            i++;
+        }
+
+        /* Add the ULTs to their associated pool */
+#ifdef ABT_CONFIG_DISABLE_POOL_PRODUCER_CHECK
+        ABTI_pool_push_many(p_pool, units, num_units);
+#else
+        int push_errno = ABTI_pool_push_many(p_pool, units, num_units,
+                             ABTI_self_get_native_thread_id(p_local));
+        if (push_errno != ABT_SUCCESS) {
+            for (j = i - num_units; j < i; j++) {
+                p_threads[j]->state = ABT_THREAD_STATE_BLOCKED;
+            }
+            if (abt_errno == ABT_SUCCESS) abt_errno = push_errno;
+            continue;
+        }
+#endif
+
+        /* Decrease the number of blocked threads */
+        for (j = 0; j < num_units; j++) {
+            ABTI_pool_dec_num_blocked(p_pool);
+        }
+    }
+    ABTI_CHECK_ERROR(abt_errno);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
 static inline ABT_bool ABTI_thread_is_ready(ABTI_thread *p_thread)
 {
     /* ULT can be regarded as 'ready' only if its state is READY and it has been
@@ -1928,6 +2342,7 @@ void ABTI_thread_print(ABTI_thread *p_thread, FILE *p_os, int indent)
         case ABTI_THREAD_TYPE_MAIN:       type = "MAIN"; break;
         case ABTI_THREAD_TYPE_MAIN_SCHED: type = "MAIN_SCHED"; break;
         case ABTI_THREAD_TYPE_USER:       type = "USER"; break;
+        case ABTI_THREAD_TYPE_TASK:       type = "TASK"; break;
         default:                          type = "UNKNOWN"; break;
     }
     switch (p_thread->state) {
@@ -2198,19 +2613,33 @@ static int ABTI_thread_revive(ABTI_local *p_local, ABTI_pool *p_pool,
 
     /* Create a ULT context */
     stacksize = p_thread->attr.stacksize;
+    /* The stack is filled again to measure the usage of the new function. */
+    if (gp_ABTI_global->stack_watermark == ABT_TRUE
+#ifndef ABT_CONFIG_DISABLE_STACKABLE_SCHED
+        && p_thread->is_sched == NULL
+#endif
+        ) {
+        ABTI_stack_usage_fill(p_thread);
+    }
 #ifndef ABT_CONFIG_DISABLE_STACKABLE_SCHED
     if (p_thread->is_sched) {
         abt_errno = ABTD_thread_context_create_sched(NULL, thread_func, arg,
                                            stacksize, p_thread->attr.p_stack,
                                            &p_thread->ctx);
-    } else {
+    } else
 #endif
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
+    if (p_thread->attr.dynamic_promotion == ABT_TRUE) {
+        /* The context is not fully created now. */
+        abt_errno = ABTD_thread_context_init(NULL, thread_func, arg,
+                                             &p_thread->ctx);
+    } else
+#endif
+    {
         abt_errno = ABTD_thread_context_create_thread(NULL, thread_func, arg,
                                            stacksize, p_thread->attr.p_stack,
                                            &p_thread->ctx);
-#ifndef ABT_CONFIG_DISABLE_STACKABLE_SCHED
     }
-#endif
     ABTI_CHECK_ERROR(abt_errno);
 
     p_thread->state          = ABT_THREAD_STATE_READY;
@@ -2263,7 +2692,7 @@ static inline int ABTI_thread_join(ABTI_local **pp_local, ABTI_thread *p_thread)
 
     ABTI_local *p_local = *pp_local;
 #ifndef ABT_CONFIG_DISABLE_EXT_THREAD
-    ABT_unit_type type = ABTI_self_get_type(p_local);
+    ABT_unit_type type = ABTI_self_get_suspend_type(p_local);
     if (type != ABT_UNIT_TYPE_THREAD) goto busywait_based;
 #endif
 
@@ -2277,7 +2706,8 @@ static inline int ABTI_thread_join(ABTI_local **pp_local, ABTI_thread *p_thread)
         (access == ABT_POOL_ACCESS_PRIV ||
          access == ABT_POOL_ACCESS_MPSC ||
          access == ABT_POOL_ACCESS_SPSC) &&
-        (p_thread->state == ABT_THREAD_STATE_READY)) {
+        (p_thread->state == ABT_THREAD_STATE_READY) &&
+        ABTI_thread_is_stack_copy(p_thread) == ABT_FALSE) {
 
         ABTI_xstream *p_xstream = p_self->p_last_xstream;
 
@@ -286,6 +286,103 @@ int ABT_thread_attr_set_migratable(ABT_thread_attr attr, ABT_bool flag)
 #endif
 }
 
+/**
+ * @ingroup ULT_ATTR
+ * @brief   Set whether the ULT uses dynamic promotion in the attribute object.
+ *
+ * \c ABT_thread_attr_set_dynamic_promotion() sets whether the ULT created
+ * with the target attribute object uses dynamic promotion.  Such a ULT does
+ * not get a full context when it is created.  It is called on its stack like
+ * a normal function and returns to the scheduler without a context switch
+ * unless it suspends; its context is created only when it suspends for the
+ * first time.  This makes ULTs that never yield or block cheaper.
+ *
+ * Dynamic promotion is available with the fcontext of x86-64 and AArch64.
+ * The default is \c ABT_TRUE if Argobots is configured with
+ * \c --enable-dynamic-promotion and \c ABT_FALSE otherwise.
+ *
+ * @param[in] attr  handle to the target attribute object
+ * @param[in] flag  dynamic promotion flag (<tt>ABT_TRUE</tt>: use dynamic
+ *                  promotion, <tt>ABT_FALSE</tt>: create the context eagerly)
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ * @retval ABT_ERR_FEATURE_NA if dynamic promotion is not supported
+ */
+int ABT_thread_attr_set_dynamic_promotion(ABT_thread_attr attr, ABT_bool flag)
+{
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
+    int abt_errno = ABT_SUCCESS;
+    ABTI_thread_attr *p_attr = ABTI_thread_attr_get_ptr(attr);
+    ABTI_CHECK_NULL_THREAD_ATTR_PTR(p_attr);
+
+    /* Set the value */
+    p_attr->dynamic_promotion = flag;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+#else
+    return ABT_ERR_FEATURE_NA;
+#endif
+}
+
+/**
+ * @ingroup ULT_ATTR
+ * @brief   Set whether the ULT copies its stack in the attribute object.
+ *
+ * \c ABT_thread_attr_set_stack_copy() sets whether the ULT created with the
+ * target attribute object is a stack-copying ULT.  Such a ULT has no stack of
+ * its own.  It runs on a stack that each ES shares among stack-copying ULTs,
+ * and when it suspends, only the part of the stack it uses is copied to a
+ * buffer of that size when another stack-copying ULT runs on the ES.  The
+ * frames are copied back when it is resumed.  This trades the copies for
+ * memory if many ULTs are suspended with shallow stacks.
+ *
+ * A stack-copying ULT keeps running on the ES where it first runs, so it is
+ * not migratable, and it should be created in a pool that only this ES
+ * consumes; other ESs that pop it push it back to its pool.  Its stack size
+ * is that of the shared stack, which is set by \c ABT_COPY_STACKSIZE, so the
+ * stack size in the attribute object is ignored.
+ * \c ABT_thread_attr_set_stack() makes the ULT use the given stack instead.
+ *
+ * Stack-copying ULTs are available when dynamic promotion is supported.
+ *
+ * @param[in] attr  handle to the target attribute object
+ * @param[in] flag  stack-copying flag (<tt>ABT_TRUE</tt>: copy the stack,
+ *                  <tt>ABT_FALSE</tt>: use a stack of its own)
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ * @retval ABT_ERR_FEATURE_NA if stack-copying ULTs are not supported
+ */
+int ABT_thread_attr_set_stack_copy(ABT_thread_attr attr, ABT_bool flag)
+{
+#ifdef ABT_CONFIG_USE_DYNAMIC_PROMOTION
+    int abt_errno = ABT_SUCCESS;
+    ABTI_thread_attr *p_attr = ABTI_thread_attr_get_ptr(attr);
+    ABTI_CHECK_NULL_THREAD_ATTR_PTR(p_attr);
+
+    /* Set the value */
+    if (flag == ABT_TRUE) {
+        p_attr->p_stack   = NULL;
+        p_attr->stacktype = ABTI_STACK_TYPE_COPY;
+    } else if (p_attr->stacktype == ABTI_STACK_TYPE_COPY) {
+        p_attr->stacktype = ABTI_STACK_TYPE_MEMPOOL;
+    }
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+#else
+    return ABT_ERR_FEATURE_NA;
+#endif
+}
+
 
 /*****************************************************************************/
 /* Private APIs                                                              */
@@ -332,6 +429,7 @@ void ABTI_thread_attr_get_str(ABTI_thread_attr *p_attr, char *p_buf)
         case ABTI_STACK_TYPE_MALLOC:  stacktype = "MALLOC"; break;
         case ABTI_STACK_TYPE_USER:    stacktype = "USER"; break;
         case ABTI_STACK_TYPE_MAIN:    stacktype = "MAIN"; break;
+        case ABTI_STACK_TYPE_COPY:    stacktype = "COPY"; break;
         default:                      stacktype = "UNKNOWN"; break;
     }
 
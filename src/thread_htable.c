@@ -222,6 +222,44 @@ ABTI_thread *ABTI_thread_htable_pop_low(ABTI_thread_htable *p_htable,
     return p_thread;
 }
 
+/* Remove p_thread from the high-priority queue of the idx-th row.  Returns
+ * ABT_FALSE if p_thread is not in the queue. */
+ABT_bool ABTI_thread_htable_remove(ABTI_thread_htable *p_htable, int idx,
+                                   ABTI_thread *p_thread)
+{
+    ABTI_thread_queue *p_queue = &p_htable->queue[idx];
+    ABTI_thread *p_prev = NULL, *p_curr;
+    ABT_bool found = ABT_FALSE;
+
+    ABTI_thread_queue_acquire_mutex(p_queue);
+    for (p_curr = p_queue->head; p_curr != NULL; ) {
+        if (p_curr == p_thread) {
+            found = ABT_TRUE;
+            break;
+        }
+        if (p_curr == p_queue->tail) break;
+        p_prev = p_curr;
+        p_curr = ABTI_thread_get_ptr(p_curr->unit_def.p_next->handle.thread);
+    }
+    if (found == ABT_TRUE) {
+        ABTD_atomic_fetch_sub_uint32(&p_htable->num_elems, 1);
+        if (p_queue->head == p_queue->tail) {
+            p_queue->head = NULL;
+            p_queue->tail = NULL;
+        } else if (p_prev == NULL) {
+            ABT_thread next = p_thread->unit_def.p_next->handle.thread;
+            p_queue->head = ABTI_thread_get_ptr(next);
+        } else {
+            p_prev->unit_def.p_next = p_thread->unit_def.p_next;
+            if (p_thread == p_queue->tail) p_queue->tail = p_prev;
+        }
+        p_queue->num_threads--;
+    }
+    ABTI_thread_queue_release_mutex(p_queue);
+
+    return found;
+}
+
 ABT_bool ABTI_thread_htable_switch_low(ABTI_local **pp_local,
                                        ABTI_thread_queue *p_queue,
                                        ABTI_thread *p_thread,
@@ -230,7 +268,9 @@ ABT_bool ABTI_thread_htable_switch_low(ABTI_local **pp_local,
     ABTI_thread *p_target = NULL;
 
     ABTI_thread_queue_acquire_low_mutex(p_queue);
-    if (p_queue->low_head) {
+    /* A stack-copying ULT cannot be switched to directly. */
+    if (p_queue->low_head &&
+        ABTI_thread_is_stack_copy(p_queue->low_head) == ABT_FALSE) {
         p_target = p_queue->low_head;
 
         /* Push p_thread to the queue */
@@ -19,6 +19,7 @@ int ABTI_timer_create(ABTI_timer **pp_newtimer);
  * \c ABT_get_wtime() returns the elapsed wall clock time in seconds
  * since an arbitrary time in the past.
  * The resolution of elapsed time is at least a unit of microsecond.
+ * The time is monotonic; it is not affected by changes of the system time.
  *
  * @return Elapsed wall clock time in seconds
  */
@@ -27,6 +28,20 @@ double ABT_get_wtime(void)
     return ABTI_get_wtime();
 }
 
+/**
+ * @ingroup TIMER
+ * @brief   Get elapsed wall clock time in nanoseconds.
+ *
+ * \c ABT_get_wtime_nsec() returns the same time as \c ABT_get_wtime() as an
+ * integer number of nanoseconds.
+ *
+ * @return Elapsed wall clock time in nanoseconds
+ */
+uint64_t ABT_get_wtime_nsec(void)
+{
+    return ABTI_get_wtime_nsec();
+}
+
 /**
  * @ingroup TIMER
  * @brief   Create a new timer.
@@ -223,6 +238,37 @@ int ABT_timer_read(ABT_timer timer, double *secs)
     goto fn_exit;
 }
 
+/**
+ * @ingroup TIMER
+ * @brief   Read the elapsed time of the timer in nanoseconds.
+ *
+ * \c ABT_timer_read_nsec() returns the time difference in nanoseconds between
+ * the start time of \c timer (when \c ABT_timer_start() was called) and the
+ * end time of \c timer (when \c ABT_timer_stop() was called) through
+ * \c nsecs.
+ *
+ * @param[in]  timer  handle to the timer
+ * @param[out] nsecs  elapsed time in nanoseconds
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_timer_read_nsec(ABT_timer timer, uint64_t *nsecs)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_timer *p_timer = ABTI_timer_get_ptr(timer);
+    ABTI_CHECK_NULL_TIMER_PTR(p_timer);
+
+    *nsecs = ABTD_time_read_nsec(&p_timer->end)
+           - ABTD_time_read_nsec(&p_timer->start);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
 /**
  * @ingroup TIMER
  * @brief   Stop the timer and read the elapsed time of the timer.
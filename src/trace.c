@@ -0,0 +1,183 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+#ifdef ABT_CONFIG_USE_TRACE
+
+static uint64_t ABTI_trace_get_nsec(void)
+{
+    ABTD_time t;
+    ABTD_time_get(&t);
+    return ABTD_time_read_nsec(&t);
+}
+
+void ABTI_trace_init(ABTI_global *p_global)
+{
+    ABTI_spinlock_clear(&p_global->trace_lock);
+    p_global->p_trace_bufs = NULL;
+    p_global->trace_start_tsc = ABTD_tsc_read();
+    p_global->trace_start_nsec = ABTI_trace_get_nsec();
+}
+
+void ABTI_trace_finalize(ABTI_global *p_global)
+{
+    ABTI_trace_buffer *p_buf, *p_next;
+
+    if (p_global->trace_file) {
+        FILE *fp = fopen(p_global->trace_file, "w");
+        if (fp) {
+            ABTI_trace_print(p_global, fp);
+            fclose(fp);
+        } else {
+            fprintf(stderr, "ABT_TRACE_FILE: cannot open %s\n",
+                    p_global->trace_file);
+        }
+        ABTU_free(p_global->trace_file);
+        p_global->trace_file = NULL;
+    }
+
+    for (p_buf = p_global->p_trace_bufs; p_buf; p_buf = p_next) {
+        p_next = p_buf->p_next;
+        ABTU_free(p_buf->events);
+        ABTU_free(p_buf);
+    }
+    p_global->p_trace_bufs = NULL;
+}
+
+/* Attach a trace buffer to p_xstream.  The buffer used by a previous ES of the
+ * same rank is reused so that its events are kept. */
+void ABTI_trace_xstream_init(ABTI_xstream *p_xstream)
+{
+    ABTI_global *p_global = gp_ABTI_global;
+    ABTI_trace_buffer *p_buf;
+
+    p_xstream->p_trace = NULL;
+    if (p_global->trace_buffer_size == 0) return;
+
+    ABTI_spinlock_acquire(&p_global->trace_lock);
+    for (p_buf = p_global->p_trace_bufs; p_buf; p_buf = p_buf->p_next) {
+        if (p_buf->rank == p_xstream->rank && p_buf->in_use == ABT_FALSE) break;
+    }
+    if (p_buf == NULL) {
+        p_buf = (ABTI_trace_buffer *)ABTU_malloc(sizeof(ABTI_trace_buffer));
+        p_buf->rank = p_xstream->rank;
+        p_buf->mask = p_global->trace_buffer_size - 1;
+        p_buf->pos = 0;
+        p_buf->events = (ABTI_trace_event *)ABTU_malloc(
+            sizeof(ABTI_trace_event) * p_global->trace_buffer_size);
+        p_buf->p_next = p_global->p_trace_bufs;
+        p_global->p_trace_bufs = p_buf;
+    }
+    p_buf->in_use = ABT_TRUE;
+    ABTI_spinlock_release(&p_global->trace_lock);
+
+    p_xstream->p_trace = p_buf;
+}
+
+void ABTI_trace_xstream_finalize(ABTI_xstream *p_xstream)
+{
+    ABTI_global *p_global = gp_ABTI_global;
+    ABTI_trace_buffer *p_buf = p_xstream->p_trace;
+
+    if (p_buf == NULL) return;
+    ABTI_spinlock_acquire(&p_global->trace_lock);
+    p_buf->in_use = ABT_FALSE;
+    ABTI_spinlock_release(&p_global->trace_lock);
+    p_xstream->p_trace = NULL;
+}
+
+static void ABTI_trace_print_event(FILE *fp, int rank, ABTI_trace_event *p_ev,
+                                   double ts)
+{
+    static const char *stop_reasons[ABTI_TRACE_NUM_STOPS] = {
+        "yield", "block", "terminate", "switch", "other"
+    };
+    const char *name = NULL;
+
+    switch (p_ev->kind) {
+        case ABTI_TRACE_EVENT_THREAD_RUN:
+        case ABTI_TRACE_EVENT_TASK_RUN:
+            fprintf(fp, ",\n{\"name\":\"%s 0x%" PRIx64 "\",\"cat\":\"%s\","
+                    "\"ph\":\"B\",\"ts\":%.3f,\"pid\":0,\"tid\":%d}",
+                    p_ev->kind == ABTI_TRACE_EVENT_THREAD_RUN ? "ULT"
+                                                              : "tasklet",
+                    p_ev->obj,
+                    p_ev->kind == ABTI_TRACE_EVENT_THREAD_RUN ? "ult"
+                                                              : "tasklet",
+                    ts, rank);
+            return;
+        case ABTI_TRACE_EVENT_THREAD_STOP:
+            fprintf(fp, ",\n{\"ph\":\"E\",\"ts\":%.3f,\"pid\":0,\"tid\":%d,"
+                    "\"args\":{\"reason\":\"%s\"}}", ts, rank,
+                    p_ev->arg < ABTI_TRACE_NUM_STOPS ? stop_reasons[p_ev->arg]
+                                                     : "unknown");
+            return;
+        case ABTI_TRACE_EVENT_TASK_END:
+            fprintf(fp, ",\n{\"ph\":\"E\",\"ts\":%.3f,\"pid\":0,\"tid\":%d}",
+                    ts, rank);
+            return;
+        case ABTI_TRACE_EVENT_THREAD_CREATE:  name = "create";    break;
+        case ABTI_TRACE_EVENT_THREAD_RESUME:  name = "resume";    break;
+        case ABTI_TRACE_EVENT_POOL_PUSH:      name = "push";      break;
+        case ABTI_TRACE_EVENT_POOL_POP:       name = "pop";       break;
+        case ABTI_TRACE_EVENT_STEAL:          name = "steal";     break;
+        case ABTI_TRACE_EVENT_MUTEX_CONTENDED: name = "contended"; break;
+        default: return;
+    }
+    fprintf(fp, ",\n{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,"
+            "\"pid\":0,\"tid\":%d,\"args\":{\"obj\":\"0x%" PRIx64 "\"",
+            name, ts, rank, p_ev->obj);
+    if (p_ev->kind == ABTI_TRACE_EVENT_POOL_PUSH ||
+        p_ev->kind == ABTI_TRACE_EVENT_POOL_POP ||
+        p_ev->kind == ABTI_TRACE_EVENT_STEAL) {
+        fprintf(fp, ",\"pool\":%u", p_ev->arg);
+    }
+    fprintf(fp, "}}");
+}
+
+/* Write all the trace buffers in the Chrome trace event format.  Each ES is
+ * shown as a thread whose ID is its rank.  Tick counts are converted to
+ * microseconds with the tick rate measured since ABTI_trace_init(). */
+void ABTI_trace_print(ABTI_global *p_global, FILE *fp)
+{
+    ABTI_trace_buffer *p_buf;
+    uint64_t end_tsc, end_nsec, i, first;
+
+    /* Wait for a while if tracing has just started so that the tick rate can
+     * be measured precisely enough. */
+    do {
+        end_tsc = ABTD_tsc_read();
+        end_nsec = ABTI_trace_get_nsec();
+    } while (end_nsec - p_global->trace_start_nsec < 10000000);
+    double usec_per_tick = (double)(end_nsec - p_global->trace_start_nsec)
+                         / (double)(end_tsc - p_global->trace_start_tsc)
+                         * 1.0e-3;
+
+    fprintf(fp, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    fprintf(fp, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,"
+            "\"args\":{\"name\":\"Argobots\"}}");
+
+    ABTI_spinlock_acquire(&p_global->trace_lock);
+    for (p_buf = p_global->p_trace_bufs; p_buf; p_buf = p_buf->p_next) {
+        uint64_t pos = p_buf->pos;
+        fprintf(fp, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,"
+                "\"tid\":%d,\"args\":{\"name\":\"ES %d\"}}",
+                p_buf->rank, p_buf->rank);
+        first = (pos > p_buf->mask + 1) ? pos - (p_buf->mask + 1) : 0;
+        for (i = first; i < pos; i++) {
+            ABTI_trace_event *p_ev = &p_buf->events[i & p_buf->mask];
+            double ts = (double)(p_ev->tsc - p_global->trace_start_tsc)
+                      * usec_per_tick;
+            ABTI_trace_print_event(fp, p_buf->rank, p_ev, ts);
+        }
+    }
+    ABTI_spinlock_release(&p_global->trace_lock);
+
+    fprintf(fp, "\n]}\n");
+    fflush(fp);
+}
+
+#endif /* ABT_CONFIG_USE_TRACE */
@@ -0,0 +1,233 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+#define TWHEEL_SHIFT(level)     (ABTI_TWHEEL_SLOT_BITS * (level))
+#define TWHEEL_SLOT_MASK        (ABTI_TWHEEL_NUM_SLOTS - 1)
+#define TWHEEL_MAX_DELTA        \
+    ((UINT64_C(1) << TWHEEL_SHIFT(ABTI_TWHEEL_NUM_LEVELS)) - 1)
+
+static inline
+void twheel_link(ABTI_twheel *p_wheel, ABTI_twheel_entry *p_entry,
+                 int level, int slot)
+{
+    ABTI_twheel_entry **pp_head = &p_wheel->slots[level][slot];
+    p_entry->p_prev = NULL;
+    p_entry->p_next = *pp_head;
+    if (*pp_head) (*pp_head)->p_prev = p_entry;
+    *pp_head = p_entry;
+    p_wheel->occupied[level] |= UINT64_C(1) << slot;
+    p_entry->level = level;
+    p_entry->slot = slot;
+}
+
+static inline
+void twheel_unlink(ABTI_twheel *p_wheel, ABTI_twheel_entry *p_entry)
+{
+    int level = p_entry->level, slot = p_entry->slot;
+    if (p_entry->p_prev) {
+        p_entry->p_prev->p_next = p_entry->p_next;
+    } else {
+        p_wheel->slots[level][slot] = p_entry->p_next;
+        if (p_entry->p_next == NULL) {
+            p_wheel->occupied[level] &= ~(UINT64_C(1) << slot);
+        }
+    }
+    if (p_entry->p_next) p_entry->p_next->p_prev = p_entry->p_prev;
+}
+
+/* Put p_entry in the slot that the current tick reaches at its deadline.  The
+ * deadline is rounded up to a tick so that the entry never expires early. */
+static void twheel_place(ABTI_twheel *p_wheel, ABTI_twheel_entry *p_entry,
+                         uint64_t min_target)
+{
+    uint64_t tick_mask = (UINT64_C(1) << ABTI_TWHEEL_TICK_SHIFT) - 1;
+    uint64_t target = (p_entry->deadline + tick_mask) >> ABTI_TWHEEL_TICK_SHIFT;
+    uint64_t delta;
+    int level;
+
+    if (target < min_target) target = min_target;
+    delta = target - p_wheel->cur;
+    if (delta > TWHEEL_MAX_DELTA) {
+        /* It will be placed again when this slot is cascaded. */
+        delta = TWHEEL_MAX_DELTA;
+        target = p_wheel->cur + delta;
+    }
+    for (level = 0; level < ABTI_TWHEEL_NUM_LEVELS - 1; level++) {
+        if (delta < (UINT64_C(1) << TWHEEL_SHIFT(level + 1))) break;
+    }
+    twheel_link(p_wheel, p_entry, level,
+                (int)((target >> TWHEEL_SHIFT(level)) & TWHEEL_SLOT_MASK));
+}
+
+/* Move the entries of the slot of level that the current tick has reached to
+ * lower levels.  Higher levels are cascaded first. */
+static void twheel_cascade(ABTI_twheel *p_wheel, int level)
+{
+    ABTI_twheel_entry *p_entry, *p_next;
+    int slot;
+
+    if (level >= ABTI_TWHEEL_NUM_LEVELS) return;
+    slot = (int)((p_wheel->cur >> TWHEEL_SHIFT(level)) & TWHEEL_SLOT_MASK);
+    if (slot == 0) twheel_cascade(p_wheel, level + 1);
+
+    p_entry = p_wheel->slots[level][slot];
+    p_wheel->slots[level][slot] = NULL;
+    p_wheel->occupied[level] &= ~(UINT64_C(1) << slot);
+    while (p_entry) {
+        p_next = p_entry->p_next;
+        twheel_place(p_wheel, p_entry, p_wheel->cur);
+        p_entry = p_next;
+    }
+}
+
+ABTI_twheel *ABTI_twheel_create(void)
+{
+    ABTI_twheel *p_wheel = (ABTI_twheel *)ABTU_calloc(1, sizeof(ABTI_twheel));
+    ABTI_spinlock_clear(&p_wheel->lock);
+    p_wheel->cur = ABTI_get_wtime_nsec() >> ABTI_TWHEEL_TICK_SHIFT;
+    return p_wheel;
+}
+
+void ABTI_twheel_free(ABTI_twheel *p_wheel)
+{
+    ABTI_ASSERT(p_wheel->num_entries == 0);
+    ABTU_free(p_wheel);
+}
+
+/* Add p_entry, whose deadline, f_expire, and p_arg have been set.  This must
+ * be called by the owner ES of p_wheel. */
+void ABTI_twheel_add(ABTI_twheel *p_wheel, ABTI_twheel_entry *p_entry)
+{
+    p_entry->p_wheel = p_wheel;
+    ABTI_spinlock_acquire(&p_wheel->lock);
+    p_entry->is_pending = ABT_TRUE;
+    p_entry->is_firing = 0;
+    if (p_wheel->num_entries == 0) {
+        /* The owner does not advance an empty wheel, so cur may be stale.
+         * Otherwise, the next advance would walk all the ticks since cur,
+         * and the entry could go to a higher level than its delay needs. */
+        uint64_t now = ABTI_get_wtime_nsec() >> ABTI_TWHEEL_TICK_SHIFT;
+        if (p_wheel->cur < now) p_wheel->cur = now;
+    }
+    twheel_place(p_wheel, p_entry, p_wheel->cur + 1);
+    p_wheel->num_entries++;
+    ABTI_spinlock_release(&p_wheel->lock);
+}
+
+/* Remove p_entry if it has not expired.  Returns ABT_FALSE if f_expire has
+ * been or is being called. */
+ABT_bool ABTI_twheel_remove(ABTI_twheel_entry *p_entry)
+{
+    ABTI_twheel *p_wheel = p_entry->p_wheel;
+    ABT_bool removed = ABT_FALSE;
+
+    ABTI_spinlock_acquire(&p_wheel->lock);
+    if (p_entry->is_pending == ABT_TRUE) {
+        twheel_unlink(p_wheel, p_entry);
+        p_entry->is_pending = ABT_FALSE;
+        p_wheel->num_entries--;
+        removed = ABT_TRUE;
+    }
+    ABTI_spinlock_release(&p_wheel->lock);
+
+    return removed;
+}
+
+/* Make sure that p_wheel no longer uses p_entry.  If f_expire of p_entry has
+ * been called, this waits until f_expire calls ABTI_twheel_fired(). */
+void ABTI_twheel_cancel(ABTI_twheel_entry *p_entry)
+{
+    if (ABTI_twheel_remove(p_entry) == ABT_FALSE) {
+        while (ABTD_atomic_load_uint32(&p_entry->is_firing)) {
+            ABTD_atomic_pause();
+        }
+    }
+}
+
+/* Called by f_expire when it does not access p_entry anymore. */
+void ABTI_twheel_fired(ABTI_twheel_entry *p_entry)
+{
+    ABTD_atomic_store_uint32(&p_entry->is_firing, 0);
+}
+
+/* Advance the current tick to now_nsec and call f_expire of the expired
+ * entries outside the lock.  This must be called by the owner ES. */
+void ABTI_twheel_advance(ABTI_local *p_local, ABTI_twheel *p_wheel,
+                         uint64_t now_nsec)
+{
+    uint64_t now = now_nsec >> ABTI_TWHEEL_TICK_SHIFT;
+    ABTI_twheel_entry *p_expired = NULL, *p_entry, *p_next;
+
+    ABTI_spinlock_acquire(&p_wheel->lock);
+    while (p_wheel->cur < now) {
+        if (p_wheel->num_entries == 0) {
+            p_wheel->cur = now;
+            break;
+        }
+        if (p_wheel->occupied[0] == 0) {
+            /* Nothing expires before the next cascade. */
+            uint64_t boundary = (p_wheel->cur | TWHEEL_SLOT_MASK) + 1;
+            if (boundary > now) {
+                p_wheel->cur = now;
+                break;
+            }
+            p_wheel->cur = boundary;
+        } else {
+            p_wheel->cur++;
+        }
+        if ((p_wheel->cur & TWHEEL_SLOT_MASK) == 0) twheel_cascade(p_wheel, 1);
+
+        int slot = (int)(p_wheel->cur & TWHEEL_SLOT_MASK);
+        p_entry = p_wheel->slots[0][slot];
+        p_wheel->slots[0][slot] = NULL;
+        p_wheel->occupied[0] &= ~(UINT64_C(1) << slot);
+        while (p_entry) {
+            p_next = p_entry->p_next;
+            p_entry->is_pending = ABT_FALSE;
+            p_entry->is_firing = 1;
+            p_wheel->num_entries--;
+            p_entry->p_next = p_expired;
+            p_expired = p_entry;
+            p_entry = p_next;
+        }
+    }
+    ABTI_spinlock_release(&p_wheel->lock);
+
+    while (p_expired) {
+        /* p_expired may be freed by f_expire. */
+        p_next = p_expired->p_next;
+        p_expired->f_expire(p_local, p_expired);
+        p_expired = p_next;
+    }
+}
+
+/* Return the earliest time (nanoseconds) at which ABTI_twheel_advance() may
+ * expire or cascade entries, or UINT64_MAX if p_wheel is empty. */
+uint64_t ABTI_twheel_get_next_nsec(ABTI_twheel *p_wheel)
+{
+    uint64_t next = UINT64_MAX;
+    int level, i;
+
+    ABTI_spinlock_acquire(&p_wheel->lock);
+    for (level = 0; level < ABTI_TWHEEL_NUM_LEVELS; level++) {
+        uint64_t occupied = p_wheel->occupied[level];
+        if (occupied == 0) continue;
+
+        /* Find the first non-empty slot after the current one. */
+        uint64_t digits = p_wheel->cur >> TWHEEL_SHIFT(level);
+        for (i = 1; i <= ABTI_TWHEEL_NUM_SLOTS; i++) {
+            int slot = (int)((digits + i) & TWHEEL_SLOT_MASK);
+            if (occupied & (UINT64_C(1) << slot)) break;
+        }
+        uint64_t tick = (digits + i) << TWHEEL_SHIFT(level);
+        if (tick < next) next = tick;
+    }
+    ABTI_spinlock_release(&p_wheel->lock);
+
+    return (next == UINT64_MAX) ? UINT64_MAX
+                                : next << ABTI_TWHEEL_TICK_SHIFT;
+}
@@ -62,3 +62,30 @@ void ABTI_unit_set_associated_pool(ABT_unit unit, ABTI_pool *p_pool)
         p_task->p_pool = p_pool;
     }
 }
+
+/* Re-create a unit that has been popped from p_src as a unit of p_dst and
+ * associate its work unit with p_dst.  The returned unit can be pushed to
+ * p_dst. */
+ABT_unit ABTI_unit_move_to_pool(ABTI_pool *p_src, ABT_unit unit,
+                                ABTI_pool *p_dst)
+{
+    ABT_unit_type type = p_src->u_get_type(unit);
+
+    if (type == ABT_UNIT_TYPE_THREAD) {
+        ABT_thread thread = p_src->u_get_thread(unit);
+        ABTI_thread *p_thread = ABTI_thread_get_ptr(thread);
+        p_src->u_free(&p_thread->unit);
+        p_thread->unit = p_dst->u_create_from_thread(thread);
+        p_thread->p_pool = p_dst;
+        return p_thread->unit;
+
+    } else {
+        ABTI_ASSERT(type == ABT_UNIT_TYPE_TASK);
+        ABT_task task = p_src->u_get_task(unit);
+        ABTI_task *p_task = ABTI_task_get_ptr(task);
+        p_src->u_free(&p_task->unit);
+        p_task->unit = p_dst->u_create_from_task(task);
+        p_task->p_pool = p_dst;
+        return p_task->unit;
+    }
+}
@@ -0,0 +1,191 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/time.h>
+#include <pthread.h>
+#include "abt.h"
+#include "abttest.h"
+
+/* This code tests that pthreads can block on eventuals, futures, barriers,
+ * and condition variables until ULTs wake them up. */
+
+#define DEFAULT_NUM_PTHREADS    4
+#define TIMEOUT_MSEC            5
+
+static int num_pthreads;
+static ABT_eventual g_eventual;
+static ABT_future g_future;
+static ABT_barrier g_barrier;
+static ABT_mutex g_mutex;
+static ABT_cond g_cond;
+static int g_flag = 0;
+static int g_num_woken = 0;
+
+static void get_abstime(struct timespec *p_ts, int msec)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    p_ts->tv_sec = tv.tv_sec + msec / 1000;
+    p_ts->tv_nsec = tv.tv_usec * 1000 + (msec % 1000) * 1000000;
+    if (p_ts->tv_nsec >= 1000000000) {
+        p_ts->tv_sec++;
+        p_ts->tv_nsec -= 1000000000;
+    }
+}
+
+void *pthread_eventual(void *arg)
+{
+    int *p_value;
+    int ret = ABT_eventual_wait(g_eventual, (void **)&p_value);
+    ATS_ERROR(ret, "ABT_eventual_wait");
+    if (*p_value == 42) __sync_fetch_and_add(&g_num_woken, 1);
+    return NULL;
+}
+
+void *pthread_future(void *arg)
+{
+    int ret = ABT_future_wait(g_future);
+    ATS_ERROR(ret, "ABT_future_wait");
+    __sync_fetch_and_add(&g_num_woken, 1);
+    return NULL;
+}
+
+void *pthread_barrier(void *arg)
+{
+    int ret = ABT_barrier_wait(g_barrier);
+    ATS_ERROR(ret, "ABT_barrier_wait");
+    __sync_fetch_and_add(&g_num_woken, 1);
+    return NULL;
+}
+
+void *pthread_cond(void *arg)
+{
+    int ret;
+    ret = ABT_mutex_lock(g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_lock");
+    while (g_flag == 0) {
+        ret = ABT_cond_wait(g_cond, g_mutex);
+        ATS_ERROR(ret, "ABT_cond_wait");
+    }
+    g_num_woken++;
+    ret = ABT_mutex_unlock(g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_unlock");
+    return NULL;
+}
+
+void *pthread_timedwait(void *arg)
+{
+    struct timespec ts;
+    int ret;
+    get_abstime(&ts, TIMEOUT_MSEC);
+    ret = ABT_eventual_timedwait(g_eventual, NULL, &ts);
+    if (ret == ABT_ERR_TIMEDOUT) __sync_fetch_and_add(&g_num_woken, 1);
+    return NULL;
+}
+
+/* Run num_pthreads pthreads executing func while the calling ULT executes
+ * wake after a while.  Returns the number of pthreads that are not woken. */
+static int run_pthreads(void *(*func)(void *), void (*wake)(void))
+{
+    pthread_t *pthreads;
+    int i, ret;
+
+    pthreads = (pthread_t *)malloc(sizeof(pthread_t) * num_pthreads);
+    g_num_woken = 0;
+    for (i = 0; i < num_pthreads; i++) {
+        ret = pthread_create(&pthreads[i], NULL, func, NULL);
+        assert(ret == 0);
+    }
+    /* Let the pthreads block. */
+    ret = ABT_thread_sleep(0.01);
+    ATS_ERROR(ret, "ABT_thread_sleep");
+    if (wake) wake();
+    for (i = 0; i < num_pthreads; i++) {
+        ret = pthread_join(pthreads[i], NULL);
+        assert(ret == 0);
+    }
+    free(pthreads);
+    return num_pthreads - g_num_woken;
+}
+
+static void wake_eventual(void)
+{
+    static int value = 42;
+    int ret = ABT_eventual_set(g_eventual, &value, sizeof(int));
+    ATS_ERROR(ret, "ABT_eventual_set");
+}
+
+static void wake_future(void)
+{
+    int ret = ABT_future_set(g_future, NULL);
+    ATS_ERROR(ret, "ABT_future_set");
+}
+
+static void wake_barrier(void)
+{
+    int ret = ABT_barrier_wait(g_barrier);
+    ATS_ERROR(ret, "ABT_barrier_wait");
+}
+
+static void wake_cond(void)
+{
+    int ret;
+    ret = ABT_mutex_lock(g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_lock");
+    g_flag = 1;
+    ret = ABT_cond_broadcast(g_cond);
+    ATS_ERROR(ret, "ABT_cond_broadcast");
+    ret = ABT_mutex_unlock(g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_unlock");
+}
+
+int main(int argc, char *argv[])
+{
+    int ret, num_errors = 0;
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc < 2) {
+        num_pthreads = DEFAULT_NUM_PTHREADS;
+    } else {
+        num_pthreads = ATS_get_arg_val(ATS_ARG_N_ULT);
+    }
+    ATS_init(argc, argv, 1);
+
+    ret = ABT_eventual_create(sizeof(int), &g_eventual);
+    ATS_ERROR(ret, "ABT_eventual_create");
+    ret = ABT_future_create(1, NULL, &g_future);
+    ATS_ERROR(ret, "ABT_future_create");
+    ret = ABT_barrier_create(num_pthreads + 1, &g_barrier);
+    ATS_ERROR(ret, "ABT_barrier_create");
+    ret = ABT_mutex_create(&g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_create");
+    ret = ABT_cond_create(&g_cond);
+    ATS_ERROR(ret, "ABT_cond_create");
+
+    num_errors += run_pthreads(pthread_timedwait, NULL);
+    num_errors += run_pthreads(pthread_eventual, wake_eventual);
+    num_errors += run_pthreads(pthread_future, wake_future);
+    num_errors += run_pthreads(pthread_barrier, wake_barrier);
+    num_errors += run_pthreads(pthread_cond, wake_cond);
+
+    ret = ABT_cond_free(&g_cond);
+    ATS_ERROR(ret, "ABT_cond_free");
+    ret = ABT_mutex_free(&g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_free");
+    ret = ABT_barrier_free(&g_barrier);
+    ATS_ERROR(ret, "ABT_barrier_free");
+    ret = ABT_future_free(&g_future);
+    ATS_ERROR(ret, "ABT_future_free");
+    ret = ABT_eventual_free(&g_eventual);
+    ATS_ERROR(ret, "ABT_eventual_free");
+
+    /* Finalize */
+    ATS_printf(1, "# of pthreads not woken: %d\n", num_errors);
+    return ATS_finalize(num_errors);
+}
@@ -0,0 +1,165 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     100
+#define DEFAULT_NUM_TASKS       100
+#define NUM_YIELDS              3
+
+static int g_counter = 0;
+
+void thread_func(void *arg)
+{
+    int i;
+    ATS_UNUSED(arg);
+    for (i = 0; i < NUM_YIELDS; i++) {
+        ABT_thread_yield();
+    }
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+void task_func(void *arg)
+{
+    ATS_UNUSED(arg);
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+int main(int argc, char *argv[])
+{
+    int i, k;
+    int ret;
+    int num_xstreams, num_threads, num_tasks;
+    ABT_bool enabled;
+    ABT_xstream_counters counters, total;
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc < 2) {
+        num_xstreams = DEFAULT_NUM_XSTREAMS;
+        num_threads  = DEFAULT_NUM_THREADS;
+        num_tasks    = DEFAULT_NUM_TASKS;
+    } else {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads  = ATS_get_arg_val(ATS_ARG_N_ULT);
+        num_tasks    = ATS_get_arg_val(ATS_ARG_N_TASK);
+    }
+    ATS_init(argc, argv, num_xstreams);
+
+    ret = ABT_info_query_config(ABT_INFO_QUERY_KIND_ENABLED_PERF_COUNTERS,
+                                &enabled);
+    ATS_ERROR(ret, "ABT_info_query_config");
+    if (enabled == ABT_FALSE) {
+        ret = ABT_info_query_all_xstream_counters(&total);
+        if (ret != ABT_ERR_FEATURE_NA) {
+            ATS_ERROR(ABT_ERR_FEATURE_NA, "ABT_info_query_all_xstream_counters");
+        }
+        ATS_printf(1, "performance counters are not enabled\n");
+        return ATS_finalize(0);
+    }
+
+    ABT_xstream *xstreams;
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    ABT_pool *pools;
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    ABT_pool *my_pools;
+    my_pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+
+    /* Create Execution Streams with work-stealing schedulers */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC,
+                                    ABT_TRUE, &pools[i]);
+        ATS_ERROR(ret, "ABT_pool_create_basic");
+    }
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 0; i < num_xstreams; i++) {
+        for (k = 0; k < num_xstreams; k++) {
+            my_pools[k] = pools[(i + k) % num_xstreams];
+        }
+        if (i == 0) {
+            ret = ABT_xstream_set_main_sched_basic(xstreams[0],
+                                                   ABT_SCHED_RANDWS,
+                                                   num_xstreams, my_pools);
+            ATS_ERROR(ret, "ABT_xstream_set_main_sched_basic");
+        } else {
+            ret = ABT_xstream_create_basic(ABT_SCHED_RANDWS, num_xstreams,
+                                           my_pools, ABT_SCHED_CONFIG_NULL,
+                                           &xstreams[i]);
+            ATS_ERROR(ret, "ABT_xstream_create_basic");
+        }
+    }
+
+    /* Create work units in the last pool so that they are stolen */
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pools[num_xstreams - 1], thread_func, NULL,
+                                ABT_THREAD_ATTR_NULL, NULL);
+        ATS_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < num_tasks; i++) {
+        ret = ABT_task_create(pools[num_xstreams - 1], task_func, NULL, NULL);
+        ATS_ERROR(ret, "ABT_task_create");
+    }
+
+    /* Wait for the work units, which may run on this ES */
+    while (__sync_fetch_and_add(&g_counter, 0) < num_threads + num_tasks) {
+        ABT_thread_yield();
+    }
+
+    /* Join Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+    }
+
+    /* The aggregate must be the sum of the counters of each ES */
+    ret = ABT_info_query_all_xstream_counters(&total);
+    ATS_ERROR(ret, "ABT_info_query_all_xstream_counters");
+    uint64_t num_units = 0;
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_info_query_xstream_counters(xstreams[i], &counters);
+        ATS_ERROR(ret, "ABT_info_query_xstream_counters");
+        ATS_printf(1, "ES%d: %lu ULTs, %lu tasklets, %lu context switches, "
+                   "%lu/%lu steals, %lu ns idle\n", i,
+                   (unsigned long)counters.num_threads,
+                   (unsigned long)counters.num_tasks,
+                   (unsigned long)counters.num_ctxsw,
+                   (unsigned long)counters.num_steals,
+                   (unsigned long)(counters.num_steals
+                                   + counters.num_failed_steals),
+                   (unsigned long)counters.idle_nsec);
+        num_units += counters.num_threads + counters.num_tasks;
+    }
+    if (num_units != total.num_threads + total.num_tasks) {
+        ATS_ERROR(ABT_ERR_OTHER, "ABT_info_query_all_xstream_counters");
+    }
+
+    /* The main ULT and the ULTs that the ES schedulers run are also counted,
+     * so these are lower bounds. */
+    if (total.num_threads < (uint64_t)num_threads * (NUM_YIELDS + 1) ||
+        total.num_tasks < (uint64_t)num_tasks ||
+        total.num_ctxsw < total.num_threads) {
+        ATS_ERROR(ABT_ERR_OTHER, "ABT_info_query_all_xstream_counters");
+    }
+
+    /* Free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Finalize */
+    ret = ATS_finalize(0);
+
+    free(my_pools);
+    free(pools);
+    free(xstreams);
+
+    return ret;
+}
@@ -0,0 +1,162 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     100
+#define DEFAULT_NUM_TASKS       100
+#define NUM_YIELDS              3
+
+static int g_counter = 0;
+static ABT_mutex g_mutex;
+
+void thread_func(void *arg)
+{
+    int i;
+    ATS_UNUSED(arg);
+    for (i = 0; i < NUM_YIELDS; i++) {
+        ABT_mutex_lock(g_mutex);
+        ABT_thread_yield();
+        ABT_mutex_unlock(g_mutex);
+    }
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+void task_func(void *arg)
+{
+    ATS_UNUSED(arg);
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+/* Count the occurrences of pattern in fp. */
+static int count_pattern(FILE *fp, const char *pattern)
+{
+    char line[1024];
+    int count = 0;
+
+    rewind(fp);
+    while (fgets(line, sizeof(line), fp)) {
+        const char *p = line;
+        while ((p = strstr(p, pattern)) != NULL) {
+            count++;
+            p += strlen(pattern);
+        }
+    }
+    return count;
+}
+
+int main(int argc, char *argv[])
+{
+    int i;
+    int ret;
+    int num_xstreams, num_threads, num_tasks;
+    ABT_bool enabled;
+    FILE *fp;
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc < 2) {
+        num_xstreams = DEFAULT_NUM_XSTREAMS;
+        num_threads  = DEFAULT_NUM_THREADS;
+        num_tasks    = DEFAULT_NUM_TASKS;
+    } else {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads  = ATS_get_arg_val(ATS_ARG_N_ULT);
+        num_tasks    = ATS_get_arg_val(ATS_ARG_N_TASK);
+    }
+    ATS_init(argc, argv, num_xstreams);
+
+    ret = ABT_info_query_config(ABT_INFO_QUERY_KIND_ENABLED_TRACE, &enabled);
+    ATS_ERROR(ret, "ABT_info_query_config");
+    if (enabled == ABT_FALSE) {
+        ret = ABT_info_print_trace(stdout);
+        if (ret != ABT_ERR_FEATURE_NA) {
+            ATS_ERROR(ABT_ERR_FEATURE_NA, "ABT_info_print_trace");
+        }
+        ATS_printf(1, "tracing is not enabled\n");
+        return ATS_finalize(0);
+    }
+
+    ABT_xstream *xstreams;
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    ABT_pool *pools;
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+
+    ret = ABT_mutex_create(&g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_create");
+
+    /* Create Execution Streams */
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, pools + i);
+        ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    /* Create work units */
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pools[i % num_xstreams], thread_func, NULL,
+                                ABT_THREAD_ATTR_NULL, NULL);
+        ATS_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < num_tasks; i++) {
+        ret = ABT_task_create(pools[i % num_xstreams], task_func, NULL, NULL);
+        ATS_ERROR(ret, "ABT_task_create");
+    }
+
+    /* Wait for the work units, which may run on this ES */
+    while (__sync_fetch_and_add(&g_counter, 0) < num_threads + num_tasks) {
+        ABT_thread_yield();
+    }
+
+    /* Join and free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* The events of the freed ESs must be kept.  Every ULT runs at least
+     * NUM_YIELDS + 1 times. */
+    fp = tmpfile();
+    if (fp == NULL) {
+        ATS_ERROR(ABT_ERR_OTHER, "tmpfile");
+    }
+    ret = ABT_info_print_trace(fp);
+    ATS_ERROR(ret, "ABT_info_print_trace");
+    int num_es = count_pattern(fp, "\"thread_name\"");
+    int num_ult_runs = count_pattern(fp, "\"cat\":\"ult\"");
+    int num_task_runs = count_pattern(fp, "\"cat\":\"tasklet\"");
+    int num_events = count_pattern(fp, "\"traceEvents\"");
+    ATS_printf(1, "ESs: %d, ULT runs: %d, tasklet runs: %d\n",
+               num_es, num_ult_runs, num_task_runs);
+    if (num_events != 1 || num_es < num_xstreams ||
+        num_ult_runs < num_threads * (NUM_YIELDS + 1) ||
+        num_task_runs < num_tasks) {
+        ATS_ERROR(ABT_ERR_OTHER, "ABT_info_print_trace");
+    }
+    fclose(fp);
+
+    ret = ABT_mutex_free(&g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_free");
+
+    /* Finalize */
+    ret = ATS_finalize(0);
+
+    free(pools);
+    free(xstreams);
+
+    return ret;
+}
@@ -0,0 +1,253 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include "abt.h"
+#include "abttest.h"
+
+/* This code tests the NUMA-aware memory pool.  ULTs and tasklets are created
+ * on each ES, freed by the main ULT, and the ESs are joined and created again
+ * in each iteration, so stacks and task block pages go through the global
+ * lists.  Then, an ES is bound to a CPU of each NUMA node, and the stack of a
+ * ULT created by that ES is checked to be on the node.  The test is skipped
+ * on a machine with a single NUMA node. */
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     256
+#define DEFAULT_NUM_ITER        5
+#define MAX_NUM_NODES           64
+
+/* MPOL_F_NODE and MPOL_F_ADDR of <numaif.h> */
+#define TEST_MPOL_F_NODE        (1 << 0)
+#define TEST_MPOL_F_ADDR        (1 << 1)
+
+static int g_counter = 0;
+
+typedef struct {
+    int node;       /* Node where the stack of the child ULT is placed */
+} placement_arg_t;
+
+static void thread_func(void *arg)
+{
+    int idx = (int)(intptr_t)arg;
+    char buf[1024];
+    memset(buf, idx & 0xff, sizeof(buf));
+    ABT_thread_yield();
+    if (buf[idx % sizeof(buf)] == (char)(idx & 0xff)) {
+        __sync_fetch_and_add(&g_counter, 1);
+    }
+}
+
+static void task_func(void *arg)
+{
+    ATS_UNUSED(arg);
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+/* Return the NUMA node of the page at addr, or -1 if it is unknown. */
+static int get_node_of_addr(void *addr)
+{
+    int node = -1;
+#ifdef SYS_get_mempolicy
+    if (syscall(SYS_get_mempolicy, &node, NULL, 0, addr,
+                TEST_MPOL_F_NODE | TEST_MPOL_F_ADDR) != 0) {
+        node = -1;
+    }
+#else
+    ATS_UNUSED(addr);
+#endif
+    return node;
+}
+
+/* Store the ID and the first CPU of each NUMA node that has CPUs in nodes and
+ * cpus, and return the number of such nodes. */
+static int get_node_cpus(int *nodes, int *cpus, int max_nodes)
+{
+    char path[128];
+    int node, cpu, num_nodes = 0;
+    FILE *fp;
+
+    for (node = 0; node < max_nodes; node++) {
+        sprintf(path, "/sys/devices/system/node/node%d/cpulist", node);
+        fp = fopen(path, "r");
+        if (fp == NULL) continue;
+        if (fscanf(fp, "%d", &cpu) == 1) {
+            nodes[num_nodes] = node;
+            cpus[num_nodes] = cpu;
+            num_nodes++;
+        }
+        fclose(fp);
+    }
+    return num_nodes;
+}
+
+static void child_func(void *arg)
+{
+    placement_arg_t *p_arg = (placement_arg_t *)arg;
+    volatile char buf[256];
+    memset((void *)buf, 0, sizeof(buf));
+    p_arg->node = get_node_of_addr((void *)buf);
+}
+
+/* The stack of the child is allocated by the ES on which this ULT runs. */
+static void parent_func(void *arg)
+{
+    ABT_xstream xstream;
+    ABT_pool pool;
+    ABT_thread child;
+    int ret;
+
+    ret = ABT_xstream_self(&xstream);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_get_main_pools(xstream, 1, &pool);
+    ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+    ret = ABT_thread_create(pool, child_func, arg, ABT_THREAD_ATTR_NULL,
+                            &child);
+    ATS_ERROR(ret, "ABT_thread_create");
+    ret = ABT_thread_free(&child);
+    ATS_ERROR(ret, "ABT_thread_free");
+}
+
+/* Return the node where a ULT created by an ES bound to cpu has its stack, or
+ * -1 if the ES cannot be bound to cpu. */
+static int check_placement(int cpu)
+{
+    ABT_xstream xstream;
+    ABT_pool pool;
+    ABT_thread thread;
+    placement_arg_t arg = { -1 };
+    int ret;
+
+    ret = ABT_xstream_create(ABT_SCHED_NULL, &xstream);
+    ATS_ERROR(ret, "ABT_xstream_create");
+    if (ABT_xstream_set_cpubind(xstream, cpu) == ABT_SUCCESS) {
+        ret = ABT_xstream_get_main_pools(xstream, 1, &pool);
+        ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+        ret = ABT_thread_create(pool, parent_func, (void *)&arg,
+                                ABT_THREAD_ATTR_NULL, &thread);
+        ATS_ERROR(ret, "ABT_thread_create");
+        ret = ABT_thread_free(&thread);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+    ret = ABT_xstream_join(xstream);
+    ATS_ERROR(ret, "ABT_xstream_join");
+    ret = ABT_xstream_free(&xstream);
+    ATS_ERROR(ret, "ABT_xstream_free");
+    return arg.node;
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    ABT_task *tasks;
+    int i, n, ret;
+    int num_xstreams, num_threads, num_iter;
+    int num_errors = 0;
+    int nodes[MAX_NUM_NODES], node_cpus[MAX_NUM_NODES];
+    int num_nodes, num_checked = 0;
+
+    setenv("ABT_MEM_NUMA", "1", 1);
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc < 2) {
+        num_xstreams = DEFAULT_NUM_XSTREAMS;
+        num_threads  = DEFAULT_NUM_THREADS;
+        num_iter     = DEFAULT_NUM_ITER;
+    } else {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads  = ATS_get_arg_val(ATS_ARG_N_ULT);
+        num_iter     = ATS_get_arg_val(ATS_ARG_N_ITER);
+    }
+    ATS_init(argc, argv, num_xstreams);
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+    tasks = (ABT_task *)malloc(sizeof(ABT_task) * num_threads);
+
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+
+    for (n = 0; n < num_iter; n++) {
+        /* Create Execution Streams */
+        for (i = 1; i < num_xstreams; i++) {
+            ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+            ATS_ERROR(ret, "ABT_xstream_create");
+        }
+        for (i = 0; i < num_xstreams; i++) {
+            ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+            ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+        }
+
+        /* ULTs and tasklets are allocated by the main ULT and the ULTs. */
+        for (i = 0; i < num_threads; i++) {
+            ret = ABT_thread_create(pools[i % num_xstreams], thread_func,
+                                    (void *)(intptr_t)i,
+                                    ABT_THREAD_ATTR_NULL, &threads[i]);
+            ATS_ERROR(ret, "ABT_thread_create");
+            ret = ABT_task_create(pools[(i + 1) % num_xstreams], task_func,
+                                  NULL, &tasks[i]);
+            ATS_ERROR(ret, "ABT_task_create");
+        }
+        for (i = 0; i < num_threads; i++) {
+            ret = ABT_thread_free(&threads[i]);
+            ATS_ERROR(ret, "ABT_thread_free");
+            ret = ABT_task_free(&tasks[i]);
+            ATS_ERROR(ret, "ABT_task_free");
+        }
+
+        /* Stacks and pages of the ESs are returned to the global lists. */
+        for (i = 1; i < num_xstreams; i++) {
+            ret = ABT_xstream_join(xstreams[i]);
+            ATS_ERROR(ret, "ABT_xstream_join");
+            ret = ABT_xstream_free(&xstreams[i]);
+            ATS_ERROR(ret, "ABT_xstream_free");
+        }
+    }
+
+    if (g_counter != 2 * num_threads * num_iter) {
+        printf("counter = %d (expected: %d)\n", g_counter,
+               2 * num_threads * num_iter);
+        num_errors++;
+    }
+
+    /* The stack of a ULT is placed on the node of the ES that creates it. */
+    num_nodes = get_node_cpus(nodes, node_cpus, MAX_NUM_NODES);
+    if (num_nodes > 1) {
+        for (n = 0; n < num_nodes; n++) {
+            int node = check_placement(node_cpus[n]);
+            if (node == -1) continue;
+            ATS_printf(1, "node %d: stack on node %d\n", nodes[n], node);
+            num_checked++;
+            if (node != nodes[n]) {
+                printf("node %d: stack on node %d\n", nodes[n], node);
+                num_errors++;
+            }
+        }
+    } else {
+        ATS_printf(1, "single NUMA node: placement is not checked\n");
+    }
+
+    /* Finalize */
+    ret = ATS_finalize(num_errors);
+    if (ret == EXIT_SUCCESS && num_checked == 0) {
+        /* Report a skip to the test harness. */
+        ret = 77;
+    }
+
+    free(xstreams);
+    free(pools);
+    free(threads);
+    free(tasks);
+
+    return ret;
+}
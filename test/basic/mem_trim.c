@@ -0,0 +1,128 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <alloca.h>
+#include "abt.h"
+#include "abttest.h"
+
+/* This code tests that pooled stacks can be used again after their memory has
+ * been released by ABT_mem_trim() and by the periodic trimming, including
+ * stacks whose stack pages have been freed. */
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     1024
+#define DEFAULT_NUM_ITER        5
+#define STACK_TOUCH_SIZE        4096
+
+static int g_num_errors = 0;
+
+static void thread_func(void *arg)
+{
+    int idx = (int)(intptr_t)arg;
+    unsigned char *buf;
+    size_t i;
+
+    /* Fill a part of the stack, let other ULTs run, and check it. */
+    buf = (unsigned char *)alloca(STACK_TOUCH_SIZE);
+    memset(buf, idx & 0xff, STACK_TOUCH_SIZE);
+    ABT_thread_yield();
+    for (i = 0; i < STACK_TOUCH_SIZE; i++) {
+        if (buf[i] != (unsigned char)(idx & 0xff)) {
+            __sync_fetch_and_add(&g_num_errors, 1);
+            break;
+        }
+    }
+}
+
+static void create_and_free_threads(ABT_pool *pools, ABT_thread *threads,
+                                    int num_xstreams, int num_threads, int n)
+{
+    int i, ret;
+
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pools[(i + n) % num_xstreams], thread_func,
+                                (void *)(intptr_t)(i + n), ABT_THREAD_ATTR_NULL,
+                                &threads[i]);
+        ATS_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    int i, n, ret;
+    int num_xstreams, num_threads, num_iter;
+
+    /* Trim idle stacks as often as possible. */
+    setenv("ABT_MEM_TRIM_INTERVAL_MSEC", "1", 1);
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc < 2) {
+        num_xstreams = DEFAULT_NUM_XSTREAMS;
+        num_threads  = DEFAULT_NUM_THREADS;
+        num_iter     = DEFAULT_NUM_ITER;
+    } else {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads  = ATS_get_arg_val(ATS_ARG_N_ULT);
+        num_iter     = ATS_get_arg_val(ATS_ARG_N_ITER);
+    }
+    ATS_init(argc, argv, num_xstreams);
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+
+    /* Create Execution Streams */
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    for (n = 0; n < num_iter; n++) {
+        /* Stacks trimmed explicitly */
+        create_and_free_threads(pools, threads, num_xstreams, num_threads, n);
+        ret = ABT_mem_trim();
+        ATS_ERROR(ret, "ABT_mem_trim");
+        create_and_free_threads(pools, threads, num_xstreams, num_threads, n);
+
+        /* Stacks trimmed by the schedulers after being idle */
+        ret = ABT_thread_sleep(0.01);
+        ATS_ERROR(ret, "ABT_thread_sleep");
+        create_and_free_threads(pools, threads, num_xstreams, num_threads, n);
+    }
+
+    /* Join and free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Finalize */
+    ret = ATS_finalize(g_num_errors);
+
+    free(xstreams);
+    free(pools);
+    free(threads);
+
+    return ret;
+}
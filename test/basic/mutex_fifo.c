@@ -0,0 +1,214 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "abt.h"
+#include "abttest.h"
+
+/* This code tests that a FIFO mutex provides mutual exclusion to ULTs on
+ * multiple ESs and external threads, and that it is handed over to waiters in
+ * their arrival order. */
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     4
+#define DEFAULT_NUM_ITER        100
+#define NUM_PTHREADS            2
+
+static ABT_mutex g_mutex = ABT_MUTEX_NULL;
+static int g_counter = 0;
+static int num_iter;
+
+static int g_num_arrived = 0;
+static int g_order[DEFAULT_NUM_THREADS];
+static int g_num_acquired = 0;
+
+static void count_func(void *arg)
+{
+    int i, ret;
+    for (i = 0; i < num_iter; i++) {
+        switch (i % 3) {
+            case 0:
+                ret = ABT_mutex_lock(g_mutex);
+                ATS_ERROR(ret, "ABT_mutex_lock");
+                break;
+            case 1:
+                /* The mutex may have been handed over to a ULT on this ES. */
+                while (ABT_mutex_trylock(g_mutex) != ABT_SUCCESS) {
+                    ABT_thread_yield();
+                }
+                break;
+            default:
+                ret = ABT_mutex_lock_low(g_mutex);
+                ATS_ERROR(ret, "ABT_mutex_lock_low");
+                break;
+        }
+        g_counter++;
+        if (i % 2) {
+            ret = ABT_mutex_unlock(g_mutex);
+            ATS_ERROR(ret, "ABT_mutex_unlock");
+        } else {
+            ret = ABT_mutex_unlock_se(g_mutex);
+            ATS_ERROR(ret, "ABT_mutex_unlock_se");
+        }
+    }
+}
+
+static void *pthread_func(void *arg)
+{
+    int i, ret;
+    for (i = 0; i < num_iter; i++) {
+        ret = ABT_mutex_lock(g_mutex);
+        ATS_ERROR(ret, "ABT_mutex_lock");
+        g_counter++;
+        ret = ABT_mutex_unlock(g_mutex);
+        ATS_ERROR(ret, "ABT_mutex_unlock");
+    }
+    return NULL;
+}
+
+static void order_func(void *arg)
+{
+    int ret;
+    __sync_fetch_and_add(&g_num_arrived, 1);
+    ret = ABT_mutex_lock(g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_lock");
+    g_order[g_num_acquired++] = (int)(intptr_t)arg;
+    ret = ABT_mutex_unlock(g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_unlock");
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_mutex_attr mattr;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    pthread_t pthreads[NUM_PTHREADS];
+    int i, ret, expected, num_errors = 0;
+    int num_xstreams, num_threads, num_total;
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc < 2) {
+        num_xstreams = DEFAULT_NUM_XSTREAMS;
+        num_threads  = DEFAULT_NUM_THREADS;
+        num_iter     = DEFAULT_NUM_ITER;
+    } else {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads  = ATS_get_arg_val(ATS_ARG_N_ULT);
+        num_iter     = ATS_get_arg_val(ATS_ARG_N_ITER);
+    }
+    ATS_init(argc, argv, num_xstreams);
+    num_total = num_xstreams * num_threads;
+
+    ATS_printf(1, "# of ESs    : %d\n", num_xstreams);
+    ATS_printf(1, "# of ULTs/ES: %d\n", num_threads);
+    ATS_printf(1, "# of iter   : %d\n", num_iter);
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_total);
+    assert(xstreams && pools && threads);
+
+    /* Create a mutex with the FIFO property */
+    ret = ABT_mutex_attr_create(&mattr);
+    ATS_ERROR(ret, "ABT_mutex_attr_create");
+    ret = ABT_mutex_attr_set_fifo(mattr, ABT_TRUE);
+    ATS_ERROR(ret, "ABT_mutex_attr_set_fifo");
+    ret = ABT_mutex_create_with_attr(mattr, &g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_create_with_attr");
+    ret = ABT_mutex_attr_free(&mattr);
+    ATS_ERROR(ret, "ABT_mutex_attr_free");
+
+    /* Create Execution Streams */
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    /* Mutual exclusion */
+    for (i = 0; i < num_total; i++) {
+        ret = ABT_thread_create(pools[i % num_xstreams], count_func, NULL,
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ATS_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < NUM_PTHREADS; i++) {
+        ret = pthread_create(&pthreads[i], NULL, pthread_func, NULL);
+        assert(ret == 0);
+    }
+    for (i = 0; i < num_total; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+    for (i = 0; i < NUM_PTHREADS; i++) {
+        ret = pthread_join(pthreads[i], NULL);
+        assert(ret == 0);
+    }
+    expected = (num_total + NUM_PTHREADS) * num_iter;
+    if (g_counter != expected) {
+        printf("g_counter = %d (expected: %d)\n", g_counter, expected);
+        num_errors++;
+    }
+
+    /* Handover order.  The waiters on other ESs arrive one by one while the
+     * main ULT holds the mutex. */
+    if (num_threads > DEFAULT_NUM_THREADS) num_threads = DEFAULT_NUM_THREADS;
+    ret = ABT_mutex_lock(g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_lock");
+    for (i = 0; i < num_threads; i++) {
+        int pool_idx = (num_xstreams > 1) ? 1 + i % (num_xstreams - 1) : 0;
+        ret = ABT_thread_create(pools[pool_idx], order_func,
+                                (void *)(intptr_t)i, ABT_THREAD_ATTR_NULL,
+                                &threads[i]);
+        ATS_ERROR(ret, "ABT_thread_create");
+        if (num_xstreams > 1) {
+            while (__sync_fetch_and_add(&g_num_arrived, 0) != i + 1) {
+                ABT_thread_yield();
+            }
+            ret = ABT_thread_sleep(0.001);
+            ATS_ERROR(ret, "ABT_thread_sleep");
+        }
+    }
+    ret = ABT_mutex_unlock(g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_unlock");
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+    for (i = 0; i < num_threads; i++) {
+        if (g_order[i] != i) {
+            printf("order[%d] = %d (expected: %d)\n", i, g_order[i], i);
+            num_errors++;
+        }
+    }
+
+    /* Join and free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    ret = ABT_mutex_free(&g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_free");
+
+    /* Finalize */
+    ret = ATS_finalize(num_errors);
+
+    free(xstreams);
+    free(pools);
+    free(threads);
+
+    return ret;
+}
@@ -0,0 +1,178 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_DEPTH           12
+#define DEFAULT_NUM_TASKS       100
+
+static int g_counter = 0;
+
+/* Binary fork-join tree.  Children are pushed to the pool of the running ES
+ * and are stolen by the other ESs. */
+void thread_func(void *arg)
+{
+    int depth = (int)(size_t)arg;
+    int ret, i;
+
+    if (depth == 0) {
+        ABT_thread_yield();
+        __sync_fetch_and_add(&g_counter, 1);
+        return;
+    }
+
+    ABT_xstream xstream;
+    ABT_pool pool;
+    ABT_thread threads[2];
+    ret = ABT_xstream_self(&xstream);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_get_main_pools(xstream, 1, &pool);
+    ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+
+    for (i = 0; i < 2; i++) {
+        ret = ABT_thread_create(pool, thread_func, (void *)(size_t)(depth - 1),
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ATS_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < 2; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+}
+
+void task_func(void *arg)
+{
+    ATS_UNUSED(arg);
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+int main(int argc, char *argv[])
+{
+    int i, k;
+    int ret;
+    int num_xstreams, depth, num_tasks;
+    size_t size;
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc < 2) {
+        num_xstreams = DEFAULT_NUM_XSTREAMS;
+        depth        = DEFAULT_DEPTH;
+        num_tasks    = DEFAULT_NUM_TASKS;
+    } else {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        depth        = ATS_get_arg_val(ATS_ARG_N_ITER);
+        num_tasks    = ATS_get_arg_val(ATS_ARG_N_TASK);
+    }
+    ATS_init(argc, argv, num_xstreams);
+
+    ABT_xstream *xstreams;
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    ABT_pool *pools;
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    ABT_pool *my_pools;
+    my_pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+
+    /* Check p_remove and ABT_pool_pop_steal on a pool that is not associated
+     * with any scheduler */
+    ABT_pool stage;
+    ABT_unit unit;
+    ret = ABT_pool_create_basic(ABT_POOL_DEQUE, ABT_POOL_ACCESS_MPMC,
+                                ABT_FALSE, &stage);
+    ATS_ERROR(ret, "ABT_pool_create_basic");
+    for (i = 0; i < num_tasks; i++) {
+        ret = ABT_task_create(stage, task_func, NULL, NULL);
+        ATS_ERROR(ret, "ABT_task_create");
+    }
+    ret = ABT_pool_pop_steal(stage, &unit);
+    ATS_ERROR(ret, "ABT_pool_pop_steal");
+    if (unit == ABT_UNIT_NULL) {
+        ATS_ERROR(ABT_ERR_POOL, "ABT_pool_pop_steal");
+    }
+    ret = ABT_pool_push(stage, unit);
+    ATS_ERROR(ret, "ABT_pool_push");
+    ret = ABT_pool_remove(stage, unit);
+    ATS_ERROR(ret, "ABT_pool_remove");
+    ret = ABT_pool_get_size(stage, &size);
+    ATS_ERROR(ret, "ABT_pool_get_size");
+    if (size != (size_t)(num_tasks - 1)) {
+        ATS_ERROR(ABT_ERR_POOL, "ABT_pool_get_size");
+    }
+
+    /* Create pools */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_DEQUE, ABT_POOL_ACCESS_MPMC,
+                                    ABT_TRUE, &pools[i]);
+        ATS_ERROR(ret, "ABT_pool_create_basic");
+    }
+
+    /* Move the tasklets to the new pools */
+    ret = ABT_pool_push(pools[0], unit);
+    ATS_ERROR(ret, "ABT_pool_push");
+    for (i = 1; ; i++) {
+        ret = ABT_pool_pop(stage, &unit);
+        ATS_ERROR(ret, "ABT_pool_pop");
+        if (unit == ABT_UNIT_NULL) break;
+        ret = ABT_pool_push(pools[i % num_xstreams], unit);
+        ATS_ERROR(ret, "ABT_pool_push");
+    }
+    ret = ABT_pool_free(&stage);
+    ATS_ERROR(ret, "ABT_pool_free");
+
+    /* Create Execution Streams with work-stealing schedulers */
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 0; i < num_xstreams; i++) {
+        for (k = 0; k < num_xstreams; k++) {
+            my_pools[k] = pools[(i + k) % num_xstreams];
+        }
+        if (i == 0) {
+            ret = ABT_xstream_set_main_sched_basic(xstreams[0],
+                                                   ABT_SCHED_RANDWS,
+                                                   num_xstreams, my_pools);
+            ATS_ERROR(ret, "ABT_xstream_set_main_sched_basic");
+        } else {
+            ret = ABT_xstream_create_basic(ABT_SCHED_RANDWS, num_xstreams,
+                                           my_pools, ABT_SCHED_CONFIG_NULL,
+                                           &xstreams[i]);
+            ATS_ERROR(ret, "ABT_xstream_create_basic");
+        }
+    }
+
+    /* Run the fork-join tree */
+    ABT_thread root;
+    ret = ABT_thread_create(pools[0], thread_func, (void *)(size_t)depth,
+                            ABT_THREAD_ATTR_NULL, &root);
+    ATS_ERROR(ret, "ABT_thread_create");
+    ret = ABT_thread_free(&root);
+    ATS_ERROR(ret, "ABT_thread_free");
+
+    /* Join Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+    }
+
+    /* Free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Finalize */
+    int expected = (1 << depth) + num_tasks;
+    ATS_printf(1, "counter: %d (expected: %d)\n", g_counter, expected);
+    ret = ATS_finalize(g_counter != expected);
+
+    free(my_pools);
+    free(pools);
+    free(xstreams);
+
+    return ret;
+}
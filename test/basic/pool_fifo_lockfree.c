@@ -0,0 +1,181 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     16
+#define DEFAULT_NUM_TASKS       3000    /* More than the ring holds */
+
+static int g_counter = 0;
+
+void task_func(void *arg)
+{
+    ATS_UNUSED(arg);
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+void thread_func(void *arg)
+{
+    size_t my_id = (size_t)arg;
+    int i;
+    for (i = 0; i < 10; i++) {
+        ATS_printf(2, "[TH%lu]: iteration %d\n", my_id, i);
+        ABT_thread_yield();
+    }
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+int main(int argc, char *argv[])
+{
+    int i, k;
+    int ret;
+    int num_xstreams, num_threads, num_tasks;
+    size_t size;
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc < 2) {
+        num_xstreams = DEFAULT_NUM_XSTREAMS;
+        num_threads  = DEFAULT_NUM_THREADS;
+        num_tasks    = DEFAULT_NUM_TASKS;
+    } else {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads  = ATS_get_arg_val(ATS_ARG_N_ULT);
+        num_tasks    = ATS_get_arg_val(ATS_ARG_N_TASK);
+    }
+    ATS_init(argc, argv, num_xstreams);
+
+    ABT_xstream *xstreams;
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    ABT_sched *scheds;
+    scheds = (ABT_sched *)malloc(sizeof(ABT_sched) * num_xstreams);
+    ABT_pool *pools;
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    ABT_pool *my_pools;
+    my_pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    ABT_unit *units;
+    units = (ABT_unit *)malloc(sizeof(ABT_unit) * num_tasks);
+
+    /* Create pools shared by all ESs */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_FIFO_LOCKFREE,
+                                    ABT_POOL_ACCESS_MPMC, ABT_TRUE, &pools[i]);
+        ATS_ERROR(ret, "ABT_pool_create_basic");
+    }
+
+    /* Fill a pool that is not associated with any scheduler, and check its
+     * size and p_remove */
+    ABT_pool stage;
+    ret = ABT_pool_create_basic(ABT_POOL_FIFO_LOCKFREE, ABT_POOL_ACCESS_MPMC,
+                                ABT_FALSE, &stage);
+    ATS_ERROR(ret, "ABT_pool_create_basic");
+    for (i = 0; i < num_tasks; i++) {
+        ret = ABT_task_create(stage, task_func, NULL, NULL);
+        ATS_ERROR(ret, "ABT_task_create");
+    }
+    ret = ABT_pool_get_size(stage, &size);
+    ATS_ERROR(ret, "ABT_pool_get_size");
+    if (size != (size_t)num_tasks) {
+        ATS_ERROR(ABT_ERR_POOL, "ABT_pool_get_size");
+    }
+
+    for (i = 0; i < num_tasks; i++) {
+        ret = ABT_pool_pop(stage, &units[i]);
+        ATS_ERROR(ret, "ABT_pool_pop");
+        if (units[i] == ABT_UNIT_NULL) {
+            ATS_ERROR(ABT_ERR_POOL, "ABT_pool_pop");
+        }
+    }
+    ret = ABT_pool_get_size(stage, &size);
+    ATS_ERROR(ret, "ABT_pool_get_size");
+    if (size != 0) {
+        ATS_ERROR(ABT_ERR_POOL, "ABT_pool_get_size");
+    }
+
+    for (i = 0; i < num_tasks; i++) {
+        ret = ABT_pool_push(stage, units[i]);
+        ATS_ERROR(ret, "ABT_pool_push");
+    }
+    for (i = 0; i < num_tasks; i += 3) {
+        ret = ABT_pool_remove(stage, units[i]);
+        ATS_ERROR(ret, "ABT_pool_remove");
+        ret = ABT_pool_push(pools[i % num_xstreams], units[i]);
+        ATS_ERROR(ret, "ABT_pool_push");
+    }
+    ret = ABT_pool_get_size(stage, &size);
+    ATS_ERROR(ret, "ABT_pool_get_size");
+    if (size != (size_t)(num_tasks - (num_tasks + 2) / 3)) {
+        ATS_ERROR(ABT_ERR_POOL, "ABT_pool_get_size");
+    }
+
+    /* Move the remaining units to the shared pools */
+    for (i = 0; ; i++) {
+        ABT_unit unit;
+        ret = ABT_pool_pop(stage, &unit);
+        ATS_ERROR(ret, "ABT_pool_pop");
+        if (unit == ABT_UNIT_NULL) break;
+        ret = ABT_pool_push(pools[i % num_xstreams], unit);
+        ATS_ERROR(ret, "ABT_pool_push");
+    }
+    ret = ABT_pool_free(&stage);
+    ATS_ERROR(ret, "ABT_pool_free");
+
+    /* Create schedulers */
+    for (i = 0; i < num_xstreams; i++) {
+        for (k = 0; k < num_xstreams; k++) {
+            my_pools[k] = pools[(i + k) % num_xstreams];
+        }
+        ret = ABT_sched_create_basic(ABT_SCHED_BASIC, num_xstreams, my_pools,
+                                     ABT_SCHED_CONFIG_NULL, &scheds[i]);
+        ATS_ERROR(ret, "ABT_sched_create_basic");
+    }
+
+    /* Create Execution Streams */
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_set_main_sched(xstreams[0], scheds[0]);
+    ATS_ERROR(ret, "ABT_xstream_set_main_sched");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(scheds[i], &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+
+    /* Create ULTs */
+    for (i = 0; i < num_threads; i++) {
+        size_t tid = i + 1;
+        ret = ABT_thread_create(pools[i % num_xstreams], thread_func,
+                                (void *)tid, ABT_THREAD_ATTR_NULL, NULL);
+        ATS_ERROR(ret, "ABT_thread_create");
+    }
+
+    /* Join Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+    }
+
+    /* Free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Finalize */
+    int expected = num_threads + num_tasks;
+    ATS_printf(1, "counter: %d (expected: %d)\n", g_counter, expected);
+    ret = ATS_finalize(g_counter != expected);
+
+    free(units);
+    free(my_pools);
+    free(pools);
+    free(scheds);
+    free(xstreams);
+
+    return ret;
+}
@@ -0,0 +1,184 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     100
+
+static int g_counter = 0;
+
+void thread_func(void *arg)
+{
+    ATS_UNUSED(arg);
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+void task_func(void *arg)
+{
+    ATS_UNUSED(arg);
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+/* Pop all units of src with ABT_pool_pop_many and push them to dst with
+ * ABT_pool_push_many in chunks of 7 units. */
+static void move_units(ABT_pool src, ABT_pool dst, size_t expected)
+{
+    ABT_unit units[7];
+    size_t num_units, total = 0, size;
+    int ret;
+
+    do {
+        ret = ABT_pool_pop_many(src, units, 7, &num_units);
+        ATS_ERROR(ret, "ABT_pool_pop_many");
+        ret = ABT_pool_push_many(dst, units, num_units);
+        ATS_ERROR(ret, "ABT_pool_push_many");
+        total += num_units;
+    } while (num_units == 7);
+
+    ret = ABT_pool_get_size(src, &size);
+    ATS_ERROR(ret, "ABT_pool_get_size");
+    if (total != expected || size != 0) {
+        ATS_ERROR(ABT_ERR_POOL, "ABT_pool_pop_many");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int i;
+    int ret;
+    int num_xstreams, num_threads;
+    size_t size;
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc < 2) {
+        num_xstreams = DEFAULT_NUM_XSTREAMS;
+        num_threads  = DEFAULT_NUM_THREADS;
+    } else {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads  = ATS_get_arg_val(ATS_ARG_N_ULT);
+    }
+    ATS_init(argc, argv, num_xstreams);
+
+    ABT_xstream *xstreams;
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    ABT_pool *pools;
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    ABT_pool *pool_list;
+    pool_list = (ABT_pool *)malloc(sizeof(ABT_pool) * num_threads);
+    ABT_thread *threads;
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+    void (**thread_func_list)(void *);
+    thread_func_list = (void (**)(void *))malloc(sizeof(void (*)(void *)) *
+                                                 num_threads);
+
+    /* Move units through pools with and without p_push_many/p_pop_many */
+    ABT_pool stage_fifo, stage_priv, stage_lockfree;
+    ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC,
+                                ABT_FALSE, &stage_fifo);
+    ATS_ERROR(ret, "ABT_pool_create_basic");
+    ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_PRIV,
+                                ABT_FALSE, &stage_priv);
+    ATS_ERROR(ret, "ABT_pool_create_basic");
+    ret = ABT_pool_create_basic(ABT_POOL_FIFO_LOCKFREE, ABT_POOL_ACCESS_MPMC,
+                                ABT_FALSE, &stage_lockfree);
+    ATS_ERROR(ret, "ABT_pool_create_basic");
+
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_task_create(stage_fifo, task_func, NULL, NULL);
+        ATS_ERROR(ret, "ABT_task_create");
+    }
+    move_units(stage_fifo, stage_priv, num_threads);
+    move_units(stage_priv, stage_lockfree, num_threads);
+    move_units(stage_lockfree, stage_fifo, num_threads);
+    ret = ABT_pool_get_size(stage_fifo, &size);
+    ATS_ERROR(ret, "ABT_pool_get_size");
+    if (size != (size_t)num_threads) {
+        ATS_ERROR(ABT_ERR_POOL, "ABT_pool_push_many");
+    }
+
+    /* Create Execution Streams */
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, pools + i);
+        ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    /* Hand the tasklets over to the ESs */
+    move_units(stage_fifo, pools[num_xstreams - 1], num_threads);
+
+    /* Create ULTs in runs that share a pool */
+    for (i = 0; i < num_threads; i++) {
+        pool_list[i] = pools[(i / 10) % num_xstreams];
+        thread_func_list[i] = thread_func;
+    }
+    ret = ABT_thread_create_many(num_threads, pool_list, thread_func_list,
+                                 NULL, ABT_THREAD_ATTR_NULL, threads);
+    ATS_ERROR(ret, "ABT_thread_create_many");
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+
+    /* Unnamed ULTs */
+    ret = ABT_thread_create_many(num_threads, pool_list, thread_func_list,
+                                 NULL, ABT_THREAD_ATTR_NULL, NULL);
+    ATS_ERROR(ret, "ABT_thread_create_many");
+
+    /* An invalid pool in the middle fails the creation, but the ULTs that
+     * have been created still run. */
+    int num_created = num_threads / 2;
+    pool_list[num_created] = ABT_POOL_NULL;
+    ret = ABT_thread_create_many(num_threads, pool_list, thread_func_list,
+                                 NULL, ABT_THREAD_ATTR_NULL, threads);
+    if (ret != ABT_ERR_INV_POOL) {
+        ATS_ERROR(ABT_ERR_OTHER, "ABT_thread_create_many");
+    }
+    for (i = 0; i < num_threads; i++) {
+        if (i < num_created) {
+            ret = ABT_thread_free(&threads[i]);
+            ATS_ERROR(ret, "ABT_thread_free");
+        } else if (threads[i] != ABT_THREAD_NULL) {
+            ATS_ERROR(ABT_ERR_OTHER, "ABT_thread_create_many");
+        }
+    }
+
+    /* Join and free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    ret = ABT_pool_free(&stage_fifo);
+    ATS_ERROR(ret, "ABT_pool_free");
+    ret = ABT_pool_free(&stage_priv);
+    ATS_ERROR(ret, "ABT_pool_free");
+    ret = ABT_pool_free(&stage_lockfree);
+    ATS_ERROR(ret, "ABT_pool_free");
+
+    /* Finalize */
+    int expected = num_threads * 3 + num_threads / 2;
+    ATS_printf(1, "counter: %d (expected: %d)\n", g_counter, expected);
+    ret = ATS_finalize(g_counter != expected);
+
+    free(thread_func_list);
+    free(threads);
+    free(pool_list);
+    free(pools);
+    free(xstreams);
+
+    return ret;
+}
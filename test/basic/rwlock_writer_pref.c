@@ -0,0 +1,142 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "abt.h"
+#include "abttest.h"
+
+/* This code tests that a writer waiting for readers blocks new readers, and
+ * that the readers blocked by a writer acquire the rwlock before the next
+ * writer.  An external thread takes part as a reader. */
+
+#define DEFAULT_NUM_XSTREAMS    2
+#define SLEEP_SECS              0.005
+
+#define MAX_EVENTS 16
+
+static ABT_rwlock g_rwlock;
+static char g_events[MAX_EVENTS];
+static int g_num_events = 0;
+
+static void record(char event)
+{
+    int idx = __sync_fetch_and_add(&g_num_events, 1);
+    if (idx < MAX_EVENTS) g_events[idx] = event;
+}
+
+void writer_func(void *arg)
+{
+    int ret;
+    ret = ABT_rwlock_wrlock(g_rwlock);
+    ATS_ERROR(ret, "ABT_rwlock_wrlock");
+    record((char)(intptr_t)arg);
+    ret = ABT_thread_sleep(SLEEP_SECS);
+    ATS_ERROR(ret, "ABT_thread_sleep");
+    ret = ABT_rwlock_unlock(g_rwlock);
+    ATS_ERROR(ret, "ABT_rwlock_unlock");
+}
+
+void reader_func(void *arg)
+{
+    int ret;
+    ret = ABT_rwlock_rdlock(g_rwlock);
+    ATS_ERROR(ret, "ABT_rwlock_rdlock");
+    record((char)(intptr_t)arg);
+    ret = ABT_rwlock_unlock(g_rwlock);
+    ATS_ERROR(ret, "ABT_rwlock_unlock");
+}
+
+void *pthread_reader(void *arg)
+{
+    reader_func(arg);
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream xstreams[DEFAULT_NUM_XSTREAMS];
+    ABT_pool pool;
+    ABT_thread threads[4];
+    pthread_t pthread;
+    int i, ret, err, pos_w = -1, pos_r = -1, pos_v = -1;
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    ATS_init(argc, argv, DEFAULT_NUM_XSTREAMS);
+
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < DEFAULT_NUM_XSTREAMS; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+    ret = ABT_xstream_get_main_pools(xstreams[1], 1, &pool);
+    ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+
+    ret = ABT_rwlock_create(&g_rwlock);
+    ATS_ERROR(ret, "ABT_rwlock_create");
+
+    /* The main ULT holds the rwlock as a reader while writer W starts.  A
+     * reader that comes after W must wait for W. */
+    ret = ABT_rwlock_rdlock(g_rwlock);
+    ATS_ERROR(ret, "ABT_rwlock_rdlock");
+    ret = ABT_thread_create(pool, writer_func, (void *)(intptr_t)'W',
+                            ABT_THREAD_ATTR_NULL, &threads[0]);
+    ATS_ERROR(ret, "ABT_thread_create");
+    ABT_thread_sleep(SLEEP_SECS);
+    ret = ABT_thread_create(pool, reader_func, (void *)(intptr_t)'r',
+                            ABT_THREAD_ATTR_NULL, &threads[1]);
+    ATS_ERROR(ret, "ABT_thread_create");
+    ret = pthread_create(&pthread, NULL, pthread_reader, (void *)(intptr_t)'x');
+    assert(ret == 0);
+    ABT_thread_sleep(SLEEP_SECS);
+    /* Writer V comes after reader r, so it runs after r. */
+    ret = ABT_thread_create(pool, writer_func, (void *)(intptr_t)'V',
+                            ABT_THREAD_ATTR_NULL, &threads[2]);
+    ATS_ERROR(ret, "ABT_thread_create");
+    ABT_thread_sleep(SLEEP_SECS);
+    ret = ABT_rwlock_unlock(g_rwlock);
+    ATS_ERROR(ret, "ABT_rwlock_unlock");
+
+    for (i = 0; i < 3; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+    ret = pthread_join(pthread, NULL);
+    assert(ret == 0);
+
+    /* A reader after the main ULT acquires the rwlock without waiting. */
+    ret = ABT_thread_create(pool, reader_func, (void *)(intptr_t)'R',
+                            ABT_THREAD_ATTR_NULL, &threads[3]);
+    ATS_ERROR(ret, "ABT_thread_create");
+    ret = ABT_thread_free(&threads[3]);
+    ATS_ERROR(ret, "ABT_thread_free");
+
+    ret = ABT_rwlock_free(&g_rwlock);
+    ATS_ERROR(ret, "ABT_rwlock_free");
+
+    /* Join and free Execution Streams */
+    for (i = 1; i < DEFAULT_NUM_XSTREAMS; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Finalize */
+    /* W, r, and V run on the same ES in this order, so r is blocked by W.
+     * The external thread may start late, so x can be anywhere before R. */
+    ATS_printf(1, "order: %.*s\n", g_num_events, g_events);
+    for (i = 0; i < g_num_events && i < MAX_EVENTS; i++) {
+        if (g_events[i] == 'W') pos_w = i;
+        if (g_events[i] == 'r') pos_r = i;
+        if (g_events[i] == 'V') pos_v = i;
+    }
+    err = (g_num_events != 5 || g_events[4] != 'R' || pos_w < 0 ||
+           pos_r < pos_w || pos_v < pos_r);
+    return ATS_finalize(err);
+}
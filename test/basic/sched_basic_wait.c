@@ -5,11 +5,13 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
 #include "abt.h"
 #include "abttest.h"
 
 #define DEFAULT_NUM_XSTREAMS    4
 #define DEFAULT_NUM_THREADS     4
+#define WAIT_TIMEOUT            10.0    /* Much longer than the test */
 
 void thread_func(void *arg)
 {
@@ -75,7 +77,48 @@ int main(int argc, char *argv[])
         }
     }
 
+    /* A waiting scheduler must wake up when any of its pools, not only the
+     * first one, gets a work unit. */
+    ABT_sched_config config;
+    ABT_pool wait_pools[2];
+    ABT_sched wait_sched;
+    ABT_xstream wait_xstream;
+    ABT_thread thread;
+    ret = ABT_sched_config_create(&config, ABT_sched_basic_wait_timeout,
+                                  WAIT_TIMEOUT, ABT_sched_config_var_end);
+    ATS_ERROR(ret, "ABT_sched_config_create");
+    for (i = 0; i < 2; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_FIFO_WAIT, ABT_POOL_ACCESS_MPMC,
+                                    ABT_TRUE, &wait_pools[i]);
+        ATS_ERROR(ret, "ABT_pool_create_basic");
+    }
+    ret = ABT_sched_create_basic(ABT_SCHED_BASIC_WAIT, 2, wait_pools, config,
+                                 &wait_sched);
+    ATS_ERROR(ret, "ABT_sched_create_basic");
+    ret = ABT_sched_config_free(&config);
+    ATS_ERROR(ret, "ABT_sched_config_free");
+    ret = ABT_xstream_create(wait_sched, &wait_xstream);
+    ATS_ERROR(ret, "ABT_xstream_create");
+
+    for (i = 0; i < 2; i++) {
+        /* Let the scheduler wait before pushing a ULT */
+        usleep(10000);
+        double start_time = ABT_get_wtime();
+        ret = ABT_thread_create(wait_pools[i], thread_func, (void *)0,
+                                ABT_THREAD_ATTR_NULL, &thread);
+        ATS_ERROR(ret, "ABT_thread_create");
+        ret = ABT_thread_free(&thread);
+        ATS_ERROR(ret, "ABT_thread_free");
+        if (ABT_get_wtime() - start_time > WAIT_TIMEOUT / 2) {
+            ATS_ERROR(ABT_ERR_SCHED, "ABT_thread_free");
+        }
+    }
+
     /* Join Execution Streams */
+    ret = ABT_xstream_join(wait_xstream);
+    ATS_ERROR(ret, "ABT_xstream_join");
+    ret = ABT_xstream_free(&wait_xstream);
+    ATS_ERROR(ret, "ABT_xstream_free");
     for (i = 1; i < num_xstreams; i++) {
         ret = ABT_xstream_join(xstreams[i]);
         ATS_ERROR(ret, "ABT_xstream_join");
@@ -0,0 +1,110 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_ITER        10
+#define IDLE_USEC               2000    /* Long enough for ESs to park */
+
+static int g_counter = 0;
+static int g_num_xstreams;
+static ABT_pool *g_pools;
+
+/* Each ULT forks a child on the next ES, which may be parked, and joins it. */
+void thread_func(void *arg)
+{
+    int depth = (int)(size_t)arg;
+    int ret, rank;
+    ABT_thread child;
+
+    __sync_fetch_and_add(&g_counter, 1);
+    if (depth == 0) return;
+
+    ret = ABT_xstream_self_rank(&rank);
+    ATS_ERROR(ret, "ABT_xstream_self_rank");
+    ret = ABT_thread_create(g_pools[(rank + 1) % g_num_xstreams], thread_func,
+                            (void *)(size_t)(depth - 1), ABT_THREAD_ATTR_NULL,
+                            &child);
+    ATS_ERROR(ret, "ABT_thread_create");
+    ret = ABT_thread_free(&child);
+    ATS_ERROR(ret, "ABT_thread_free");
+}
+
+int main(int argc, char *argv[])
+{
+    int i, n;
+    int ret;
+    int num_xstreams, num_iter;
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc < 2) {
+        num_xstreams = DEFAULT_NUM_XSTREAMS;
+        num_iter     = DEFAULT_NUM_ITER;
+    } else {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_iter     = ATS_get_arg_val(ATS_ARG_N_ITER);
+    }
+    ATS_init(argc, argv, num_xstreams);
+    g_num_xstreams = num_xstreams;
+
+    ABT_xstream *xstreams;
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    g_pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    ABT_thread *threads;
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_xstreams);
+
+    /* Create Execution Streams */
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &g_pools[i]);
+        ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    /* Let the secondary ESs become idle, and then give them work. */
+    for (n = 0; n < num_iter; n++) {
+        usleep(IDLE_USEC);
+        for (i = 1; i < num_xstreams; i++) {
+            ret = ABT_thread_create(g_pools[i], thread_func,
+                                    (void *)(size_t)1,
+                                    ABT_THREAD_ATTR_NULL, &threads[i]);
+            ATS_ERROR(ret, "ABT_thread_create");
+        }
+        for (i = 1; i < num_xstreams; i++) {
+            ret = ABT_thread_free(&threads[i]);
+            ATS_ERROR(ret, "ABT_thread_free");
+        }
+    }
+
+    /* Join requests must also reach idle ESs. */
+    usleep(IDLE_USEC);
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Finalize */
+    int expected = num_iter * (num_xstreams - 1) * 2;
+    ATS_printf(1, "counter: %d (expected: %d)\n", g_counter, expected);
+    ret = ATS_finalize(g_counter != expected);
+
+    free(threads);
+    free(g_pools);
+    free(xstreams);
+
+    return ret;
+}
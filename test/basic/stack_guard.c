@@ -0,0 +1,242 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <alloca.h>
+#include <signal.h>
+#include <setjmp.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include "abt.h"
+#include "abttest.h"
+
+/* This code tests that pooled stacks with guard pages can be used up to their
+ * reported sizes, that a ULT overflowing its stack is stopped by SIGSEGV
+ * instead of corrupting other memory, and that other faults still reach the
+ * handler installed by the application. */
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     256
+#define DEFAULT_NUM_ITER        5
+
+/* Stack bytes kept for the frames of the ULT function and memset() */
+#define STACK_MARGIN            4096
+
+static int g_num_errors = 0;
+static int g_num_user_faults = 0;
+static sigjmp_buf g_fault_env;
+
+static void thread_func(void *arg)
+{
+    int idx = (int)(intptr_t)arg;
+    size_t stacksize, touch, i;
+    ABT_thread self;
+    ABT_thread_attr attr;
+    unsigned char *buf;
+    int ret;
+
+    ret = ABT_thread_self(&self);
+    ATS_ERROR(ret, "ABT_thread_self");
+    ret = ABT_thread_get_attr(self, &attr);
+    ATS_ERROR(ret, "ABT_thread_get_attr");
+    ret = ABT_thread_attr_get_stacksize(attr, &stacksize);
+    ATS_ERROR(ret, "ABT_thread_attr_get_stacksize");
+    ret = ABT_thread_attr_free(&attr);
+    ATS_ERROR(ret, "ABT_thread_attr_free");
+    if (stacksize <= STACK_MARGIN) {
+        __sync_fetch_and_add(&g_num_errors, 1);
+        return;
+    }
+
+    /* The whole stack except the margin must be writable. */
+    touch = stacksize - STACK_MARGIN;
+    buf = (unsigned char *)alloca(touch);
+    memset(buf, idx & 0xff, touch);
+    for (i = 0; i < touch; i++) {
+        if (buf[i] != (unsigned char)(idx & 0xff)) {
+            __sync_fetch_and_add(&g_num_errors, 1);
+            break;
+        }
+    }
+}
+
+static int overflow(int depth)
+{
+    volatile char buf[256];
+    buf[0] = (char)depth;
+    if (depth < (1 << 30)) {
+        return overflow(depth + 1) + buf[0];
+    }
+    return buf[0];
+}
+
+static void overflow_func(void *arg)
+{
+    ATS_UNUSED(arg);
+    overflow(0);
+}
+
+static void user_fault_handler(int sig, siginfo_t *p_info, void *p_ucontext)
+{
+    ATS_UNUSED(sig);
+    ATS_UNUSED(p_info);
+    ATS_UNUSED(p_ucontext);
+    g_num_user_faults++;
+    siglongjmp(g_fault_env, 1);
+}
+
+/* Touch an inaccessible page twice.  Both faults must be passed to the
+ * handler of the application while the handler of Argobots stays installed.
+ * Returns 0 on success. */
+static int test_user_fault(void)
+{
+    volatile char *p_page;
+    struct sigaction cur;
+    int i;
+
+    p_page = (volatile char *)mmap(NULL, 4096, PROT_NONE,
+                                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if ((void *)p_page == MAP_FAILED) return 1;
+    for (i = 0; i < 2; i++) {
+        if (sigsetjmp(g_fault_env, 1) == 0) {
+            p_page[0] = 1;
+        }
+    }
+    munmap((void *)p_page, 4096);
+    sigaction(SIGSEGV, NULL, &cur);
+    if (cur.sa_sigaction == user_fault_handler) return 1;
+    return (g_num_user_faults == 2) ? 0 : 1;
+}
+
+/* Run a ULT that overflows its stack in a child process.  Returns 0 if the
+ * child is killed by SIGSEGV. */
+static int test_overflow(int argc, char **argv)
+{
+    int status;
+    pid_t pid = fork();
+
+    if (pid == 0) {
+        /* Do not dump the core of the expected crash. */
+        struct rlimit rlim = { 0, 0 };
+        ABT_xstream xstream;
+        ABT_thread thread;
+        ABT_pool pool;
+        setrlimit(RLIMIT_CORE, &rlim);
+
+        ATS_init(argc, argv, 1);
+        ABT_xstream_self(&xstream);
+        ABT_xstream_get_main_pools(xstream, 1, &pool);
+        ABT_thread_create(pool, overflow_func, NULL, ABT_THREAD_ATTR_NULL,
+                          &thread);
+        ABT_thread_free(&thread);
+        ATS_finalize(0);
+        exit(EXIT_SUCCESS);
+    }
+
+    if (pid < 0 || waitpid(pid, &status, 0) != pid) {
+        return 1;
+    }
+    if (!WIFSIGNALED(status) || WTERMSIG(status) != SIGSEGV) {
+        ATS_printf(1, "child status = %d\n", status);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    int i, n, ret;
+    int num_xstreams, num_threads, num_iter;
+
+    setenv("ABT_MEM_STACK_GUARD", "1", 1);
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc < 2) {
+        num_xstreams = DEFAULT_NUM_XSTREAMS;
+        num_threads  = DEFAULT_NUM_THREADS;
+        num_iter     = DEFAULT_NUM_ITER;
+    } else {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads  = ATS_get_arg_val(ATS_ARG_N_ULT);
+        num_iter     = ATS_get_arg_val(ATS_ARG_N_ITER);
+    }
+
+    /* The child process is created before any ES is running. */
+    if (test_overflow(argc, argv) != 0) {
+        __sync_fetch_and_add(&g_num_errors, 1);
+    }
+
+    /* The handler of the application is installed before Argobots. */
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = user_fault_handler;
+    action.sa_flags = SA_SIGINFO;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGSEGV, &action, NULL);
+
+    ATS_init(argc, argv, num_xstreams);
+
+    if (test_user_fault() != 0) {
+        ATS_printf(1, "user faults = %d\n", g_num_user_faults);
+        __sync_fetch_and_add(&g_num_errors, 1);
+    }
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+
+    /* Create Execution Streams */
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    /* Stacks are reused with their guard pages across iterations. */
+    for (n = 0; n < num_iter; n++) {
+        for (i = 0; i < num_threads; i++) {
+            ret = ABT_thread_create(pools[(i + n) % num_xstreams], thread_func,
+                                    (void *)(intptr_t)i, ABT_THREAD_ATTR_NULL,
+                                    &threads[i]);
+            ATS_ERROR(ret, "ABT_thread_create");
+        }
+        for (i = 0; i < num_threads; i++) {
+            ret = ABT_thread_free(&threads[i]);
+            ATS_ERROR(ret, "ABT_thread_free");
+        }
+        ret = ABT_mem_trim();
+        ATS_ERROR(ret, "ABT_mem_trim");
+    }
+
+    /* Join and free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Finalize */
+    ret = ATS_finalize(g_num_errors);
+
+    free(xstreams);
+    free(pools);
+    free(threads);
+
+    return ret;
+}
@@ -0,0 +1,205 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <alloca.h>
+#include "abt.h"
+#include "abttest.h"
+
+/* This code tests the stack usage measurement and adaptive stack sizing.
+ * ULTs of deep_func first run on large stacks given by an attribute.  After
+ * enough of them have terminated, ULTs of deep_func created without an
+ * attribute must get a stack that is large enough, while ULTs of small_func
+ * must get a stack smaller than the default one. */
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define NUM_SAMPLES             8
+#define SMALL_STACK_USAGE       1024
+#define DEEP_STACK_USAGE        (40 * 1024)
+#define DEFAULT_STACKSIZE       16384
+
+static int g_counter = 0;
+static int g_checksum = 0;
+
+/* Write a stack buffer of size bytes and return the sum of its bytes so that
+ * the writes are not optimized away.  The buffer is sized by the caller so
+ * that small_func does not reserve a frame larger than its stack. */
+static int touch_stack(size_t size)
+{
+    volatile char *buf = (volatile char *)alloca(size);
+    size_t i;
+    int sum = 0;
+    for (i = 0; i < size; i++) {
+        buf[size - 1 - i] = (char)i;
+    }
+    for (i = 0; i < size; i++) {
+        sum += buf[size - 1 - i];
+    }
+    return sum;
+}
+
+static void small_func(void *arg)
+{
+    ATS_UNUSED(arg);
+    __sync_fetch_and_add(&g_checksum, touch_stack(SMALL_STACK_USAGE));
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+static void deep_func(void *arg)
+{
+    ATS_UNUSED(arg);
+    __sync_fetch_and_add(&g_checksum, touch_stack(DEEP_STACK_USAGE));
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+static size_t get_stacksize(ABT_thread thread)
+{
+    ABT_thread_attr attr;
+    size_t stacksize;
+    void *p_stack;
+    int ret;
+
+    ret = ABT_thread_get_attr(thread, &attr);
+    ATS_ERROR(ret, "ABT_thread_get_attr");
+    ret = ABT_thread_attr_get_stack(attr, &p_stack, &stacksize);
+    ATS_ERROR(ret, "ABT_thread_attr_get_stack");
+    ret = ABT_thread_attr_free(&attr);
+    ATS_ERROR(ret, "ABT_thread_attr_free");
+    return stacksize;
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread threads[2 * NUM_SAMPLES];
+    ABT_thread_attr attr;
+    size_t stacksize;
+    int i, ret, num_xstreams;
+    int num_errors = 0;
+    char samples[32];
+    FILE *fp;
+
+    setenv("ABT_STACK_ADAPTIVE", "1", 1);
+    sprintf(samples, "%d", NUM_SAMPLES);
+    setenv("ABT_STACK_ADAPTIVE_SAMPLES", samples, 1);
+    setenv("ABT_THREAD_STACKSIZE", "16384", 1);
+    setenv("ABT_MEM_STACK_SIZES", "8192,65536,262144", 1);
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc < 2) {
+        num_xstreams = DEFAULT_NUM_XSTREAMS;
+    } else {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+    }
+    ATS_init(argc, argv, num_xstreams);
+
+    /* Nothing has been measured yet. */
+    fp = tmpfile();
+    ret = ABT_info_print_stack_usage(fp);
+    if (ret == ABT_ERR_FEATURE_NA) {
+        /* The memory pool is disabled. */
+        ATS_printf(1, "adaptive stack sizing is not supported\n");
+        fclose(fp);
+        return ATS_finalize(0);
+    }
+    ATS_ERROR(ret, "ABT_info_print_stack_usage");
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+
+    /* Create Execution Streams */
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    /* Measure the stack usage.  ULTs of deep_func would overflow the default
+     * stack, so they are given large stacks. */
+    ret = ABT_thread_attr_create(&attr);
+    ATS_ERROR(ret, "ABT_thread_attr_create");
+    ret = ABT_thread_attr_set_stacksize(attr, 262144);
+    ATS_ERROR(ret, "ABT_thread_attr_set_stacksize");
+    for (i = 0; i < NUM_SAMPLES; i++) {
+        ret = ABT_thread_create(pools[i % num_xstreams], small_func, NULL,
+                                ABT_THREAD_ATTR_NULL, &threads[2 * i]);
+        ATS_ERROR(ret, "ABT_thread_create");
+        ret = ABT_thread_create(pools[i % num_xstreams], deep_func, NULL,
+                                attr, &threads[2 * i + 1]);
+        ATS_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < 2 * NUM_SAMPLES; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+    ret = ABT_thread_attr_free(&attr);
+    ATS_ERROR(ret, "ABT_thread_attr_free");
+
+    /* New ULTs get the stack sizes chosen from the measured usage. */
+    for (i = 0; i < NUM_SAMPLES; i++) {
+        ret = ABT_thread_create(pools[i % num_xstreams], small_func, NULL,
+                                ABT_THREAD_ATTR_NULL, &threads[2 * i]);
+        ATS_ERROR(ret, "ABT_thread_create");
+        ret = ABT_thread_create(pools[i % num_xstreams], deep_func, NULL,
+                                ABT_THREAD_ATTR_NULL, &threads[2 * i + 1]);
+        ATS_ERROR(ret, "ABT_thread_create");
+
+        stacksize = get_stacksize(threads[2 * i]);
+        if (stacksize >= DEFAULT_STACKSIZE ||
+            stacksize < SMALL_STACK_USAGE) {
+            printf("small_func: stacksize = %zu\n", stacksize);
+            num_errors++;
+        }
+        stacksize = get_stacksize(threads[2 * i + 1]);
+        if (stacksize < DEEP_STACK_USAGE) {
+            printf("deep_func: stacksize = %zu\n", stacksize);
+            num_errors++;
+        }
+    }
+    for (i = 0; i < 2 * NUM_SAMPLES; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+
+    /* Both functions have been measured. */
+    ret = ABT_info_print_stack_usage(fp);
+    ATS_ERROR(ret, "ABT_info_print_stack_usage");
+    if (ftell(fp) == 0) {
+        printf("nothing is printed\n");
+        num_errors++;
+    }
+    fclose(fp);
+
+    /* Join and free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    if (g_counter != 4 * NUM_SAMPLES) {
+        printf("counter = %d (expected: %d)\n", g_counter, 4 * NUM_SAMPLES);
+        num_errors++;
+    }
+    ATS_printf(1, "checksum: %d\n", g_checksum);
+
+    /* Finalize */
+    ret = ATS_finalize(num_errors);
+
+    free(xstreams);
+    free(pools);
+
+    return ret;
+}
@@ -0,0 +1,213 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "abt.h"
+#include "abttest.h"
+
+/* This code tests that synchronization objects can be created and freed
+ * repeatedly by ULTs and external threads, and that objects created on one ES
+ * can be freed on another ES. */
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     4
+#define DEFAULT_NUM_ITER        100
+#define NUM_OBJS                8
+
+/* The last size does not fit in any size class of the slab caches. */
+static const int g_value_sizes[] = { 0, 8, 200, 1000, 5000 };
+#define NUM_VALUE_SIZES (int)(sizeof(g_value_sizes) / sizeof(g_value_sizes[0]))
+
+static int num_iter;
+static int g_num_errors = 0;
+
+typedef struct {
+    ABT_mutex mutexes[NUM_OBJS];
+    ABT_eventual eventuals[NUM_OBJS];
+} objs_t;
+
+/* Create and free objects of every type. */
+static void create_free(int seed)
+{
+    ABT_mutex mutex;
+    ABT_cond cond;
+    ABT_eventual eventual;
+    ABT_future future;
+    ABT_barrier barrier;
+    ABT_rwlock rwlock;
+    int ret, nbytes = g_value_sizes[seed % NUM_VALUE_SIZES];
+    char *value = (char *)malloc(nbytes + 1), *p_value;
+
+    ret = ABT_mutex_create(&mutex);
+    ATS_ERROR(ret, "ABT_mutex_create");
+    ret = ABT_cond_create(&cond);
+    ATS_ERROR(ret, "ABT_cond_create");
+    ret = ABT_eventual_create(nbytes, &eventual);
+    ATS_ERROR(ret, "ABT_eventual_create");
+    ret = ABT_future_create(seed % 16 + 1, NULL, &future);
+    ATS_ERROR(ret, "ABT_future_create");
+    ret = ABT_barrier_create(1, &barrier);
+    ATS_ERROR(ret, "ABT_barrier_create");
+    ret = ABT_rwlock_create(&rwlock);
+    ATS_ERROR(ret, "ABT_rwlock_create");
+
+    /* The objects must work and not overlap. */
+    ret = ABT_mutex_lock(mutex);
+    ATS_ERROR(ret, "ABT_mutex_lock");
+    ret = ABT_rwlock_wrlock(rwlock);
+    ATS_ERROR(ret, "ABT_rwlock_wrlock");
+    memset(value, seed, nbytes);
+    ret = ABT_eventual_set(eventual, value, nbytes);
+    ATS_ERROR(ret, "ABT_eventual_set");
+    ret = ABT_eventual_wait(eventual, (void **)&p_value);
+    ATS_ERROR(ret, "ABT_eventual_wait");
+    if (nbytes > 0 && memcmp(p_value, value, nbytes) != 0) {
+        __sync_fetch_and_add(&g_num_errors, 1);
+    }
+    ret = ABT_barrier_wait(barrier);
+    ATS_ERROR(ret, "ABT_barrier_wait");
+    ret = ABT_rwlock_unlock(rwlock);
+    ATS_ERROR(ret, "ABT_rwlock_unlock");
+    ret = ABT_mutex_unlock(mutex);
+    ATS_ERROR(ret, "ABT_mutex_unlock");
+
+    ret = ABT_rwlock_free(&rwlock);
+    ATS_ERROR(ret, "ABT_rwlock_free");
+    ret = ABT_barrier_free(&barrier);
+    ATS_ERROR(ret, "ABT_barrier_free");
+    ret = ABT_future_free(&future);
+    ATS_ERROR(ret, "ABT_future_free");
+    ret = ABT_eventual_free(&eventual);
+    ATS_ERROR(ret, "ABT_eventual_free");
+    ret = ABT_cond_free(&cond);
+    ATS_ERROR(ret, "ABT_cond_free");
+    ret = ABT_mutex_free(&mutex);
+    ATS_ERROR(ret, "ABT_mutex_free");
+    free(value);
+}
+
+static void thread_func(void *arg)
+{
+    int i;
+    for (i = 0; i < num_iter; i++) {
+        create_free((int)(intptr_t)arg + i);
+    }
+}
+
+static void *pthread_func(void *arg)
+{
+    thread_func(arg);
+    return NULL;
+}
+
+static void create_objs(void *arg)
+{
+    objs_t *p_objs = (objs_t *)arg;
+    int i, ret;
+    for (i = 0; i < NUM_OBJS; i++) {
+        ret = ABT_mutex_create(&p_objs->mutexes[i]);
+        ATS_ERROR(ret, "ABT_mutex_create");
+        ret = ABT_eventual_create(g_value_sizes[i % NUM_VALUE_SIZES],
+                                  &p_objs->eventuals[i]);
+        ATS_ERROR(ret, "ABT_eventual_create");
+    }
+}
+
+static void free_objs(void *arg)
+{
+    objs_t *p_objs = (objs_t *)arg;
+    int i, ret;
+    for (i = 0; i < NUM_OBJS; i++) {
+        ret = ABT_mutex_free(&p_objs->mutexes[i]);
+        ATS_ERROR(ret, "ABT_mutex_free");
+        ret = ABT_eventual_free(&p_objs->eventuals[i]);
+        ATS_ERROR(ret, "ABT_eventual_free");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    pthread_t pthread;
+    objs_t objs;
+    int i, ret;
+    int num_xstreams, num_threads, num_total;
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc < 2) {
+        num_xstreams = DEFAULT_NUM_XSTREAMS;
+        num_threads  = DEFAULT_NUM_THREADS;
+        num_iter     = DEFAULT_NUM_ITER;
+    } else {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads  = ATS_get_arg_val(ATS_ARG_N_ULT);
+        num_iter     = ATS_get_arg_val(ATS_ARG_N_ITER);
+    }
+    ATS_init(argc, argv, num_xstreams);
+    num_total = num_xstreams * num_threads;
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_total);
+
+    /* Create Execution Streams */
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    /* Create and free objects on every ES and on an external thread */
+    for (i = 0; i < num_total; i++) {
+        ret = ABT_thread_create(pools[i % num_xstreams], thread_func,
+                                (void *)(intptr_t)i, ABT_THREAD_ATTR_NULL,
+                                &threads[i]);
+        ATS_ERROR(ret, "ABT_thread_create");
+    }
+    ret = pthread_create(&pthread, NULL, pthread_func, (void *)(intptr_t)1);
+    assert(ret == 0);
+    for (i = 0; i < num_total; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+    ret = pthread_join(pthread, NULL);
+    assert(ret == 0);
+
+    /* Free objects on an ES different from the one that created them */
+    ret = ABT_thread_create(pools[num_xstreams - 1], create_objs, &objs,
+                            ABT_THREAD_ATTR_NULL, &threads[0]);
+    ATS_ERROR(ret, "ABT_thread_create");
+    ret = ABT_thread_free(&threads[0]);
+    ATS_ERROR(ret, "ABT_thread_free");
+    free_objs(&objs);
+
+    /* Join and free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Finalize */
+    ret = ATS_finalize(g_num_errors);
+
+    free(xstreams);
+    free(pools);
+    free(threads);
+
+    return ret;
+}
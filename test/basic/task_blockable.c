@@ -0,0 +1,180 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+/* This code tests tasklets that suspend.  Some of them return without
+ * suspending, and the others yield, lock a contended mutex, or wait on an
+ * eventual, so they are promoted to ULTs while running. */
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_TASKS       64
+#define DEFAULT_NUM_ITER        10
+
+static int g_num_errors = 0;
+static int g_counter = 0;
+static int g_locked_counter = 0;
+static ABT_eventual g_eventual;
+static ABT_mutex g_mutex;
+static ABT_key g_key;
+
+static void task_func(void *arg)
+{
+    int idx = (int)(intptr_t)arg;
+    ABT_unit_type type;
+    void *value;
+
+    /* It is a tasklet until it suspends. */
+    ABT_self_get_type(&type);
+    if (type != ABT_UNIT_TYPE_TASK) {
+        __sync_fetch_and_add(&g_num_errors, 1);
+    }
+    ABT_key_set(g_key, arg);
+
+    switch (idx % 4) {
+        case 0:
+            /* Return without suspension */
+            break;
+        case 1:
+            /* Suspend by yield */
+            ABT_thread_yield();
+            ABT_thread_yield();
+            break;
+        case 2:
+            /* Suspend until the main ULT sets the eventual */
+            ABT_eventual_wait(g_eventual, NULL);
+            break;
+        case 3:
+            /* Suspend while holding the mutex */
+            ABT_mutex_lock(g_mutex);
+            g_locked_counter++;
+            ABT_thread_yield();
+            ABT_mutex_unlock(g_mutex);
+            break;
+    }
+
+    /* The tasklet-specific value must survive the suspension. */
+    ABT_key_get(g_key, &value);
+    if (value != arg) {
+        __sync_fetch_and_add(&g_num_errors, 1);
+    }
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_task *tasks;
+    ABT_bool blockable;
+    int i, n, ret;
+    int num_xstreams, num_tasks, num_iter;
+
+    setenv("ABT_TASK_BLOCKABLE", "1", 1);
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc < 2) {
+        num_xstreams = DEFAULT_NUM_XSTREAMS;
+        num_tasks    = DEFAULT_NUM_TASKS;
+        num_iter     = DEFAULT_NUM_ITER;
+    } else {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_tasks    = ATS_get_arg_val(ATS_ARG_N_TASK);
+        num_iter     = ATS_get_arg_val(ATS_ARG_N_ITER);
+    }
+    ATS_init(argc, argv, num_xstreams);
+
+    ret = ABT_info_query_config(ABT_INFO_QUERY_KIND_ENABLED_BLOCKABLE_TASK,
+                                (void *)&blockable);
+    ATS_ERROR(ret, "ABT_info_query_config");
+    if (blockable != ABT_TRUE) {
+        /* Tasklets cannot suspend in this configuration. */
+        ATS_printf(1, "blockable tasklets are not supported\n");
+        ret = ATS_finalize(0);
+        return ret;
+    }
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    tasks = (ABT_task *)malloc(sizeof(ABT_task) * num_tasks);
+
+    /* Create Execution Streams */
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    ret = ABT_mutex_create(&g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_create");
+    ret = ABT_key_create(NULL, &g_key);
+    ATS_ERROR(ret, "ABT_key_create");
+
+    for (n = 0; n < num_iter; n++) {
+        ret = ABT_eventual_create(0, &g_eventual);
+        ATS_ERROR(ret, "ABT_eventual_create");
+
+        /* Half of the tasklets are unnamed. */
+        for (i = 0; i < num_tasks; i++) {
+            ret = ABT_task_create(pools[(i + n) % num_xstreams], task_func,
+                                  (void *)(intptr_t)i,
+                                  (i / 4) % 2 ? &tasks[i] : NULL);
+            ATS_ERROR(ret, "ABT_task_create");
+        }
+
+        ABT_thread_yield();
+        ret = ABT_eventual_set(g_eventual, NULL, 0);
+        ATS_ERROR(ret, "ABT_eventual_set");
+
+        for (i = 0; i < num_tasks; i++) {
+            if ((i / 4) % 2) {
+                ret = ABT_task_free(&tasks[i]);
+                ATS_ERROR(ret, "ABT_task_free");
+            }
+        }
+        while (__sync_fetch_and_add(&g_counter, 0) != num_tasks * (n + 1)) {
+            ABT_thread_yield();
+        }
+        ret = ABT_eventual_free(&g_eventual);
+        ATS_ERROR(ret, "ABT_eventual_free");
+    }
+
+    /* Join and free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    ret = ABT_key_free(&g_key);
+    ATS_ERROR(ret, "ABT_key_free");
+    ret = ABT_mutex_free(&g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_free");
+
+    if (g_locked_counter != (num_tasks / 4) * num_iter) {
+        printf("locked counter = %d (expected: %d)\n", g_locked_counter,
+               (num_tasks / 4) * num_iter);
+        g_num_errors++;
+    }
+
+    /* Finalize */
+    ret = ATS_finalize(g_num_errors);
+
+    free(xstreams);
+    free(pools);
+    free(tasks);
+
+    return ret;
+}
@@ -0,0 +1,157 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+/* This code tests ULTs created with and without dynamic promotion side by
+ * side.  Some of them return without suspending, some yield and migrate to
+ * other ESs, and some block on an eventual, so both the fast return path and
+ * the promotion path are taken. */
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     64
+#define DEFAULT_NUM_ITER        10
+
+static int g_num_errors = 0;
+static int g_counter = 0;
+static ABT_eventual g_eventual;
+
+static int fib(int n)
+{
+    return n < 2 ? n : fib(n - 1) + fib(n - 2);
+}
+
+static void thread_func(void *arg)
+{
+    int idx = (int)(intptr_t)arg;
+    int val = fib(10);
+
+    switch (idx % 3) {
+        case 0:
+            /* Return without suspension */
+            break;
+        case 1:
+            /* Suspend by yield */
+            ABT_thread_yield();
+            ABT_thread_yield();
+            break;
+        case 2:
+            /* Suspend until the main ULT sets the eventual */
+            ABT_eventual_wait(g_eventual, NULL);
+            break;
+    }
+
+    /* Local variables must survive the suspension. */
+    if (val != 55 || fib(10) != 55) {
+        __sync_fetch_and_add(&g_num_errors, 1);
+    }
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    ABT_thread_attr attrs[2];
+    int i, n, ret;
+    int num_xstreams, num_threads, num_iter;
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc < 2) {
+        num_xstreams = DEFAULT_NUM_XSTREAMS;
+        num_threads  = DEFAULT_NUM_THREADS;
+        num_iter     = DEFAULT_NUM_ITER;
+    } else {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads  = ATS_get_arg_val(ATS_ARG_N_ULT);
+        num_iter     = ATS_get_arg_val(ATS_ARG_N_ITER);
+    }
+    ATS_init(argc, argv, num_xstreams);
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+
+    /* Create Execution Streams */
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    /* attrs[0] disables and attrs[1] enables dynamic promotion. */
+    for (i = 0; i < 2; i++) {
+        ret = ABT_thread_attr_create(&attrs[i]);
+        ATS_ERROR(ret, "ABT_thread_attr_create");
+        ret = ABT_thread_attr_set_dynamic_promotion(attrs[i],
+                                                    i ? ABT_TRUE : ABT_FALSE);
+        if (ret == ABT_ERR_FEATURE_NA) {
+            ATS_printf(1, "dynamic promotion is not supported\n");
+        } else {
+            ATS_ERROR(ret, "ABT_thread_attr_set_dynamic_promotion");
+        }
+    }
+
+    for (n = 0; n < num_iter; n++) {
+        ret = ABT_eventual_create(0, &g_eventual);
+        ATS_ERROR(ret, "ABT_eventual_create");
+
+        for (i = 0; i < num_threads; i++) {
+            ret = ABT_thread_create(pools[(i + n) % num_xstreams], thread_func,
+                                    (void *)(intptr_t)i, attrs[(i / 3) % 2],
+                                    &threads[i]);
+            ATS_ERROR(ret, "ABT_thread_create");
+        }
+
+        ABT_thread_yield();
+        ret = ABT_eventual_set(g_eventual, NULL, 0);
+        ATS_ERROR(ret, "ABT_eventual_set");
+
+        for (i = 0; i < num_threads; i++) {
+            ret = ABT_thread_free(&threads[i]);
+            ATS_ERROR(ret, "ABT_thread_free");
+        }
+        ret = ABT_eventual_free(&g_eventual);
+        ATS_ERROR(ret, "ABT_eventual_free");
+    }
+
+    for (i = 0; i < 2; i++) {
+        ret = ABT_thread_attr_free(&attrs[i]);
+        ATS_ERROR(ret, "ABT_thread_attr_free");
+    }
+
+    /* Join and free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    if (g_counter != num_threads * num_iter) {
+        printf("counter = %d (expected: %d)\n", g_counter,
+               num_threads * num_iter);
+        g_num_errors++;
+    }
+
+    /* Finalize */
+    ret = ATS_finalize(g_num_errors);
+
+    free(xstreams);
+    free(pools);
+    free(threads);
+
+    return ret;
+}
@@ -0,0 +1,120 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     100
+#define DEFAULT_NUM_ITER        3
+
+static int g_num_iter;
+static int g_num_early = 0;
+
+/* Each ULT sleeps for a few milliseconds, which depend on its index, and
+ * checks that it does not wake up before the deadline. */
+void thread_func(void *arg)
+{
+    int idx = (int)(intptr_t)arg;
+    int i, ret;
+
+    for (i = 0; i < g_num_iter; i++) {
+        double secs = 1.0e-3 * ((idx + i) % 5 + 1);
+        double start = ABT_get_wtime();
+        ret = ABT_thread_sleep(secs);
+        ATS_ERROR(ret, "ABT_thread_sleep");
+        if (ABT_get_wtime() < start + secs) {
+            __sync_fetch_and_add(&g_num_early, 1);
+        }
+
+        double deadline = ABT_get_wtime() + 2.0e-3;
+        ret = ABT_thread_sleep_until(deadline);
+        ATS_ERROR(ret, "ABT_thread_sleep_until");
+        if (ABT_get_wtime() < deadline) {
+            __sync_fetch_and_add(&g_num_early, 1);
+        }
+    }
+
+    /* A deadline in the past does not block. */
+    ret = ABT_thread_sleep_until(0.0);
+    ATS_ERROR(ret, "ABT_thread_sleep_until");
+}
+
+int main(int argc, char *argv[])
+{
+    int i, ret;
+    int num_xstreams, num_threads;
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc < 2) {
+        num_xstreams = DEFAULT_NUM_XSTREAMS;
+        num_threads  = DEFAULT_NUM_THREADS;
+        g_num_iter   = DEFAULT_NUM_ITER;
+    } else {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads  = ATS_get_arg_val(ATS_ARG_N_ULT);
+        g_num_iter   = ATS_get_arg_val(ATS_ARG_N_ITER);
+    }
+    ATS_init(argc, argv, num_xstreams);
+
+    ABT_xstream *xstreams;
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    ABT_pool *pools;
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    ABT_thread *threads;
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+
+    /* Create Execution Streams */
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, pools + i);
+        ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    double start = ABT_get_wtime();
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pools[i % num_xstreams], thread_func,
+                                (void *)(intptr_t)i, ABT_THREAD_ATTR_NULL,
+                                &threads[i]);
+        ATS_ERROR(ret, "ABT_thread_create");
+    }
+
+    /* The main ULT also sleeps. */
+    ret = ABT_thread_sleep(1.0e-3);
+    ATS_ERROR(ret, "ABT_thread_sleep");
+
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+    double elapsed = ABT_get_wtime() - start;
+
+    /* Join and free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Finalize */
+    ATS_printf(1, "early wake-ups: %d, elapsed: %.3f sec\n", g_num_early,
+               elapsed);
+    ret = ATS_finalize(g_num_early != 0);
+
+    free(threads);
+    free(pools);
+    free(xstreams);
+
+    return ret;
+}
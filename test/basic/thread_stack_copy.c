@@ -0,0 +1,271 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "abt.h"
+#include "abttest.h"
+
+/* This code tests stack-copying ULTs running together with normal ULTs on
+ * the same ESs.  They yield, block on an eventual, wait for a mutex, a FIFO
+ * mutex, or an rwlock, sleep, or time out on a condition variable, so their
+ * frames are copied out and back while other ULTs use the shared stack. */
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     64
+#define DEFAULT_NUM_ITER        10
+#define BUF_SIZE                256
+
+static int g_num_errors = 0;
+static int g_counter = 0;
+static int g_locked_counter = 0;
+static int g_timedout_counter = 0;
+static ABT_eventual g_eventual;
+static ABT_mutex g_mutex;
+static ABT_mutex g_fifo_mutex;
+static ABT_rwlock g_rwlock;
+static ABT_cond g_cond;
+
+static int check_buf(const char *buf, int idx)
+{
+    int i;
+    for (i = 0; i < BUF_SIZE; i++) {
+        if (buf[i] != (char)(idx + i)) return 1;
+    }
+    return 0;
+}
+
+/* Return the number of ULTs in [0, num_threads) that run the given cases of
+ * thread_func(). */
+static int count_cases(int num_threads, int case1, int case2)
+{
+    int i, num = 0;
+    for (i = 0; i < num_threads; i++) {
+        if (i % 8 == case1 || i % 8 == case2) num++;
+    }
+    return num;
+}
+
+static void thread_func(void *arg)
+{
+    int idx = (int)(intptr_t)arg;
+    char buf[BUF_SIZE];
+    char *p_buf = buf;
+    struct timeval tv;
+    struct timespec ts;
+    int i, ret;
+
+    for (i = 0; i < BUF_SIZE; i++) {
+        buf[i] = (char)(idx + i);
+    }
+
+    switch (idx % 8) {
+        case 0:
+            /* Return without suspension */
+            break;
+        case 1:
+            /* Suspend by yield */
+            ABT_thread_yield();
+            ABT_thread_yield();
+            break;
+        case 2:
+            /* Suspend until the main ULT sets the eventual */
+            ABT_eventual_wait(g_eventual, NULL);
+            break;
+        case 3:
+            /* Suspend while holding the mutex */
+            ABT_mutex_lock(g_mutex);
+            g_locked_counter++;
+            ABT_thread_yield();
+            ABT_mutex_unlock(g_mutex);
+            break;
+        case 4:
+            /* Wait in the queue of the FIFO mutex */
+            ABT_mutex_lock(g_fifo_mutex);
+            g_locked_counter++;
+            ABT_thread_yield();
+            ABT_mutex_unlock(g_fifo_mutex);
+            break;
+        case 5:
+            /* Wait for the rwlock as a reader or a writer */
+            if ((idx / 8) % 4 < 2) {
+                ABT_rwlock_rdlock(g_rwlock);
+            } else {
+                ABT_rwlock_wrlock(g_rwlock);
+            }
+            ABT_thread_yield();
+            ABT_rwlock_unlock(g_rwlock);
+            break;
+        case 6:
+            /* Sleep on the timer of the ES */
+            ABT_thread_sleep(1.0e-3);
+            break;
+        case 7:
+            /* Time out on the condition variable, which is never signaled */
+            gettimeofday(&tv, NULL);
+            ts.tv_sec = tv.tv_sec;
+            ts.tv_nsec = tv.tv_usec * 1000 + 1000000;
+            if (ts.tv_nsec >= 1000000000) {
+                ts.tv_sec++;
+                ts.tv_nsec -= 1000000000;
+            }
+            ABT_mutex_lock(g_mutex);
+            ret = ABT_cond_timedwait(g_cond, g_mutex, &ts);
+            if (ret == ABT_ERR_COND_TIMEDOUT) g_timedout_counter++;
+            ABT_mutex_unlock(g_mutex);
+            break;
+    }
+
+    /* Local variables and pointers to them must survive the suspension. */
+    if (check_buf(buf, idx) || check_buf(p_buf, idx)) {
+        __sync_fetch_and_add(&g_num_errors, 1);
+    }
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    ABT_thread_attr attrs[2];
+    int i, n, ret;
+    int num_xstreams, num_threads, num_iter;
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc < 2) {
+        num_xstreams = DEFAULT_NUM_XSTREAMS;
+        num_threads  = DEFAULT_NUM_THREADS;
+        num_iter     = DEFAULT_NUM_ITER;
+    } else {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads  = ATS_get_arg_val(ATS_ARG_N_ULT);
+        num_iter     = ATS_get_arg_val(ATS_ARG_N_ITER);
+    }
+    ATS_init(argc, argv, num_xstreams);
+
+    /* attrs[0] is the default and attrs[1] enables stack copying. */
+    for (i = 0; i < 2; i++) {
+        ret = ABT_thread_attr_create(&attrs[i]);
+        ATS_ERROR(ret, "ABT_thread_attr_create");
+    }
+    ret = ABT_thread_attr_set_stack_copy(attrs[1], ABT_TRUE);
+    if (ret == ABT_ERR_FEATURE_NA) {
+        /* Stack-copying ULTs are not supported in this configuration. */
+        ATS_printf(1, "stack-copying ULTs are not supported\n");
+        for (i = 0; i < 2; i++) {
+            ret = ABT_thread_attr_free(&attrs[i]);
+            ATS_ERROR(ret, "ABT_thread_attr_free");
+        }
+        ret = ATS_finalize(0);
+        return ret;
+    }
+    ATS_ERROR(ret, "ABT_thread_attr_set_stack_copy");
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+
+    /* Create Execution Streams */
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    ret = ABT_mutex_create(&g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_create");
+    ABT_mutex_attr mutex_attr;
+    ret = ABT_mutex_attr_create(&mutex_attr);
+    ATS_ERROR(ret, "ABT_mutex_attr_create");
+    ret = ABT_mutex_attr_set_fifo(mutex_attr, ABT_TRUE);
+    ATS_ERROR(ret, "ABT_mutex_attr_set_fifo");
+    ret = ABT_mutex_create_with_attr(mutex_attr, &g_fifo_mutex);
+    ATS_ERROR(ret, "ABT_mutex_create_with_attr");
+    ret = ABT_mutex_attr_free(&mutex_attr);
+    ATS_ERROR(ret, "ABT_mutex_attr_free");
+    ret = ABT_rwlock_create(&g_rwlock);
+    ATS_ERROR(ret, "ABT_rwlock_create");
+    ret = ABT_cond_create(&g_cond);
+    ATS_ERROR(ret, "ABT_cond_create");
+
+    for (n = 0; n < num_iter; n++) {
+        ret = ABT_eventual_create(0, &g_eventual);
+        ATS_ERROR(ret, "ABT_eventual_create");
+
+        for (i = 0; i < num_threads; i++) {
+            ret = ABT_thread_create(pools[(i + n) % num_xstreams], thread_func,
+                                    (void *)(intptr_t)i, attrs[(i / 8) % 2],
+                                    &threads[i]);
+            ATS_ERROR(ret, "ABT_thread_create");
+        }
+
+        ABT_thread_yield();
+        ret = ABT_eventual_set(g_eventual, NULL, 0);
+        ATS_ERROR(ret, "ABT_eventual_set");
+
+        for (i = 0; i < num_threads; i++) {
+            ret = ABT_thread_free(&threads[i]);
+            ATS_ERROR(ret, "ABT_thread_free");
+        }
+        ret = ABT_eventual_free(&g_eventual);
+        ATS_ERROR(ret, "ABT_eventual_free");
+    }
+
+    for (i = 0; i < 2; i++) {
+        ret = ABT_thread_attr_free(&attrs[i]);
+        ATS_ERROR(ret, "ABT_thread_attr_free");
+    }
+
+    /* Join and free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    ret = ABT_mutex_free(&g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_free");
+    ret = ABT_mutex_free(&g_fifo_mutex);
+    ATS_ERROR(ret, "ABT_mutex_free");
+    ret = ABT_rwlock_free(&g_rwlock);
+    ATS_ERROR(ret, "ABT_rwlock_free");
+    ret = ABT_cond_free(&g_cond);
+    ATS_ERROR(ret, "ABT_cond_free");
+
+    if (g_counter != num_threads * num_iter) {
+        printf("counter = %d (expected: %d)\n", g_counter,
+               num_threads * num_iter);
+        g_num_errors++;
+    }
+    if (g_locked_counter != count_cases(num_threads, 3, 4) * num_iter) {
+        printf("locked counter = %d (expected: %d)\n", g_locked_counter,
+               count_cases(num_threads, 3, 4) * num_iter);
+        g_num_errors++;
+    }
+    if (g_timedout_counter != count_cases(num_threads, 7, 7) * num_iter) {
+        printf("timed-out counter = %d (expected: %d)\n", g_timedout_counter,
+               count_cases(num_threads, 7, 7) * num_iter);
+        g_num_errors++;
+    }
+
+    /* Finalize */
+    ret = ATS_finalize(g_num_errors);
+
+    free(xstreams);
+    free(pools);
+    free(threads);
+
+    return ret;
+}
@@ -0,0 +1,149 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <alloca.h>
+#include "abt.h"
+#include "abttest.h"
+
+/* This code tests that ULTs get usable stacks of the requested sizes whether
+ * or not the sizes are pooled, and that the stacks of live ULTs do not
+ * overlap. */
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_ITER        10
+
+/* Sizes that match, fall between, and exceed the default pooled sizes */
+static const size_t g_stacksizes[] = {
+    4096, 16384, 20000, 65536, 100000, 262144, 1048576, 2 * 1048576
+};
+#define NUM_STACKSIZES (int)(sizeof(g_stacksizes) / sizeof(g_stacksizes[0]))
+
+static int g_num_errors = 0;
+
+static void thread_func(void *arg)
+{
+    int idx = (int)(intptr_t)arg;
+    size_t req = g_stacksizes[idx % NUM_STACKSIZES];
+    size_t stacksize, touch, i;
+    ABT_thread self;
+    ABT_thread_attr attr;
+    unsigned char *buf;
+    int ret;
+
+    ret = ABT_thread_self(&self);
+    ATS_ERROR(ret, "ABT_thread_self");
+    ret = ABT_thread_get_attr(self, &attr);
+    ATS_ERROR(ret, "ABT_thread_get_attr");
+    ret = ABT_thread_attr_get_stacksize(attr, &stacksize);
+    ATS_ERROR(ret, "ABT_thread_attr_get_stacksize");
+    ret = ABT_thread_attr_free(&attr);
+    ATS_ERROR(ret, "ABT_thread_attr_free");
+
+    /* Only the ULT descriptor can be taken from the requested size. */
+    if (stacksize + 1024 < req) {
+        ATS_printf(1, "stacksize = %zu (requested: %zu)\n", stacksize, req);
+        __sync_fetch_and_add(&g_num_errors, 1);
+        return;
+    }
+
+    /* Fill half of the stack, let other ULTs run, and check it. */
+    touch = req / 2;
+    buf = (unsigned char *)alloca(touch);
+    memset(buf, idx & 0xff, touch);
+    ABT_thread_yield();
+    for (i = 0; i < touch; i++) {
+        if (buf[i] != (unsigned char)(idx & 0xff)) {
+            __sync_fetch_and_add(&g_num_errors, 1);
+            break;
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    ABT_thread_attr *attrs;
+    int i, n, ret;
+    int num_xstreams, num_iter, num_total;
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc < 2) {
+        num_xstreams = DEFAULT_NUM_XSTREAMS;
+        num_iter     = DEFAULT_NUM_ITER;
+    } else {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_iter     = ATS_get_arg_val(ATS_ARG_N_ITER);
+    }
+    ATS_init(argc, argv, num_xstreams);
+    num_total = num_xstreams * NUM_STACKSIZES;
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_total);
+    attrs = (ABT_thread_attr *)malloc(sizeof(ABT_thread_attr) * NUM_STACKSIZES);
+
+    /* Create Execution Streams */
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    for (i = 0; i < NUM_STACKSIZES; i++) {
+        ret = ABT_thread_attr_create(&attrs[i]);
+        ATS_ERROR(ret, "ABT_thread_attr_create");
+        ret = ABT_thread_attr_set_stacksize(attrs[i], g_stacksizes[i]);
+        ATS_ERROR(ret, "ABT_thread_attr_set_stacksize");
+    }
+
+    /* Stacks freed in an iteration are reused in the next one, possibly by
+     * ULTs on other ESs. */
+    for (n = 0; n < num_iter; n++) {
+        for (i = 0; i < num_total; i++) {
+            ret = ABT_thread_create(pools[(i + n) % num_xstreams], thread_func,
+                                    (void *)(intptr_t)i,
+                                    attrs[i % NUM_STACKSIZES], &threads[i]);
+            ATS_ERROR(ret, "ABT_thread_create");
+        }
+        for (i = 0; i < num_total; i++) {
+            ret = ABT_thread_free(&threads[i]);
+            ATS_ERROR(ret, "ABT_thread_free");
+        }
+    }
+
+    for (i = 0; i < NUM_STACKSIZES; i++) {
+        ret = ABT_thread_attr_free(&attrs[i]);
+        ATS_ERROR(ret, "ABT_thread_attr_free");
+    }
+
+    /* Join and free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Finalize */
+    ret = ATS_finalize(g_num_errors);
+
+    free(xstreams);
+    free(pools);
+    free(threads);
+    free(attrs);
+
+    return ret;
+}
@@ -0,0 +1,248 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/time.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     20
+#define TIMEOUT_MSEC            5
+
+static ABT_mutex g_mutex;
+static ABT_cond g_cond;
+static ABT_eventual g_eventual;
+static ABT_future g_future;
+static ABT_barrier g_barrier;
+
+static int g_num_timedout = 0;
+static int g_num_success = 0;
+static int g_num_errors = 0;
+
+static void get_abstime(struct timespec *p_ts, int msec)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    long nsec = tv.tv_usec * 1000 + (long)msec * 1000000;
+    p_ts->tv_sec  = tv.tv_sec + nsec / 1000000000;
+    p_ts->tv_nsec = nsec % 1000000000;
+}
+
+/* Count the result of a timed wait.  A timeout before the deadline is an
+ * error. */
+static void check_result(int ret, int expected, double start, int msec)
+{
+    if (ret == ABT_ERR_TIMEDOUT || ret == ABT_ERR_COND_TIMEDOUT) {
+        __sync_fetch_and_add(&g_num_timedout, 1);
+        if (ABT_get_wtime() < start + msec * 1.0e-3 - 1.0e-3) {
+            __sync_fetch_and_add(&g_num_errors, 1);
+        }
+    } else if (ret == ABT_SUCCESS) {
+        __sync_fetch_and_add(&g_num_success, 1);
+    } else {
+        ATS_ERROR(ret, "timed wait");
+    }
+    if (ret != expected) __sync_fetch_and_add(&g_num_errors, 1);
+}
+
+void timeout_func(void *arg)
+{
+    int expected = (int)(intptr_t)arg;
+    struct timespec ts;
+    double start;
+    int ret;
+
+    /* The condition variable is never signaled. */
+    ret = ABT_mutex_lock(g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_lock");
+    start = ABT_get_wtime();
+    get_abstime(&ts, TIMEOUT_MSEC);
+    ret = ABT_cond_timedwait(g_cond, g_mutex, &ts);
+    check_result(ret, ABT_ERR_COND_TIMEDOUT, start, TIMEOUT_MSEC);
+    ret = ABT_mutex_unlock(g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_unlock");
+
+    /* The eventual and the future are set by the main ULT after the first
+     * timeouts. */
+    start = ABT_get_wtime();
+    get_abstime(&ts, TIMEOUT_MSEC);
+    ret = ABT_eventual_timedwait(g_eventual, NULL, &ts);
+    check_result(ret, expected, start, TIMEOUT_MSEC);
+
+    start = ABT_get_wtime();
+    get_abstime(&ts, TIMEOUT_MSEC);
+    ret = ABT_future_timedwait(g_future, &ts);
+    check_result(ret, expected, start, TIMEOUT_MSEC);
+}
+
+void mutex_func(void *arg)
+{
+    int expected = (int)(intptr_t)arg;
+    int msec = (expected == ABT_SUCCESS) ? 10000 : TIMEOUT_MSEC;
+    struct timespec ts;
+    double start = ABT_get_wtime();
+    int ret;
+
+    get_abstime(&ts, msec);
+    ret = ABT_mutex_timedlock(g_mutex, &ts);
+    check_result(ret, expected, start, msec);
+    if (ret == ABT_SUCCESS) {
+        ret = ABT_mutex_unlock(g_mutex);
+        ATS_ERROR(ret, "ABT_mutex_unlock");
+    }
+}
+
+void barrier_func(void *arg)
+{
+    int expected = (int)(intptr_t)arg;
+    int msec = (expected == ABT_SUCCESS) ? 10000 : TIMEOUT_MSEC;
+    struct timespec ts;
+    double start = ABT_get_wtime();
+    int ret;
+
+    get_abstime(&ts, msec);
+    ret = ABT_barrier_timedwait(g_barrier, &ts);
+    check_result(ret, expected, start, msec);
+}
+
+static void run_threads(ABT_pool *pools, int num_xstreams,
+                        ABT_thread *threads, int num_threads,
+                        void (*thread_func)(void *), int expected)
+{
+    int i, ret;
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pools[i % num_xstreams], thread_func,
+                                (void *)(intptr_t)expected,
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ATS_ERROR(ret, "ABT_thread_create");
+    }
+}
+
+static void join_threads(ABT_thread *threads, int num_threads)
+{
+    int i, ret;
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int i, ret;
+    int num_xstreams, num_threads;
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc < 2) {
+        num_xstreams = DEFAULT_NUM_XSTREAMS;
+        num_threads  = DEFAULT_NUM_THREADS;
+    } else {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads  = ATS_get_arg_val(ATS_ARG_N_ULT);
+    }
+    ATS_init(argc, argv, num_xstreams);
+
+    ABT_xstream *xstreams;
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    ABT_pool *pools;
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    ABT_thread *threads;
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+
+    ret = ABT_mutex_create(&g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_create");
+    ret = ABT_cond_create(&g_cond);
+    ATS_ERROR(ret, "ABT_cond_create");
+    ret = ABT_eventual_create(0, &g_eventual);
+    ATS_ERROR(ret, "ABT_eventual_create");
+    ret = ABT_future_create(1, NULL, &g_future);
+    ATS_ERROR(ret, "ABT_future_create");
+    ret = ABT_barrier_create(num_threads + 1, &g_barrier);
+    ATS_ERROR(ret, "ABT_barrier_create");
+
+    /* Create Execution Streams */
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, pools + i);
+        ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    /* Every wait times out. */
+    run_threads(pools, num_xstreams, threads, num_threads, timeout_func,
+                ABT_ERR_TIMEDOUT);
+    join_threads(threads, num_threads);
+
+    /* Waits on the ready eventual and future succeed. */
+    ret = ABT_eventual_set(g_eventual, NULL, 0);
+    ATS_ERROR(ret, "ABT_eventual_set");
+    ret = ABT_future_set(g_future, NULL);
+    ATS_ERROR(ret, "ABT_future_set");
+    run_threads(pools, num_xstreams, threads, num_threads, timeout_func,
+                ABT_SUCCESS);
+    join_threads(threads, num_threads);
+
+    /* The mutex is held by the main ULT until the waiters time out. */
+    ret = ABT_mutex_lock(g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_lock");
+    run_threads(pools, num_xstreams, threads, num_threads, mutex_func,
+                ABT_ERR_TIMEDOUT);
+    join_threads(threads, num_threads);
+    run_threads(pools, num_xstreams, threads, num_threads, mutex_func,
+                ABT_SUCCESS);
+    ret = ABT_thread_sleep(1.0e-3);
+    ATS_ERROR(ret, "ABT_thread_sleep");
+    ret = ABT_mutex_unlock(g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_unlock");
+    join_threads(threads, num_threads);
+
+    /* The barrier lacks one waiter, and the timed out waiters leave it. */
+    run_threads(pools, num_xstreams, threads, num_threads, barrier_func,
+                ABT_ERR_TIMEDOUT);
+    join_threads(threads, num_threads);
+    run_threads(pools, num_xstreams, threads, num_threads, barrier_func,
+                ABT_SUCCESS);
+    ret = ABT_barrier_wait(g_barrier);
+    ATS_ERROR(ret, "ABT_barrier_wait");
+    join_threads(threads, num_threads);
+
+    /* Join and free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    ret = ABT_barrier_free(&g_barrier);
+    ATS_ERROR(ret, "ABT_barrier_free");
+    ret = ABT_future_free(&g_future);
+    ATS_ERROR(ret, "ABT_future_free");
+    ret = ABT_eventual_free(&g_eventual);
+    ATS_ERROR(ret, "ABT_eventual_free");
+    ret = ABT_cond_free(&g_cond);
+    ATS_ERROR(ret, "ABT_cond_free");
+    ret = ABT_mutex_free(&g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_free");
+
+    /* Finalize */
+    ATS_printf(1, "timed out: %d, succeeded: %d, errors: %d\n",
+               g_num_timedout, g_num_success, g_num_errors);
+    ret = ATS_finalize(g_num_errors != 0);
+
+    free(threads);
+    free(pools);
+    free(xstreams);
+
+    return ret;
+}
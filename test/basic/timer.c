@@ -128,6 +128,29 @@ int main(int argc, char *argv[])
     ABT_timer_stop(timer);
     ABT_timer_read(timer, &t_fini);
 
+    /* The nanosecond variants must agree with the ones in seconds */
+    uint64_t t_fini_nsec;
+    ret = ABT_timer_read_nsec(timer, &t_fini_nsec);
+    ATS_ERROR(ret, "ABT_timer_read_nsec");
+    if (t_fini_nsec * 1.0e-9 < t_fini - 1.0e-6 ||
+        t_fini_nsec * 1.0e-9 > t_fini + 1.0e-6) {
+        ATS_ERROR(ABT_ERR_OTHER, "ABT_timer_read_nsec");
+    }
+
+    /* The time must not go backwards */
+    uint64_t t_prev = ABT_get_wtime_nsec(), t_cur;
+    double t_end = ABT_get_wtime() + 0.01;
+    while (ABT_get_wtime() < t_end) {
+        t_cur = ABT_get_wtime_nsec();
+        if (t_cur < t_prev) {
+            ATS_ERROR(ABT_ERR_OTHER, "ABT_get_wtime_nsec");
+        }
+        t_prev = t_cur;
+    }
+    if (t_prev * 1.0e-9 < t_end - 1.0e-3) {
+        ATS_ERROR(ABT_ERR_OTHER, "ABT_get_wtime_nsec");
+    }
+
     ABT_timer_free(&timer);
     free(xstreams);
     free(pools);
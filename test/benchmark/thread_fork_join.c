@@ -13,6 +13,16 @@
 #include "abttest.h"
 #include "bench_util.h"
 
+/* USE_DEQUE_POOL runs the random work-stealing scheduler on deque pools. */
+#ifdef USE_DEQUE_POOL
+#define USE_PRIV_POOL
+#define POOL_KIND       ABT_POOL_DEQUE
+#define POOL_ACCESS     ABT_POOL_ACCESS_MPMC
+#else
+#define POOL_KIND       ABT_POOL_FIFO
+#define POOL_ACCESS     ABT_POOL_ACCESS_PRIV
+#endif
+
 #ifndef USE_PAPI
 #define ABTX_prof_summary(my_es, nults, iter,                                  \
     crea_time, crea_timestd, crea_llcm, crea_llcmstd, crea_tlbm, crea_tlbmstd, \
@@ -222,8 +232,7 @@ int main(int argc, char *argv[])
 #else
     /* Create pools */
     for (i = 0; i < ness; i++) {
-        ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_PRIV, ABT_TRUE,
-                              &pools[i]);
+        ABT_pool_create_basic(POOL_KIND, POOL_ACCESS, ABT_TRUE, &pools[i]);
     }
 
     for (i = 1; i < ness; i++) {
@@ -233,11 +242,29 @@ int main(int argc, char *argv[])
 
     /* Create ESs*/
     ABT_xstream_self(&xstreams[0]);
+#ifdef USE_DEQUE_POOL
+    ABT_pool *my_pools = (ABT_pool *)malloc(ness*sizeof(ABT_pool));
+    for (i = 0; i < ness; i++) {
+        int k;
+        for (k = 0; k < ness; k++) {
+            my_pools[k] = pools[(i + k) % ness];
+        }
+        if (i == 0) {
+            ABT_xstream_set_main_sched_basic(xstreams[0], ABT_SCHED_RANDWS,
+                                             ness, my_pools);
+        } else {
+            ABT_xstream_create_basic(ABT_SCHED_RANDWS, ness, my_pools,
+                                     ABT_SCHED_CONFIG_NULL, &xstreams[i]);
+        }
+    }
+    free(my_pools);
+#else
     ABT_xstream_set_main_sched_basic(xstreams[0], ABT_SCHED_DEFAULT, 1, &pools[0]);
     for (i = 1; i < ness; i++) {
         ABT_xstream_create_basic(ABT_SCHED_DEFAULT, 1, &pools[i],
                                  ABT_SCHED_CONFIG_NULL, &xstreams[i]);
     }
+#endif
 
     master_thread_func((void *)(size_t)0);
 #endif